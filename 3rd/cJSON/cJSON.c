@@ -49,6 +49,39 @@
 #include <locale.h>
 #endif
 
+/* vector kernels for the string loops, define CJSON_NO_SIMD for plain C only */
+#ifndef CJSON_NO_SIMD
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CJSON_SIMD_AVX2
+#define CJSON_SIMD_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define CJSON_SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define CJSON_SIMD_NEON
+#endif
+#if defined(_MSC_VER) && (defined(CJSON_SIMD_SSE2) || defined(CJSON_SIMD_NEON))
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define CJSON_ATOMICS
+#endif
+
+/* thread-local slabs for items (see cJSON_UseNodeSlabs), define CJSON_NO_NODE_SLAB to leave them out */
+#if !defined(CJSON_NO_NODE_SLAB) && defined(CJSON_ATOMICS)
+#define CJSON_NODE_SLAB
+/* a pthread key destructor hands a thread's free items back when it exits */
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#define CJSON_NODE_THREAD_EXIT
+#endif
+#endif
+
 #if defined(_MSC_VER)
 #pragma warning (pop)
 #endif
@@ -237,10 +270,248 @@ CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks)
     }
 }
 
+#ifdef CJSON_NODE_SLAB
+#define NODE_SLAB_SIZE ((size_t)64 * 1024)
+#define NODE_ALIGNMENT ((size_t)64)
+/* free items move between a thread and the depot in batches of NODE_BATCH */
+#define NODE_BATCH 256
+#define NODE_CACHE_LIMIT (4 * NODE_BATCH)
+
+typedef struct {
+    cJSON *free_items; /* linked through next */
+    size_t free_count;
+    unsigned char *slab_next; /* not yet handed out part of the newest slab */
+    unsigned char *slab_end;
+    cJSON_bool flush_on_exit; /* the thread-exit destructor is armed */
+} node_cache;
+
+/* initial-exec keeps the shared library from calling __tls_get_addr on every item */
+#if defined(__GNUC__) || defined(__clang__)
+#define NODE_THREAD_LOCAL _Thread_local __attribute__((tls_model("initial-exec")))
+#else
+#define NODE_THREAD_LOCAL _Thread_local
+#endif
+static NODE_THREAD_LOCAL node_cache thread_nodes = { NULL, 0, NULL, NULL, false };
+
+/* batches of up to NODE_BATCH free items given back by threads that free more items than they allocate or exit,
+ * chained through the prev pointer of their first item, whose type holds the batch size */
+static cJSON *node_depot = NULL;
+/* every slab ever allocated, chained through its first word; slabs are never freed */
+static void *node_slabs = NULL;
+static atomic_flag node_lock = ATOMIC_FLAG_INIT;
+static cJSON_bool node_slabs_enabled = false;
+
+static void node_lock_acquire(void)
+{
+    while (atomic_flag_test_and_set_explicit(&node_lock, memory_order_acquire))
+    {
+    }
+}
+
+static void node_lock_release(void)
+{
+    atomic_flag_clear_explicit(&node_lock, memory_order_release);
+}
+
+static void node_push_batch(cJSON * const batch, size_t count)
+{
+    batch->type = (int)count;
+    node_lock_acquire();
+    batch->prev = node_depot;
+    node_depot = batch;
+    node_lock_release();
+}
+
+#ifdef CJSON_NODE_THREAD_EXIT
+static pthread_key_t node_exit_key;
+static pthread_once_t node_exit_once = PTHREAD_ONCE_INIT;
+static cJSON_bool node_exit_key_valid = false;
+
+static void node_thread_exit(void *unused)
+{
+    (void)unused;
+    cJSON_FlushThreadNodes();
+}
+
+static void node_create_exit_key(void)
+{
+    node_exit_key_valid = (pthread_key_create(&node_exit_key, node_thread_exit) == 0);
+}
+
+/* a non-NULL value makes pthread run node_thread_exit when the thread exits */
+static void node_arm_thread_exit(node_cache * const cache)
+{
+    pthread_once(&node_exit_once, node_create_exit_key);
+    if (node_exit_key_valid && (pthread_setspecific(node_exit_key, cache) == 0))
+    {
+        cache->flush_on_exit = true;
+    }
+}
+#endif
+
+static cJSON_bool node_new_slab(node_cache * const cache)
+{
+    size_t misalignment = 0;
+    unsigned char *slab = (unsigned char*)global_hooks.allocate(NODE_SLAB_SIZE + NODE_ALIGNMENT);
+    if (slab == NULL)
+    {
+        return false;
+    }
+
+    node_lock_acquire();
+    *(void**)slab = node_slabs;
+    node_slabs = slab;
+    node_lock_release();
+
+    /* items start on the first cache line after the link; sizeof(cJSON) is 64 on LP64 so each gets its own line,
+     * with CJSON_COMPACT_NODES it is 40 and eight items share five lines */
+    cache->slab_next = slab + sizeof(void*);
+    misalignment = (size_t)cache->slab_next % NODE_ALIGNMENT;
+    if (misalignment != 0)
+    {
+        cache->slab_next += NODE_ALIGNMENT - misalignment;
+    }
+    cache->slab_end = slab + NODE_SLAB_SIZE + NODE_ALIGNMENT;
+
+    return true;
+}
+
+static cJSON *node_allocate(void)
+{
+    node_cache *cache = &thread_nodes;
+    cJSON *node = cache->free_items;
+
+    if (node == NULL)
+    {
+#ifdef CJSON_NODE_THREAD_EXIT
+        if (!cache->flush_on_exit)
+        {
+            node_arm_thread_exit(cache);
+        }
+#endif
+        node_lock_acquire();
+        node = node_depot;
+        if (node != NULL)
+        {
+            node_depot = node->prev;
+        }
+        node_lock_release();
+        cache->free_count = (node != NULL) ? (size_t)node->type : 0;
+    }
+
+    if (node != NULL)
+    {
+        cache->free_items = node->next;
+        cache->free_count--;
+        return node;
+    }
+
+    if (((size_t)(cache->slab_end - cache->slab_next) < sizeof(cJSON)) && !node_new_slab(cache))
+    {
+        return NULL;
+    }
+    node = (cJSON*)cache->slab_next;
+    cache->slab_next += sizeof(cJSON);
+
+    return node;
+}
+
+static void node_deallocate(cJSON * const node)
+{
+    node_cache *cache = &thread_nodes;
+    cJSON *batch = NULL;
+    cJSON *last = NULL;
+    size_t i = 0;
+
+#ifdef CJSON_NODE_THREAD_EXIT
+    /* a thread may only ever delete items that other threads parsed */
+    if (!cache->flush_on_exit)
+    {
+        node_arm_thread_exit(cache);
+    }
+#endif
+    node->next = cache->free_items;
+    cache->free_items = node;
+    if (++cache->free_count < NODE_CACHE_LIMIT)
+    {
+        return;
+    }
+
+    /* too many free items on this thread, e.g. it deletes what another one parsed */
+    batch = cache->free_items;
+    last = batch;
+    for (i = 1; i < NODE_BATCH; i++)
+    {
+        last = last->next;
+    }
+    cache->free_items = last->next;
+    cache->free_count -= NODE_BATCH;
+    last->next = NULL;
+    node_push_batch(batch, NODE_BATCH);
+}
+#endif
+
+CJSON_PUBLIC(void) cJSON_FlushThreadNodes(void)
+{
+#ifdef CJSON_NODE_SLAB
+    node_cache *cache = &thread_nodes;
+    cJSON *batch = NULL;
+    cJSON *last = NULL;
+    size_t count = 0;
+
+    /* the unused end of the current slab becomes free items as well, so no other thread allocates a slab in its place */
+    while ((size_t)(cache->slab_end - cache->slab_next) >= sizeof(cJSON))
+    {
+        cJSON *node = (cJSON*)cache->slab_next;
+        cache->slab_next += sizeof(cJSON);
+        node->next = cache->free_items;
+        cache->free_items = node;
+    }
+    cache->slab_next = NULL;
+    cache->slab_end = NULL;
+
+    while (cache->free_items != NULL)
+    {
+        batch = cache->free_items;
+        last = batch;
+        for (count = 1; (count < NODE_BATCH) && (last->next != NULL); count++)
+        {
+            last = last->next;
+        }
+        cache->free_items = last->next;
+        last->next = NULL;
+        node_push_batch(batch, count);
+    }
+    cache->free_count = 0;
+    /* the exit destructor has been consumed if this is it; re-arm on next use */
+    cache->flush_on_exit = false;
+#endif
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_UseNodeSlabs(cJSON_bool enable)
+{
+#ifdef CJSON_NODE_SLAB
+    node_slabs_enabled = enable ? true : false;
+    return true;
+#else
+    return enable ? false : true;
+#endif
+}
+
 /* Internal constructor. */
 static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
 {
-    cJSON* node = (cJSON*)hooks->allocate(sizeof(cJSON));
+    cJSON* node = NULL;
+#ifdef CJSON_NODE_SLAB
+    if (node_slabs_enabled)
+    {
+        node = node_allocate();
+    }
+    else
+#endif
+    {
+        node = (cJSON*)hooks->allocate(sizeof(cJSON));
+    }
     if (node)
     {
         memset(node, '\0', sizeof(cJSON));
@@ -249,18 +520,107 @@ static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
     return node;
 }
 
+/* Shared by an external item and its duplicates, see cJSON_CreateStringExternal */
+typedef struct
+{
+#ifdef CJSON_ATOMICS
+    atomic_size_t references;
+#else
+    size_t references; /* without C11 atomics, duplicates must be deleted on one thread */
+#endif
+    char *value;
+    cJSON_ReleaseFunc release;
+    void *user_data;
+} external_owner;
+
+/* External items are allocated with room for their owner, never from the slabs */
+typedef struct
+{
+    cJSON item;
+    external_owner *owner;
+} external_item;
+
+static cJSON *new_external_item(external_owner * const owner, int type)
+{
+    external_item *external = (external_item*)global_hooks.allocate(sizeof(external_item));
+    if (external == NULL)
+    {
+        return NULL;
+    }
+    memset(external, '\0', sizeof(external_item));
+    external->owner = owner;
+    external->item.type = type | cJSON_IsReference | cJSON_ValueIsExternal;
+    external->item.valuestring = owner->value;
+
+    return &external->item;
+}
+
+/* Another item for the value of item, which must be external */
+static cJSON *share_external(const cJSON * const item)
+{
+    external_owner *owner = ((const external_item*)item)->owner;
+    cJSON *shared = new_external_item(owner, item->type & 0xFF);
+    if (shared != NULL)
+    {
+#ifdef CJSON_ATOMICS
+        atomic_fetch_add_explicit(&owner->references, 1, memory_order_relaxed);
+#else
+        owner->references++;
+#endif
+    }
+
+    return shared;
+}
+
+static void drop_external(cJSON * const item)
+{
+    external_owner *owner = ((external_item*)item)->owner;
+#ifdef CJSON_ATOMICS
+    if (atomic_fetch_sub_explicit(&owner->references, 1, memory_order_acq_rel) == 1)
+#else
+    if (--owner->references == 0)
+#endif
+    {
+        if (owner->release != NULL)
+        {
+            owner->release(owner->value, owner->user_data);
+        }
+        global_hooks.deallocate(owner);
+    }
+    global_hooks.deallocate(item);
+}
+
+#ifdef CJSON_COMPACT_NODES
+/* child, valuestring and valuedouble share their storage, only the one type selects may be read */
+#define item_child(item) ((((item)->type & (cJSON_Array | cJSON_Object)) != 0) ? (item)->child : NULL)
+#define item_valuestring(item) ((((item)->type & (cJSON_String | cJSON_Raw | cJSON_TypedArray)) != 0) ? (item)->valuestring : NULL)
+#define item_valuedouble(item) ((((item)->type & cJSON_Number) != 0) ? (item)->valuedouble : 0.0)
+#else
+#define item_child(item) ((item)->child)
+#define item_valuestring(item) ((item)->valuestring)
+#define item_valuedouble(item) ((item)->valuedouble)
+#endif
+
 /* Delete a cJSON structure. */
 CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
 {
     cJSON *next = NULL;
+    cJSON *last_child = NULL;
     while (item != NULL)
     {
         next = item->next;
-        if (!(item->type & cJSON_IsReference) && (item->child != NULL))
+        if (!(item->type & cJSON_IsReference) && (item_child(item) != NULL))
         {
-            cJSON_Delete(item->child);
+            /* no recursion: the children are spliced in front of the remaining siblings and deleted next */
+            last_child = item->child;
+            while (last_child->next != NULL)
+            {
+                last_child = last_child->next;
+            }
+            last_child->next = next;
+            next = item->child;
         }
-        if (!(item->type & cJSON_IsReference) && (item->valuestring != NULL))
+        if (!(item->type & cJSON_IsReference) && (item_valuestring(item) != NULL))
         {
             global_hooks.deallocate(item->valuestring);
             item->valuestring = NULL;
@@ -270,7 +630,20 @@ CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
             global_hooks.deallocate(item->string);
             item->string = NULL;
         }
-        global_hooks.deallocate(item);
+        if (item->type & cJSON_ValueIsExternal)
+        {
+            drop_external(item);
+        }
+#ifdef CJSON_NODE_SLAB
+        else if (node_slabs_enabled)
+        {
+            node_deallocate(item);
+        }
+#endif
+        else
+        {
+            global_hooks.deallocate(item);
+        }
         item = next;
     }
 }
@@ -293,8 +666,26 @@ typedef struct
     size_t offset;
     size_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
     internal_hooks hooks;
+    cJSON_bool in_situ; /* strings are unescaped into content, which is writable */
+    size_t typed_min; /* numeric arrays with at least this many elements become typed arrays, 0 for never */
 } parse_buffer;
 
+/* A typed array is a single block: this header followed by count doubles or long longs. The item's valuestring points
+ * to it, so cJSON_Delete frees it like a string. */
+typedef union
+{
+    struct
+    {
+        size_t count;
+        int kind; /* cJSON_TypedDouble or cJSON_TypedInt64 */
+    } info;
+    double align_double;
+    long long align_integer;
+} typed_array;
+
+#define typed_array_doubles(array) ((double*)((array) + 1))
+#define typed_array_integers(array) ((long long*)((array) + 1))
+
 /* check if the given size is left to read in a given parse buffer (starting with 1) */
 #define can_read(buffer, size) ((buffer != NULL) && (((buffer)->offset + size) <= (buffer)->length))
 /* check if the buffer can be accessed at the given index (starting with 0) */
@@ -303,6 +694,20 @@ typedef struct
 /* get a pointer to the buffer at the position */
 #define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
 
+/* Saturate a number into the range of valueint, as items do */
+static int saturate_int(double number)
+{
+    if (number >= INT_MAX)
+    {
+        return INT_MAX;
+    }
+    if (number <= (double)INT_MIN)
+    {
+        return INT_MIN;
+    }
+    return (int)number;
+}
+
 /* Parse the input text to generate a number, and populate the result into item. */
 static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
 {
@@ -361,18 +766,7 @@ loop_end:
     item->valuedouble = number;
 
     /* use saturation in case of overflow */
-    if (number >= INT_MAX)
-    {
-        item->valueint = INT_MAX;
-    }
-    else if (number <= (double)INT_MIN)
-    {
-        item->valueint = INT_MIN;
-    }
-    else
-    {
-        item->valueint = (int)number;
-    }
+    item->valueint = saturate_int(number);
 
     item->type = cJSON_Number;
 
@@ -383,6 +777,13 @@ loop_end:
 /* don't ask me, but the original cJSON_SetNumberValue returns an integer or double */
 CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number)
 {
+#ifdef CJSON_COMPACT_NODES
+    /* valuedouble is child or valuestring of any other type */
+    if (!(object->type & cJSON_Number))
+    {
+        return number;
+    }
+#endif
     if (number >= INT_MAX)
     {
         object->valueint = INT_MAX;
@@ -549,38 +950,64 @@ static cJSON_bool compare_double(double a, double b)
     return (fabs(a - b) <= maxVal * DBL_EPSILON);
 }
 
-/* Render the number nicely from the given item into a string. */
-static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
+/* Render an integer into output without a terminator, returns the length */
+static int format_integer(long long number, unsigned char * const output)
 {
-    unsigned char *output_pointer = NULL;
-    double d = item->valuedouble;
+    unsigned char digits[20];
+    unsigned long long magnitude = (number < 0) ? (0ULL - (unsigned long long)number) : (unsigned long long)number;
+    int count = 0;
     int length = 0;
-    size_t i = 0;
-    unsigned char number_buffer[26] = {0}; /* temporary buffer to print the number into */
-    unsigned char decimal_point = get_decimal_point();
-    double test = 0.0;
 
-    if (output_buffer == NULL)
+    do
     {
-        return false;
+        digits[count++] = (unsigned char)('0' + (magnitude % 10));
+        magnitude /= 10;
+    } while (magnitude != 0);
+
+    if (number < 0)
+    {
+        output[length++] = '-';
+    }
+    while (count > 0)
+    {
+        output[length++] = digits[--count];
     }
 
+    return length;
+}
+
+/* Render a number held as valuedouble and saturated valueint into number_buffer (at least 26 bytes) with '.' as
+ * decimal point, returns the length or -1 */
+static int format_number(double d, int valueint, unsigned char * const number_buffer)
+{
+    int length = 0;
+    size_t i = 0;
+    unsigned char decimal_point = get_decimal_point();
+    double test = 0.0;
+    char *end = NULL;
+
     /* This checks for NaN and Infinity */
     if (isnan(d) || isinf(d))
     {
         length = sprintf((char*)number_buffer, "null");
     }
-	else if(d == (double)item->valueint)
+	else if(d == (double)valueint)
 	{
-		length = sprintf((char*)number_buffer, "%d", item->valueint);
+		length = format_integer(valueint, number_buffer);
 	}
+    else if ((d > -1e15) && (d < 1e15) && (d == (double)(long long)d))
+    {
+        /* whole numbers of up to 15 digits, which "%1.15g" would print the same */
+        length = format_integer((long long)d, number_buffer);
+    }
     else
     {
         /* Try 15 decimal places of precision to avoid nonsignificant nonzero digits */
         length = sprintf((char*)number_buffer, "%1.15g", d);
 
         /* Check whether the original double can be recovered */
-        if ((sscanf((char*)number_buffer, "%lg", &test) != 1) || !compare_double((double)test, d))
+        test = strtod((char*)number_buffer, &end);
+        if ((end == (char*)number_buffer) || !compare_double((double)test, d))
         {
             /* If not, print with 17 decimal places of precision */
             length = sprintf((char*)number_buffer, "%1.17g", d);
@@ -588,7 +1015,37 @@ static cJSON_bool print_number(const cJSON * const item, printbuffer * const out
     }
 
     /* sprintf failed or buffer overrun occurred */
-    if ((length < 0) || (length > (int)(sizeof(number_buffer) - 1)))
+    if ((length < 0) || (length > 25))
+    {
+        return -1;
+    }
+
+    /* replace locale dependent decimal point with '.' */
+    for (i = 0; i < ((size_t)length); i++)
+    {
+        if (number_buffer[i] == decimal_point)
+        {
+            number_buffer[i] = '.';
+        }
+    }
+
+    return length;
+}
+
+/* Render the number nicely from the given item into a string. */
+static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
+{
+    unsigned char *output_pointer = NULL;
+    int length = 0;
+    unsigned char number_buffer[26] = {0}; /* temporary buffer to print the number into */
+
+    if (output_buffer == NULL)
+    {
+        return false;
+    }
+
+    length = format_number(item->valuedouble, item->valueint, number_buffer);
+    if (length < 0)
     {
         return false;
     }
@@ -600,47 +1057,106 @@ static cJSON_bool print_number(const cJSON * const item, printbuffer * const out
         return false;
     }
 
-    /* copy the printed number to the output and replace locale
-     * dependent decimal point with '.' */
-    for (i = 0; i < ((size_t)length); i++)
-    {
-        if (number_buffer[i] == decimal_point)
-        {
-            output_pointer[i] = '.';
-            continue;
-        }
-
-        output_pointer[i] = number_buffer[i];
-    }
-    output_pointer[i] = '\0';
+    memcpy(output_pointer, number_buffer, (size_t)length);
+    output_pointer[length] = '\0';
 
     output_buffer->offset += (size_t)length;
 
     return true;
 }
 
-/* parse 4 digit hexadecimal number */
-static unsigned parse_hex4(const unsigned char * const input)
+/* Render a typed array like an array of number items */
+static cJSON_bool print_typed_array(const cJSON * const item, printbuffer * const output_buffer)
 {
-    unsigned int h = 0;
+    const typed_array *array = (const typed_array*)item->valuestring;
+    unsigned char *output_pointer = NULL;
+    const size_t separator = (size_t)(output_buffer->format ? 2 : 1);
     size_t i = 0;
+    int length = 0;
 
-    for (i = 0; i < 4; i++)
+    if (array == NULL)
     {
-        /* parse digit */
-        if ((input[i] >= '0') && (input[i] <= '9'))
-        {
-            h += (unsigned int) input[i] - '0';
-        }
-        else if ((input[i] >= 'A') && (input[i] <= 'F'))
-        {
-            h += (unsigned int) 10 + input[i] - 'A';
-        }
-        else if ((input[i] >= 'a') && (input[i] <= 'f'))
-        {
-            h += (unsigned int) 10 + input[i] - 'a';
-        }
-        else /* invalid */
+        return false;
+    }
+
+    output_pointer = ensure(output_buffer, 1);
+    if (output_pointer == NULL)
+    {
+        return false;
+    }
+    *output_pointer = '[';
+    output_buffer->offset++;
+
+    for (i = 0; i < array->info.count; i++)
+    {
+        /* room for the longest number, a separator and the closing bracket */
+        output_pointer = ensure(output_buffer, 26 + separator + 1);
+        if (output_pointer == NULL)
+        {
+            return false;
+        }
+
+        if (array->info.kind == cJSON_TypedInt64)
+        {
+            length = format_integer(typed_array_integers(array)[i], output_pointer);
+        }
+        else
+        {
+            const double number = typed_array_doubles(array)[i];
+            length = format_number(number, saturate_int(number), output_pointer);
+            if (length < 0)
+            {
+                return false;
+            }
+        }
+        output_pointer += length;
+
+        if ((i + 1) < array->info.count)
+        {
+            *output_pointer++ = ',';
+            if (output_buffer->format)
+            {
+                *output_pointer++ = ' ';
+            }
+            length += (int)separator;
+        }
+        output_buffer->offset += (size_t)length;
+    }
+
+    output_pointer = ensure(output_buffer, 2);
+    if (output_pointer == NULL)
+    {
+        return false;
+    }
+    *output_pointer++ = ']';
+    *output_pointer = '\0';
+    output_buffer->offset++;
+
+    return true;
+}
+
+/* parse 4 digit hexadecimal number */
+static unsigned parse_hex4(const unsigned char * const input)
+{
+    unsigned int h = 0;
+    size_t i = 0;
+
+    for (i = 0; i < 4; i++)
+    {
+        /* parse digit */
+        if ((input[i] >= '0') && (input[i] <= '9'))
+        {
+            h += (unsigned int) input[i] - '0';
+        }
+        else if ((input[i] >= 'A') && (input[i] <= 'F'))
+        {
+            h += (unsigned int) 10 + input[i] - 'A';
+        }
+        else if ((input[i] >= 'a') && (input[i] <= 'f'))
+        {
+            h += (unsigned int) 10 + input[i] - 'a';
+        }
+        else /* invalid */
         {
             return 0;
         }
@@ -777,6 +1293,148 @@ fail:
     return 0;
 }
 
+#if defined(CJSON_SIMD_SSE2) || defined(CJSON_SIMD_NEON)
+/* index of the lowest set bit, mask must not be 0 */
+static unsigned int first_set_bit(unsigned long long mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index = 0;
+    _BitScanForward64(&index, mask);
+    return (unsigned int)index;
+#else
+    return (unsigned int)__builtin_ctzll(mask);
+#endif
+}
+#endif
+
+/* Return the first '\"' or '\\' in [start, end), or end.
+ * Everything before it can be copied into a parsed string as is. */
+static const unsigned char *skip_unescaped(const unsigned char *start, const unsigned char * const end)
+{
+#if defined(CJSON_SIMD_AVX2)
+    const __m256i quote32 = _mm256_set1_epi8('\"');
+    const __m256i backslash32 = _mm256_set1_epi8('\\');
+    while ((end - start) >= 32)
+    {
+        const __m256i chunk = _mm256_loadu_si256((const __m256i*)(const void*)start);
+        const unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(
+            _mm256_cmpeq_epi8(chunk, quote32), _mm256_cmpeq_epi8(chunk, backslash32)));
+        if (mask != 0)
+        {
+            return start + first_set_bit(mask);
+        }
+        start += 32;
+    }
+#endif
+#if defined(CJSON_SIMD_SSE2)
+    {
+        const __m128i quote = _mm_set1_epi8('\"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        while ((end - start) >= 16)
+        {
+            const __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)start);
+            const unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(
+                _mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+            if (mask != 0)
+            {
+                return start + first_set_bit(mask);
+            }
+            start += 16;
+        }
+    }
+#elif defined(CJSON_SIMD_NEON)
+    {
+        const uint8x16_t quote = vdupq_n_u8('\"');
+        const uint8x16_t backslash = vdupq_n_u8('\\');
+        while ((end - start) >= 16)
+        {
+            const uint8x16_t chunk = vld1q_u8(start);
+            const uint8x16_t hits = vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash));
+            /* narrow to one nibble per byte */
+            const unsigned long long mask = vget_lane_u64(vreinterpret_u64_u8(
+                vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+            if (mask != 0)
+            {
+                return start + (first_set_bit(mask) >> 2);
+            }
+            start += 16;
+        }
+    }
+#endif
+    while ((start < end) && (*start != '\"') && (*start != '\\'))
+    {
+        start++;
+    }
+    return start;
+}
+
+/* Return the first byte in [start, end) that has to be escaped when printed
+ * ('\"', '\\' or a control character), or end. */
+static const unsigned char *skip_printable(const unsigned char *start, const unsigned char * const end)
+{
+#if defined(CJSON_SIMD_AVX2)
+    const __m256i quote32 = _mm256_set1_epi8('\"');
+    const __m256i backslash32 = _mm256_set1_epi8('\\');
+    const __m256i control32 = _mm256_set1_epi8(0x1F);
+    while ((end - start) >= 32)
+    {
+        const __m256i chunk = _mm256_loadu_si256((const __m256i*)(const void*)start);
+        /* unsigned chunk <= 0x1F */
+        const __m256i is_control = _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control32), control32);
+        const unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(is_control,
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote32), _mm256_cmpeq_epi8(chunk, backslash32))));
+        if (mask != 0)
+        {
+            return start + first_set_bit(mask);
+        }
+        start += 32;
+    }
+#endif
+#if defined(CJSON_SIMD_SSE2)
+    {
+        const __m128i quote = _mm_set1_epi8('\"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i control = _mm_set1_epi8(0x1F);
+        while ((end - start) >= 16)
+        {
+            const __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)start);
+            const __m128i is_control = _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control);
+            const unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(is_control,
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash))));
+            if (mask != 0)
+            {
+                return start + first_set_bit(mask);
+            }
+            start += 16;
+        }
+    }
+#elif defined(CJSON_SIMD_NEON)
+    {
+        const uint8x16_t quote = vdupq_n_u8('\"');
+        const uint8x16_t backslash = vdupq_n_u8('\\');
+        const uint8x16_t space = vdupq_n_u8(0x20);
+        while ((end - start) >= 16)
+        {
+            const uint8x16_t chunk = vld1q_u8(start);
+            const uint8x16_t hits = vorrq_u8(vcltq_u8(chunk, space),
+                vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash)));
+            const unsigned long long mask = vget_lane_u64(vreinterpret_u64_u8(
+                vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+            if (mask != 0)
+            {
+                return start + (first_set_bit(mask) >> 2);
+            }
+            start += 16;
+        }
+    }
+#endif
+    while ((start < end) && (*start > 31) && (*start != '\"') && (*start != '\\'))
+    {
+        start++;
+    }
+    return start;
+}
+
 /* Parse the input text into an unescaped cinput, and populate item. */
 static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_buffer)
 {
@@ -795,32 +1453,44 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
         /* calculate approximate size of the output (overestimate) */
         size_t allocation_length = 0;
         size_t skipped_bytes = 0;
-        while (((size_t)(input_end - input_buffer->content) < input_buffer->length) && (*input_end != '\"'))
+        const unsigned char * const buffer_end = input_buffer->content + input_buffer->length;
+        for (;;)
         {
+            /* skip runs of plain characters at once */
+            input_end = skip_unescaped(input_end, buffer_end);
+            if ((input_end >= buffer_end) || (*input_end == '\"'))
+            {
+                break;
+            }
             /* is escape sequence */
-            if (input_end[0] == '\\')
+            if ((input_end + 1) >= buffer_end)
             {
-                if ((size_t)(input_end + 1 - input_buffer->content) >= input_buffer->length)
-                {
-                    /* prevent buffer overflow when last input character is a backslash */
-                    goto fail;
-                }
-                skipped_bytes++;
-                input_end++;
+                /* prevent buffer overflow when last input character is a backslash */
+                goto fail;
             }
-            input_end++;
+            skipped_bytes++;
+            input_end += 2;
         }
-        if (((size_t)(input_end - input_buffer->content) >= input_buffer->length) || (*input_end != '\"'))
+        if (input_end >= buffer_end)
         {
             goto fail; /* string ended unexpectedly */
         }
 
-        /* This is at most how much we need for the output */
-        allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
-        output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
-        if (output == NULL)
+        if (input_buffer->in_situ)
         {
-            goto fail; /* allocation failure */
+            /* unescaping never grows the string, so it fits where it came from,
+             * terminated at the latest on the closing quote */
+            output = (unsigned char*)(size_t)input_pointer;
+        }
+        else
+        {
+            /* This is at most how much we need for the output */
+            allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
+            output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
+            if (output == NULL)
+            {
+                goto fail; /* allocation failure */
+            }
         }
     }
 
@@ -828,12 +1498,15 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     /* loop through the string literal */
     while (input_pointer < input_end)
     {
-        if (*input_pointer != '\\')
-        {
-            *output_pointer++ = *input_pointer++;
-        }
+        /* copy runs of plain characters at once */
+        const unsigned char *run_end = skip_unescaped(input_pointer, input_end);
+        /* in situ the output trails the input in the same buffer */
+        memmove(output_pointer, input_pointer, (size_t)(run_end - input_pointer));
+        output_pointer += run_end - input_pointer;
+        input_pointer = run_end;
+
         /* escape sequence */
-        else
+        if (input_pointer < input_end)
         {
             unsigned char sequence_length = 2;
             if ((input_end - input_pointer) < 1)
@@ -884,7 +1557,8 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     /* zero terminate the output */
     *output_pointer = '\0';
 
-    item->type = cJSON_String;
+    /* in situ strings are owned by the input buffer */
+    item->type = input_buffer->in_situ ? (cJSON_String | cJSON_IsReference) : cJSON_String;
     item->valuestring = (char*)output;
 
     input_buffer->offset = (size_t) (input_end - input_buffer->content);
@@ -893,7 +1567,7 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     return true;
 
 fail:
-    if (output != NULL)
+    if ((output != NULL) && !input_buffer->in_situ)
     {
         input_buffer->hooks.deallocate(output);
         output = NULL;
@@ -911,6 +1585,7 @@ fail:
 static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffer * const output_buffer)
 {
     const unsigned char *input_pointer = NULL;
+    const unsigned char *input_end = NULL;
     unsigned char *output = NULL;
     unsigned char *output_pointer = NULL;
     size_t output_length = 0;
@@ -936,7 +1611,9 @@ static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffe
     }
 
     /* set "flag" to 1 if something needs to be escaped */
-    for (input_pointer = input; *input_pointer; input_pointer++)
+    input_end = input + strlen((const char*)input);
+    for (input_pointer = skip_printable(input, input_end); input_pointer < input_end;
+         input_pointer = skip_printable(input_pointer + 1, input_end))
     {
         switch (*input_pointer)
         {
@@ -959,7 +1636,7 @@ static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffe
                 break;
         }
     }
-    output_length = (size_t)(input_pointer - input) + escape_characters;
+    output_length = (size_t)(input_end - input) + escape_characters;
 
     output = ensure(output_buffer, output_length + sizeof("\"\""));
     if (output == NULL)
@@ -981,46 +1658,48 @@ static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffe
     output[0] = '\"';
     output_pointer = output + 1;
     /* copy the string */
-    for (input_pointer = input; *input_pointer != '\0'; (void)input_pointer++, output_pointer++)
-    {
-        if ((*input_pointer > 31) && (*input_pointer != '\"') && (*input_pointer != '\\'))
+    for (input_pointer = input; input_pointer < input_end; (void)input_pointer++, output_pointer++)
+    {
+        /* copy runs of normal characters at once */
+        const unsigned char *run_end = skip_printable(input_pointer, input_end);
+        memcpy(output_pointer, input_pointer, (size_t)(run_end - input_pointer));
+        output_pointer += run_end - input_pointer;
+        input_pointer = run_end;
+        if (input_pointer == input_end)
         {
-            /* normal character, copy */
-            *output_pointer = *input_pointer;
+            break;
         }
-        else
+
+        /* character needs to be escaped */
+        *output_pointer++ = '\\';
+        switch (*input_pointer)
         {
-            /* character needs to be escaped */
-            *output_pointer++ = '\\';
-            switch (*input_pointer)
-            {
-                case '\\':
-                    *output_pointer = '\\';
-                    break;
-                case '\"':
-                    *output_pointer = '\"';
-                    break;
-                case '\b':
-                    *output_pointer = 'b';
-                    break;
-                case '\f':
-                    *output_pointer = 'f';
-                    break;
-                case '\n':
-                    *output_pointer = 'n';
-                    break;
-                case '\r':
-                    *output_pointer = 'r';
-                    break;
-                case '\t':
-                    *output_pointer = 't';
-                    break;
-                default:
-                    /* escape and print as unicode codepoint */
-                    sprintf((char*)output_pointer, "u%04x", *input_pointer);
-                    output_pointer += 4;
-                    break;
-            }
+            case '\\':
+                *output_pointer = '\\';
+                break;
+            case '\"':
+                *output_pointer = '\"';
+                break;
+            case '\b':
+                *output_pointer = 'b';
+                break;
+            case '\f':
+                *output_pointer = 'f';
+                break;
+            case '\n':
+                *output_pointer = 'n';
+                break;
+            case '\r':
+                *output_pointer = 'r';
+                break;
+            case '\t':
+                *output_pointer = 't';
+                break;
+            default:
+                /* escape and print as unicode codepoint */
+                sprintf((char*)output_pointer, "u%04x", *input_pointer);
+                output_pointer += 4;
+                break;
         }
     }
     output[output_length + 1] = '\"';
@@ -1037,11 +1716,73 @@ static cJSON_bool print_string(const cJSON * const item, printbuffer * const p)
 
 /* Predeclare these prototypes. */
 static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON *parse_with_length_opts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated, cJSON_bool in_situ, size_t typed_min);
 static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer);
-static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer);
-static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer);
+static void* cast_away_const(const void* string);
+
+/* Arrays and objects are parsed and printed with an explicit stack of the open ones instead of recursion,
+ * so the C stack use does not depend on how deeply a document nests. */
+#define NESTING_INLINE_FRAMES 16
+
+typedef struct
+{
+    cJSON *container;
+    cJSON *child; /* parsing: the last child so far, printing: the child being printed */
+} nesting_frame;
+
+typedef struct
+{
+    nesting_frame *frames;
+    size_t depth;
+    size_t capacity;
+    const internal_hooks *hooks;
+    nesting_frame inline_frames[NESTING_INLINE_FRAMES];
+} nesting_stack;
+
+static void nesting_init(nesting_stack * const stack, const internal_hooks * const hooks)
+{
+    stack->frames = stack->inline_frames;
+    stack->depth = 0;
+    stack->capacity = NESTING_INLINE_FRAMES;
+    stack->hooks = hooks;
+}
+
+static void nesting_free(nesting_stack * const stack)
+{
+    if (stack->frames != stack->inline_frames)
+    {
+        stack->hooks->deallocate(stack->frames);
+    }
+    stack->frames = NULL;
+}
+
+/* returns the new top frame, or NULL if growing the stack failed */
+static nesting_frame *nesting_push(nesting_stack * const stack, cJSON * const container, cJSON * const child)
+{
+    nesting_frame *frame = NULL;
+
+    if (stack->depth == stack->capacity)
+    {
+        nesting_frame *frames = (nesting_frame*)stack->hooks->allocate(2 * stack->capacity * sizeof(nesting_frame));
+        if (frames == NULL)
+        {
+            return NULL;
+        }
+        memcpy(frames, stack->frames, stack->depth * sizeof(nesting_frame));
+        if (stack->frames != stack->inline_frames)
+        {
+            stack->hooks->deallocate(stack->frames);
+        }
+        stack->frames = frames;
+        stack->capacity *= 2;
+    }
+
+    frame = &stack->frames[stack->depth++];
+    frame->container = container;
+    frame->child = child;
+
+    return frame;
+}
 
 /* Utility to jump whitespace and cr/lf */
 static parse_buffer *buffer_skip_whitespace(parse_buffer * const buffer)
@@ -1103,7 +1844,27 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return
 /* Parse an object - create a new root, and populate. */
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
+    return parse_with_length_opts(value, buffer_length, return_parse_end, require_null_terminated, false, 0);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *value, size_t buffer_length)
+{
+    return parse_with_length_opts(value, buffer_length, NULL, false, true, 0);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthTyped(const char *value, size_t buffer_length, size_t typed_min)
+{
+    return parse_with_length_opts(value, buffer_length, NULL, false, false, typed_min);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSituTyped(char *value, size_t buffer_length, size_t typed_min)
+{
+    return parse_with_length_opts(value, buffer_length, NULL, false, true, typed_min);
+}
+
+static cJSON *parse_with_length_opts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated, cJSON_bool in_situ, size_t typed_min)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 }, 0, 0 };
     cJSON *item = NULL;
 
     /* reset error position */
@@ -1119,6 +1880,8 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
     buffer.length = buffer_length;
     buffer.offset = 0;
     buffer.hooks = global_hooks;
+    buffer.in_situ = in_situ;
+    buffer.typed_min = typed_min;
 
     item = cJSON_New_Item(&global_hooks);
     if (item == NULL) /* memory fail */
@@ -1321,14 +2084,9 @@ CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, cons
     return print_value(item, &p);
 }
 
-/* Parser core - when encountering text, process appropriately. */
-static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer)
+/* Parse null, false, true, a string or a number; arrays and objects are left to parse_value. */
+static cJSON_bool parse_scalar(cJSON * const item, parse_buffer * const input_buffer)
 {
-    if ((input_buffer == NULL) || (input_buffer->content == NULL))
-    {
-        return false; /* no input */
-    }
-
     /* parse the different types of values */
     /* null */
     if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "null", 4) == 0))
@@ -1362,385 +2120,434 @@ static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buf
     {
         return parse_number(item, input_buffer);
     }
-    /* array */
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '['))
+    return false;
+}
+
+/* Grow a typed array being parsed to hold at least one more element; frees it and returns NULL on failure */
+static typed_array *typed_array_grow(typed_array *array, size_t * const capacity, const internal_hooks * const hooks)
+{
+    const size_t new_capacity = (*capacity == 0) ? 16 : (*capacity * 2);
+    typed_array *new_array = NULL;
+
+    if (new_capacity > ((((size_t)-1) - sizeof(typed_array)) / sizeof(double)))
     {
-        return parse_array(item, input_buffer);
+        hooks->deallocate(array);
+        return NULL;
     }
-    /* object */
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '{'))
+    new_array = (typed_array*)hooks->allocate(sizeof(typed_array) + (new_capacity * sizeof(double)));
+    if (new_array != NULL)
     {
-        return parse_object(item, input_buffer);
+        memcpy(new_array, array, sizeof(typed_array) + (*capacity * sizeof(double)));
+        *capacity = new_capacity;
     }
-
-    return false;
+    hooks->deallocate(array);
+    return new_array;
 }
 
-/* Render a value to text. */
-static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer)
+/* Parse the array at the current offset into a typed array if it holds at least typed_min numbers and nothing else.
+ * Otherwise, also for malformed input, the offset is left alone and the regular parser takes over, so errors are
+ * reported exactly as without typed arrays. */
+static cJSON_bool parse_typed_array(cJSON * const item, parse_buffer * const input_buffer)
 {
-    unsigned char *output = NULL;
+    const size_t start = input_buffer->offset;
+    typed_array *array = NULL;
+    size_t capacity = 0;
+    size_t count = 0;
+    int kind = cJSON_TypedInt64;
 
-    if ((item == NULL) || (output_buffer == NULL))
+    array = (typed_array*)input_buffer->hooks.allocate(sizeof(typed_array));
+    if (array == NULL)
     {
         return false;
     }
 
-    switch ((item->type) & 0xFF)
+    input_buffer->offset++;
+    buffer_skip_whitespace(input_buffer);
+    for (;;)
     {
-        case cJSON_NULL:
-            output = ensure(output_buffer, 5);
-            if (output == NULL)
+        const unsigned char *number = buffer_at_offset(input_buffer);
+        unsigned long long magnitude = 0;
+        size_t digits = 0;
+        size_t length = 0;
+        cJSON_bool integral = true;
+        double value = 0;
+
+        if (cannot_access_at_index(input_buffer, 0) || !((number[0] == '-') || ((number[0] >= '0') && (number[0] <= '9'))))
+        {
+            goto rollback;
+        }
+
+        /* measure the characters parse_number would hand to strtod, collecting integers on the way */
+        for (length = 0; (length < 63) && can_access_at_index(input_buffer, length); length++)
+        {
+            if ((number[length] >= '0') && (number[length] <= '9'))
             {
-                return false;
+                if (digits < 18)
+                {
+                    magnitude = (magnitude * 10) + (unsigned long long)(number[length] - '0');
+                }
+                digits++;
             }
-            strcpy((char*)output, "null");
-            return true;
-
-        case cJSON_False:
-            output = ensure(output_buffer, 6);
-            if (output == NULL)
+            else if ((number[length] == '-') && (length == 0))
             {
-                return false;
+                continue;
             }
-            strcpy((char*)output, "false");
-            return true;
-
-        case cJSON_True:
-            output = ensure(output_buffer, 5);
-            if (output == NULL)
+            else if ((number[length] == '+') || (number[length] == '-') || (number[length] == 'e') || (number[length] == 'E') || (number[length] == '.'))
             {
-                return false;
+                integral = false;
             }
-            strcpy((char*)output, "true");
-            return true;
-
-        case cJSON_Number:
-            return print_number(item, output_buffer);
+            else
+            {
+                break;
+            }
+        }
 
-        case cJSON_Raw:
+        if (integral && (digits > 0) && (digits <= 18) && (length < 63))
         {
-            size_t raw_length = 0;
-            if (item->valuestring == NULL)
+            const long long integer = (number[0] == '-') ? -(long long)magnitude : (long long)magnitude;
+            input_buffer->offset += length;
+            value = (double)integer;
+            if (count == capacity)
             {
-                return false;
+                array = typed_array_grow(array, &capacity, &input_buffer->hooks);
+                if (array == NULL)
+                {
+                    goto rollback;
+                }
             }
-
-            raw_length = strlen(item->valuestring) + sizeof("");
-            output = ensure(output_buffer, raw_length);
-            if (output == NULL)
+            if (kind == cJSON_TypedInt64)
             {
-                return false;
+                typed_array_integers(array)[count++] = integer;
+            }
+            else
+            {
+                typed_array_doubles(array)[count++] = value;
             }
-            memcpy(output, item->valuestring, raw_length);
-            return true;
-        }
-
-        case cJSON_String:
-            return print_string(item, output_buffer);
-
-        case cJSON_Array:
-            return print_array(item, output_buffer);
-
-        case cJSON_Object:
-            return print_object(item, output_buffer);
-
-        default:
-            return false;
-    }
-}
-
-/* Build an array from input text. */
-static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer)
-{
-    cJSON *head = NULL; /* head of the linked list */
-    cJSON *current_item = NULL;
-
-    if (input_buffer->depth >= CJSON_NESTING_LIMIT)
-    {
-        return false; /* to deeply nested */
-    }
-    input_buffer->depth++;
-
-    if (buffer_at_offset(input_buffer)[0] != '[')
-    {
-        /* not an array */
-        goto fail;
-    }
-
-    input_buffer->offset++;
-    buffer_skip_whitespace(input_buffer);
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ']'))
-    {
-        /* empty array */
-        goto success;
-    }
-
-    /* check if we skipped to the end of the buffer */
-    if (cannot_access_at_index(input_buffer, 0))
-    {
-        input_buffer->offset--;
-        goto fail;
-    }
-
-    /* step back to character in front of the first element */
-    input_buffer->offset--;
-    /* loop through the comma separated array elements */
-    do
-    {
-        /* allocate next item */
-        cJSON *new_item = cJSON_New_Item(&(input_buffer->hooks));
-        if (new_item == NULL)
-        {
-            goto fail; /* allocation failure */
-        }
-
-        /* attach next item to list */
-        if (head == NULL)
-        {
-            /* start the linked list */
-            current_item = head = new_item;
         }
         else
         {
-            /* add to the end and advance */
-            current_item->next = new_item;
-            new_item->prev = current_item;
-            current_item = new_item;
+            cJSON parsed;
+            size_t i = 0;
+
+            if (!parse_number(&parsed, input_buffer))
+            {
+                goto rollback;
+            }
+            if (count == capacity)
+            {
+                array = typed_array_grow(array, &capacity, &input_buffer->hooks);
+                if (array == NULL)
+                {
+                    goto rollback;
+                }
+            }
+            if (kind == cJSON_TypedInt64)
+            {
+                /* the first fraction turns the integers parsed so far into doubles, in place */
+                for (i = 0; i < count; i++)
+                {
+                    typed_array_doubles(array)[i] = (double)typed_array_integers(array)[i];
+                }
+                kind = cJSON_TypedDouble;
+            }
+            typed_array_doubles(array)[count++] = parsed.valuedouble;
         }
 
-        /* parse next value */
-        input_buffer->offset++;
         buffer_skip_whitespace(input_buffer);
-        if (!parse_value(current_item, input_buffer))
+        if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','))
         {
-            goto fail; /* failed to parse value */
+            input_buffer->offset++;
+            buffer_skip_whitespace(input_buffer);
+            continue;
         }
-        buffer_skip_whitespace(input_buffer);
+        if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ']'))
+        {
+            input_buffer->offset++;
+            break;
+        }
+        goto rollback;
     }
-    while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
 
-    if (cannot_access_at_index(input_buffer, 0) || buffer_at_offset(input_buffer)[0] != ']')
+    if (count < input_buffer->typed_min)
     {
-        goto fail; /* expected end of array */
+        goto rollback;
     }
 
-success:
-    input_buffer->depth--;
-
-    if (head != NULL) {
-        head->prev = current_item;
+    /* give back what the doubling left unused */
+    if ((input_buffer->hooks.reallocate != NULL) && (count < capacity))
+    {
+        typed_array *shrunk = (typed_array*)input_buffer->hooks.reallocate(array, sizeof(typed_array) + (count * sizeof(double)));
+        if (shrunk != NULL)
+        {
+            array = shrunk;
+        }
     }
-
-    item->type = cJSON_Array;
-    item->child = head;
-
-    input_buffer->offset++;
-
+    array->info.count = count;
+    array->info.kind = kind;
+    item->type = cJSON_TypedArray;
+    item->valuestring = (char*)array;
     return true;
 
-fail:
-    if (head != NULL)
+rollback:
+    if (array != NULL)
     {
-        cJSON_Delete(head);
+        input_buffer->hooks.deallocate(array);
     }
-
+    input_buffer->offset = start;
     return false;
 }
 
-/* Render an array to text */
-static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer)
+/* Parser core - when encountering text, process appropriately. */
+static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer)
 {
-    unsigned char *output_pointer = NULL;
-    size_t length = 0;
-    cJSON *current_element = item->child;
+    nesting_stack stack;
+    nesting_frame *frame = NULL;
+    cJSON *current_item = item;
+    cJSON_bool success = false;
+    int const_name = 0;
 
-    if (output_buffer == NULL)
+    if ((input_buffer == NULL) || (input_buffer->content == NULL))
     {
-        return false;
+        return false; /* no input */
     }
 
-    /* Compose the output array. */
-    /* opening square bracket */
-    output_pointer = ensure(output_buffer, 1);
-    if (output_pointer == NULL)
+    nesting_init(&stack, &input_buffer->hooks);
+    for (;;)
     {
-        return false;
-    }
-
-    *output_pointer = '[';
-    output_buffer->offset++;
-    output_buffer->depth++;
+        /* the name of an in situ parsed member stays flagged when its value replaces the type */
+        const_name = current_item->type & cJSON_StringIsConst;
 
-    while (current_element != NULL)
-    {
-        if (!print_value(current_element, output_buffer))
+        if ((input_buffer->typed_min > 0) && (input_buffer->depth < CJSON_NESTING_LIMIT) && can_access_at_index(input_buffer, 0)
+            && (buffer_at_offset(input_buffer)[0] == '[') && parse_typed_array(current_item, input_buffer))
         {
-            return false;
+            /* an array of numbers, stored contiguously */
+            current_item->type |= const_name;
         }
-        update_offset(output_buffer);
-        if (current_element->next)
+        else if (can_access_at_index(input_buffer, 0) && ((buffer_at_offset(input_buffer)[0] == '[') || (buffer_at_offset(input_buffer)[0] == '{')))
         {
-            length = (size_t) (output_buffer->format ? 2 : 1);
-            output_pointer = ensure(output_buffer, length + 1);
-            if (output_pointer == NULL)
+            /* open an array or object; it is linked into the tree right away so that failing deletes it with the root */
+            if (input_buffer->depth >= CJSON_NESTING_LIMIT)
             {
-                return false;
+                goto fail; /* to deeply nested */
             }
-            *output_pointer++ = ',';
-            if(output_buffer->format)
+            input_buffer->depth++;
+
+            current_item->type = ((buffer_at_offset(input_buffer)[0] == '[') ? cJSON_Array : cJSON_Object) | const_name;
+            frame = nesting_push(&stack, current_item, NULL);
+            if (frame == NULL)
             {
-                *output_pointer++ = ' ';
+                goto fail; /* allocation failure */
             }
-            *output_pointer = '\0';
-            output_buffer->offset += length;
-        }
-        current_element = current_element->next;
-    }
-
-    output_pointer = ensure(output_buffer, 2);
-    if (output_pointer == NULL)
-    {
-        return false;
-    }
-    *output_pointer++ = ']';
-    *output_pointer = '\0';
-    output_buffer->depth--;
 
-    return true;
-}
+            input_buffer->offset++;
+            buffer_skip_whitespace(input_buffer);
+            if (!(can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == (cJSON_IsArray(current_item) ? ']' : '}'))))
+            {
+                /* check if we skipped to the end of the buffer */
+                if (cannot_access_at_index(input_buffer, 0))
+                {
+                    input_buffer->offset--;
+                    goto fail;
+                }
 
-/* Build an object from the text. */
-static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer)
-{
-    cJSON *head = NULL; /* linked list head */
-    cJSON *current_item = NULL;
+                /* step back to character in front of the first element */
+                input_buffer->offset--;
+                goto next_element;
+            }
 
-    if (input_buffer->depth >= CJSON_NESTING_LIMIT)
-    {
-        return false; /* to deeply nested */
-    }
-    input_buffer->depth++;
+            /* empty array or object */
+            stack.depth--;
+            input_buffer->depth--;
+            input_buffer->offset++;
+        }
+        else
+        {
+            if (!parse_scalar(current_item, input_buffer))
+            {
+                goto fail;
+            }
+            current_item->type |= const_name;
+        }
 
-    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '{'))
-    {
-        goto fail; /* not an object */
-    }
+        /* a value is complete, continue in the innermost open array or object, closing those that end here */
+        for (;;)
+        {
+            if (stack.depth == 0)
+            {
+                success = true;
+                goto end;
+            }
+            frame = &stack.frames[stack.depth - 1];
 
-    input_buffer->offset++;
-    buffer_skip_whitespace(input_buffer);
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '}'))
-    {
-        goto success; /* empty object */
-    }
+            buffer_skip_whitespace(input_buffer);
+            if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','))
+            {
+                break;
+            }
+            if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != (cJSON_IsArray(frame->container) ? ']' : '}')))
+            {
+                goto fail; /* expected end of array or object */
+            }
 
-    /* check if we skipped to the end of the buffer */
-    if (cannot_access_at_index(input_buffer, 0))
-    {
-        input_buffer->offset--;
-        goto fail;
-    }
+            stack.depth--;
+            input_buffer->depth--;
+            input_buffer->offset++;
+        }
 
-    /* step back to character in front of the first element */
-    input_buffer->offset--;
-    /* loop through the comma separated array elements */
-    do
-    {
-        /* allocate next item */
-        cJSON *new_item = cJSON_New_Item(&(input_buffer->hooks));
-        if (new_item == NULL)
+next_element:
+        /* allocate the next element and add it to the end of the list */
+        frame = &stack.frames[stack.depth - 1];
+        current_item = cJSON_New_Item(&(input_buffer->hooks));
+        if (current_item == NULL)
         {
             goto fail; /* allocation failure */
         }
-
-        /* attach next item to list */
-        if (head == NULL)
+        if (frame->child == NULL)
         {
-            /* start the linked list */
-            current_item = head = new_item;
+            frame->container->child = current_item;
         }
         else
         {
-            /* add to the end and advance */
-            current_item->next = new_item;
-            new_item->prev = current_item;
-            current_item = new_item;
+            frame->child->next = current_item;
+            current_item->prev = frame->child;
         }
+        frame->container->child->prev = current_item;
+        frame->child = current_item;
 
-        if (cannot_access_at_index(input_buffer, 1))
+        if (cJSON_IsObject(frame->container))
         {
-            goto fail; /* nothing comes after the comma */
-        }
+            if (cannot_access_at_index(input_buffer, 1))
+            {
+                goto fail; /* nothing comes after the comma */
+            }
 
-        /* parse the name of the child */
-        input_buffer->offset++;
-        buffer_skip_whitespace(input_buffer);
-        if (!parse_string(current_item, input_buffer))
-        {
-            goto fail; /* failed to parse name */
-        }
-        buffer_skip_whitespace(input_buffer);
+            /* parse the name of the child */
+            input_buffer->offset++;
+            buffer_skip_whitespace(input_buffer);
+            if (!parse_string(current_item, input_buffer))
+            {
+                goto fail; /* failed to parse name */
+            }
+            buffer_skip_whitespace(input_buffer);
 
-        /* swap valuestring and string, because we parsed the name */
-        current_item->string = current_item->valuestring;
-        current_item->valuestring = NULL;
+            /* swap valuestring and string, because we parsed the name */
+            current_item->string = current_item->valuestring;
+            current_item->valuestring = NULL;
+            if (input_buffer->in_situ)
+            {
+                /* the name lives in the input buffer */
+                current_item->type |= cJSON_StringIsConst;
+            }
 
-        if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
-        {
-            goto fail; /* invalid object */
+            if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
+            {
+                goto fail; /* invalid object */
+            }
         }
 
-        /* parse the value */
+        /* the value follows the comma, the ':' or the opening bracket */
         input_buffer->offset++;
         buffer_skip_whitespace(input_buffer);
-        if (!parse_value(current_item, input_buffer))
-        {
-            goto fail; /* failed to parse value */
-        }
-        buffer_skip_whitespace(input_buffer);
     }
-    while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
 
-    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '}'))
+fail:
+    success = false;
+
+end:
+    nesting_free(&stack);
+
+    return success;
+}
+
+/* Render null, false, true, a number, raw JSON or a string; arrays and objects are left to print_value. */
+static cJSON_bool print_scalar(const cJSON * const item, printbuffer * const output_buffer)
+{
+    unsigned char *output = NULL;
+
+    if (item->type & cJSON_TypedArray)
     {
-        goto fail; /* expected end of object */
+        return print_typed_array(item, output_buffer);
     }
 
-success:
-    input_buffer->depth--;
+    switch ((item->type) & 0xFF)
+    {
+        case cJSON_NULL:
+            output = ensure(output_buffer, 5);
+            if (output == NULL)
+            {
+                return false;
+            }
+            strcpy((char*)output, "null");
+            return true;
 
-    if (head != NULL) {
-        head->prev = current_item;
-    }
+        case cJSON_False:
+            output = ensure(output_buffer, 6);
+            if (output == NULL)
+            {
+                return false;
+            }
+            strcpy((char*)output, "false");
+            return true;
 
-    item->type = cJSON_Object;
-    item->child = head;
+        case cJSON_True:
+            output = ensure(output_buffer, 5);
+            if (output == NULL)
+            {
+                return false;
+            }
+            strcpy((char*)output, "true");
+            return true;
 
-    input_buffer->offset++;
-    return true;
+        case cJSON_Number:
+            return print_number(item, output_buffer);
 
-fail:
-    if (head != NULL)
-    {
-        cJSON_Delete(head);
-    }
+        case cJSON_Raw:
+        {
+            size_t raw_length = 0;
+            if (item->valuestring == NULL)
+            {
+                return false;
+            }
 
-    return false;
+            raw_length = strlen(item->valuestring) + sizeof("");
+            output = ensure(output_buffer, raw_length);
+            if (output == NULL)
+            {
+                return false;
+            }
+            memcpy(output, item->valuestring, raw_length);
+            return true;
+        }
+
+        case cJSON_String:
+            return print_string(item, output_buffer);
+
+        default:
+            return false;
+    }
 }
 
-/* Render an object to text. */
-static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer)
+/* Render the opening bracket of an array or object */
+static cJSON_bool print_container_start(const cJSON * const item, printbuffer * const output_buffer)
 {
     unsigned char *output_pointer = NULL;
     size_t length = 0;
-    cJSON *current_item = item->child;
 
-    if (output_buffer == NULL)
+    if (cJSON_IsArray(item))
     {
-        return false;
+        output_pointer = ensure(output_buffer, 1);
+        if (output_pointer == NULL)
+        {
+            return false;
+        }
+
+        *output_pointer = '[';
+        output_buffer->offset++;
+        output_buffer->depth++;
+
+        return true;
     }
 
-    /* Compose the output: */
     length = (size_t) (output_buffer->format ? 2 : 1); /* fmt: {\n */
     output_pointer = ensure(output_buffer, length + 1);
     if (output_pointer == NULL)
@@ -1756,70 +2563,120 @@ static cJSON_bool print_object(const cJSON * const item, printbuffer * const out
     }
     output_buffer->offset += length;
 
-    while (current_item)
+    return true;
+}
+
+/* Render the indentation and key in front of an object member's value */
+static cJSON_bool print_member_name(const cJSON * const item, printbuffer * const output_buffer)
+{
+    unsigned char *output_pointer = NULL;
+    size_t length = 0;
+
+    if (output_buffer->format)
+    {
+        size_t i;
+        output_pointer = ensure(output_buffer, output_buffer->depth);
+        if (output_pointer == NULL)
+        {
+            return false;
+        }
+        for (i = 0; i < output_buffer->depth; i++)
+        {
+            *output_pointer++ = '\t';
+        }
+        output_buffer->offset += output_buffer->depth;
+    }
+
+    /* print key */
+    if (!print_string_ptr((unsigned char*)item->string, output_buffer))
+    {
+        return false;
+    }
+    update_offset(output_buffer);
+
+    length = (size_t) (output_buffer->format ? 2 : 1);
+    output_pointer = ensure(output_buffer, length);
+    if (output_pointer == NULL)
+    {
+        return false;
+    }
+    *output_pointer++ = ':';
+    if (output_buffer->format)
+    {
+        *output_pointer++ = '\t';
+    }
+    output_buffer->offset += length;
+
+    return true;
+}
+
+/* Render what follows an element: a comma if it is not the last, and a newline for formatted object members */
+static cJSON_bool print_separator(const cJSON * const container, const cJSON * const item, printbuffer * const output_buffer)
+{
+    unsigned char *output_pointer = NULL;
+    size_t length = 0;
+
+    if (cJSON_IsArray(container))
     {
-        if (output_buffer->format)
+        if (item->next)
         {
-            size_t i;
-            output_pointer = ensure(output_buffer, output_buffer->depth);
+            length = (size_t) (output_buffer->format ? 2 : 1);
+            output_pointer = ensure(output_buffer, length + 1);
             if (output_pointer == NULL)
             {
                 return false;
             }
-            for (i = 0; i < output_buffer->depth; i++)
+            *output_pointer++ = ',';
+            if(output_buffer->format)
             {
-                *output_pointer++ = '\t';
+                *output_pointer++ = ' ';
             }
-            output_buffer->offset += output_buffer->depth;
+            *output_pointer = '\0';
+            output_buffer->offset += length;
         }
 
-        /* print key */
-        if (!print_string_ptr((unsigned char*)current_item->string, output_buffer))
-        {
-            return false;
-        }
-        update_offset(output_buffer);
+        return true;
+    }
+
+    /* print comma if not last */
+    length = ((size_t)(output_buffer->format ? 1 : 0) + (size_t)(item->next ? 1 : 0));
+    output_pointer = ensure(output_buffer, length + 1);
+    if (output_pointer == NULL)
+    {
+        return false;
+    }
+    if (item->next)
+    {
+        *output_pointer++ = ',';
+    }
+
+    if (output_buffer->format)
+    {
+        *output_pointer++ = '\n';
+    }
+    *output_pointer = '\0';
+    output_buffer->offset += length;
 
-        length = (size_t) (output_buffer->format ? 2 : 1);
-        output_pointer = ensure(output_buffer, length);
-        if (output_pointer == NULL)
-        {
-            return false;
-        }
-        *output_pointer++ = ':';
-        if (output_buffer->format)
-        {
-            *output_pointer++ = '\t';
-        }
-        output_buffer->offset += length;
+    return true;
+}
 
-        /* print value */
-        if (!print_value(current_item, output_buffer))
-        {
-            return false;
-        }
-        update_offset(output_buffer);
+/* Render the closing bracket of an array or object */
+static cJSON_bool print_container_end(const cJSON * const item, printbuffer * const output_buffer)
+{
+    unsigned char *output_pointer = NULL;
 
-        /* print comma if not last */
-        length = ((size_t)(output_buffer->format ? 1 : 0) + (size_t)(current_item->next ? 1 : 0));
-        output_pointer = ensure(output_buffer, length + 1);
+    if (cJSON_IsArray(item))
+    {
+        output_pointer = ensure(output_buffer, 2);
         if (output_pointer == NULL)
         {
             return false;
         }
-        if (current_item->next)
-        {
-            *output_pointer++ = ',';
-        }
-
-        if (output_buffer->format)
-        {
-            *output_pointer++ = '\n';
-        }
+        *output_pointer++ = ']';
         *output_pointer = '\0';
-        output_buffer->offset += length;
+        output_buffer->depth--;
 
-        current_item = current_item->next;
+        return true;
     }
 
     output_pointer = ensure(output_buffer, output_buffer->format ? (output_buffer->depth + 1) : 2);
@@ -1842,6 +2699,93 @@ static cJSON_bool print_object(const cJSON * const item, printbuffer * const out
     return true;
 }
 
+/* Render a value to text. */
+static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer)
+{
+    nesting_stack stack;
+    nesting_frame *frame = NULL;
+    cJSON *current_item = (cJSON*)cast_away_const(item);
+    cJSON_bool success = false;
+
+    if ((item == NULL) || (output_buffer == NULL))
+    {
+        return false;
+    }
+
+    nesting_init(&stack, &output_buffer->hooks);
+    for (;;)
+    {
+        if (cJSON_IsArray(current_item) || cJSON_IsObject(current_item))
+        {
+            if (!print_container_start(current_item, output_buffer))
+            {
+                goto end;
+            }
+            if (current_item->child != NULL)
+            {
+                /* descend into the first element */
+                if (nesting_push(&stack, current_item, current_item->child) == NULL)
+                {
+                    goto end;
+                }
+                current_item = current_item->child;
+                if (cJSON_IsObject(stack.frames[stack.depth - 1].container) && !print_member_name(current_item, output_buffer))
+                {
+                    goto end;
+                }
+                continue;
+            }
+            if (!print_container_end(current_item, output_buffer))
+            {
+                goto end;
+            }
+        }
+        else if (!print_scalar(current_item, output_buffer))
+        {
+            goto end;
+        }
+
+        /* a value is complete, move on to its next sibling, closing the arrays and objects that end here */
+        for (;;)
+        {
+            if (stack.depth == 0)
+            {
+                success = true;
+                goto end;
+            }
+            frame = &stack.frames[stack.depth - 1];
+
+            update_offset(output_buffer);
+            if (!print_separator(frame->container, frame->child, output_buffer))
+            {
+                goto end;
+            }
+            if (frame->child->next != NULL)
+            {
+                break;
+            }
+
+            stack.depth--;
+            if (!print_container_end(frame->container, output_buffer))
+            {
+                goto end;
+            }
+        }
+
+        frame->child = frame->child->next;
+        current_item = frame->child;
+        if (cJSON_IsObject(frame->container) && !print_member_name(current_item, output_buffer))
+        {
+            goto end;
+        }
+    }
+
+end:
+    nesting_free(&stack);
+
+    return success;
+}
+
 /* Get Array size/item / object item. */
 CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array)
 {
@@ -1853,7 +2797,7 @@ CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array)
         return 0;
     }
 
-    child = array->child;
+    child = item_child(array);
 
     while(child != NULL)
     {
@@ -1875,7 +2819,7 @@ static cJSON* get_array_item(const cJSON *array, size_t index)
         return NULL;
     }
 
-    current_child = array->child;
+    current_child = item_child(array);
     while ((current_child != NULL) && (index > 0))
     {
         index--;
@@ -1904,7 +2848,7 @@ static cJSON *get_object_item(const cJSON * const object, const char * const nam
         return NULL;
     }
 
-    current_element = object->child;
+    current_element = item_child(object);
     if (case_sensitive)
     {
         while ((current_element != NULL) && (current_element->string != NULL) && (strcmp(name, current_element->string) != 0))
@@ -1966,7 +2910,8 @@ static cJSON *create_reference(const cJSON *item, const internal_hooks * const h
 
     memcpy(reference, item, sizeof(cJSON));
     reference->string = NULL;
-    reference->type |= cJSON_IsReference;
+    /* a reference borrows the value of an external item like any other, without sharing its owner */
+    reference->type = (reference->type & ~cJSON_ValueIsExternal) | cJSON_IsReference;
     reference->next = reference->prev = NULL;
     return reference;
 }
@@ -1979,6 +2924,12 @@ static cJSON_bool add_item_to_array(cJSON *array, cJSON *item)
     {
         return false;
     }
+#ifdef CJSON_COMPACT_NODES
+    if (!(array->type & (cJSON_Array | cJSON_Object)))
+    {
+        return false;
+    }
+#endif
 
     child = array->child;
     /*
@@ -2204,7 +3155,7 @@ CJSON_PUBLIC(cJSON*) cJSON_AddArrayToObject(cJSON * const object, const char * c
 
 CJSON_PUBLIC(cJSON *) cJSON_DetachItemViaPointer(cJSON *parent, cJSON * const item)
 {
-    if ((parent == NULL) || (item == NULL))
+    if ((parent == NULL) || (item == NULL) || (item_child(parent) == NULL))
     {
         return NULL;
     }
@@ -2314,7 +3265,7 @@ CJSON_PUBLIC(cJSON_bool) cJSON_InsertItemInArray(cJSON *array, int which, cJSON
 
 CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemViaPointer(cJSON * const parent, cJSON * const item, cJSON * replacement)
 {
-    if ((parent == NULL) || (parent->child == NULL) || (replacement == NULL) || (item == NULL))
+    if ((parent == NULL) || (item_child(parent) == NULL) || (replacement == NULL) || (item == NULL))
     {
         return false;
     }
@@ -2504,6 +3455,50 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateStringReference(const char *string)
     return item;
 }
 
+static cJSON *create_external(const char *value, int type, cJSON_ReleaseFunc release, void *user_data)
+{
+    external_owner *owner = NULL;
+    cJSON *item = NULL;
+
+    if (value != NULL)
+    {
+        owner = (external_owner*)global_hooks.allocate(sizeof(external_owner));
+    }
+    if (owner != NULL)
+    {
+#ifdef CJSON_ATOMICS
+        atomic_init(&owner->references, 1);
+#else
+        owner->references = 1;
+#endif
+        owner->value = (char*)cast_away_const(value);
+        owner->release = release;
+        owner->user_data = user_data;
+        item = new_external_item(owner, type);
+        if (item == NULL)
+        {
+            global_hooks.deallocate(owner);
+        }
+    }
+    if ((item == NULL) && (release != NULL))
+    {
+        /* the caller handed value over either way */
+        release(value, user_data);
+    }
+
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateStringExternal(const char *value, cJSON_ReleaseFunc release, void *user_data)
+{
+    return create_external(value, cJSON_String, release, user_data);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateRawExternal(const char *value, cJSON_ReleaseFunc release, void *user_data)
+{
+    return create_external(value, cJSON_Raw, release, user_data);
+}
+
 CJSON_PUBLIC(cJSON *) cJSON_CreateObjectReference(const cJSON *child)
 {
     cJSON *item = cJSON_New_Item(&global_hooks);
@@ -2725,6 +3720,156 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateStringArray(const char *const *strings, int co
     return a;
 }
 
+static cJSON *create_typed_array(const void *numbers, size_t count, int kind)
+{
+    typed_array *array = NULL;
+    cJSON *item = NULL;
+
+    if (count > ((((size_t)-1) - sizeof(typed_array)) / sizeof(double)))
+    {
+        return NULL;
+    }
+
+    array = (typed_array*)global_hooks.allocate(sizeof(typed_array) + (count * sizeof(double)));
+    if (array == NULL)
+    {
+        return NULL;
+    }
+    array->info.count = count;
+    array->info.kind = kind;
+    if (numbers != NULL)
+    {
+        memcpy(array + 1, numbers, count * sizeof(double));
+    }
+    else
+    {
+        memset(array + 1, 0, count * sizeof(double));
+    }
+
+    item = cJSON_New_Item(&global_hooks);
+    if (item == NULL)
+    {
+        global_hooks.deallocate(array);
+        return NULL;
+    }
+    item->type = cJSON_TypedArray;
+    item->valuestring = (char*)array;
+
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateTypedDoubleArray(const double *numbers, size_t count)
+{
+    return create_typed_array(numbers, count, cJSON_TypedDouble);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateTypedInt64Array(const long long *numbers, size_t count)
+{
+    return create_typed_array(numbers, count, cJSON_TypedInt64);
+}
+
+CJSON_PUBLIC(int) cJSON_GetTypedArrayKind(const cJSON *item)
+{
+    if (!cJSON_IsTypedArray(item))
+    {
+        return 0;
+    }
+
+    return ((const typed_array*)item->valuestring)->info.kind;
+}
+
+CJSON_PUBLIC(size_t) cJSON_GetTypedArraySize(const cJSON *item)
+{
+    if (!cJSON_IsTypedArray(item))
+    {
+        return 0;
+    }
+
+    return ((const typed_array*)item->valuestring)->info.count;
+}
+
+CJSON_PUBLIC(double *) cJSON_GetTypedArrayDoubles(const cJSON *item)
+{
+    if (cJSON_GetTypedArrayKind(item) != cJSON_TypedDouble)
+    {
+        return NULL;
+    }
+
+    return typed_array_doubles((typed_array*)item->valuestring);
+}
+
+CJSON_PUBLIC(long long *) cJSON_GetTypedArrayInt64s(const cJSON *item)
+{
+    if (cJSON_GetTypedArrayKind(item) != cJSON_TypedInt64)
+    {
+        return NULL;
+    }
+
+    return typed_array_integers((typed_array*)item->valuestring);
+}
+
+CJSON_PUBLIC(double) cJSON_GetTypedArrayNumber(const cJSON *item, size_t index)
+{
+    const typed_array *array = NULL;
+
+    if (index >= cJSON_GetTypedArraySize(item))
+    {
+        return (double) NAN;
+    }
+
+    array = (const typed_array*)item->valuestring;
+    if (array->info.kind == cJSON_TypedInt64)
+    {
+        return (double)typed_array_integers(array)[index];
+    }
+    return typed_array_doubles(array)[index];
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_ExpandTypedArray(cJSON *item)
+{
+    cJSON *head = NULL;
+    cJSON *tail = NULL;
+    cJSON *number = NULL;
+    size_t count = cJSON_GetTypedArraySize(item);
+    size_t i = 0;
+
+    if (!cJSON_IsTypedArray(item) || (item->type & cJSON_IsReference))
+    {
+        return false;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        number = cJSON_CreateNumber(cJSON_GetTypedArrayNumber(item, i));
+        if (number == NULL)
+        {
+            cJSON_Delete(head);
+            return false;
+        }
+        if (head == NULL)
+        {
+            head = number;
+        }
+        else
+        {
+            tail->next = number;
+            number->prev = tail;
+        }
+        tail = number;
+    }
+    if (head != NULL)
+    {
+        head->prev = tail;
+    }
+
+    global_hooks.deallocate(item->valuestring);
+    item->valuestring = NULL;
+    item->type = cJSON_Array | (item->type & cJSON_StringIsConst);
+    item->child = head;
+
+    return true;
+}
+
 /* Duplication */
 CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
 {
@@ -2738,8 +3883,8 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
     {
         goto fail;
     }
-    /* Create new item */
-    newitem = cJSON_New_Item(&global_hooks);
+    /* Create new item; external values are shared rather than copied */
+    newitem = (item->type & cJSON_ValueIsExternal) ? share_external(item) : cJSON_New_Item(&global_hooks);
     if (!newitem)
     {
         goto fail;
@@ -2747,8 +3892,24 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
     /* Copy over all vars */
     newitem->type = item->type & (~cJSON_IsReference);
     newitem->valueint = item->valueint;
-    newitem->valuedouble = item->valuedouble;
-    if (item->valuestring)
+    newitem->valuedouble = item_valuedouble(item);
+    if (item->type & cJSON_ValueIsExternal)
+    {
+        newitem->type |= cJSON_IsReference;
+        newitem->valuestring = item->valuestring;
+    }
+    else if (item->type & cJSON_TypedArray)
+    {
+        const typed_array *array = (const typed_array*)item->valuestring;
+        const size_t size = sizeof(typed_array) + (array->info.count * sizeof(double));
+        newitem->valuestring = (char*)global_hooks.allocate(size);
+        if (!newitem->valuestring)
+        {
+            goto fail;
+        }
+        memcpy(newitem->valuestring, array, size);
+    }
+    else if (item_valuestring(item))
     {
         newitem->valuestring = (char*)cJSON_strdup((unsigned char*)item->valuestring, &global_hooks);
         if (!newitem->valuestring)
@@ -2758,7 +3919,9 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
     }
     if (item->string)
     {
-        newitem->string = (item->type&cJSON_StringIsConst) ? item->string : (char*)cJSON_strdup((unsigned char*)item->string, &global_hooks);
+        /* constant names may point into an in situ parsed buffer, so copy them too */
+        newitem->type &= ~cJSON_StringIsConst;
+        newitem->string = (char*)cJSON_strdup((unsigned char*)item->string, &global_hooks);
         if (!newitem->string)
         {
             goto fail;
@@ -2770,7 +3933,7 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
         return newitem;
     }
     /* Walk the ->next chain for the child. */
-    child = item->child;
+    child = item_child(item);
     while (child != NULL)
     {
         newchild = cJSON_Duplicate(child, true); /* Duplicate (with recurse) each item in the ->next chain */
@@ -2793,7 +3956,7 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
         }
         child = child->next;
     }
-    if (newitem && newitem->child)
+    if (newitem && item_child(newitem))
     {
         newitem->child->prev = newchild;
     }
@@ -2913,7 +4076,7 @@ CJSON_PUBLIC(cJSON_bool) cJSON_IsInvalid(const cJSON * const item)
         return false;
     }
 
-    return (item->type & 0xFF) == cJSON_Invalid;
+    return ((item->type & 0xFF) == cJSON_Invalid) && !(item->type & cJSON_TypedArray);
 }
 
 CJSON_PUBLIC(cJSON_bool) cJSON_IsFalse(const cJSON * const item)
@@ -3006,8 +4169,72 @@ CJSON_PUBLIC(cJSON_bool) cJSON_IsRaw(const cJSON * const item)
     return (item->type & 0xFF) == cJSON_Raw;
 }
 
+CJSON_PUBLIC(cJSON_bool) cJSON_IsTypedArray(const cJSON * const item)
+{
+    if (item == NULL)
+    {
+        return false;
+    }
+
+    return (item->type & cJSON_TypedArray) != 0;
+}
+
+/* a typed array equals an array of number items that holds the same elements */
+static cJSON_bool compare_typed_to_nodes(const cJSON * const typed, const cJSON * const array)
+{
+    size_t count = cJSON_GetTypedArraySize(typed);
+    const cJSON *element = array->child;
+    size_t i = 0;
+
+    for (i = 0; i < count; i++, element = element->next)
+    {
+        if ((element == NULL) || ((element->type & 0xFF) != cJSON_Number) || !compare_double(cJSON_GetTypedArrayNumber(typed, i), element->valuedouble))
+        {
+            return false;
+        }
+    }
+    return element == NULL;
+}
+
+/* typed arrays are equal if their elements are, whatever the kind */
+static cJSON_bool compare_typed_arrays(const cJSON * const a, const cJSON * const b)
+{
+    size_t count = cJSON_GetTypedArraySize(a);
+    size_t i = 0;
+
+    if (cJSON_IsTypedArray(a) && cJSON_IsArray(b))
+    {
+        return compare_typed_to_nodes(a, b);
+    }
+    if (cJSON_IsArray(a) && cJSON_IsTypedArray(b))
+    {
+        return compare_typed_to_nodes(b, a);
+    }
+    if (!cJSON_IsTypedArray(a) || !cJSON_IsTypedArray(b) || (count != cJSON_GetTypedArraySize(b)))
+    {
+        return false;
+    }
+    if (cJSON_GetTypedArrayKind(a) == cJSON_GetTypedArrayKind(b) && (cJSON_GetTypedArrayKind(a) == cJSON_TypedInt64))
+    {
+        return memcmp(cJSON_GetTypedArrayInt64s(a), cJSON_GetTypedArrayInt64s(b), count * sizeof(long long)) == 0;
+    }
+    for (i = 0; i < count; i++)
+    {
+        if (!compare_double(cJSON_GetTypedArrayNumber(a, i), cJSON_GetTypedArrayNumber(b, i)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * const b, const cJSON_bool case_sensitive)
 {
+    if ((a != NULL) && (b != NULL) && ((a->type | b->type) & cJSON_TypedArray))
+    {
+        return compare_typed_arrays(a, b);
+    }
+
     if ((a == NULL) || (b == NULL) || ((a->type & 0xFF) != (b->type & 0xFF)))
     {
         return false;
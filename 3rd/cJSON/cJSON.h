@@ -98,6 +98,14 @@ then using the CJSON_API_VISIBILITY flag to "export" the same symbols the way CJ
 
 #define cJSON_IsReference 256
 #define cJSON_StringIsConst 512
+/* numeric array stored contiguously, see cJSON_CreateTypedDoubleArray; not a cJSON_Array and has no children */
+#define cJSON_TypedArray 1024
+/* valuestring is owned by the caller and given back through a release callback, see cJSON_CreateStringExternal */
+#define cJSON_ValueIsExternal 2048
+
+/* Element types of typed arrays */
+#define cJSON_TypedDouble 1
+#define cJSON_TypedInt64 2
 
 /* The cJSON structure: */
 typedef struct cJSON
@@ -105,6 +113,24 @@ typedef struct cJSON
     /* next/prev allow you to walk array/object chains. Alternatively, use GetArraySize/GetArrayItem/GetObjectItem */
     struct cJSON *next;
     struct cJSON *prev;
+#ifdef CJSON_COMPACT_NODES
+    /* Compact layout (40 instead of 64 bytes on LP64): the type decides which of child, valuestring and valuedouble is
+     * in use, the others must not be read. Every file including cJSON.h has to be compiled with the same setting. */
+    union
+    {
+        /* An array or object item will have a child pointer pointing to a chain of the items in the array/object. */
+        struct cJSON *child;
+        /* The item's string, if type==cJSON_String  and type == cJSON_Raw */
+        char *valuestring;
+        /* The item's number, if type==cJSON_Number */
+        double valuedouble;
+    };
+
+    /* The type of the item, as above. */
+    int type;
+    /* writing to valueint is DEPRECATED, use cJSON_SetNumberValue instead */
+    int valueint;
+#else
     /* An array or object item will have a child pointer pointing to a chain of the items in the array/object. */
     struct cJSON *child;
 
@@ -117,6 +143,7 @@ typedef struct cJSON
     int valueint;
     /* The item's number, if type==cJSON_Number */
     double valuedouble;
+#endif
 
     /* The item's name string, if this item is the child of, or is in the list of subitems of an object. */
     char *string;
@@ -131,6 +158,9 @@ typedef struct cJSON_Hooks
 
 typedef int cJSON_bool;
 
+/* Gives back the value of an external string or raw item once no item uses it anymore */
+typedef void (CJSON_CDECL *cJSON_ReleaseFunc)(const char *value, void *user_data);
+
 /* Limits how deeply nested arrays/objects can be before cJSON rejects to parse them.
  * This is to prevent stack overflows. */
 #ifndef CJSON_NESTING_LIMIT
@@ -142,6 +172,14 @@ CJSON_PUBLIC(const char*) cJSON_Version(void);
 
 /* Supply malloc, realloc and free functions to cJSON */
 CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks);
+/* Take items from per-thread free lists carved out of cache-aligned 64 KiB slabs instead of one malloc_fn/free_fn call each.
+ * Slabs come from malloc_fn and are kept for reuse, never freed. As with cJSON_InitHooks, only switch while no items exist.
+ * Returns false if this build has no slab support (it needs C11 atomics and thread-local storage). */
+CJSON_PUBLIC(cJSON_bool) cJSON_UseNodeSlabs(cJSON_bool enable);
+/* Hand the calling thread's free items, and the unused end of its current slab, to the shared pool other threads take
+ * from. On POSIX systems this runs by itself when a thread that used the slabs exits; call it on other systems before a
+ * thread exits, or when a pooled thread goes idle. Otherwise an exiting thread strands up to a few thousand items. */
+CJSON_PUBLIC(void) cJSON_FlushThreadNodes(void);
 
 /* Memory Management: the caller is always responsible to free the results from all variants of cJSON_Parse (with cJSON_Delete) and cJSON_Print (with stdlib free, cJSON_Hooks.free_fn, or cJSON_free as appropriate). The exception is cJSON_PrintPreallocated, where the caller has full responsibility of the buffer. */
 /* Supply a block of JSON, and this returns a cJSON object you can interrogate. */
@@ -151,6 +189,14 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_len
 /* If you supply a ptr in return_parse_end and parsing fails, then return_parse_end will contain a pointer to the error so will match cJSON_GetErrorPtr(). */
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated);
+/* ParseInSitu parses destructively: strings and object names are unescaped inside value, and the returned items point into it
+ * (flagged cJSON_IsReference and cJSON_StringIsConst). value must stay alive and unchanged until the result is deleted; its
+ * contents are undefined afterwards, also when parsing fails. cJSON_Duplicate copies such items into memory of their own. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *value, size_t buffer_length);
+/* The Typed variants parse arrays of at least typed_min numbers (and nothing else) into cJSON_TypedArray items: long long
+ * elements if every number is an integer of up to 18 digits, double elements otherwise. typed_min 0 parses as usual. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthTyped(const char *value, size_t buffer_length, size_t typed_min);
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSituTyped(char *value, size_t buffer_length, size_t typed_min);
 
 /* Render a cJSON entity to text for transfer/storage. */
 CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item);
@@ -190,6 +236,7 @@ CJSON_PUBLIC(cJSON_bool) cJSON_IsString(const cJSON * const item);
 CJSON_PUBLIC(cJSON_bool) cJSON_IsArray(const cJSON * const item);
 CJSON_PUBLIC(cJSON_bool) cJSON_IsObject(const cJSON * const item);
 CJSON_PUBLIC(cJSON_bool) cJSON_IsRaw(const cJSON * const item);
+CJSON_PUBLIC(cJSON_bool) cJSON_IsTypedArray(const cJSON * const item);
 
 /* These calls create a cJSON item of the appropriate type. */
 CJSON_PUBLIC(cJSON *) cJSON_CreateNull(void);
@@ -210,6 +257,11 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateStringReference(const char *string);
  * they will not be freed by cJSON_Delete */
 CJSON_PUBLIC(cJSON *) cJSON_CreateObjectReference(const cJSON *child);
 CJSON_PUBLIC(cJSON *) cJSON_CreateArrayReference(const cJSON *child);
+/* Create a string/raw item whose valuestring is value itself, without a copy. release(value, user_data) runs once the
+ * item and every cJSON_Duplicate of it are deleted, from whichever thread deletes the last one; NULL release never gives
+ * value back. If the item cannot be created, release runs right away and NULL is returned. */
+CJSON_PUBLIC(cJSON *) cJSON_CreateStringExternal(const char *value, cJSON_ReleaseFunc release, void *user_data);
+CJSON_PUBLIC(cJSON *) cJSON_CreateRawExternal(const char *value, cJSON_ReleaseFunc release, void *user_data);
 
 /* These utilities create an Array of count items.
  * The parameter count cannot be greater than the number of elements in the number array, otherwise array access will be out of bounds.*/
@@ -218,6 +270,22 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateFloatArray(const float *numbers, int count);
 CJSON_PUBLIC(cJSON *) cJSON_CreateDoubleArray(const double *numbers, int count);
 CJSON_PUBLIC(cJSON *) cJSON_CreateStringArray(const char *const *strings, int count);
 
+/* Typed arrays keep count numbers in one block instead of one item each, and print like an array of number items (long
+ * long elements print exactly, also beyond 2^53). numbers is copied; pass NULL to get zeroes to fill in through
+ * cJSON_GetTypedArrayDoubles/cJSON_GetTypedArrayInt64s. */
+CJSON_PUBLIC(cJSON *) cJSON_CreateTypedDoubleArray(const double *numbers, size_t count);
+CJSON_PUBLIC(cJSON *) cJSON_CreateTypedInt64Array(const long long *numbers, size_t count);
+/* cJSON_TypedDouble or cJSON_TypedInt64, 0 if item is not a typed array */
+CJSON_PUBLIC(int) cJSON_GetTypedArrayKind(const cJSON *item);
+CJSON_PUBLIC(size_t) cJSON_GetTypedArraySize(const cJSON *item);
+/* The elements, NULL if item is not a typed array of that kind */
+CJSON_PUBLIC(double *) cJSON_GetTypedArrayDoubles(const cJSON *item);
+CJSON_PUBLIC(long long *) cJSON_GetTypedArrayInt64s(const cJSON *item);
+/* Element "index" of either kind as double, NaN if out of range */
+CJSON_PUBLIC(double) cJSON_GetTypedArrayNumber(const cJSON *item, size_t index);
+/* Turn a typed array into an ordinary array of number items in place, for code that walks children */
+CJSON_PUBLIC(cJSON_bool) cJSON_ExpandTypedArray(cJSON *item);
+
 /* Append item to the specified array/object. */
 CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToArray(cJSON *array, cJSON *item);
 CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item);
@@ -272,7 +340,11 @@ CJSON_PUBLIC(cJSON*) cJSON_AddObjectToObject(cJSON * const object, const char *
 CJSON_PUBLIC(cJSON*) cJSON_AddArrayToObject(cJSON * const object, const char * const name);
 
 /* When assigning an integer value, it needs to be propagated to valuedouble too. */
+#ifdef CJSON_COMPACT_NODES
+#define cJSON_SetIntValue(object, number) ((object) ? cJSON_SetNumberHelper(object, (double)(number)) : (number))
+#else
 #define cJSON_SetIntValue(object, number) ((object) ? (object)->valueint = (object)->valuedouble = (number) : (number))
+#endif
 /* helper for the cJSON_SetNumberValue macro */
 CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number);
 #define cJSON_SetNumberValue(object, number) ((object != NULL) ? cJSON_SetNumberHelper(object, (double)number) : (number))
@@ -287,7 +359,11 @@ CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring)
 )
 
 /* Macro for iterating over an array or object */
+#ifdef CJSON_COMPACT_NODES
+#define cJSON_ArrayForEach(element, array) for(element = ((array != NULL) && ((array)->type & (cJSON_Array | cJSON_Object))) ? (array)->child : NULL; element != NULL; element = element->next)
+#else
 #define cJSON_ArrayForEach(element, array) for(element = (array != NULL) ? (array)->child : NULL; element != NULL; element = element->next)
+#endif
 
 /* malloc/free objects using the malloc/free functions that have been set with cJSON_InitHooks */
 CJSON_PUBLIC(void *) cJSON_malloc(size_t size);
@@ -0,0 +1,99 @@
+/**
+ * @file external_string_bench.c
+ * @brief Returning a large string from a method, copied or external
+ *
+ * A method returns a 5 MB string, either with cJSON_CreateString() (a copy
+ * per call) or with cJSON_CreateStringExternal() (no copy). Reports
+ * microseconds per call:
+ *   - result:  the method's result alone, created and deleted
+ *   - call:    mjrpc_process_str(), including printing the response
+ *   - hit:     mjrpc_process_cjson() answered from the response cache
+ *
+ * Usage: mjsonrpc-bench-external-strings [iterations]
+ */
+
+#include "mjsonrpc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define VALUE_SIZE (5 * 1024 * 1024)
+
+static char* value;
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double) t.tv_sec + (double) t.tv_nsec / 1e9;
+}
+
+static cJSON* copied(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) ctx;
+    (void) params;
+    (void) id;
+    return cJSON_CreateString(value);
+}
+
+static cJSON* external(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) ctx;
+    (void) params;
+    (void) id;
+    return cJSON_CreateStringExternal(value, NULL, NULL);
+}
+
+static double time_results(mjrpc_func func, long iterations)
+{
+    double t = now();
+    for (long i = 0; i < iterations; i++)
+        cJSON_Delete(func(NULL, NULL, NULL));
+    return (now() - t) * 1e6 / (double) iterations;
+}
+
+static double time_calls(mjrpc_func func, long iterations)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(8);
+    mjrpc_add_method(h, func, "get", NULL);
+    double t = now();
+    for (long i = 0; i < iterations; i++)
+        free(mjrpc_process_str(h, "{\"jsonrpc\":\"2.0\",\"method\":\"get\",\"id\":1}", NULL));
+    double us = (now() - t) * 1e6 / (double) iterations;
+    mjrpc_destroy_handle(h);
+    return us;
+}
+
+static double time_hits(mjrpc_func func, long iterations)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(8);
+    mjrpc_add_cached_method(h, func, "get", NULL, 0);
+    cJSON* request = cJSON_Parse("{\"jsonrpc\":\"2.0\",\"method\":\"get\",\"id\":1}");
+    cJSON_Delete(mjrpc_process_cjson(h, request, NULL));
+    double t = now();
+    for (long i = 0; i < iterations; i++)
+        cJSON_Delete(mjrpc_process_cjson(h, request, NULL));
+    double us = (now() - t) * 1e6 / (double) iterations;
+    cJSON_Delete(request);
+    mjrpc_destroy_handle(h);
+    return us;
+}
+
+int main(int argc, char** argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 200;
+    value = malloc(VALUE_SIZE + 1);
+    for (size_t i = 0; i < VALUE_SIZE; i++)
+        value[i] = (char) ('a' + i % 26);
+    value[VALUE_SIZE] = '\0';
+
+    printf("%-9s %12s %12s %12s\n", "result", "result us", "call us", "hit us");
+    printf("%-9s %12.1f %12.1f %12.1f\n", "copied", time_results(copied, iterations), time_calls(copied, iterations),
+           time_hits(copied, iterations * 100));
+    printf("%-9s %12.1f %12.1f %12.1f\n", "external", time_results(external, iterations),
+           time_calls(external, iterations), time_hits(external, iterations * 100));
+    free(value);
+    return 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * @file msgpack_bench.c
+ * @brief The same calls as JSON text and as MessagePack
+ *
+ * Sends one request to an echo method through mjrpc_process_buf() and, in
+ * its MessagePack form, through mjrpc_process_msgpack(). Reports request and
+ * response sizes and microseconds per call for:
+ *   - small:   a few named scalar params
+ *   - records: an array of 100 objects with numbers and strings
+ *   - numbers: an array of 10000 doubles
+ *
+ * Usage: mjsonrpc-bench-msgpack [iterations]
+ */
+
+#include "mjsonrpc_msgpack.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double) t.tv_sec + (double) t.tv_nsec / 1e9;
+}
+
+static cJSON* echo(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) ctx;
+    (void) id;
+    return cJSON_Duplicate(params, true);
+}
+
+static cJSON* request_with(cJSON* params)
+{
+    cJSON* request = cJSON_CreateObject();
+    cJSON_AddStringToObject(request, "jsonrpc", "2.0");
+    cJSON_AddStringToObject(request, "method", "echo");
+    cJSON_AddItemToObject(request, "params", params);
+    cJSON_AddNumberToObject(request, "id", 1);
+    return request;
+}
+
+static void report(mjrpc_handle_t* h, const char* name, cJSON* request, long iterations)
+{
+    char* json = cJSON_PrintUnformatted(request);
+    size_t json_len = strlen(json);
+    size_t packed_len;
+    char* packed = mjrpc_msgpack_encode(request, &packed_len);
+
+    char* response = mjrpc_process_buf(h, json, json_len, NULL);
+    size_t json_response = strlen(response);
+    free(response);
+    size_t packed_response;
+    free(mjrpc_process_msgpack(h, packed, packed_len, &packed_response, NULL));
+
+    double t = now();
+    for (long i = 0; i < iterations; i++)
+        free(mjrpc_process_buf(h, json, json_len, NULL));
+    double json_us = (now() - t) * 1e6 / (double) iterations;
+    t = now();
+    for (long i = 0; i < iterations; i++)
+    {
+        size_t len;
+        free(mjrpc_process_msgpack(h, packed, packed_len, &len, NULL));
+    }
+    double packed_us = (now() - t) * 1e6 / (double) iterations;
+
+    printf("%-8s json %7zu/%7zu bytes %9.2f us   msgpack %7zu/%7zu bytes %9.2f us\n", name, json_len, json_response,
+           json_us, packed_len, packed_response, packed_us);
+    free(json);
+    free(packed);
+    cJSON_Delete(request);
+}
+
+int main(int argc, char** argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 2000;
+    mjrpc_handle_t* h = mjrpc_create_handle(8);
+    mjrpc_add_method(h, echo, "echo", NULL);
+
+    cJSON* small = cJSON_CreateObject();
+    cJSON_AddNumberToObject(small, "a", 42);
+    cJSON_AddStringToObject(small, "b", "hello");
+    cJSON_AddTrueToObject(small, "c");
+    report(h, "small", request_with(small), iterations * 100);
+
+    cJSON* records = cJSON_CreateArray();
+    for (int i = 0; i < 100; i++)
+    {
+        cJSON* record = cJSON_CreateObject();
+        cJSON_AddNumberToObject(record, "id", i);
+        cJSON_AddStringToObject(record, "name", "sensor-name");
+        cJSON_AddNumberToObject(record, "value", sin(i) * 100);
+        cJSON_AddNumberToObject(record, "count", i * 1000);
+        cJSON_AddItemToArray(records, record);
+    }
+    report(h, "records", request_with(records), iterations);
+
+    cJSON* numbers = cJSON_CreateArray();
+    for (int i = 0; i < 10000; i++)
+        cJSON_AddItemToArray(numbers, cJSON_CreateNumber(sin(i * 0.01) * 1000));
+    report(h, "numbers", request_with(numbers), iterations / 20 + 1);
+
+    mjrpc_destroy_handle(h);
+    return 0;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file nesting_bench.c
+ * @brief Parse, print and delete of deep and wide documents in cJSON
+ *
+ * Two documents: "deep" nests arrays and objects CJSON_NESTING_LIMIT levels
+ * deep, "wide" is an array of 20000 small objects. For each, times
+ * cJSON_ParseWithLength(), cJSON_PrintUnformatted() and cJSON_Delete(), and
+ * reports the most C stack the three used, measured on a thread whose stack
+ * is painted beforehand.
+ *
+ * Usage: mjsonrpc-bench-nesting [iterations]
+ */
+
+#include "cJSON.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_STACK (1024 * 1024)
+#define PAINT 0xA5
+
+static double elapsed(const struct timespec* t0, const struct timespec* t1)
+{
+    return (double) (t1->tv_sec - t0->tv_sec) + (double) (t1->tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+static char* deep_document(void)
+{
+    char* text = malloc(CJSON_NESTING_LIMIT * 8 + 2);
+    size_t n = 0;
+    for (int i = 0; i < CJSON_NESTING_LIMIT; i++)
+    {
+        if (i % 2)
+        {
+            memcpy(text + n, "{\"a\":", 5);
+            n += 5;
+        }
+        else
+            text[n++] = '[';
+    }
+    text[n++] = '0';
+    for (int i = CJSON_NESTING_LIMIT - 1; i >= 0; i--)
+        text[n++] = i % 2 ? '}' : ']';
+    text[n] = '\0';
+    return text;
+}
+
+static char* wide_document(void)
+{
+    cJSON* array = cJSON_CreateArray();
+    for (int i = 0; i < 20000; i++)
+    {
+        cJSON* object = cJSON_CreateObject();
+        cJSON_AddNumberToObject(object, "id", i);
+        cJSON_AddStringToObject(object, "name", "item");
+        cJSON_AddItemToObject(object, "tags", cJSON_CreateArray());
+        cJSON_AddBoolToObject(object, "on", i % 2);
+        cJSON_AddItemToArray(array, object);
+    }
+    char* text = cJSON_PrintUnformatted(array);
+    cJSON_Delete(array);
+    return text;
+}
+
+typedef struct
+{
+    const char* text;
+    long iterations;
+    double parse_s;
+    double print_s;
+    double delete_s;
+} job_t;
+
+static void* run_job(void* arg)
+{
+    job_t* job = arg;
+    size_t len = strlen(job->text);
+    struct timespec t0, t1;
+    job->parse_s = job->print_s = job->delete_s = 0;
+    for (long i = 0; i < job->iterations; i++)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        cJSON* item = cJSON_ParseWithLength(job->text, len);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        job->parse_s += elapsed(&t0, &t1);
+        if (item == NULL)
+        {
+            fprintf(stderr, "parse failed\n");
+            exit(1);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        char* printed = cJSON_PrintUnformatted(item);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        job->print_s += elapsed(&t0, &t1);
+        free(printed);
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        cJSON_Delete(item);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        job->delete_s += elapsed(&t0, &t1);
+    }
+    return NULL;
+}
+
+/* Runs the job on a painted stack and returns how many bytes of it were touched */
+static size_t run_on_painted_stack(job_t* job)
+{
+    unsigned char* stack = aligned_alloc(4096, BENCH_STACK);
+    memset(stack, PAINT, BENCH_STACK);
+
+    pthread_attr_t attr;
+    pthread_t thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, BENCH_STACK);
+    pthread_create(&thread, &attr, run_job, job);
+    pthread_join(thread, NULL);
+    pthread_attr_destroy(&attr);
+
+    /* The stack grows down; the thread's own bookkeeping is counted too */
+    size_t untouched = 0;
+    while (untouched < BENCH_STACK && stack[untouched] == PAINT)
+        untouched++;
+    free(stack);
+    return BENCH_STACK - untouched;
+}
+
+static void report(const char* name, char* text, long iterations)
+{
+    job_t job = {text, iterations, 0, 0, 0};
+    size_t stack = run_on_painted_stack(&job);
+    double mb = (double) strlen(text) * (double) iterations / 1e6;
+    printf("%-5s %8zu bytes  parse %7.1f MB/s  print %7.1f MB/s  delete %7.1f MB/s  stack %7zu bytes\n", name,
+           strlen(text), mb / job.parse_s, mb / job.print_s, mb / job.delete_s, stack);
+    free(text);
+}
+
+int main(int argc, char** argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 2000;
+    report("deep", deep_document(), iterations * 10);
+    report("wide", wide_document(), iterations / 10 + 1);
+    return 0;
+}
@@ -0,0 +1,167 @@
+/**
+ * @file node_bench.c
+ * @brief Item allocation churn in cJSON, malloc_fn/free_fn against node slabs
+ *
+ * Four workloads, each timed with the default hooks (glibc malloc) and with
+ * cJSON_UseNodeSlabs(true):
+ *   - build:  create and delete an object of 64 members holding small arrays
+ *   - parse:  cJSON_ParseInSitu() and delete a JSON-RPC request
+ *   - thread: the parse workload on four threads at once
+ *   - walk:   sum a params array of 64Ki numbers, one pass per 100 iterations
+ *
+ * mjsonrpc-bench-nodes-compact runs the same with CJSON_COMPACT_NODES.
+ *
+ * Usage: mjsonrpc-bench-nodes [iterations]
+ */
+
+#include "cJSON.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define THREADS 4
+
+static const char request[] =
+    "{\"jsonrpc\":\"2.0\",\"method\":\"update\",\"params\":{\"items\":["
+    "{\"id\":1,\"tags\":[\"a\",\"b\"],\"w\":0.5,\"on\":true},{\"id\":2,\"tags\":[\"c\"],\"w\":1.5,\"on\":false},"
+    "{\"id\":3,\"tags\":[],\"w\":2.5,\"on\":null},{\"id\":4,\"tags\":[\"d\",\"e\",\"f\"],\"w\":3.5,\"on\":true}],"
+    "\"page\":{\"offset\":0,\"limit\":100}},\"id\":42}";
+
+static long iterations;
+static long request_items;
+
+static double elapsed(const struct timespec* t0, const struct timespec* t1)
+{
+    return (double) (t1->tv_sec - t0->tv_sec) + (double) (t1->tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+static long build(void)
+{
+    long items = 0;
+    for (long i = 0; i < iterations; i++)
+    {
+        cJSON* object = cJSON_CreateObject();
+        for (int m = 0; m < 64; m++)
+        {
+            cJSON* array = cJSON_CreateArray();
+            cJSON_AddItemToArray(array, cJSON_CreateNumber(m));
+            cJSON_AddItemToArray(array, cJSON_CreateBool(m & 1));
+            cJSON_AddItemToArray(array, cJSON_CreateNull());
+            cJSON_AddItemToObjectCS(object, "member", array);
+        }
+        cJSON_Delete(object);
+        items += 1 + 64 * 4;
+    }
+    return items;
+}
+
+static long count_items(const cJSON* item)
+{
+    long items = 0;
+    for (; item != NULL; item = item->next)
+        items += 1 + (cJSON_IsArray(item) || cJSON_IsObject(item) ? count_items(item->child) : 0);
+    return items;
+}
+
+static long parse(void)
+{
+    char buffer[sizeof(request)];
+    long items = 0;
+    for (long i = 0; i < iterations; i++)
+    {
+        memcpy(buffer, request, sizeof(request));
+        cJSON* item = cJSON_ParseInSitu(buffer, sizeof(request) - 1);
+        if (item == NULL)
+        {
+            fprintf(stderr, "parse failed\n");
+            exit(1);
+        }
+        cJSON_Delete(item);
+        items += request_items;
+    }
+    return items;
+}
+
+static void* parse_thread(void* arg)
+{
+    *(long*) arg = parse();
+    return NULL;
+}
+
+static long threaded(void)
+{
+    pthread_t threads[THREADS];
+    long items[THREADS];
+    long total = 0;
+    for (int t = 0; t < THREADS; t++)
+        pthread_create(&threads[t], NULL, parse_thread, &items[t]);
+    for (int t = 0; t < THREADS; t++)
+    {
+        pthread_join(threads[t], NULL);
+        total += items[t];
+    }
+    return total;
+}
+
+static long walk(void)
+{
+    const int count = 1 << 16;
+    cJSON* params = cJSON_CreateArray();
+    for (int i = 0; i < count; i++)
+        cJSON_AddItemToArray(params, cJSON_CreateNumber(i & 1023));
+
+    long items = 0;
+    double sum = 0;
+    for (long pass = 0; pass < iterations / 100; pass++)
+    {
+        const cJSON* item;
+        cJSON_ArrayForEach(item, params)
+            sum += item->valuedouble;
+        items += count;
+    }
+    cJSON_Delete(params);
+    if (sum < 0)
+        printf("%f\n", sum);
+    return items;
+}
+
+/* Nanoseconds per item created and deleted, or visited */
+static double run(long (*workload)(void), int slabs)
+{
+    struct timespec t0, t1;
+    cJSON_UseNodeSlabs(slabs);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    long items = workload();
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    cJSON_UseNodeSlabs(0);
+    return elapsed(&t0, &t1) * 1e9 / (double) items;
+}
+
+int main(int argc, char** argv)
+{
+    iterations = argc > 1 ? atol(argv[1]) : 200000;
+    if (!cJSON_UseNodeSlabs(1))
+    {
+        fprintf(stderr, "node slabs not supported by this build\n");
+        return 1;
+    }
+    cJSON_UseNodeSlabs(0);
+    cJSON* item = cJSON_Parse(request);
+    request_items = count_items(item);
+    cJSON_Delete(item);
+
+    const char* names[] = {"build", "parse", "thread", "walk"};
+    long (*workloads[])(void) = {build, parse, threaded, walk};
+    printf("%zu-byte items\n", sizeof(cJSON));
+    printf("%-8s %12s %12s %8s\n", "workload", "malloc ns", "slab ns", "speedup");
+    for (int w = 0; w < 4; w++)
+    {
+        double heap = run(workloads[w], 0);
+        double slab = run(workloads[w], 1);
+        printf("%-8s %12.2f %12.2f %7.2fx\n", names[w], heap, slab, heap / slab);
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file params_bench.c
+ * @brief Reading every param of a call, cJSON lookups against the params view
+ *
+ * Calls methods that read all members of a params object by name, or all
+ * elements of a params array by position, for a range of params sizes:
+ *   - cJSON:  cJSON_GetObjectItem() / cJSON_GetObjectItemCaseSensitive() /
+ *             cJSON_GetArrayItem()
+ *   - view:   mjrpc_params_get() / mjrpc_params_get_case_sensitive() /
+ *             mjrpc_params_at()
+ * Reports nanoseconds per call, including request handling.
+ *
+ * Usage: mjsonrpc-bench-params [iterations]
+ */
+
+#include "mjsonrpc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define MAX_PARAMS 256
+
+static char names[MAX_PARAMS][16];
+
+static double elapsed(const struct timespec* t0, const struct timespec* t1)
+{
+    return (double) (t1->tv_sec - t0->tv_sec) + (double) (t1->tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+/* ctx->data selects the lookup: 0 cJSON, 1 cJSON case-sensitive, 2 view, 3 view case-sensitive */
+static cJSON* read_named(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) id;
+    int mode = *(const int*) ctx->data;
+    int count = mjrpc_params_size(ctx);
+    double sum = 0;
+    for (int i = 0; i < count; i++)
+    {
+        const cJSON* item;
+        if (mode == 0)
+            item = cJSON_GetObjectItem(params, names[i]);
+        else if (mode == 1)
+            item = cJSON_GetObjectItemCaseSensitive(params, names[i]);
+        else if (mode == 2)
+            item = mjrpc_params_get(ctx, names[i]);
+        else
+            item = mjrpc_params_get_case_sensitive(ctx, names[i]);
+        sum += item->valuedouble;
+    }
+    return cJSON_CreateNumber(sum);
+}
+
+/* ctx->data selects the lookup: 0 cJSON, 2 view */
+static cJSON* read_positional(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) id;
+    int mode = *(const int*) ctx->data;
+    int count = mjrpc_params_size(ctx);
+    double sum = 0;
+    for (int i = 0; i < count; i++)
+        sum += (mode == 0 ? cJSON_GetArrayItem(params, i) : mjrpc_params_at(ctx, i))->valuedouble;
+    return cJSON_CreateNumber(sum);
+}
+
+static double run(mjrpc_func func, int mode, cJSON* request, long iterations)
+{
+    int* data = malloc(sizeof(int));
+    *data = mode;
+    mjrpc_handle_t* h = mjrpc_create_handle(8);
+    mjrpc_add_method(h, func, "read", data);
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long i = 0; i < iterations; i++)
+        cJSON_Delete(mjrpc_process_cjson(h, request, NULL));
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    mjrpc_destroy_handle(h);
+    return elapsed(&t0, &t1) * 1e9 / (double) iterations;
+}
+
+int main(int argc, char** argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 20000;
+    for (int i = 0; i < MAX_PARAMS; i++)
+        snprintf(names[i], sizeof(names[i]), "field%d", i);
+
+    printf("%-6s %12s %12s %12s %12s %12s %12s\n", "params", "get ns", "get cs ns", "view ns", "view cs ns",
+           "array ns", "view at ns");
+    const int sizes[] = {4, 16, 64, 128, 256};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        cJSON* object = cJSON_CreateObject();
+        cJSON* array = cJSON_CreateArray();
+        for (int i = 0; i < sizes[s]; i++)
+        {
+            cJSON_AddNumberToObject(object, names[i], i);
+            cJSON_AddItemToArray(array, cJSON_CreateNumber(i));
+        }
+        cJSON* named = mjrpc_request_cjson("read", object, cJSON_CreateNumber(1));
+        cJSON* positional = mjrpc_request_cjson("read", array, cJSON_CreateNumber(1));
+
+        long n = iterations * 16 / sizes[s];
+        printf("%-6d %12.0f %12.0f %12.0f %12.0f %12.0f %12.0f\n", sizes[s], run(read_named, 0, named, n),
+               run(read_named, 1, named, n), run(read_named, 2, named, n), run(read_named, 3, named, n),
+               run(read_positional, 0, positional, n), run(read_positional, 2, positional, n));
+        cJSON_Delete(named);
+        cJSON_Delete(positional);
+    }
+    return 0;
+}
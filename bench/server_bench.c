@@ -0,0 +1,187 @@
+/**
+ * @file server_bench.c
+ * @brief Localhost throughput benchmark for mjsonrpc_server
+ *
+ * Starts a server with an "echo" method in-process and drives it from client
+ * threads, each keeping a window of pipelined requests in flight.
+ *
+ * Usage: mjsonrpc-bench-server [clients] [requests per client] [pipeline]
+ *                              [reactors] [tcp|unix] [epoll|uring]
+ */
+
+#include "mjsonrpc_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char request[] =
+    "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[1,\"two\",3.5],\"id\":1}\n";
+
+typedef struct {
+    uint16_t port;
+    const char* unix_path;
+    long requests;
+    int pipeline;
+    int failed;
+} client_t;
+
+static cJSON* echo(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) ctx;
+    (void) id;
+    return cJSON_Duplicate(params, 1);
+}
+
+static int connect_server(const client_t* c)
+{
+    if (c->unix_path)
+    {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        struct sockaddr_un addr = {0};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, c->unix_path, sizeof(addr.sun_path) - 1);
+        if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0)
+        {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(c->port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void* client_main(void* arg)
+{
+    client_t* c = arg;
+    int fd = connect_server(c);
+    if (fd < 0)
+    {
+        c->failed = 1;
+        return NULL;
+    }
+
+    size_t req_len = sizeof(request) - 1;
+    char* window = malloc(req_len * (size_t) c->pipeline);
+    for (int i = 0; i < c->pipeline; i++)
+        memcpy(window + req_len * (size_t) i, request, req_len);
+    char buf[65536];
+
+    long done = 0;
+    while (done < c->requests)
+    {
+        long batch = c->requests - done < c->pipeline ? c->requests - done : c->pipeline;
+        size_t len = req_len * (size_t) batch;
+        for (size_t off = 0; off < len;)
+        {
+            ssize_t n = write(fd, window + off, len - off);
+            if (n <= 0)
+                goto fail;
+            off += (size_t) n;
+        }
+        long lines = 0;
+        while (lines < batch)
+        {
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0)
+                goto fail;
+            for (ssize_t i = 0; i < n; i++)
+                lines += buf[i] == '\n';
+        }
+        done += batch;
+    }
+    free(window);
+    close(fd);
+    return NULL;
+
+fail:
+    c->failed = 1;
+    free(window);
+    close(fd);
+    return NULL;
+}
+
+int main(int argc, char** argv)
+{
+    int clients = argc > 1 ? atoi(argv[1]) : 4;
+    long requests = argc > 2 ? atol(argv[2]) : 200000;
+    int pipeline = argc > 3 ? atoi(argv[3]) : 32;
+    int reactors = argc > 4 ? atoi(argv[4]) : 1;
+    int use_unix = argc > 5 && strcmp(argv[5], "unix") == 0;
+    int use_uring = argc > 6 && strcmp(argv[6], "uring") == 0;
+
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, echo, "echo", NULL);
+
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/mjrpc_bench_%d.sock", (int) getpid());
+    mjrpc_server_config_t config;
+    mjrpc_server_config_init(&config);
+    if (use_unix)
+        config.unix_path = path;
+    else
+        config.tcp_host = "127.0.0.1";
+    config.reactors = reactors;
+    config.backend = use_uring ? MJRPC_SERVER_BACKEND_IO_URING : MJRPC_SERVER_BACKEND_EPOLL;
+
+    mjrpc_server_t* server = mjrpc_server_create(h, &config);
+    if (server == NULL || mjrpc_server_start(server) != MJRPC_RET_OK)
+    {
+        fprintf(stderr, "failed to start server\n");
+        return 1;
+    }
+
+    pthread_t* threads = calloc((size_t) clients, sizeof(pthread_t));
+    client_t* states = calloc((size_t) clients, sizeof(client_t));
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < clients; i++)
+    {
+        states[i].port = mjrpc_server_tcp_port(server);
+        states[i].unix_path = use_unix ? path : NULL;
+        states[i].requests = requests;
+        states[i].pipeline = pipeline;
+        pthread_create(&threads[i], NULL, client_main, &states[i]);
+    }
+    int failed = 0;
+    for (int i = 0; i < clients; i++)
+    {
+        pthread_join(threads[i], NULL);
+        failed |= states[i].failed;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    double seconds = (double) (t1.tv_sec - t0.tv_sec) + (double) (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    double total = (double) requests * clients;
+    printf("%s/%s, %d clients, %d reactors, pipeline %d: %.0f req/s (%.3f s)%s\n",
+           use_unix ? "unix" : "tcp",
+           mjrpc_server_get_backend(server) == MJRPC_SERVER_BACKEND_IO_URING ? "io_uring" : "epoll",
+           clients, reactors, pipeline, total / seconds, seconds,
+           failed ? " [client errors]" : "");
+
+    free(threads);
+    free(states);
+    mjrpc_server_destroy(server);
+    mjrpc_destroy_handle(h);
+    return failed;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file shm_bench.c
+ * @brief Round-trip latency of mjsonrpc_shm between two processes
+ *
+ * Forks a server process serving an "echo" method over a memfd channel and
+ * measures request/response round trips from the parent, one at a time.
+ *
+ * Usage: mjsonrpc-bench-shm [round trips]
+ */
+
+#include "mjsonrpc_shm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char request[] =
+    "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[1,\"two\",3.5],\"id\":1}";
+
+static cJSON* echo(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) ctx;
+    (void) id;
+    return cJSON_Duplicate(params, 1);
+}
+
+static double elapsed(const struct timespec* t0, const struct timespec* t1)
+{
+    return (double) (t1->tv_sec - t0->tv_sec) + (double) (t1->tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+int main(int argc, char** argv)
+{
+    long count = argc > 1 ? atol(argv[1]) : 200000;
+
+    mjrpc_shm_t* server = mjrpc_shm_create(NULL, 1 << 20);
+    if (server == NULL)
+    {
+        perror("mjrpc_shm_create");
+        return 1;
+    }
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        mjrpc_handle_t* h = mjrpc_create_handle(0);
+        mjrpc_add_method(h, echo, "echo", NULL);
+        mjrpc_shm_serve(server, h);
+        mjrpc_destroy_handle(h);
+        _exit(0);
+    }
+
+    mjrpc_shm_t* client = mjrpc_shm_attach(mjrpc_shm_fd(server));
+    const char* response;
+    size_t len;
+    int failed = 0;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long i = 0; i < count && !failed; i++)
+    {
+        failed = mjrpc_shm_send(client, request, sizeof(request) - 1, -1) != MJRPC_RET_OK ||
+                 mjrpc_shm_recv(client, &response, &len, -1) != MJRPC_RET_OK;
+        mjrpc_shm_release(client);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    double seconds = elapsed(&t0, &t1);
+    printf("shm, %ld round trips: %.2f us each, %.0f req/s%s\n", count, seconds * 1e6 / (double) count,
+           (double) count / seconds, failed ? " [errors]" : "");
+
+    mjrpc_shm_shutdown(client);
+    waitpid(pid, NULL, 0);
+    mjrpc_shm_close(client);
+    mjrpc_shm_close(server);
+    return failed;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file string_bench.c
+ * @brief Parse and print throughput of string-heavy documents in cJSON
+ *
+ * Builds two documents, an array of base64 blobs and an array of log lines
+ * with occasional escapes, and times cJSON_ParseWithLength() and
+ * cJSON_PrintUnformatted() on each. The same source is built against the
+ * vectorized cJSON (mjsonrpc-bench-strings) and with CJSON_NO_SIMD
+ * (mjsonrpc-bench-strings-scalar) for comparison.
+ *
+ * Usage: mjsonrpc-bench-strings [iterations]
+ */
+
+#include "cJSON.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double elapsed(const struct timespec* t0, const struct timespec* t1)
+{
+    return (double) (t1->tv_sec - t0->tv_sec) + (double) (t1->tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+static cJSON* base64_document(void)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char blob[4097];
+    cJSON* array = cJSON_CreateArray();
+    unsigned int seed = 1;
+    for (int i = 0; i < 64; i++)
+    {
+        for (size_t j = 0; j < sizeof(blob) - 1; j++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            blob[j] = alphabet[(seed >> 16) & 63];
+        }
+        blob[sizeof(blob) - 1] = '\0';
+        cJSON_AddItemToArray(array, cJSON_CreateString(blob));
+    }
+    return array;
+}
+
+static cJSON* log_document(void)
+{
+    char line[256];
+    cJSON* array = cJSON_CreateArray();
+    for (int i = 0; i < 2048; i++)
+    {
+        snprintf(line, sizeof(line),
+                 "2024-05-%02d 12:%02d:%02d INFO worker-%d handled request /api/v1/items/%d "
+                 "in %d ms, user agent \"curl/8.5.0\"%s",
+                 i % 28 + 1, i % 60, (i * 7) % 60, i % 16, i * 31, i % 97, i % 8 ? "" : "\n\ttrace follows");
+        cJSON_AddItemToArray(array, cJSON_CreateString(line));
+    }
+    return array;
+}
+
+static int run(const char* name, cJSON* document, long iterations)
+{
+    char* text = cJSON_PrintUnformatted(document);
+    size_t len = strlen(text);
+    struct timespec t0, t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long i = 0; i < iterations; i++)
+    {
+        cJSON* parsed = cJSON_ParseWithLength(text, len);
+        if (parsed == NULL)
+        {
+            fprintf(stderr, "%s: parse failed\n", name);
+            free(text);
+            return 1;
+        }
+        cJSON_Delete(parsed);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double parse_s = elapsed(&t0, &t1);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long i = 0; i < iterations; i++)
+        free(cJSON_PrintUnformatted(document));
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double print_s = elapsed(&t0, &t1);
+
+    double mb = (double) len * (double) iterations / 1e6;
+    printf("%-8s %8zu bytes  parse %8.1f MB/s  print %8.1f MB/s\n", name, len, mb / parse_s, mb / print_s);
+    free(text);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 200;
+    cJSON* base64 = base64_document();
+    cJSON* logs = log_document();
+    int failed = run("base64", base64, iterations) || run("logs", logs, iterations);
+    cJSON_Delete(base64);
+    cJSON_Delete(logs);
+    return failed;
+}
@@ -0,0 +1,118 @@
+/**
+ * @file typed_array_bench.c
+ * @brief Numeric arrays as number items against typed arrays in cJSON
+ *
+ * For an array of doubles and an array of integers, 10000 elements each by
+ * default, times:
+ *   - parse:  cJSON_ParseWithLength() against cJSON_ParseWithLengthTyped()
+ *   - print:  cJSON_PrintUnformatted() of either tree
+ *   - create: cJSON_CreateDoubleArray() against cJSON_CreateTypedDoubleArray()
+ * and reports the heap held by each parsed tree (glibc mallinfo2()).
+ *
+ * Usage: mjsonrpc-bench-typed-arrays [elements] [iterations]
+ */
+
+#include "cJSON.h"
+
+#include <malloc.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double elapsed(const struct timespec* t0, const struct timespec* t1)
+{
+    return (double) (t1->tv_sec - t0->tv_sec) + (double) (t1->tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double) t.tv_sec + (double) t.tv_nsec / 1e9;
+}
+
+static size_t heap_in_use(void)
+{
+    return mallinfo2().uordblks;
+}
+
+static cJSON* parse(const char* text, size_t len, int typed)
+{
+    cJSON* item = typed ? cJSON_ParseWithLengthTyped(text, len, 1) : cJSON_ParseWithLength(text, len);
+    if (item == NULL)
+    {
+        fprintf(stderr, "parse failed\n");
+        exit(1);
+    }
+    return item;
+}
+
+static void report(const char* name, const char* text, long iterations)
+{
+    size_t len = strlen(text);
+    double mb = (double) len * (double) iterations / 1e6;
+    printf("%-8s %8zu bytes\n", name, len);
+    for (int typed = 0; typed < 2; typed++)
+    {
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (long i = 0; i < iterations; i++)
+            cJSON_Delete(parse(text, len, typed));
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double parse_s = elapsed(&t0, &t1);
+
+        size_t before = heap_in_use();
+        cJSON* item = parse(text, len, typed);
+        size_t held = heap_in_use() - before;
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (long i = 0; i < iterations; i++)
+            free(cJSON_PrintUnformatted(item));
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        cJSON_Delete(item);
+
+        printf("  %-6s parse %7.1f MB/s  print %7.1f MB/s  tree %9zu bytes\n", typed ? "typed" : "items", mb / parse_s,
+               mb / elapsed(&t0, &t1), held);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    long elements = argc > 1 ? atol(argv[1]) : 10000;
+    long iterations = argc > 2 ? atol(argv[2]) : 200;
+    double* samples = malloc((size_t) elements * sizeof(double));
+    long long* counters = malloc((size_t) elements * sizeof(long long));
+    for (long i = 0; i < elements; i++)
+    {
+        samples[i] = sin((double) i * 0.01) * 1000.0;
+        counters[i] = (long long) i * 7919 - 40000000;
+    }
+
+    cJSON* array = cJSON_CreateTypedDoubleArray(samples, (size_t) elements);
+    char* doubles = cJSON_PrintUnformatted(array);
+    cJSON_Delete(array);
+    array = cJSON_CreateTypedInt64Array(counters, (size_t) elements);
+    char* integers = cJSON_PrintUnformatted(array);
+    cJSON_Delete(array);
+
+    report("doubles", doubles, iterations);
+    report("integers", integers, iterations);
+
+    double t = now();
+    for (long i = 0; i < iterations; i++)
+        cJSON_Delete(cJSON_CreateDoubleArray(samples, (int) elements));
+    double items_s = now() - t;
+    t = now();
+    for (long i = 0; i < iterations; i++)
+        cJSON_Delete(cJSON_CreateTypedDoubleArray(samples, (size_t) elements));
+    printf("create   items %9.0f ns  typed %9.0f ns\n", items_s * 1e9 / (double) iterations,
+           (now() - t) * 1e9 / (double) iterations);
+
+    free(doubles);
+    free(integers);
+    free(samples);
+    free(counters);
+    return 0;
+}
@@ -26,9 +26,12 @@
 
 #include <ctype.h>
 #include <limits.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 /*--- memory management hooks ---*/
 
@@ -157,7 +160,6 @@ static int resize(mjrpc_handle_t *handle) {
   init_memory_hooks_if_needed();
   const size_t old_capacity = handle->capacity;
   struct mjrpc_method *old_methods = handle->methods;
-  int rehash_failures = 0;
 
   /* Check for potential overflow */
   if (old_capacity > SIZE_MAX / 2) {
@@ -176,43 +178,31 @@ static int resize(mjrpc_handle_t *handle) {
     return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
   }
   memset(handle->methods, 0, handle->capacity * sizeof(struct mjrpc_method));
-  handle->size = 0;
 
+  /* Names are unique and the new table has no tombstones, so every entry
+   * moves to the first empty slot of its probe sequence. Moving the entry
+   * keeps its name, argument and per-method state without copying. */
   for (size_t i = 0; i < old_capacity; i++) {
-    if (old_methods[i].state == OCCUPIED) {
-      /* Store name pointer before passing ownership */
-      char *name_copy = old_methods[i].name;
-      void *arg_copy = old_methods[i].arg;
-      mjrpc_func func_copy = old_methods[i].func;
-
-      int add_result = mjrpc_add_method(handle, func_copy, name_copy, arg_copy);
-      if (add_result != MJRPC_RET_OK) {
-        /* Failed to add method during resize, free the resources */
-        g_mjrpc_free(name_copy);
-        g_mjrpc_free(arg_copy);
-        rehash_failures++;
-        log_error("Method rehash failed during resize", add_result);
-        /* Continue with remaining methods instead of aborting */
-        continue;
-      }
-      /* mjrpc_add_method strdups the name, so free our copy.
-       * arg_copy is now owned by the new entry, do not free it. */
-      g_mjrpc_free(name_copy);
+    if (old_methods[i].state != OCCUPIED)
+      continue;
+    const char *name = old_methods[i].name;
+    size_t index = hash(name, handle->capacity);
+    size_t step_size = 0;
+    while (handle->methods[index].state != EMPTY) {
+      if (step_size == 0)
+        step_size = hash2(name, handle->capacity);
+      index = (index + step_size) & (handle->capacity - 1);
     }
+    handle->methods[index] = old_methods[i];
   }
   g_mjrpc_free(old_methods);
-
-  if (rehash_failures > 0) {
-    log_error("Hash table resize completed with method failures",
-              rehash_failures);
-  }
   return MJRPC_RET_OK;
 }
 
-static bool method_get(const mjrpc_handle_t *handle, const char *key,
-                       mjrpc_func *func, void **arg) {
-  if (handle == NULL || key == NULL || func == NULL || arg == NULL) {
-    return false;
+static const struct mjrpc_method *method_get(const mjrpc_handle_t *handle,
+                                             const char *key) {
+  if (handle == NULL || key == NULL) {
+    return NULL;
   }
 
   size_t index = hash(key, handle->capacity);
@@ -223,9 +213,7 @@ static bool method_get(const mjrpc_handle_t *handle, const char *key,
   while (handle->methods[index].state != EMPTY) {
     if (handle->methods[index].state == OCCUPIED &&
         strcmp(handle->methods[index].name, key) == 0) {
-      *func = handle->methods[index].func;
-      *arg = handle->methods[index].arg;
-      return true;
+      return &handle->methods[index];
     }
     probe_count++;
     if (probe_count >= handle->capacity) {
@@ -238,28 +226,881 @@ static bool method_get(const mjrpc_handle_t *handle, const char *key,
     }
     index = (index + step_size) & (handle->capacity - 1);
   }
+  return NULL;
+}
+
+/*--- method statistics ---*/
+
+/** @brief Sub-buckets per power of two in the latency histogram (log2) */
+#define STATS_SUB_BITS 2
+
+struct mjrpc_method_stats {
+  _Atomic uint64_t calls;
+  _Atomic uint64_t notifications;
+  _Atomic uint64_t errors;
+  _Atomic uint64_t other_errors;
+  _Atomic uint64_t latency_total_ns;
+  /* Error codes are claimed by the first failure that uses a free slot */
+  _Atomic int32_t codes[MJRPC_STATS_ERROR_CODES];
+  _Atomic uint64_t code_counts[MJRPC_STATS_ERROR_CODES];
+  _Atomic uint64_t latency[MJRPC_STATS_LATENCY_BUCKETS];
+  /* Next entry in the handle's list of retired statistics */
+  struct mjrpc_method_stats *next;
+};
+
+static struct mjrpc_method_stats *stats_new(void) {
+  struct mjrpc_method_stats *stats =
+      g_mjrpc_malloc(sizeof(struct mjrpc_method_stats));
+  if (stats != NULL)
+    memset(stats, 0, sizeof(*stats));
+  return stats;
+}
+
+static uint64_t stats_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Histogram bucket of a latency
+ *
+ * Values below 2^STATS_SUB_BITS get a bucket each; above, every power of two
+ * is split into 2^STATS_SUB_BITS equal parts.
+ */
+static size_t stats_bucket(uint64_t ns) {
+  if (ns < (1u << STATS_SUB_BITS))
+    return (size_t)ns;
+  int exp = 63;
+  while (!(ns >> exp))
+    exp--;
+  size_t sub = (size_t)(ns >> (exp - STATS_SUB_BITS)) &
+               ((1u << STATS_SUB_BITS) - 1);
+  size_t bucket = ((size_t)(exp - STATS_SUB_BITS + 1) << STATS_SUB_BITS) | sub;
+  return bucket < MJRPC_STATS_LATENCY_BUCKETS
+             ? bucket
+             : MJRPC_STATS_LATENCY_BUCKETS - 1;
+}
+
+static void stats_record(struct mjrpc_method_stats *stats, bool notification,
+                         int32_t error_code, uint64_t start_ns) {
+  uint64_t elapsed = stats_now_ns() - start_ns;
+  atomic_fetch_add_explicit(notification ? &stats->notifications
+                                         : &stats->calls,
+                            1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&stats->latency_total_ns, elapsed,
+                            memory_order_relaxed);
+  atomic_fetch_add_explicit(&stats->latency[stats_bucket(elapsed)], 1,
+                            memory_order_relaxed);
+  if (error_code == 0)
+    return;
+
+  atomic_fetch_add_explicit(&stats->errors, 1, memory_order_relaxed);
+  for (size_t i = 0; i < MJRPC_STATS_ERROR_CODES; i++) {
+    int32_t code = atomic_load_explicit(&stats->codes[i], memory_order_relaxed);
+    if (code == 0 && !atomic_compare_exchange_strong_explicit(
+                         &stats->codes[i], &code, error_code,
+                         memory_order_relaxed, memory_order_relaxed) &&
+        code != error_code)
+      continue; /* Another code took the slot first */
+    if (code == 0 || code == error_code) {
+      atomic_fetch_add_explicit(&stats->code_counts[i], 1,
+                                memory_order_relaxed);
+      return;
+    }
+  }
+  atomic_fetch_add_explicit(&stats->other_errors, 1, memory_order_relaxed);
+}
+
+/*--- response cache ---*/
+
+/*
+ * Entries sit in a chained hash table and a doubly linked LRU list. Entries
+ * are keyed by the name pointer of their method entry, which stays put until
+ * the method is replaced or deleted, and both drop its entries. Cache memory
+ * comes from the cJSON hooks: unlike the library hooks they are global, and
+ * entries are shared by every thread processing requests.
+ */
+struct cache_entry {
+  uint64_t hash;
+  const char *method;
+  cJSON *params; /* copy, NULL if the call had none */
+  cJSON *result; /* serialized result, a raw item shared with hits */
+  uint64_t expires_ns; /* 0 if the entry never expires */
+  struct cache_entry *newer;
+  struct cache_entry *older;
+  struct cache_entry *next; /* bucket chain */
+};
+
+struct mjrpc_cache {
+  /* Held only for table updates, never while a method runs */
+  atomic_flag lock;
+  struct cache_entry **buckets;
+  size_t bucket_mask;
+  /* Read without the lock to skip caching when it is off */
+  atomic_size_t capacity;
+  size_t count;
+  struct cache_entry *newest;
+  struct cache_entry *oldest;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  uint64_t expirations;
+};
+
+static void cache_lock(struct mjrpc_cache *cache) {
+  while (atomic_flag_test_and_set_explicit(&cache->lock, memory_order_acquire))
+    ;
+}
+
+static void cache_unlock(struct mjrpc_cache *cache) {
+  atomic_flag_clear_explicit(&cache->lock, memory_order_release);
+}
+
+static uint64_t hash_mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+static uint64_t hash_bytes(const char *str) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (; *str; str++)
+    h = (h ^ (unsigned char)*str) * 0x100000001b3ULL;
+  return h;
+}
+
+static uint64_t number_hash(double value) {
+  uint64_t bits;
+  if (value == 0)
+    value = 0;
+  memcpy(&bits, &value, sizeof(bits));
+  return hash_mix(((uint64_t)cJSON_Number + 1) ^ bits);
+}
+
+/**
+ * @brief Hash a JSON value independently of object member order
+ * @internal
+ */
+static uint64_t json_hash(const cJSON *item) {
+  if (item == NULL)
+    return 0;
+  if (cJSON_IsTypedArray(item)) {
+    /* As the array of number items it compares equal to */
+    uint64_t h = (uint64_t)cJSON_Array + 1;
+    size_t count = cJSON_GetTypedArraySize(item);
+    for (size_t i = 0; i < count; i++)
+      h = hash_mix(h) + number_hash(cJSON_GetTypedArrayNumber(item, i));
+    return hash_mix(h);
+  }
+  uint64_t h = (uint64_t)(item->type & 0xFF) + 1;
+  switch (item->type & 0xFF) {
+  case cJSON_Number:
+    return number_hash(item->valuedouble);
+  case cJSON_String:
+  case cJSON_Raw:
+    h ^= hash_bytes(item->valuestring ? item->valuestring : "");
+    break;
+  case cJSON_Array:
+    for (const cJSON *child = item->child; child; child = child->next)
+      h = hash_mix(h) + json_hash(child);
+    break;
+  case cJSON_Object: {
+    /* Members are combined with a commutative sum */
+    uint64_t sum = 0;
+    for (const cJSON *child = item->child; child; child = child->next)
+      sum += hash_mix(hash_bytes(child->string ? child->string : "") ^
+                      json_hash(child));
+    h ^= sum;
+    break;
+  }
+  }
+  return hash_mix(h);
+}
+
+static bool cache_params_equal(const cJSON *a, const cJSON *b) {
+  if (a == NULL || b == NULL)
+    return a == b;
+  return cJSON_Compare(a, b, true);
+}
+
+/**
+ * @brief Allocate the empty bucket array for a capacity
+ * @internal
+ */
+static struct cache_entry **cache_buckets_new(size_t capacity, size_t *mask) {
+  size_t bucket_count = next_power_of_2(capacity ? capacity : 1);
+  struct cache_entry **buckets =
+      cJSON_malloc(bucket_count * sizeof(struct cache_entry *));
+  if (buckets == NULL)
+    return NULL;
+  memset(buckets, 0, bucket_count * sizeof(struct cache_entry *));
+  *mask = bucket_count - 1;
+  return buckets;
+}
+
+static struct mjrpc_cache *cache_new(size_t capacity) {
+  struct mjrpc_cache *cache = cJSON_malloc(sizeof(struct mjrpc_cache));
+  if (cache == NULL)
+    return NULL;
+  memset(cache, 0, sizeof(*cache));
+  atomic_flag_clear(&cache->lock);
+  atomic_init(&cache->capacity, capacity);
+  cache->buckets = cache_buckets_new(capacity, &cache->bucket_mask);
+  if (cache->buckets == NULL) {
+    cJSON_free(cache);
+    return NULL;
+  }
+  return cache;
+}
+
+static void cache_entry_free(struct cache_entry *entry) {
+  cJSON_Delete(entry->params);
+  cJSON_Delete(entry->result);
+  cJSON_free(entry);
+}
+
+/* Frees a serialized result once the entry and every response using it are
+ * gone */
+static void cache_result_release(const char *value, void *user_data) {
+  (void)user_data;
+  cJSON_free((void *)value);
+}
+
+static struct cache_entry *cache_find(const struct mjrpc_cache *cache,
+                                      uint64_t hash, const char *method,
+                                      const cJSON *params) {
+  struct cache_entry *entry = cache->buckets[hash & cache->bucket_mask];
+  for (; entry != NULL; entry = entry->next) {
+    if (entry->hash == hash && entry->method == method &&
+        cache_params_equal(entry->params, params))
+      return entry;
+  }
+  return NULL;
+}
+
+static void cache_lru_unlink(struct mjrpc_cache *cache,
+                             struct cache_entry *entry) {
+  if (entry->newer)
+    entry->newer->older = entry->older;
+  else
+    cache->newest = entry->older;
+  if (entry->older)
+    entry->older->newer = entry->newer;
+  else
+    cache->oldest = entry->newer;
+}
+
+static void cache_lru_push(struct mjrpc_cache *cache,
+                           struct cache_entry *entry) {
+  entry->newer = NULL;
+  entry->older = cache->newest;
+  if (cache->newest)
+    cache->newest->newer = entry;
+  else
+    cache->oldest = entry;
+  cache->newest = entry;
+}
+
+/**
+ * @brief Take an entry out of the cache and free it
+ * @internal
+ */
+static void cache_remove(struct mjrpc_cache *cache, struct cache_entry *entry) {
+  struct cache_entry **link = &cache->buckets[entry->hash & cache->bucket_mask];
+  while (*link != entry)
+    link = &(*link)->next;
+  *link = entry->next;
+  cache_lru_unlink(cache, entry);
+  cache->count--;
+  cache_entry_free(entry);
+}
+
+static void cache_insert(struct mjrpc_cache *cache, struct cache_entry *entry) {
+  struct cache_entry *old =
+      cache_find(cache, entry->hash, entry->method, entry->params);
+  if (old != NULL)
+    cache_remove(cache, old);
+  struct cache_entry **bucket =
+      &cache->buckets[entry->hash & cache->bucket_mask];
+  entry->next = *bucket;
+  *bucket = entry;
+  cache_lru_push(cache, entry);
+  cache->count++;
+  while (cache->count >
+         atomic_load_explicit(&cache->capacity, memory_order_relaxed)) {
+    cache_remove(cache, cache->oldest);
+    cache->evictions++;
+  }
+}
+
+static void cache_drop_locked(struct mjrpc_cache *cache, const char *method) {
+  struct cache_entry *entry = cache->newest;
+  while (entry != NULL) {
+    struct cache_entry *older = entry->older;
+    if (method == NULL || entry->method == method)
+      cache_remove(cache, entry);
+    entry = older;
+  }
+}
+
+/**
+ * @brief Drop the entries of one method (all entries if @p method is NULL)
+ * @internal
+ */
+static void cache_drop(struct mjrpc_cache *cache, const char *method) {
+  if (cache == NULL)
+    return;
+  cache_lock(cache);
+  cache_drop_locked(cache, method);
+  cache_unlock(cache);
+}
+
+/**
+ * @brief Empty the cache and switch it to a new capacity
+ *
+ * The cache object stays in place and is only changed under its lock, so
+ * requests being processed meanwhile keep using it safely.
+ *
+ * @return false on allocation failure, leaving the cache unchanged
+ * @internal
+ */
+static bool cache_resize(struct mjrpc_cache *cache, size_t capacity) {
+  size_t mask;
+  struct cache_entry **buckets = cache_buckets_new(capacity, &mask);
+  if (buckets == NULL)
+    return false;
+  cache_lock(cache);
+  cache_drop_locked(cache, NULL);
+  struct cache_entry **old = cache->buckets;
+  cache->buckets = buckets;
+  cache->bucket_mask = mask;
+  atomic_store_explicit(&cache->capacity, capacity, memory_order_relaxed);
+  cache_unlock(cache);
+  cJSON_free(old);
+  return true;
+}
+
+static void cache_destroy(struct mjrpc_cache *cache) {
+  if (cache == NULL)
+    return;
+  cache_drop(cache, NULL);
+  cJSON_free(cache->buckets);
+  cJSON_free(cache);
+}
+
+/*--- single flight ---*/
+
+#define FLIGHT_BUCKETS 64
+
+/*
+ * A call of a single-flight method registers itself here while it runs.
+ * Identical calls arriving meanwhile join it as waiters instead of running
+ * the method; the last one to take its copy of the response frees the
+ * flight. Like cache entries, flights are keyed by method name pointer and
+ * live in cJSON memory because they are shared between threads.
+ */
+struct flight {
+  uint64_t hash;
+  const char *method;
+  cJSON *params; /* copy, NULL if the call had none */
+  atomic_size_t waiters;
+  atomic_bool done;
+  cJSON *response; /* leader's response without id, NULL on failure */
+  struct flight *next;
+};
+
+struct mjrpc_flights {
+  /* Held only to register, join or retire a flight */
+  atomic_flag lock;
+  struct flight *buckets[FLIGHT_BUCKETS];
+};
+
+static void flights_lock(struct mjrpc_flights *flights) {
+  while (
+      atomic_flag_test_and_set_explicit(&flights->lock, memory_order_acquire))
+    ;
+}
+
+static void flights_unlock(struct mjrpc_flights *flights) {
+  atomic_flag_clear_explicit(&flights->lock, memory_order_release);
+}
+
+static struct mjrpc_flights *flights_new(void) {
+  struct mjrpc_flights *flights = cJSON_malloc(sizeof(struct mjrpc_flights));
+  if (flights == NULL)
+    return NULL;
+  memset(flights, 0, sizeof(*flights));
+  atomic_flag_clear(&flights->lock);
+  return flights;
+}
+
+static void flight_free(struct flight *flight) {
+  cJSON_Delete(flight->params);
+  cJSON_Delete(flight->response);
+  cJSON_free(flight);
+}
+
+/**
+ * @brief Block until the leader of a flight has published its response
+ * @internal
+ *
+ * Spins briefly, then sleeps with exponential backoff so long-running
+ * methods do not burn the waiting threads' CPU.
+ */
+static void flight_wait(const struct flight *flight) {
+  unsigned spins = 0;
+  struct timespec delay = {0, 1000};
+  while (!atomic_load_explicit(&flight->done, memory_order_acquire)) {
+    if (spins++ < 128)
+      continue;
+    nanosleep(&delay, NULL);
+    if (delay.tv_nsec < 256000)
+      delay.tv_nsec *= 2;
+  }
+}
+
+/*--- namespace routing ---*/
+
+enum route_kind { ROUTE_NONE, ROUTE_HANDLE, ROUTE_FUNC };
+
+/**
+ * @brief Node of the namespace radix trie
+ * @internal
+ *
+ * Every edge carries a label of one or more bytes; sibling labels start with
+ * distinct bytes and are kept sorted by that byte. Keys are stored with their
+ * trailing '.', so a match always ends on a namespace boundary. Removal
+ * merges a node left without entry and with a single child into that child,
+ * so the trie stays compact across register/unregister cycles.
+ */
+struct mjrpc_route {
+  char *label;
+  size_t label_len;
+  struct mjrpc_route **children;
+  size_t child_count;
+  int kind;
+  mjrpc_handle_t *child;
+  mjrpc_func func;
+  void *arg;
+};
+
+static struct mjrpc_route *route_new(const char *label, size_t label_len) {
+  struct mjrpc_route *node = g_mjrpc_malloc(sizeof(struct mjrpc_route));
+  if (node == NULL)
+    return NULL;
+  memset(node, 0, sizeof(struct mjrpc_route));
+  node->label = g_mjrpc_malloc(label_len + 1);
+  if (node->label == NULL) {
+    g_mjrpc_free(node);
+    return NULL;
+  }
+  memcpy(node->label, label, label_len);
+  node->label[label_len] = '\0';
+  node->label_len = label_len;
+  return node;
+}
+
+static void route_clear(struct mjrpc_route *node) {
+  if (node->kind == ROUTE_FUNC && node->arg != NULL)
+    g_mjrpc_free(node->arg);
+  node->kind = ROUTE_NONE;
+  node->child = NULL;
+  node->func = NULL;
+  node->arg = NULL;
+}
+
+static void route_free(struct mjrpc_route *node) {
+  if (node == NULL)
+    return;
+  for (size_t i = 0; i < node->child_count; i++)
+    route_free(node->children[i]);
+  route_clear(node);
+  g_mjrpc_free(node->children);
+  g_mjrpc_free(node->label);
+  g_mjrpc_free(node);
+}
+
+/**
+ * @brief Binary search for the child whose label starts with @p first
+ * @param pos Receives the index of the child, or where it would be inserted
+ *            (can be NULL)
+ * @internal
+ */
+static struct mjrpc_route *route_find_child(const struct mjrpc_route *node,
+                                            char first, size_t *pos) {
+  size_t lo = 0;
+  size_t hi = node->child_count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    unsigned char at = (unsigned char)node->children[mid]->label[0];
+    if (at == (unsigned char)first) {
+      lo = mid;
+      break;
+    }
+    if (at < (unsigned char)first)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (pos)
+    *pos = lo;
+  if (lo < node->child_count && node->children[lo]->label[0] == first)
+    return node->children[lo];
+  return NULL;
+}
+
+static int route_insert_child(struct mjrpc_route *node, size_t pos,
+                              struct mjrpc_route *child) {
+  struct mjrpc_route **children = g_mjrpc_malloc(
+      (node->child_count + 1) * sizeof(struct mjrpc_route *));
+  if (children == NULL)
+    return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+  if (pos > 0)
+    memcpy(children, node->children, pos * sizeof(struct mjrpc_route *));
+  children[pos] = child;
+  if (node->child_count > pos)
+    memcpy(children + pos + 1, node->children + pos,
+           (node->child_count - pos) * sizeof(struct mjrpc_route *));
+  g_mjrpc_free(node->children);
+  node->children = children;
+  node->child_count++;
+  return MJRPC_RET_OK;
+}
+
+/**
+ * @brief Fold a node without entry into its only child
+ * @return The child now standing in for @p node, or @p node unchanged on
+ *         allocation failure (the trie stays valid, only less compact)
+ * @internal
+ */
+static struct mjrpc_route *route_merge(struct mjrpc_route *node) {
+  struct mjrpc_route *only = node->children[0];
+  char *label = g_mjrpc_malloc(node->label_len + only->label_len + 1);
+  if (label == NULL)
+    return node;
+  memcpy(label, node->label, node->label_len);
+  memcpy(label + node->label_len, only->label, only->label_len + 1);
+  g_mjrpc_free(only->label);
+  only->label = label;
+  only->label_len += node->label_len;
+  node->child_count = 0;
+  route_free(node);
+  return only;
+}
+
+/**
+ * @brief Find or create the trie node for a key, splitting edges as needed
+ * @return Node for key, or NULL on allocation failure
+ * @internal
+ */
+static struct mjrpc_route *route_insert(struct mjrpc_route *root,
+                                        const char *key, size_t key_len) {
+  struct mjrpc_route *node = root;
+  while (key_len > 0) {
+    size_t pos = 0;
+    struct mjrpc_route *next = route_find_child(node, key[0], &pos);
+    if (next == NULL) {
+      struct mjrpc_route *leaf = route_new(key, key_len);
+      if (leaf == NULL)
+        return NULL;
+      if (route_insert_child(node, pos, leaf) != MJRPC_RET_OK) {
+        route_free(leaf);
+        return NULL;
+      }
+      return leaf;
+    }
+
+    size_t common = 0;
+    while (common < next->label_len && common < key_len &&
+           next->label[common] == key[common])
+      common++;
+
+    if (common < next->label_len) {
+      /* Split the edge: node -> mid(label[0..common)) -> next(rest) */
+      struct mjrpc_route *mid = route_new(next->label, common);
+      if (mid == NULL)
+        return NULL;
+      char *rest = g_mjrpc_malloc(next->label_len - common + 1);
+      if (rest == NULL || route_insert_child(mid, 0, next) != MJRPC_RET_OK) {
+        g_mjrpc_free(rest);
+        route_free(mid);
+        return NULL;
+      }
+      memcpy(rest, next->label + common, next->label_len - common + 1);
+      g_mjrpc_free(next->label);
+      next->label = rest;
+      next->label_len -= common;
+      node->children[pos] = mid;
+      next = mid;
+    }
+    node = next;
+    key += common;
+    key_len -= common;
+  }
+  return node;
+}
+
+/**
+ * @brief Remove the entry for a key, pruning nodes that became empty and
+ *        merging those left with a single child
+ * @return true if an entry was removed
+ * @internal
+ */
+static bool route_remove(struct mjrpc_route *node, const char *key,
+                         size_t key_len) {
+  if (key_len == 0) {
+    if (node->kind == ROUTE_NONE)
+      return false;
+    route_clear(node);
+    return true;
+  }
+  size_t pos = 0;
+  struct mjrpc_route *next = route_find_child(node, key[0], &pos);
+  if (next == NULL || next->label_len > key_len ||
+      memcmp(next->label, key, next->label_len) != 0)
+    return false;
+  if (!route_remove(next, key + next->label_len, key_len - next->label_len))
+    return false;
+  if (next->kind == ROUTE_NONE && next->child_count == 0) {
+    route_free(next);
+    memmove(node->children + pos, node->children + pos + 1,
+            (--node->child_count - pos) * sizeof(struct mjrpc_route *));
+  } else if (next->kind == ROUTE_NONE && next->child_count == 1) {
+    node->children[pos] = route_merge(next);
+  }
+  return true;
+}
+
+/**
+ * @brief Find the longest registered namespace that prefixes a method name
+ * @param routes Trie root (can be NULL)
+ * @param name Method name
+ * @param suffix Receives the part of name after the matched prefix
+ * @return Matching node, or NULL if no namespace matches
+ * @internal
+ */
+static const struct mjrpc_route *route_get(const struct mjrpc_route *routes,
+                                           const char *name,
+                                           const char **suffix) {
+  const struct mjrpc_route *best = NULL;
+  const struct mjrpc_route *node = routes;
+  size_t pos = 0;
+  while (node != NULL) {
+    if (node->kind != ROUTE_NONE) {
+      best = node;
+      *suffix = name + pos;
+    }
+    if (name[pos] == '\0')
+      break;
+    node = route_find_child(node, name[pos], NULL);
+    if (node == NULL || strncmp(name + pos, node->label, node->label_len) != 0)
+      break;
+    pos += node->label_len;
+  }
+  return best;
+}
+
+static int route_add(mjrpc_handle_t *handle, const char *prefix, int kind,
+                     mjrpc_handle_t *child, mjrpc_func func, void *arg) {
+  init_memory_hooks_if_needed();
+  if (handle->routes == NULL) {
+    handle->routes = route_new("", 0);
+    if (handle->routes == NULL)
+      return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+  }
+
+  /* Keys carry the namespace separator so "a" never matches "ab.x" */
+  const size_t prefix_len = strlen(prefix);
+  char *key = g_mjrpc_malloc(prefix_len + 2);
+  if (key == NULL)
+    return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+  memcpy(key, prefix, prefix_len);
+  key[prefix_len] = '.';
+  key[prefix_len + 1] = '\0';
+
+  struct mjrpc_route *node = route_insert(handle->routes, key, prefix_len + 1);
+  g_mjrpc_free(key);
+  if (node == NULL) {
+    log_error("Route insertion failed", MJRPC_RET_ERROR_MEM_ALLOC_FAILED);
+    return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+  }
+  route_clear(node);
+  node->kind = kind;
+  node->child = child;
+  node->func = func;
+  node->arg = arg;
+  return MJRPC_RET_OK;
+}
+
+/*--- params access ---*/
+
+/**
+ * @brief Open-addressed table of object params keyed by case-folded name
+ * @internal
+ *
+ * Linear probing keeps members with equal names in member order along their
+ * probe sequence, so the first match is the first matching member.
+ */
+struct mjrpc_params_names {
+  size_t mask;
+  struct {
+    uint64_t hash;
+    cJSON *item;
+  } slots[];
+};
+
+static void params_view_init(mjrpc_func_ctx_t *ctx, const cJSON *params) {
+  ctx->params = params;
+  ctx->params_count = -1;
+  ctx->params_index = NULL;
+  ctx->params_names = NULL;
+}
+
+static void params_view_release(mjrpc_func_ctx_t *ctx) {
+  if (ctx->params_index != ctx->params_inline)
+    g_mjrpc_free(ctx->params_index);
+  ctx->params_index = NULL;
+  g_mjrpc_free(ctx->params_names);
+  ctx->params_names = NULL;
+}
+
+/* FNV-1a like hash_bytes() but with ASCII case folded, as cJSON compares */
+static uint64_t fold_hash(const char *key) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (; *key; key++)
+    h = (h ^ (unsigned char)tolower((unsigned char)*key)) * 0x100000001b3ULL;
+  return h;
+}
+
+static bool fold_equal(const char *a, const char *b) {
+  for (; tolower((unsigned char)*a) == tolower((unsigned char)*b); a++, b++) {
+    if (*a == '\0')
+      return true;
+  }
   return false;
 }
 
+static struct mjrpc_params_names *params_names_build(mjrpc_func_ctx_t *ctx) {
+  size_t capacity = 16;
+  while (capacity < (size_t)ctx->params_count * 2)
+    capacity <<= 1;
+  struct mjrpc_params_names *names = g_mjrpc_malloc(
+      sizeof(struct mjrpc_params_names) + capacity * sizeof(names->slots[0]));
+  if (names == NULL) {
+    log_error("Params names allocation failed",
+              MJRPC_RET_ERROR_MEM_ALLOC_FAILED);
+    return NULL;
+  }
+  names->mask = capacity - 1;
+  memset(names->slots, 0, capacity * sizeof(names->slots[0]));
+  for (cJSON *item = ctx->params->child; item != NULL; item = item->next) {
+    if (item->string == NULL)
+      continue;
+    uint64_t hash_value = fold_hash(item->string);
+    size_t index = (size_t)hash_value & names->mask;
+    while (names->slots[index].item != NULL)
+      index = (index + 1) & names->mask;
+    names->slots[index].hash = hash_value;
+    names->slots[index].item = item;
+  }
+  return names;
+}
+
+static cJSON *params_get(mjrpc_func_ctx_t *ctx, const char *name,
+                         bool case_sensitive) {
+  if (ctx == NULL || name == NULL || !cJSON_IsObject(ctx->params))
+    return NULL;
+  if (ctx->params_names == NULL) {
+    /* Small objects are scanned, and so is everything without memory */
+    if (mjrpc_params_size(ctx) <= MJRPC_PARAMS_INLINE ||
+        (ctx->params_names = params_names_build(ctx)) == NULL)
+      return case_sensitive
+                 ? cJSON_GetObjectItemCaseSensitive(ctx->params, name)
+                 : cJSON_GetObjectItem(ctx->params, name);
+  }
+
+  const struct mjrpc_params_names *names = ctx->params_names;
+  uint64_t hash_value = fold_hash(name);
+  for (size_t index = (size_t)hash_value & names->mask;
+       names->slots[index].item != NULL; index = (index + 1) & names->mask) {
+    if (names->slots[index].hash != hash_value)
+      continue;
+    cJSON *item = names->slots[index].item;
+    if (case_sensitive ? strcmp(item->string, name) == 0
+                       : fold_equal(item->string, name))
+      return item;
+  }
+  return NULL;
+}
+
+int mjrpc_params_size(mjrpc_func_ctx_t *ctx) {
+  if (ctx == NULL)
+    return 0;
+  if (ctx->params_count < 0) {
+    int count = 0;
+    if (cJSON_IsArray(ctx->params) || cJSON_IsObject(ctx->params))
+      for (const cJSON *item = ctx->params->child; item != NULL;
+           item = item->next)
+        count++;
+    ctx->params_count = count;
+  }
+  return ctx->params_count;
+}
+
+cJSON *mjrpc_params_at(mjrpc_func_ctx_t *ctx, int index) {
+  int count = mjrpc_params_size(ctx);
+  if (index < 0 || index >= count)
+    return NULL;
+  if (ctx->params_index == NULL) {
+    cJSON **entries = ctx->params_inline;
+    if (count > MJRPC_PARAMS_INLINE)
+      entries = g_mjrpc_malloc((size_t)count * sizeof(cJSON *));
+    if (entries == NULL) {
+      log_error("Params index allocation failed",
+                MJRPC_RET_ERROR_MEM_ALLOC_FAILED);
+      /* Still answer, just without the index */
+      return cJSON_GetArrayItem(ctx->params, index);
+    }
+    int i = 0;
+    for (cJSON *item = ctx->params->child; item != NULL; item = item->next)
+      entries[i++] = item;
+    ctx->params_index = entries;
+  }
+  return ctx->params_index[index];
+}
+
+cJSON *mjrpc_params_get(mjrpc_func_ctx_t *ctx, const char *name) {
+  return params_get(ctx, name, false);
+}
+
+cJSON *mjrpc_params_get_case_sensitive(mjrpc_func_ctx_t *ctx,
+                                       const char *name) {
+  return params_get(ctx, name, true);
+}
+
 /*--- private functions ---*/
 
-static cJSON *invoke_callback(const mjrpc_handle_t *handle,
-                              const char *method_name, cJSON *params, cJSON *id,
-                              int params_type) {
+static cJSON *call_method(mjrpc_func func, void *arg, const char *suffix,
+                          cJSON *params, cJSON *id, int params_type,
+                          struct mjrpc_method_stats *stats) {
+  uint64_t start_ns = stats ? stats_now_ns() : 0;
   cJSON *returned = NULL;
-  mjrpc_func func = NULL;
-  void *arg = NULL;
   mjrpc_func_ctx_t ctx = {0};
   ctx.error_code = 0;
   ctx.error_message = NULL;
   ctx.error_data = NULL;
   ctx.params_type = params_type;
-  if (!method_get(handle, method_name, &func, &arg) || !func) {
-    return mjrpc_response_error(JSON_RPC_CODE_METHOD_NOT_FOUND,
-                                "Method not found.", id);
-  }
+  ctx.method_suffix = suffix;
   ctx.data = arg;
+  params_view_init(&ctx, params);
   returned = func(&ctx, params, id);
+  params_view_release(&ctx);
+  if (stats)
+    stats_record(stats, id == NULL, ctx.error_code, start_ns);
   if (ctx.error_code) {
     cJSON_Delete(returned);
     cJSON *err_resp =
@@ -286,6 +1127,505 @@ static cJSON *invoke_callback(const mjrpc_handle_t *handle,
   return mjrpc_response_ok(returned, id);
 }
 
+/*--- asynchronous calls ---*/
+
+/**
+ * @brief "After" stage of one interceptor, with the state its "before" set
+ * @internal
+ */
+struct after_stage {
+  mjrpc_after_func after;
+  void *arg;
+  void *state;
+};
+
+/**
+ * @brief "After" stages owed to the call being dispatched
+ * @internal
+ *
+ * Lives on the stack of the interceptor chain. An asynchronous method takes
+ * a copy into its token and clears the pointer in the dispatch, so the
+ * stages run when the token completes rather than when the method returns.
+ */
+struct after_stages {
+  const char *method;
+  const struct after_stage *stages;
+  size_t count;
+};
+
+/**
+ * @brief Copy of struct after_stages owned by an asynchronous token
+ * @internal
+ */
+struct async_after {
+  char *method;
+  size_t count;
+  struct after_stage stages[];
+};
+
+/**
+ * @brief Run "after" stages in reverse order of their "before" stages
+ * @internal
+ */
+static void run_after_stages(const struct after_stage *stages, size_t count,
+                             mjrpc_intercept_ctx_t *ctx, cJSON *response) {
+  while (count-- > 0) {
+    if (stages[count].after == NULL)
+      continue;
+    ctx->data = stages[count].arg;
+    ctx->state = stages[count].state;
+    stages[count].after(ctx, response);
+  }
+}
+
+/**
+ * @brief Responses of a batch request that contains asynchronous calls
+ * @internal
+ *
+ * Every element owns one slot, written by exactly one thread. The response
+ * array is assembled by whoever drops pending to zero; the dispatcher holds
+ * one reference while it walks the batch so early completions cannot
+ * deliver a partial array.
+ */
+struct async_batch {
+  cJSON **slots;
+  size_t slot_count;
+  atomic_size_t pending;
+  mjrpc_response_func on_response;
+  void *user_data;
+  mjrpc_free_func free_fn;
+};
+
+/**
+ * @brief State of one mjrpc_process_async() call
+ * @internal
+ */
+struct async_dispatch {
+  mjrpc_response_func on_response;
+  void *user_data;
+  /** @brief Tokens handed out while processing the request */
+  size_t pending;
+  /** @brief Whether any pending token will produce a response */
+  bool expects_response;
+  /** @brief Batch and slot of the element being dispatched (NULL/0 for a
+   * single request) */
+  struct async_batch *batch;
+  size_t slot;
+  /** @brief Interceptor stages of the call being dispatched, NULL if none */
+  const struct after_stages *after;
+};
+
+struct mjrpc_async_token {
+  /** @brief Copy of the request id, NULL for notifications */
+  cJSON *id;
+  mjrpc_response_func on_response;
+  void *user_data;
+  /** @brief Owning batch, NULL for a single request */
+  struct async_batch *batch;
+  size_t slot;
+  /** @brief Free hook of the creating thread; completion may happen on a
+   * thread with different hooks */
+  mjrpc_free_func free_fn;
+  /** @brief Statistics of the method, NULL if disabled */
+  struct mjrpc_method_stats *stats;
+  uint64_t start_ns;
+  /** @brief Interceptor stages to run on completion, NULL if none */
+  struct async_after *after;
+};
+
+/**
+ * @brief Copy the pending "after" stages of a dispatch for its token
+ * @return The copy, or NULL on allocation failure
+ * @internal
+ */
+static struct async_after *async_after_create(const struct after_stages *from) {
+  struct async_after *after = g_mjrpc_malloc(
+      sizeof(struct async_after) + from->count * sizeof(struct after_stage));
+  if (after == NULL)
+    return NULL;
+  after->method = g_mjrpc_strdup(from->method);
+  if (after->method == NULL) {
+    g_mjrpc_free(after);
+    return NULL;
+  }
+  after->count = from->count;
+  memcpy(after->stages, from->stages,
+         from->count * sizeof(struct after_stage));
+  return after;
+}
+
+static cJSON *call_async_method(mjrpc_async_func func, void *arg,
+                                cJSON *params, cJSON *id, int params_type,
+                                struct async_dispatch *dispatch,
+                                struct mjrpc_method_stats *stats) {
+  uint64_t start_ns = stats ? stats_now_ns() : 0;
+  if (dispatch == NULL) {
+    if (stats)
+      stats_record(stats, id == NULL, JSON_RPC_CODE_INTERNAL_ERROR, start_ns);
+    return mjrpc_response_error(
+        JSON_RPC_CODE_INTERNAL_ERROR,
+        "Asynchronous method requires mjrpc_process_async().", id);
+  }
+
+  mjrpc_async_token_t *token = g_mjrpc_malloc(sizeof(mjrpc_async_token_t));
+  if (token == NULL) {
+    log_error("Async token allocation failed",
+              MJRPC_RET_ERROR_MEM_ALLOC_FAILED);
+    if (stats)
+      stats_record(stats, id == NULL, JSON_RPC_CODE_INTERNAL_ERROR, start_ns);
+    return mjrpc_response_error(JSON_RPC_CODE_INTERNAL_ERROR,
+                                "Out of memory.", id);
+  }
+  token->after = NULL;
+  if (dispatch->after != NULL) {
+    token->after = async_after_create(dispatch->after);
+    if (token->after == NULL) {
+      g_mjrpc_free(token);
+      log_error("Async token allocation failed",
+                MJRPC_RET_ERROR_MEM_ALLOC_FAILED);
+      if (stats)
+        stats_record(stats, id == NULL, JSON_RPC_CODE_INTERNAL_ERROR,
+                     start_ns);
+      return mjrpc_response_error(JSON_RPC_CODE_INTERNAL_ERROR,
+                                  "Out of memory.", id);
+    }
+    /* The token runs them now, once it completes */
+    dispatch->after = NULL;
+  }
+  token->id = id;
+  token->on_response = dispatch->on_response;
+  token->user_data = dispatch->user_data;
+  token->batch = dispatch->batch;
+  token->slot = dispatch->slot;
+  token->free_fn = g_mjrpc_free;
+  token->stats = stats;
+  token->start_ns = start_ns;
+  if (token->batch != NULL)
+    atomic_fetch_add_explicit(&token->batch->pending, 1, memory_order_relaxed);
+  dispatch->pending++;
+  if (id != NULL)
+    dispatch->expects_response = true;
+
+  mjrpc_func_ctx_t ctx = {0};
+  ctx.data = arg;
+  ctx.params_type = params_type;
+  params_view_init(&ctx, params);
+  func(&ctx, params, id, token);
+  params_view_release(&ctx);
+  /* Errors are reported through mjrpc_fail(); drop anything left here */
+  cJSON_Delete(ctx.error_data);
+  g_mjrpc_free(ctx.error_message);
+  return NULL;
+}
+
+/**
+ * @brief Move the non-empty slots of a batch into a response array
+ * @return The array, or NULL if every element was a notification
+ * @internal
+ */
+static cJSON *collect_slots(cJSON **slots, size_t count) {
+  cJSON *array = NULL;
+  for (size_t i = 0; i < count; i++) {
+    if (slots[i] == NULL)
+      continue;
+    if (array == NULL)
+      array = cJSON_CreateArray();
+    if (array == NULL || !cJSON_AddItemToArray(array, slots[i]))
+      cJSON_Delete(slots[i]);
+  }
+  return array;
+}
+
+/**
+ * @brief Drop one reference to a batch, delivering it on the last one
+ * @internal
+ */
+static void async_batch_release(struct async_batch *batch) {
+  if (atomic_fetch_sub_explicit(&batch->pending, 1, memory_order_acq_rel) != 1)
+    return;
+
+  cJSON *array = collect_slots(batch->slots, batch->slot_count);
+  mjrpc_response_func on_response = batch->on_response;
+  void *user_data = batch->user_data;
+  batch->free_fn(batch->slots);
+  batch->free_fn(batch);
+  on_response(array, user_data);
+}
+
+static void async_finish(mjrpc_async_token_t *token, cJSON *response) {
+  struct async_after *after = token->after;
+  if (after != NULL) {
+    /* The request is gone by now; only the method name was kept */
+    mjrpc_intercept_ctx_t ctx = {0};
+    ctx.method = after->method;
+    run_after_stages(after->stages, after->count, &ctx, response);
+    token->free_fn(after->method);
+    token->free_fn(after);
+  }
+  struct async_batch *batch = token->batch;
+  if (batch != NULL) {
+    batch->slots[token->slot] = response;
+    token->free_fn(token);
+    async_batch_release(batch);
+    return;
+  }
+  mjrpc_response_func on_response = token->on_response;
+  void *user_data = token->user_data;
+  token->free_fn(token);
+  on_response(response, user_data);
+}
+
+/**
+ * @brief Call a synchronous method, sharing the run of an identical call
+ * @param shared Set if the response is a copy of another call's response
+ * @internal
+ */
+static cJSON *call_sync_method(const mjrpc_handle_t *handle,
+                               const struct mjrpc_method *method,
+                               cJSON *params, cJSON *id, int params_type,
+                               bool *shared) {
+  struct mjrpc_flights *flights = handle->flights;
+  *shared = false;
+  if (!method->single_flight || flights == NULL || id == NULL)
+    return call_method(method->func, method->arg, NULL, params, id,
+                       params_type, method->stats);
+
+  uint64_t start_ns = method->stats ? stats_now_ns() : 0;
+  uint64_t hash = hash_mix(hash_bytes(method->name) ^ json_hash(params));
+  struct flight **bucket = &flights->buckets[hash % FLIGHT_BUCKETS];
+  struct flight *flight;
+  flights_lock(flights);
+  for (flight = *bucket; flight != NULL; flight = flight->next) {
+    if (flight->hash == hash && flight->method == method->name &&
+        cache_params_equal(flight->params, params))
+      break;
+  }
+  if (flight != NULL) {
+    atomic_fetch_add_explicit(&flight->waiters, 1, memory_order_relaxed);
+    flights_unlock(flights);
+    flight_wait(flight);
+    cJSON *response =
+        flight->response ? cJSON_Duplicate(flight->response, true) : NULL;
+    if (atomic_fetch_sub_explicit(&flight->waiters, 1,
+                                  memory_order_acq_rel) == 1)
+      flight_free(flight);
+    if (response == NULL) /* The leader failed to share; run it here */
+      return call_method(method->func, method->arg, NULL, params, id,
+                         params_type, method->stats);
+    cJSON_AddItemToObjectCS(response, "id", id);
+    if (method->stats) {
+      cJSON *code = cJSON_GetObjectItemCaseSensitive(
+          cJSON_GetObjectItemCaseSensitive(response, "error"), "code");
+      stats_record(method->stats, false, code ? code->valueint : 0, start_ns);
+    }
+    *shared = true;
+    return response;
+  }
+
+  /* Lead: without the copy of params the call just runs unshared */
+  flight = cJSON_malloc(sizeof(struct flight));
+  cJSON *params_copy = params ? cJSON_Duplicate(params, true) : NULL;
+  if (flight == NULL || (params != NULL && params_copy == NULL)) {
+    flights_unlock(flights);
+    cJSON_free(flight);
+    cJSON_Delete(params_copy);
+    return call_method(method->func, method->arg, NULL, params, id,
+                       params_type, method->stats);
+  }
+  flight->hash = hash;
+  flight->method = method->name;
+  flight->params = params_copy;
+  atomic_init(&flight->waiters, 0);
+  atomic_init(&flight->done, false);
+  flight->response = NULL;
+  flight->next = *bucket;
+  *bucket = flight;
+  flights_unlock(flights);
+
+  cJSON *response = call_method(method->func, method->arg, NULL, params, id,
+                                params_type, method->stats);
+
+  flights_lock(flights);
+  struct flight **link = bucket;
+  while (*link != flight)
+    link = &(*link)->next;
+  *link = flight->next;
+  flights_unlock(flights);
+  /* Nobody can join any more, so the waiter count is final */
+  if (atomic_load_explicit(&flight->waiters, memory_order_acquire) == 0) {
+    flight_free(flight);
+    return response;
+  }
+  flight->response = cJSON_Duplicate(response, true);
+  cJSON_DeleteItemFromObjectCaseSensitive(flight->response, "id");
+  atomic_store_explicit(&flight->done, true, memory_order_release);
+  return response;
+}
+
+/**
+ * @brief Answer a call of a cacheable method, from the cache if possible
+ * @internal
+ */
+static cJSON *call_cached_method(const mjrpc_handle_t *handle,
+                                 const struct mjrpc_method *method,
+                                 cJSON *params, cJSON *id, int params_type) {
+  struct mjrpc_cache *cache = handle->cache;
+  bool shared;
+  if (cache == NULL || id == NULL ||
+      atomic_load_explicit(&cache->capacity, memory_order_relaxed) == 0)
+    return call_sync_method(handle, method, params, id, params_type, &shared);
+
+  uint64_t start_ns = method->stats ? stats_now_ns() : 0;
+  uint64_t hash = hash_mix(hash_bytes(method->name) ^ json_hash(params));
+  cJSON *raw = NULL;
+  cache_lock(cache);
+  struct cache_entry *entry = cache_find(cache, hash, method->name, params);
+  if (entry != NULL && entry->expires_ns != 0 &&
+      stats_now_ns() >= entry->expires_ns) {
+    cache_remove(cache, entry);
+    cache->expirations++;
+    entry = NULL;
+  }
+  if (entry != NULL) {
+    cache_lru_unlink(cache, entry);
+    cache_lru_push(cache, entry);
+    cache->hits++;
+    /* The response shares the text instead of copying it */
+    raw = cJSON_Duplicate(entry->result, false);
+  } else {
+    cache->misses++;
+  }
+  cache_unlock(cache);
+  if (raw != NULL) {
+    if (method->stats)
+      stats_record(method->stats, false, 0, start_ns);
+    return mjrpc_response_ok(raw, id);
+  }
+
+  cJSON *response =
+      call_sync_method(handle, method, params, id, params_type, &shared);
+  cJSON *result = cJSON_GetObjectItemCaseSensitive(response, "result");
+  if (result == NULL || shared) /* The leader stores shared results */
+    return response;
+
+  /* Serialized and copied outside the lock */
+  entry = cJSON_malloc(sizeof(struct cache_entry));
+  if (entry == NULL)
+    return response;
+  entry->hash = hash;
+  entry->method = method->name;
+  entry->params = params ? cJSON_Duplicate(params, true) : NULL;
+  char *text = cJSON_PrintUnformatted(result);
+  entry->result =
+      text ? cJSON_CreateRawExternal(text, cache_result_release, NULL) : NULL;
+  entry->expires_ns =
+      method->cache_ttl_ms
+          ? stats_now_ns() + (uint64_t)method->cache_ttl_ms * 1000000u
+          : 0;
+  if (entry->result == NULL || (params != NULL && entry->params == NULL)) {
+    cache_entry_free(entry);
+    return response;
+  }
+  cache_lock(cache);
+  cache_insert(cache, entry);
+  cache_unlock(cache);
+  return response;
+}
+
+static cJSON *invoke_callback(const mjrpc_handle_t *handle,
+                              const char *method_name, cJSON *params, cJSON *id,
+                              int params_type,
+                              struct async_dispatch *dispatch) {
+  /* Exact entries win; otherwise follow namespace delegation downwards */
+  for (int depth = 0; depth <= MJRPC_ROUTE_MAX_DEPTH; depth++) {
+    const struct mjrpc_method *method = method_get(handle, method_name);
+    if (method != NULL && method->func != NULL && method->cacheable)
+      return call_cached_method(handle, method, params, id, params_type);
+    if (method != NULL && method->func != NULL) {
+      bool shared;
+      return call_sync_method(handle, method, params, id, params_type,
+                              &shared);
+    }
+    if (method != NULL && method->async_func != NULL)
+      return call_async_method(method->async_func, method->arg, params, id,
+                               params_type, dispatch, method->stats);
+
+    const char *suffix = NULL;
+    const struct mjrpc_route *route =
+        route_get(handle->routes, method_name, &suffix);
+    if (route == NULL)
+      break;
+    if (route->kind == ROUTE_FUNC)
+      return call_method(route->func, route->arg, suffix, params, id,
+                         params_type, NULL);
+    handle = route->child;
+    method_name = suffix;
+  }
+  return mjrpc_response_error(JSON_RPC_CODE_METHOD_NOT_FOUND,
+                              "Method not found.", id);
+}
+
+/*--- interceptors ---*/
+
+struct mjrpc_interceptor {
+  mjrpc_before_func before;
+  mjrpc_after_func after;
+  void *arg;
+};
+
+/**
+ * @brief Run a call through the interceptor chain of @p handle
+ * @internal
+ */
+static cJSON *intercept_callback(const mjrpc_handle_t *handle,
+                                 const char *method_name, cJSON *params,
+                                 cJSON *id, int params_type,
+                                 struct async_dispatch *dispatch) {
+  const struct mjrpc_interceptor *chain = handle->interceptors;
+  size_t count = handle->interceptor_count;
+  struct after_stage stages[MJRPC_MAX_INTERCEPTORS];
+  mjrpc_intercept_ctx_t ctx = {0};
+  ctx.method = method_name;
+  ctx.params = params;
+  ctx.id = id;
+
+  size_t ran = 0;
+  while (ran < count && ctx.error_code == 0) {
+    ctx.data = chain[ran].arg;
+    ctx.state = NULL;
+    if (chain[ran].before)
+      chain[ran].before(&ctx);
+    stages[ran].after = chain[ran].after;
+    stages[ran].arg = chain[ran].arg;
+    stages[ran++].state = ctx.state;
+  }
+
+  cJSON *response;
+  const struct after_stages pending = {method_name, stages, ran};
+  if (ctx.error_code != 0) {
+    response = mjrpc_response_error(ctx.error_code, ctx.error_message, id);
+    g_mjrpc_free(ctx.error_message);
+    ctx.error_message = NULL;
+  } else if (dispatch != NULL) {
+    /* An asynchronous method takes the stages and clears the pointer */
+    dispatch->after = &pending;
+    response = invoke_callback(handle, method_name, params, id, params_type,
+                               dispatch);
+    const bool handed_off = dispatch->after == NULL;
+    dispatch->after = NULL;
+    if (handed_off)
+      return response;
+  } else {
+    response = invoke_callback(handle, method_name, params, id, params_type,
+                               NULL);
+  }
+
+  /* The id now belongs to the response */
+  ctx.id = NULL;
+  run_after_stages(stages, ran, &ctx, response);
+  return response;
+}
+
 static bool key_equals_ignore_case(const char *left, const char *right) {
   while (tolower((unsigned char)*left) == tolower((unsigned char)*right)) {
     if (*left == '\0')
@@ -297,12 +1637,15 @@ static bool key_equals_ignore_case(const char *left, const char *right) {
 }
 
 static cJSON *rpc_handle_obj_req(const mjrpc_handle_t *handle,
-                                 const cJSON *request) {
+                                 const cJSON *request,
+                                 struct async_dispatch *dispatch) {
   cJSON *id = NULL;
   const cJSON *version = NULL;
   const cJSON *method = NULL;
   cJSON *params = NULL;
-  for (cJSON *item = request->child; item != NULL; item = item->next) {
+  /* Batch elements may be anything; only objects have members to read */
+  cJSON *members = cJSON_IsObject(request) ? request->child : NULL;
+  for (cJSON *item = members; item != NULL; item = item->next) {
     if (item->string == NULL)
       continue;
     switch (tolower((unsigned char)item->string[0])) {
@@ -325,39 +1668,43 @@ static cJSON *rpc_handle_obj_req(const mjrpc_handle_t *handle,
     }
   }
 
+  /* Members of in situ parsed requests carry reference flags */
+  const int id_type = id ? (id->type & 0xFF) : cJSON_NULL;
 #ifdef cJSON_Int
-  if (id == NULL || id->type == cJSON_NULL || id->type == cJSON_String ||
-      id->type == cJSON_Int)
+  if (id_type == cJSON_NULL || id_type == cJSON_String || id_type == cJSON_Int)
 #else
-  if (id == NULL || id->type == cJSON_NULL || id->type == cJSON_String ||
-      id->type == cJSON_Number)
+  if (id_type == cJSON_NULL || id_type == cJSON_String ||
+      id_type == cJSON_Number)
 #endif
   {
     cJSON *id_copy = NULL;
     if (id) {
-      if (id->type == cJSON_NULL)
+      if (id_type == cJSON_NULL)
         id_copy = cJSON_CreateNull();
       else
-        id_copy = (id->type == cJSON_String)
+        id_copy = (id_type == cJSON_String)
                       ? cJSON_CreateString(id->valuestring)
                       : cJSON_CreateNumber(id->valuedouble);
     }
 
-    if (version == NULL || version->type != cJSON_String ||
-        strcmp("2.0", version->valuestring) != 0)
+    if (!cJSON_IsString(version) || strcmp("2.0", version->valuestring) != 0)
       return mjrpc_response_error(
           JSON_RPC_CODE_INVALID_REQUEST,
           "Invalid request received: JSONRPC version error.", id_copy);
 
-    if (method != NULL && method->type == cJSON_String) {
+    if (cJSON_IsString(method)) {
       // Determine params type: 0=object, 1=array, 2=no params
       int actual_params_type = 2; // no params by default
       if (params != NULL) {
-        actual_params_type = (params->type == cJSON_Array) ? 1 : 0;
+        actual_params_type =
+            cJSON_IsArray(params) || cJSON_IsTypedArray(params) ? 1 : 0;
       }
 
+      if (handle->interceptor_count != 0)
+        return intercept_callback(handle, method->valuestring, params,
+                                  id_copy, actual_params_type, dispatch);
       return invoke_callback(handle, method->valuestring, params, id_copy,
-                             actual_params_type);
+                             actual_params_type, dispatch);
     }
     return mjrpc_response_error(JSON_RPC_CODE_INVALID_REQUEST,
                                 "Invalid request received: No 'method' member.",
@@ -369,12 +1716,72 @@ static cJSON *rpc_handle_obj_req(const mjrpc_handle_t *handle,
       "Invalid request received: 'id' member type error.", cJSON_CreateNull());
 }
 
+/**
+ * @brief Dispatch a batch that may contain asynchronous calls
+ * @return NULL if the batch went asynchronous (it is delivered through the
+ *         dispatch callback), otherwise the response array as for a
+ *         synchronous batch
+ * @internal
+ */
+static cJSON *rpc_handle_ary_req_async(const mjrpc_handle_t *handle,
+                                       const cJSON *request,
+                                       struct async_dispatch *dispatch) {
+  size_t count = 0;
+  for (const cJSON *item = request->child; item != NULL; item = item->next)
+    count++;
+
+  struct async_batch *batch = g_mjrpc_malloc(sizeof(struct async_batch));
+  cJSON **slots = batch ? g_mjrpc_malloc(count * sizeof(cJSON *)) : NULL;
+  if (slots == NULL) {
+    g_mjrpc_free(batch);
+    log_error("Async batch allocation failed",
+              MJRPC_RET_ERROR_MEM_ALLOC_FAILED);
+    return mjrpc_response_error(JSON_RPC_CODE_INTERNAL_ERROR, "Out of memory.",
+                                cJSON_CreateNull());
+  }
+  memset(slots, 0, count * sizeof(cJSON *));
+  batch->slots = slots;
+  batch->slot_count = count;
+  atomic_init(&batch->pending, 1); /* held by this function */
+  batch->on_response = dispatch->on_response;
+  batch->user_data = dispatch->user_data;
+  batch->free_fn = g_mjrpc_free;
+
+  dispatch->batch = batch;
+  dispatch->slot = 0;
+  for (const cJSON *item = request->child; item != NULL; item = item->next) {
+    /* Asynchronous elements may already own their slot on another thread */
+    cJSON *response = rpc_handle_obj_req(handle, item, dispatch);
+    if (response != NULL) {
+      slots[dispatch->slot] = response;
+      dispatch->expects_response = true;
+    }
+    dispatch->slot++;
+  }
+  dispatch->batch = NULL;
+
+  if (dispatch->pending > 0) {
+    async_batch_release(batch);
+    return NULL;
+  }
+
+  /* Nothing went asynchronous: answer like a synchronous batch */
+  cJSON *array = collect_slots(slots, count);
+  g_mjrpc_free(slots);
+  g_mjrpc_free(batch);
+  return array;
+}
+
 static cJSON *rpc_handle_ary_req(const mjrpc_handle_t *handle,
-                                 const cJSON *request) {
+                                 const cJSON *request,
+                                 struct async_dispatch *dispatch) {
+  if (dispatch != NULL)
+    return rpc_handle_ary_req_async(handle, request, dispatch);
+
   int valid_reqs = 0;
   cJSON *return_json_array = cJSON_CreateArray();
   for (const cJSON *item = request->child; item != NULL; item = item->next) {
-    cJSON *obj_req = rpc_handle_obj_req(handle, item);
+    cJSON *obj_req = rpc_handle_obj_req(handle, item, NULL);
     if (obj_req) {
       cJSON_AddItemToArray(return_json_array, obj_req);
       valid_reqs++;
@@ -397,32 +1804,279 @@ cJSON *mjrpc_request_cjson(const char *method, cJSON *params, cJSON *id) {
     return NULL;
   }
 
-  cJSON *json = cJSON_CreateObject();
-  if (json == NULL) {
-    cJSON_Delete(params);
-    cJSON_Delete(id);
-    return NULL;
+  cJSON *json = cJSON_CreateObject();
+  if (json == NULL) {
+    cJSON_Delete(params);
+    cJSON_Delete(id);
+    return NULL;
+  }
+
+  cJSON_AddStringToObject(json, "jsonrpc", "2.0");
+  cJSON_AddStringToObject(json, "method", method);
+  cJSON_AddItemToObject(json, "params", params);
+  cJSON_AddItemToObject(json, "id", id);
+
+  return json;
+}
+
+char *mjrpc_request_str(const char *method, cJSON *params, cJSON *id) {
+  cJSON *json = mjrpc_request_cjson(method, params, id);
+  if (json == NULL)
+    return NULL;
+
+  char *json_str = cJSON_PrintUnformatted(json);
+  cJSON_Delete(json);
+
+  // Note: json_str must be freed by caller using standard free()
+  // (cJSON uses malloc internally)
+  return json_str;
+}
+
+/*--- request writer ---*/
+
+static void writer_put(mjrpc_request_writer_t *w, const char *data,
+                       size_t len) {
+  /* Keep counting after an overflow so mjrpc_request_end() can report the
+   * size needed; one byte stays reserved for the terminator */
+  if (w->len + len < w->size)
+    memcpy(w->buf + w->len, data, len);
+  else if (w->error == MJRPC_RET_OK)
+    w->error = MJRPC_RET_ERROR_TOO_LARGE;
+  w->len += len;
+}
+
+static void writer_put_string(mjrpc_request_writer_t *w, const char *str) {
+  static const char hex[] = "0123456789abcdef";
+  writer_put(w, "\"", 1);
+  const char *run = str;
+  for (const char *p = str;; p++) {
+    unsigned char ch = (unsigned char)*p;
+    if (ch >= 0x20 && ch != '"' && ch != '\\')
+      continue;
+    writer_put(w, run, (size_t)(p - run));
+    run = p + 1;
+    if (ch == '\0')
+      break;
+    char esc[6] = {'\\', 0};
+    size_t esc_len = 2;
+    switch (ch) {
+    case '"':
+    case '\\':
+      esc[1] = (char)ch;
+      break;
+    case '\b':
+      esc[1] = 'b';
+      break;
+    case '\f':
+      esc[1] = 'f';
+      break;
+    case '\n':
+      esc[1] = 'n';
+      break;
+    case '\r':
+      esc[1] = 'r';
+      break;
+    case '\t':
+      esc[1] = 't';
+      break;
+    default:
+      memcpy(esc + 1, "u00", 3);
+      esc[4] = hex[ch >> 4];
+      esc[5] = hex[ch & 0xf];
+      esc_len = 6;
+      break;
+    }
+    writer_put(w, esc, esc_len);
+  }
+  writer_put(w, "\"", 1);
+}
+
+static void writer_begin(mjrpc_request_writer_t *w, char *buf, size_t size,
+                         const char *method) {
+  memset(w, 0, sizeof(*w));
+  w->buf = buf;
+  w->size = buf ? size : 0;
+  if (method == NULL) {
+    w->error = MJRPC_RET_ERROR_INVALID_PARAM;
+    return;
+  }
+  static const char head[] = "{\"jsonrpc\":\"2.0\",\"method\":";
+  writer_put(w, head, sizeof(head) - 1);
+  writer_put_string(w, method);
+}
+
+/**
+ * @brief Emit what precedes a value: params opening, separator and name
+ * @return false if the value must not be written
+ */
+static bool writer_prefix(mjrpc_request_writer_t *w, const char *name) {
+  if (w == NULL || w->error == MJRPC_RET_ERROR_INVALID_PARAM)
+    return false;
+  if (w->depth == 0) {
+    writer_put(w, name ? ",\"params\":{" : ",\"params\":[", 11);
+    w->objects = name ? 1 : 0;
+    w->depth = 1;
+  }
+  uint32_t level = 1u << (w->depth - 1);
+  if ((name != NULL) != ((w->objects & level) != 0)) {
+    w->error = MJRPC_RET_ERROR_INVALID_PARAM;
+    return false;
+  }
+  if (w->nonempty & level)
+    writer_put(w, ",", 1);
+  w->nonempty |= level;
+  if (name) {
+    writer_put_string(w, name);
+    writer_put(w, ":", 1);
+  }
+  return true;
+}
+
+void mjrpc_request_begin(mjrpc_request_writer_t *writer, char *buf,
+                         size_t size, const char *method, int64_t id) {
+  if (writer == NULL)
+    return;
+  writer_begin(writer, buf, size, method);
+  writer->id = id;
+  writer->has_id = true;
+}
+
+void mjrpc_notification_begin(mjrpc_request_writer_t *writer, char *buf,
+                              size_t size, const char *method) {
+  if (writer == NULL)
+    return;
+  writer_begin(writer, buf, size, method);
+}
+
+void mjrpc_request_add_int(mjrpc_request_writer_t *writer, const char *name,
+                           int64_t value) {
+  if (!writer_prefix(writer, name))
+    return;
+  char num[24];
+  int n = snprintf(num, sizeof(num), "%lld", (long long)value);
+  writer_put(writer, num, (size_t)n);
+}
+
+void mjrpc_request_add_double(mjrpc_request_writer_t *writer, const char *name,
+                              double value) {
+  if (!writer_prefix(writer, name))
+    return;
+  if (value != value || value - value != 0) { /* NaN or infinite */
+    writer_put(writer, "null", 4);
+    return;
+  }
+  /* Shortest of 15 or 17 significant digits that reads back exactly, the
+   * same rule cJSON's printer uses */
+  char num[32];
+  int n = snprintf(num, sizeof(num), "%1.15g", value);
+  if (strtod(num, NULL) != value)
+    n = snprintf(num, sizeof(num), "%1.17g", value);
+  writer_put(writer, num, (size_t)n);
+}
+
+void mjrpc_request_add_string(mjrpc_request_writer_t *writer, const char *name,
+                              const char *value) {
+  if (!writer_prefix(writer, name))
+    return;
+  if (value)
+    writer_put_string(writer, value);
+  else
+    writer_put(writer, "null", 4);
+}
+
+void mjrpc_request_add_bool(mjrpc_request_writer_t *writer, const char *name,
+                            bool value) {
+  if (!writer_prefix(writer, name))
+    return;
+  if (value)
+    writer_put(writer, "true", 4);
+  else
+    writer_put(writer, "false", 5);
+}
+
+void mjrpc_request_add_null(mjrpc_request_writer_t *writer, const char *name) {
+  if (writer_prefix(writer, name))
+    writer_put(writer, "null", 4);
+}
+
+void mjrpc_request_add_raw(mjrpc_request_writer_t *writer, const char *name,
+                           const char *json, size_t len) {
+  if (writer != NULL && json == NULL) {
+    writer->error = MJRPC_RET_ERROR_INVALID_PARAM;
+    return;
+  }
+  if (writer_prefix(writer, name))
+    writer_put(writer, json, len);
+}
+
+static void writer_open(mjrpc_request_writer_t *w, const char *name,
+                        bool object) {
+  if (!writer_prefix(w, name))
+    return;
+  if (w->depth >= MJRPC_WRITER_MAX_DEPTH) {
+    w->error = MJRPC_RET_ERROR_INVALID_PARAM;
+    return;
   }
+  uint32_t level = 1u << w->depth;
+  w->depth++;
+  w->nonempty &= ~level;
+  if (object)
+    w->objects |= level;
+  else
+    w->objects &= ~level;
+  writer_put(w, object ? "{" : "[", 1);
+}
 
-  cJSON_AddStringToObject(json, "jsonrpc", "2.0");
-  cJSON_AddStringToObject(json, "method", method);
-  cJSON_AddItemToObject(json, "params", params);
-  cJSON_AddItemToObject(json, "id", id);
+void mjrpc_request_open_array(mjrpc_request_writer_t *writer,
+                              const char *name) {
+  writer_open(writer, name, false);
+}
 
-  return json;
+void mjrpc_request_open_object(mjrpc_request_writer_t *writer,
+                               const char *name) {
+  writer_open(writer, name, true);
 }
 
-char *mjrpc_request_str(const char *method, cJSON *params, cJSON *id) {
-  cJSON *json = mjrpc_request_cjson(method, params, id);
-  if (json == NULL)
-    return NULL;
+static void writer_close(mjrpc_request_writer_t *w) {
+  w->depth--;
+  writer_put(w, (w->objects >> w->depth) & 1 ? "}" : "]", 1);
+}
 
-  char *json_str = cJSON_PrintUnformatted(json);
-  cJSON_Delete(json);
+void mjrpc_request_close(mjrpc_request_writer_t *writer) {
+  if (writer == NULL || writer->error == MJRPC_RET_ERROR_INVALID_PARAM)
+    return;
+  /* The params container itself is closed by mjrpc_request_end() */
+  if (writer->depth <= 1) {
+    writer->error = MJRPC_RET_ERROR_INVALID_PARAM;
+    return;
+  }
+  writer_close(writer);
+}
 
-  // Note: json_str must be freed by caller using standard free()
-  // (cJSON uses malloc internally)
-  return json_str;
+int mjrpc_request_end(mjrpc_request_writer_t *writer, size_t *len) {
+  if (writer == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  if (writer->error == MJRPC_RET_ERROR_INVALID_PARAM)
+    return writer->error;
+  if (writer->depth > 1) {
+    writer->error = MJRPC_RET_ERROR_INVALID_PARAM;
+    return writer->error;
+  }
+  if (writer->depth == 1)
+    writer_close(writer);
+  if (writer->has_id) {
+    char tail[32];
+    int n = snprintf(tail, sizeof(tail), ",\"id\":%lld}",
+                     (long long)writer->id);
+    writer_put(writer, tail, (size_t)n);
+  } else {
+    writer_put(writer, "}", 1);
+  }
+  if (len)
+    *len = writer->len;
+  if (writer->error == MJRPC_RET_OK)
+    writer->buf[writer->len] = '\0';
+  return writer->error;
 }
 
 cJSON *mjrpc_response_ok(cJSON *result, cJSON *id) {
@@ -482,6 +2136,14 @@ mjrpc_handle_t *mjrpc_create_handle(size_t initial_capacity) {
     return NULL;
   handle->capacity = initial_capacity;
   handle->size = 0;
+  handle->routes = NULL;
+  handle->interceptors = NULL;
+  handle->interceptor_count = 0;
+  handle->cache = NULL;
+  handle->flights = NULL;
+  handle->stats_enabled = false;
+  handle->retired_stats = NULL;
+  handle->typed_array_min = 0;
   handle->methods = (struct mjrpc_method *)g_mjrpc_malloc(
       handle->capacity * sizeof(struct mjrpc_method));
   if (handle->methods == NULL) {
@@ -501,21 +2163,28 @@ int mjrpc_destroy_handle(mjrpc_handle_t *handle) {
       g_mjrpc_free(handle->methods[i].name);
       if (handle->methods[i].arg != NULL)
         g_mjrpc_free(handle->methods[i].arg);
+      g_mjrpc_free(handle->methods[i].stats);
     }
   }
+  while (handle->retired_stats != NULL) {
+    struct mjrpc_method_stats *next = handle->retired_stats->next;
+    g_mjrpc_free(handle->retired_stats);
+    handle->retired_stats = next;
+  }
+  cache_destroy(handle->cache);
+  cJSON_free(handle->flights);
+  for (size_t i = 0; i < handle->interceptor_count; i++)
+    g_mjrpc_free(handle->interceptors[i].arg);
+  g_mjrpc_free(handle->interceptors);
+  route_free(handle->routes);
   g_mjrpc_free(handle->methods);
   g_mjrpc_free(handle);
   return MJRPC_RET_OK;
 }
 
-int mjrpc_add_method(mjrpc_handle_t *handle, mjrpc_func function_pointer,
-                     const char *method_name, void *arg2func) {
-  init_memory_hooks_if_needed();
-  if (handle == NULL)
-    return MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED;
-  if (function_pointer == NULL || method_name == NULL)
-    return MJRPC_RET_ERROR_INVALID_PARAM;
-
+static int method_add(mjrpc_handle_t *handle, mjrpc_func func,
+                      mjrpc_async_func async_func, const char *method_name,
+                      void *arg2func) {
   /* Check load factor and resize if needed */
   if ((double)handle->size / (double)handle->capacity >= HASH_LOAD_FACTOR) {
     int resize_result = resize(handle);
@@ -535,7 +2204,13 @@ int mjrpc_add_method(mjrpc_handle_t *handle, mjrpc_func function_pointer,
       if (handle->methods[index].arg != NULL) {
         g_mjrpc_free(handle->methods[index].arg);
       }
-      handle->methods[index].func = function_pointer;
+      if (handle->methods[index].cacheable)
+        cache_drop(handle->cache, handle->methods[index].name);
+      handle->methods[index].cacheable = false;
+      handle->methods[index].cache_ttl_ms = 0;
+      handle->methods[index].single_flight = false;
+      handle->methods[index].func = func;
+      handle->methods[index].async_func = async_func;
       handle->methods[index].arg = arg2func;
       return MJRPC_RET_OK;
     }
@@ -565,13 +2240,153 @@ int mjrpc_add_method(mjrpc_handle_t *handle, mjrpc_func function_pointer,
               MJRPC_RET_ERROR_MEM_ALLOC_FAILED);
     return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
   }
-  handle->methods[index].func = function_pointer;
+  handle->methods[index].stats = NULL;
+  if (handle->stats_enabled) {
+    handle->methods[index].stats = stats_new();
+    if (handle->methods[index].stats == NULL) {
+      g_mjrpc_free(handle->methods[index].name);
+      handle->methods[index].name = NULL;
+      return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+    }
+  }
+  handle->methods[index].func = func;
+  handle->methods[index].async_func = async_func;
   handle->methods[index].arg = arg2func;
+  handle->methods[index].cacheable = false;
+  handle->methods[index].cache_ttl_ms = 0;
+  handle->methods[index].single_flight = false;
   handle->methods[index].state = OCCUPIED;
   handle->size++;
   return MJRPC_RET_OK;
 }
 
+int mjrpc_add_method(mjrpc_handle_t *handle, mjrpc_func function_pointer,
+                     const char *method_name, void *arg2func) {
+  init_memory_hooks_if_needed();
+  if (handle == NULL)
+    return MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED;
+  if (function_pointer == NULL || method_name == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  return method_add(handle, function_pointer, NULL, method_name, arg2func);
+}
+
+int mjrpc_add_async_method(mjrpc_handle_t *handle,
+                           mjrpc_async_func function_pointer,
+                           const char *method_name, void *arg2func) {
+  init_memory_hooks_if_needed();
+  if (handle == NULL)
+    return MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED;
+  if (function_pointer == NULL || method_name == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  return method_add(handle, NULL, function_pointer, method_name, arg2func);
+}
+
+int mjrpc_add_cached_method(mjrpc_handle_t *handle,
+                            mjrpc_func function_pointer,
+                            const char *method_name, void *arg2func,
+                            uint32_t ttl_ms) {
+  init_memory_hooks_if_needed();
+  if (handle == NULL)
+    return MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED;
+  if (function_pointer == NULL || method_name == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  if (handle->cache == NULL) {
+    handle->cache = cache_new(MJRPC_CACHE_DEFAULT_ENTRIES);
+    if (handle->cache == NULL)
+      return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+  }
+  int ret = method_add(handle, function_pointer, NULL, method_name, arg2func);
+  if (ret != MJRPC_RET_OK)
+    return ret;
+  struct mjrpc_method *method =
+      (struct mjrpc_method *)method_get(handle, method_name);
+  method->cacheable = true;
+  method->cache_ttl_ms = ttl_ms;
+  return MJRPC_RET_OK;
+}
+
+int mjrpc_set_cache_capacity(mjrpc_handle_t *handle, size_t max_entries) {
+  if (handle == NULL)
+    return MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED;
+  if (handle->cache != NULL)
+    return cache_resize(handle->cache, max_entries)
+               ? MJRPC_RET_OK
+               : MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+  /* No cached method yet, so no request can be using the cache */
+  handle->cache = cache_new(max_entries);
+  return handle->cache ? MJRPC_RET_OK : MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+}
+
+int mjrpc_cache_invalidate(const mjrpc_handle_t *handle,
+                           const char *method_name, const cJSON *params) {
+  if (handle == NULL)
+    return MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED;
+  if (params != NULL && method_name == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  struct mjrpc_cache *cache = handle->cache;
+  if (cache == NULL)
+    return MJRPC_RET_OK;
+  if (method_name == NULL) {
+    cache_drop(cache, NULL);
+    return MJRPC_RET_OK;
+  }
+  const struct mjrpc_method *method = method_get(handle, method_name);
+  if (method == NULL || !method->cacheable)
+    return MJRPC_RET_OK;
+  if (params == NULL) {
+    cache_drop(cache, method->name);
+    return MJRPC_RET_OK;
+  }
+  uint64_t hash = hash_mix(hash_bytes(method->name) ^ json_hash(params));
+  cache_lock(cache);
+  struct cache_entry *entry = cache_find(cache, hash, method->name, params);
+  if (entry != NULL)
+    cache_remove(cache, entry);
+  cache_unlock(cache);
+  return MJRPC_RET_OK;
+}
+
+int mjrpc_get_cache_stats(const mjrpc_handle_t *handle,
+                          mjrpc_cache_stats_t *stats) {
+  if (handle == NULL)
+    return MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED;
+  if (stats == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  memset(stats, 0, sizeof(*stats));
+  struct mjrpc_cache *cache = handle->cache;
+  if (cache == NULL)
+    return MJRPC_RET_OK;
+  cache_lock(cache);
+  stats->hits = cache->hits;
+  stats->misses = cache->misses;
+  stats->evictions = cache->evictions;
+  stats->expirations = cache->expirations;
+  stats->entries = cache->count;
+  cache_unlock(cache);
+  return MJRPC_RET_OK;
+}
+
+int mjrpc_set_single_flight(mjrpc_handle_t *handle, const char *method_name,
+                            bool enabled) {
+  if (handle == NULL)
+    return MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED;
+  if (method_name == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  struct mjrpc_method *method =
+      (struct mjrpc_method *)method_get(handle, method_name);
+  if (method == NULL)
+    return MJRPC_RET_ERROR_NOT_FOUND;
+  if (method->func == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  if (enabled && handle->flights == NULL) {
+    handle->flights = flights_new();
+    if (handle->flights == NULL)
+      return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+  }
+  method->single_flight = enabled;
+  return MJRPC_RET_OK;
+}
+
 int mjrpc_del_method(mjrpc_handle_t *handle, const char *name) {
   init_memory_hooks_if_needed();
   if (handle == NULL)
@@ -587,12 +2402,20 @@ int mjrpc_del_method(mjrpc_handle_t *handle, const char *name) {
   while (handle->methods[index].state != EMPTY) {
     if (handle->methods[index].state == OCCUPIED &&
         strcmp(handle->methods[index].name, name) == 0) {
+      if (handle->methods[index].cacheable)
+        cache_drop(handle->cache, handle->methods[index].name);
       g_mjrpc_free(handle->methods[index].name);
       handle->methods[index].name = NULL;
       if (handle->methods[index].arg != NULL) {
         g_mjrpc_free(handle->methods[index].arg);
         handle->methods[index].arg = NULL;
       }
+      /* Asynchronous calls in flight may still record into it */
+      if (handle->methods[index].stats != NULL) {
+        handle->methods[index].stats->next = handle->retired_stats;
+        handle->retired_stats = handle->methods[index].stats;
+        handle->methods[index].stats = NULL;
+      }
       handle->methods[index].state = DELETED;
       handle->size--;
       return MJRPC_RET_OK;
@@ -611,6 +2434,97 @@ int mjrpc_del_method(mjrpc_handle_t *handle, const char *name) {
   return MJRPC_RET_ERROR_NOT_FOUND;
 }
 
+int mjrpc_add_namespace(mjrpc_handle_t *handle, const char *prefix,
+                        mjrpc_handle_t *child) {
+  if (handle == NULL)
+    return MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED;
+  if (prefix == NULL || child == NULL || child == handle)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  return route_add(handle, prefix, ROUTE_HANDLE, child, NULL, NULL);
+}
+
+int mjrpc_add_prefix_method(mjrpc_handle_t *handle,
+                            mjrpc_func function_pointer, const char *prefix,
+                            void *arg2func) {
+  if (handle == NULL)
+    return MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED;
+  if (function_pointer == NULL || prefix == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  return route_add(handle, prefix, ROUTE_FUNC, NULL, function_pointer,
+                   arg2func);
+}
+
+int mjrpc_del_namespace(mjrpc_handle_t *handle, const char *prefix) {
+  init_memory_hooks_if_needed();
+  if (handle == NULL)
+    return MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED;
+  if (prefix == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  if (handle->routes == NULL)
+    return MJRPC_RET_ERROR_NOT_FOUND;
+
+  const size_t prefix_len = strlen(prefix);
+  char *key = g_mjrpc_malloc(prefix_len + 2);
+  if (key == NULL)
+    return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+  memcpy(key, prefix, prefix_len);
+  key[prefix_len] = '.';
+  key[prefix_len + 1] = '\0';
+  const bool removed = route_remove(handle->routes, key, prefix_len + 1);
+  g_mjrpc_free(key);
+  return removed ? MJRPC_RET_OK : MJRPC_RET_ERROR_NOT_FOUND;
+}
+
+int mjrpc_add_interceptor(mjrpc_handle_t *handle, mjrpc_before_func before,
+                          mjrpc_after_func after, void *arg) {
+  init_memory_hooks_if_needed();
+  if (handle == NULL)
+    return MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED;
+  if (before == NULL && after == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  if (handle->interceptor_count >= MJRPC_MAX_INTERCEPTORS)
+    return MJRPC_RET_ERROR_TOO_LARGE;
+
+  /* Rebuilt on every change so dispatch walks one contiguous array */
+  size_t count = handle->interceptor_count;
+  struct mjrpc_interceptor *chain =
+      g_mjrpc_malloc((count + 1) * sizeof(struct mjrpc_interceptor));
+  if (chain == NULL)
+    return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+  if (count > 0)
+    memcpy(chain, handle->interceptors,
+           count * sizeof(struct mjrpc_interceptor));
+  chain[count].before = before;
+  chain[count].after = after;
+  chain[count].arg = arg;
+  g_mjrpc_free(handle->interceptors);
+  handle->interceptors = chain;
+  handle->interceptor_count = count + 1;
+  return MJRPC_RET_OK;
+}
+
+int mjrpc_del_interceptor(mjrpc_handle_t *handle, mjrpc_before_func before,
+                          mjrpc_after_func after) {
+  init_memory_hooks_if_needed();
+  if (handle == NULL)
+    return MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED;
+  for (size_t i = 0; i < handle->interceptor_count; i++) {
+    struct mjrpc_interceptor *entry = &handle->interceptors[i];
+    if (entry->before != before || entry->after != after)
+      continue;
+    g_mjrpc_free(entry->arg);
+    memmove(entry, entry + 1,
+            (handle->interceptor_count - i - 1) *
+                sizeof(struct mjrpc_interceptor));
+    if (--handle->interceptor_count == 0) {
+      g_mjrpc_free(handle->interceptors);
+      handle->interceptors = NULL;
+    }
+    return MJRPC_RET_OK;
+  }
+  return MJRPC_RET_ERROR_NOT_FOUND;
+}
+
 size_t mjrpc_get_method_count(const mjrpc_handle_t *handle) {
   if (handle == NULL)
     return 0;
@@ -634,9 +2548,207 @@ int mjrpc_enum_methods(const mjrpc_handle_t *handle,
   return MJRPC_RET_OK;
 }
 
+/**
+ * @brief Argument of the built-in statistics method
+ * @internal
+ */
+struct stats_method_arg {
+  const mjrpc_handle_t *handle;
+};
+
+static cJSON *stats_to_json(const mjrpc_method_stats_t *stats) {
+  cJSON *json = cJSON_CreateObject();
+  cJSON *codes = cJSON_CreateObject();
+  cJSON *latency = cJSON_CreateObject();
+  if (json == NULL || codes == NULL || latency == NULL) {
+    cJSON_Delete(json);
+    cJSON_Delete(codes);
+    cJSON_Delete(latency);
+    return NULL;
+  }
+  cJSON_AddNumberToObject(json, "calls", (double)stats->calls);
+  cJSON_AddNumberToObject(json, "notifications", (double)stats->notifications);
+  cJSON_AddNumberToObject(json, "errors", (double)stats->errors);
+  for (size_t i = 0; i < MJRPC_STATS_ERROR_CODES; i++) {
+    if (stats->error_codes[i].count == 0)
+      continue;
+    char key[16];
+    snprintf(key, sizeof(key), "%d", (int)stats->error_codes[i].code);
+    cJSON_AddNumberToObject(codes, key, (double)stats->error_codes[i].count);
+  }
+  if (stats->other_errors)
+    cJSON_AddNumberToObject(codes, "other", (double)stats->other_errors);
+  cJSON_AddItemToObject(json, "error_codes", codes);
+
+  uint64_t count = 0;
+  for (size_t i = 0; i < MJRPC_STATS_LATENCY_BUCKETS; i++)
+    count += stats->latency[i];
+  cJSON_AddNumberToObject(
+      latency, "mean", count ? (double)(stats->latency_total_ns / count) : 0);
+  cJSON_AddNumberToObject(latency, "p50",
+                          (double)mjrpc_stats_percentile_ns(stats, 50));
+  cJSON_AddNumberToObject(latency, "p90",
+                          (double)mjrpc_stats_percentile_ns(stats, 90));
+  cJSON_AddNumberToObject(latency, "p99",
+                          (double)mjrpc_stats_percentile_ns(stats, 99));
+  cJSON_AddNumberToObject(latency, "max",
+                          (double)mjrpc_stats_percentile_ns(stats, 100));
+  cJSON_AddItemToObject(json, "latency_ns", latency);
+  return json;
+}
+
+static cJSON *stats_method(mjrpc_func_ctx_t *ctx, cJSON *params, cJSON *id) {
+  (void)params;
+  (void)id;
+  const struct stats_method_arg *arg = ctx->data;
+  const mjrpc_handle_t *handle = arg->handle;
+  cJSON *result = cJSON_CreateObject();
+  if (result == NULL)
+    return NULL;
+  for (size_t i = 0; i < handle->capacity; i++) {
+    const struct mjrpc_method *method = &handle->methods[i];
+    mjrpc_method_stats_t snapshot;
+    if (method->state != OCCUPIED ||
+        mjrpc_get_method_stats(handle, method->name, &snapshot) !=
+            MJRPC_RET_OK)
+      continue;
+    cJSON *entry = stats_to_json(&snapshot);
+    if (entry != NULL)
+      cJSON_AddItemToObject(result, method->name, entry);
+  }
+  return result;
+}
+
+int mjrpc_enable_stats(mjrpc_handle_t *handle, bool add_method) {
+  init_memory_hooks_if_needed();
+  if (handle == NULL)
+    return MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED;
+
+  for (size_t i = 0; i < handle->capacity; i++) {
+    struct mjrpc_method *method = &handle->methods[i];
+    if (method->state != OCCUPIED || method->stats != NULL)
+      continue;
+    method->stats = stats_new();
+    if (method->stats == NULL)
+      return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+  }
+  handle->stats_enabled = true;
+  if (!add_method)
+    return MJRPC_RET_OK;
+
+  struct stats_method_arg *arg =
+      g_mjrpc_malloc(sizeof(struct stats_method_arg));
+  if (arg == NULL)
+    return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+  arg->handle = handle;
+  int ret = method_add(handle, stats_method, NULL, MJRPC_STATS_METHOD, arg);
+  if (ret != MJRPC_RET_OK)
+    g_mjrpc_free(arg);
+  return ret;
+}
+
+int mjrpc_get_method_stats(const mjrpc_handle_t *handle, const char *name,
+                           mjrpc_method_stats_t *stats) {
+  if (handle == NULL)
+    return MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED;
+  if (name == NULL || stats == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  const struct mjrpc_method *method = method_get(handle, name);
+  if (method == NULL || method->stats == NULL)
+    return MJRPC_RET_ERROR_NOT_FOUND;
+
+  struct mjrpc_method_stats *src = method->stats;
+  stats->calls = atomic_load_explicit(&src->calls, memory_order_relaxed);
+  stats->notifications =
+      atomic_load_explicit(&src->notifications, memory_order_relaxed);
+  stats->errors = atomic_load_explicit(&src->errors, memory_order_relaxed);
+  stats->other_errors =
+      atomic_load_explicit(&src->other_errors, memory_order_relaxed);
+  for (size_t i = 0; i < MJRPC_STATS_ERROR_CODES; i++) {
+    stats->error_codes[i].code =
+        atomic_load_explicit(&src->codes[i], memory_order_relaxed);
+    stats->error_codes[i].count =
+        atomic_load_explicit(&src->code_counts[i], memory_order_relaxed);
+  }
+  stats->latency_total_ns =
+      atomic_load_explicit(&src->latency_total_ns, memory_order_relaxed);
+  for (size_t i = 0; i < MJRPC_STATS_LATENCY_BUCKETS; i++)
+    stats->latency[i] =
+        atomic_load_explicit(&src->latency[i], memory_order_relaxed);
+  return MJRPC_RET_OK;
+}
+
+int mjrpc_reset_stats(const mjrpc_handle_t *handle) {
+  if (handle == NULL)
+    return MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED;
+  for (size_t i = 0; i < handle->capacity; i++) {
+    struct mjrpc_method_stats *stats = handle->methods[i].stats;
+    if (handle->methods[i].state != OCCUPIED || stats == NULL)
+      continue;
+    atomic_store_explicit(&stats->calls, 0, memory_order_relaxed);
+    atomic_store_explicit(&stats->notifications, 0, memory_order_relaxed);
+    atomic_store_explicit(&stats->errors, 0, memory_order_relaxed);
+    atomic_store_explicit(&stats->other_errors, 0, memory_order_relaxed);
+    atomic_store_explicit(&stats->latency_total_ns, 0, memory_order_relaxed);
+    for (size_t j = 0; j < MJRPC_STATS_ERROR_CODES; j++) {
+      atomic_store_explicit(&stats->codes[j], 0, memory_order_relaxed);
+      atomic_store_explicit(&stats->code_counts[j], 0, memory_order_relaxed);
+    }
+    for (size_t j = 0; j < MJRPC_STATS_LATENCY_BUCKETS; j++)
+      atomic_store_explicit(&stats->latency[j], 0, memory_order_relaxed);
+  }
+  return MJRPC_RET_OK;
+}
+
+uint64_t mjrpc_stats_bucket_upper_ns(size_t bucket) {
+  if (bucket >= MJRPC_STATS_LATENCY_BUCKETS - 1)
+    return UINT64_MAX;
+  if (bucket < (1u << STATS_SUB_BITS))
+    return bucket;
+  size_t shift = (bucket >> STATS_SUB_BITS) - 1;
+  uint64_t sub = bucket & ((1u << STATS_SUB_BITS) - 1);
+  return (((1u << STATS_SUB_BITS) + sub + 1) << shift) - 1;
+}
+
+uint64_t mjrpc_stats_percentile_ns(const mjrpc_method_stats_t *stats,
+                                   double percentile) {
+  if (stats == NULL)
+    return 0;
+  uint64_t count = 0;
+  for (size_t i = 0; i < MJRPC_STATS_LATENCY_BUCKETS; i++)
+    count += stats->latency[i];
+  if (count == 0)
+    return 0;
+  if (percentile < 0)
+    percentile = 0;
+  if (percentile > 100)
+    percentile = 100;
+  /* Rank of the percentile among the recorded values, 1-based */
+  double rank = percentile / 100.0 * (double)count;
+  uint64_t target = (uint64_t)rank;
+  if ((double)target < rank || target == 0)
+    target++;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < MJRPC_STATS_LATENCY_BUCKETS; i++) {
+    seen += stats->latency[i];
+    if (seen >= target)
+      return mjrpc_stats_bucket_upper_ns(i);
+  }
+  return UINT64_MAX;
+}
+
 char *mjrpc_process_str(const mjrpc_handle_t *handle, const char *request_str,
                         int *ret_code) {
-  cJSON *request = cJSON_Parse(request_str);
+  return mjrpc_process_buf(handle, request_str,
+                           request_str ? strlen(request_str) : 0, ret_code);
+}
+
+/**
+ * @brief Answer a request parsed from @p len bytes, consuming it
+ * @internal
+ */
+static char *process_parsed(const mjrpc_handle_t *handle, cJSON *request,
+                            size_t len, int *ret_code) {
   if (request == NULL) {
     // Parse failed, create error response
     if (ret_code) {
@@ -658,10 +2770,9 @@ char *mjrpc_process_str(const mjrpc_handle_t *handle, const char *request_str,
   cJSON_Delete(request);
 
   if (response) {
-    const size_t request_length = strlen(request_str);
     char *response_str =
-        request_length < INT_MAX
-            ? cJSON_PrintBuffered(response, (int)request_length + 1, false)
+        len < INT_MAX
+            ? cJSON_PrintBuffered(response, (int)len + 1, false)
             : cJSON_PrintUnformatted(response);
     cJSON_Delete(response);
     return response_str;
@@ -669,8 +2780,76 @@ char *mjrpc_process_str(const mjrpc_handle_t *handle, const char *request_str,
   return NULL;
 }
 
-cJSON *mjrpc_process_cjson(const mjrpc_handle_t *handle,
-                           const cJSON *request_cjson, int *ret_code) {
+int mjrpc_set_typed_arrays(mjrpc_handle_t *handle, size_t min_count) {
+  if (handle == NULL)
+    return MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED;
+  handle->typed_array_min = min_count;
+  return MJRPC_RET_OK;
+}
+
+size_t mjrpc_get_typed_arrays(const mjrpc_handle_t *handle) {
+  return handle ? handle->typed_array_min : 0;
+}
+
+/**
+ * @brief Turn typed params arrays back into items
+ * @internal
+ *
+ * Positional params are read item by item, so only arrays nested inside
+ * params stay typed. A batch made of numbers only is expanded as well.
+ */
+static cJSON *expand_typed_params(cJSON *request) {
+  if (cJSON_IsTypedArray(request)) {
+    if (!cJSON_ExpandTypedArray(request))
+      log_error("Typed batch expansion failed",
+                MJRPC_RET_ERROR_MEM_ALLOC_FAILED);
+    return request;
+  }
+  cJSON *requests = cJSON_IsArray(request) ? request->child : request;
+  for (cJSON *each = requests; each != NULL; each = each->next) {
+    if (!cJSON_IsObject(each))
+      continue;
+    for (cJSON *item = each->child; item != NULL; item = item->next) {
+      if (cJSON_IsTypedArray(item) && item->string != NULL &&
+          key_equals_ignore_case(item->string, "params") &&
+          !cJSON_ExpandTypedArray(item))
+        log_error("Typed params expansion failed",
+                  MJRPC_RET_ERROR_MEM_ALLOC_FAILED);
+    }
+    if (each == request)
+      break;
+  }
+  return request;
+}
+
+char *mjrpc_process_buf(const mjrpc_handle_t *handle, const char *buf,
+                        size_t len, int *ret_code) {
+  if (buf != NULL && handle != NULL && handle->typed_array_min != 0)
+    return process_parsed(
+        handle,
+        expand_typed_params(
+            cJSON_ParseWithLengthTyped(buf, len, handle->typed_array_min)),
+        len, ret_code);
+  return process_parsed(handle, buf ? cJSON_ParseWithLength(buf, len) : NULL,
+                        len, ret_code);
+}
+
+char *mjrpc_process_buf_insitu(const mjrpc_handle_t *handle, char *buf,
+                               size_t len, int *ret_code) {
+  /* The tree points into buf, which outlives it and the response */
+  if (buf != NULL && handle != NULL && handle->typed_array_min != 0)
+    return process_parsed(
+        handle,
+        expand_typed_params(
+            cJSON_ParseInSituTyped(buf, len, handle->typed_array_min)),
+        len, ret_code);
+  return process_parsed(handle, buf ? cJSON_ParseInSitu(buf, len) : NULL,
+                        len, ret_code);
+}
+
+static cJSON *process_request(const mjrpc_handle_t *handle,
+                              const cJSON *request_cjson, int *ret_code,
+                              struct async_dispatch *dispatch) {
   init_memory_hooks_if_needed();
   int ret = MJRPC_RET_OK;
   if (handle == NULL) {
@@ -692,15 +2871,14 @@ cJSON *mjrpc_process_cjson(const mjrpc_handle_t *handle,
 
   cJSON *cjson_return = NULL;
   if (request_cjson->type == cJSON_Array) {
-    int array_size = cJSON_GetArraySize(request_cjson);
-    if (array_size <= 0) {
+    if (request_cjson->child == NULL) {
       ret = MJRPC_RET_ERROR_EMPTY_REQUEST;
       cjson_return = mjrpc_response_error(
           JSON_RPC_CODE_INVALID_REQUEST,
           "Invalid request received: Empty JSON array.", cJSON_CreateNull());
     } else {
-      cjson_return = rpc_handle_ary_req(handle, request_cjson);
-      if (cjson_return)
+      cjson_return = rpc_handle_ary_req(handle, request_cjson, dispatch);
+      if (cjson_return || (dispatch && dispatch->expects_response))
         ret = MJRPC_RET_OK;
       else
         ret = MJRPC_RET_OK_NOTIFICATION;
@@ -712,8 +2890,8 @@ cJSON *mjrpc_process_cjson(const mjrpc_handle_t *handle,
           JSON_RPC_CODE_INVALID_REQUEST,
           "Invalid request received: Empty JSON object.", cJSON_CreateNull());
     } else {
-      cjson_return = rpc_handle_obj_req(handle, request_cjson);
-      if (cjson_return)
+      cjson_return = rpc_handle_obj_req(handle, request_cjson, dispatch);
+      if (cjson_return || (dispatch && dispatch->expects_response))
         ret = MJRPC_RET_OK;
       else
         ret = MJRPC_RET_OK_NOTIFICATION;
@@ -730,6 +2908,68 @@ cJSON *mjrpc_process_cjson(const mjrpc_handle_t *handle,
   return cjson_return;
 }
 
+cJSON *mjrpc_process_cjson(const mjrpc_handle_t *handle,
+                           const cJSON *request_cjson, int *ret_code) {
+  return process_request(handle, request_cjson, ret_code, NULL);
+}
+
+int mjrpc_process_async(const mjrpc_handle_t *handle,
+                        const cJSON *request_cjson,
+                        mjrpc_response_func on_response, void *user_data) {
+  if (handle == NULL)
+    return MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED;
+  if (on_response == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+
+  struct async_dispatch dispatch = {0};
+  dispatch.on_response = on_response;
+  dispatch.user_data = user_data;
+  int ret = MJRPC_RET_OK;
+  cJSON *response = process_request(handle, request_cjson, &ret, &dispatch);
+  /* Otherwise the last token to complete delivers the response */
+  if (dispatch.pending == 0)
+    on_response(response, user_data);
+  return ret;
+}
+
+int mjrpc_complete(mjrpc_async_token_t *token, cJSON *result) {
+  if (token == NULL) {
+    cJSON_Delete(result);
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  }
+  if (token->stats)
+    stats_record(token->stats, token->id == NULL, 0, token->start_ns);
+  if (result == NULL)
+    result = cJSON_CreateNull();
+  cJSON *response = NULL;
+  if (token->id != NULL)
+    response = mjrpc_response_ok(result, token->id);
+  else
+    cJSON_Delete(result);
+  async_finish(token, response);
+  return MJRPC_RET_OK;
+}
+
+const cJSON *mjrpc_async_token_id(const mjrpc_async_token_t *token) {
+  return token ? token->id : NULL;
+}
+
+bool mjrpc_async_token_in_batch(const mjrpc_async_token_t *token) {
+  return token != NULL && token->batch != NULL;
+}
+
+int mjrpc_fail(mjrpc_async_token_t *token, int32_t code, const char *message) {
+  if (token == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  if (token->stats)
+    stats_record(token->stats, token->id == NULL, code, token->start_ns);
+  cJSON *response = NULL;
+  if (token->id != NULL)
+    response = mjrpc_response_error(code, message, token->id);
+  async_finish(token, response);
+  return MJRPC_RET_OK;
+}
+
 int mjrpc_set_memory_hooks(mjrpc_malloc_func malloc_func,
                            mjrpc_free_func free_func,
                            mjrpc_strdup_func strdup_func) {
@@ -757,6 +2997,21 @@ int mjrpc_set_memory_hooks(mjrpc_malloc_func malloc_func,
   return MJRPC_RET_OK;
 }
 
+void *mjrpc_malloc(size_t size) {
+  init_memory_hooks_if_needed();
+  return g_mjrpc_malloc(size);
+}
+
+void mjrpc_free(void *ptr) {
+  init_memory_hooks_if_needed();
+  g_mjrpc_free(ptr);
+}
+
+char *mjrpc_strdup(const char *str) {
+  init_memory_hooks_if_needed();
+  return g_mjrpc_strdup(str);
+}
+
 int mjrpc_set_error_log_hook(mjrpc_error_log_func error_log_func) {
   g_mjrpc_error_log = error_log_func;
   return MJRPC_RET_OK;
@@ -3,7 +3,7 @@
  * @brief A lightweight JSON-RPC 2.0 message parser and generator based on cJSON
  * @author Xiao
  * @date 2026
- * @version 2.4.0
+ * @version 3.0.0
  *
  * @details
  * This library provides a complete implementation of JSON-RPC 2.0 specification
@@ -49,6 +49,7 @@ extern "C" {
 #endif
 
 #include "cJSON.h"
+#include <stdbool.h>
 #include <stdint.h>
 
 /**
@@ -108,9 +109,27 @@ enum mjrpc_error_return {
   MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED,
 
   /** @brief Invalid parameter provided */
-  MJRPC_RET_ERROR_INVALID_PARAM
+  MJRPC_RET_ERROR_INVALID_PARAM,
+
+  /** @brief A system call failed, see errno */
+  MJRPC_RET_ERROR_SYSTEM,
+
+  /** @brief Message exceeds the configured size limit */
+  MJRPC_RET_ERROR_TOO_LARGE,
+
+  /** @brief Operation did not complete before its timeout */
+  MJRPC_RET_ERROR_TIMEOUT,
+
+  /** @brief Call was cancelled before a response arrived */
+  MJRPC_RET_ERROR_CANCELLED
 };
 
+/** @brief Params indexed inside the context without allocating */
+#define MJRPC_PARAMS_INLINE 8
+
+/** @brief Hash index over the names of object params (opaque) */
+struct mjrpc_params_names;
+
 /**
  * @struct mjrpc_func_ctx_t
  * @brief Context structure passed to RPC method callback functions
@@ -135,6 +154,28 @@ typedef struct {
 
   /** @brief Parameter type: 0=object, 1=array, 2=no params */
   int params_type;
+
+  /** @brief Part of the method name after the matched namespace prefix (only
+   * set for handlers registered with mjrpc_add_prefix_method, NULL otherwise)
+   */
+  const char *method_suffix;
+
+  /** @brief Params of the call, read through mjrpc_params_size() and
+   * mjrpc_params_at() (set by the library, do not modify) */
+  const cJSON *params;
+
+  /** @brief Number of params, -1 until first counted (set by the library) */
+  int params_count;
+
+  /** @brief Index of the params, built on first use (set by the library) */
+  cJSON **params_index;
+
+  /** @brief Storage for the index of up to MJRPC_PARAMS_INLINE params */
+  cJSON *params_inline[MJRPC_PARAMS_INLINE];
+
+  /** @brief Hash index of the params names, built on first use (set by the
+   * library) */
+  struct mjrpc_params_names *params_names;
 } mjrpc_func_ctx_t;
 
 /**
@@ -148,10 +189,52 @@ typedef struct {
  *
  * @note If error_code is set in context, the error_message will be used
  *       instead of the returned result
+ * @note Large strings can be returned without a copy through
+ *       cJSON_CreateStringExternal(). The library deletes the result, and
+ *       with it runs the release callback, once the response has been
+ *       printed (or when the caller deletes the response of
+ *       mjrpc_process_cjson()). Coalesced responses share the string
+ *       instead of copying it, so it is released after the last one. The
+ *       response cache prints a result once and shares that text with
+ *       every hit.
  */
 typedef cJSON *(*mjrpc_func)(mjrpc_func_ctx_t *context, cJSON *params,
                              cJSON *id);
 
+/**
+ * @struct mjrpc_async_token
+ * @brief Opaque handle for a call whose response is produced later
+ *
+ * Handed to asynchronous methods; consumed by exactly one call to
+ * mjrpc_complete() or mjrpc_fail().
+ */
+typedef struct mjrpc_async_token mjrpc_async_token_t;
+
+/**
+ * @typedef mjrpc_async_func
+ * @brief Function pointer type for asynchronous RPC method implementations
+ *
+ * @param context Context structure containing user data; the error fields are
+ *                not used for asynchronous methods (use mjrpc_fail())
+ * @param params JSON parameters passed to the method (can be NULL, only valid
+ *               until the function returns)
+ * @param id Request ID (NULL for notifications, owned by the token and only
+ *           valid until the token is completed)
+ * @param token Token to complete with mjrpc_complete() or mjrpc_fail()
+ */
+typedef void (*mjrpc_async_func)(mjrpc_func_ctx_t *context, cJSON *params,
+                                 cJSON *id, mjrpc_async_token_t *token);
+
+/**
+ * @typedef mjrpc_response_func
+ * @brief Callback receiving the response of mjrpc_process_async()
+ *
+ * @param response Response object (callee must delete), or NULL if the request
+ *                 produced no response (e.g. a notification)
+ * @param user_data User data pointer passed to mjrpc_process_async()
+ */
+typedef void (*mjrpc_response_func)(cJSON *response, void *user_data);
+
 /**
  * @struct mjrpc_method
  * @brief Internal structure representing a registered RPC method
@@ -164,9 +247,25 @@ struct mjrpc_method {
   /** @brief Function pointer to method implementation */
   mjrpc_func func;
 
+  /** @brief Asynchronous implementation (used when func is NULL) */
+  mjrpc_async_func async_func;
+
   /** @brief User argument passed to the function */
   void *arg;
 
+  /** @brief Call statistics (NULL unless enabled with mjrpc_enable_stats()) */
+  struct mjrpc_method_stats *stats;
+
+  /** @brief Whether results are memoized (see mjrpc_add_cached_method()) */
+  bool cacheable;
+
+  /** @brief Lifetime of memoized results in milliseconds, 0 for unlimited */
+  uint32_t cache_ttl_ms;
+
+  /** @brief Whether identical concurrent calls share one run (see
+   * mjrpc_set_single_flight()) */
+  bool single_flight;
+
   /** @brief Internal state for hash table management */
   int state;
 };
@@ -187,6 +286,32 @@ typedef struct mjrpc_handle {
 
   /** @brief Current number of registered methods */
   size_t size;
+
+  /** @brief Radix trie of namespace prefixes (NULL if none registered) */
+  struct mjrpc_route *routes;
+
+  /** @brief Interceptor chain in call order (NULL if empty) */
+  struct mjrpc_interceptor *interceptors;
+
+  /** @brief Number of installed interceptors */
+  size_t interceptor_count;
+
+  /** @brief Memoized results of cacheable methods (NULL until needed) */
+  struct mjrpc_cache *cache;
+
+  /** @brief Calls of single-flight methods in progress (NULL until needed) */
+  struct mjrpc_flights *flights;
+
+  /** @brief Whether methods get call statistics */
+  bool stats_enabled;
+
+  /** @brief Statistics of deleted methods, kept alive for asynchronous
+   *         calls still in flight */
+  struct mjrpc_method_stats *retired_stats;
+
+  /** @brief Shortest numeric array parsed as a typed array, 0 for none
+   *         (see mjrpc_set_typed_arrays()) */
+  size_t typed_array_min;
 } mjrpc_handle_t;
 
 /** @typedef mjrpc_handle_t
@@ -278,6 +403,30 @@ int mjrpc_set_memory_hooks(mjrpc_malloc_func malloc_func,
                            mjrpc_free_func free_func,
                            mjrpc_strdup_func strdup_func);
 
+/**
+ * @brief Allocate through the malloc hook of the calling thread
+ *
+ * For memory the library takes ownership of and later releases with its
+ * free hook, such as ctx->error_message or the arg2func of a method.
+ *
+ * @param size Number of bytes to allocate
+ * @return Pointer to allocated memory, or NULL on failure
+ */
+void *mjrpc_malloc(size_t size);
+
+/**
+ * @brief Release through the free hook of the calling thread
+ * @param ptr Memory from mjrpc_malloc() or mjrpc_strdup() (can be NULL)
+ */
+void mjrpc_free(void *ptr);
+
+/**
+ * @brief Duplicate a string through the strdup hook of the calling thread
+ * @param str String to duplicate
+ * @return Pointer to the copy, or NULL on failure
+ */
+char *mjrpc_strdup(const char *str);
+
 /**
  * @brief Set custom error logging function
  *
@@ -376,6 +525,178 @@ char *mjrpc_request_str(const char *method, cJSON *params, cJSON *id);
  */
 cJSON *mjrpc_request_cjson(const char *method, cJSON *params, cJSON *id);
 
+/** @brief Maximum nesting of params containers in a request writer */
+#define MJRPC_WRITER_MAX_DEPTH 16
+
+/**
+ * @struct mjrpc_request_writer_t
+ * @brief Writes one request as JSON text straight into a caller buffer
+ *
+ * Unlike mjrpc_request_str(), the writer builds no cJSON tree and allocates
+ * nothing. Start with mjrpc_request_begin() or mjrpc_notification_begin(),
+ * append parameters with the mjrpc_request_add_*() functions and finish with
+ * mjrpc_request_end(). The first parameter decides the params kind: named
+ * parameters make an object, unnamed ones an array. Errors are remembered
+ * and reported by mjrpc_request_end(), so appends need no checks.
+ *
+ * The fields are private; the writer may live on the stack and be reused
+ * for any number of requests.
+ *
+ * @par Example:
+ * @code
+ * char buf[256];
+ * size_t len;
+ * mjrpc_request_writer_t w;
+ * mjrpc_request_begin(&w, buf, sizeof(buf), "move", 7);
+ * mjrpc_request_add_string(&w, "unit", "arm");
+ * mjrpc_request_add_double(&w, "x", 1.5);
+ * mjrpc_request_open_array(&w, "flags");
+ * mjrpc_request_add_bool(&w, NULL, true);
+ * mjrpc_request_close(&w);
+ * if (mjrpc_request_end(&w, &len) == MJRPC_RET_OK)
+ *     send(fd, buf, len, 0);
+ * // {"jsonrpc":"2.0","method":"move","params":{"unit":"arm","x":1.5,
+ * //  "flags":[true]},"id":7}
+ * @endcode
+ */
+typedef struct {
+  char *buf;
+  size_t size;
+  size_t len; /* bytes produced, also counted past the end of buf */
+  int64_t id;
+  bool has_id;
+  int error;
+  int depth;         /* open containers, params included */
+  uint32_t objects;  /* bit per level: container is an object */
+  uint32_t nonempty; /* bit per level: container has an element */
+} mjrpc_request_writer_t;
+
+/**
+ * @brief Start writing a request
+ *
+ * @param writer Writer to (re)initialize
+ * @param buf Output buffer (may be NULL if @p size is 0, to measure)
+ * @param size Size of @p buf in bytes
+ * @param method Method name (escaped as needed)
+ * @param id Request ID
+ */
+void mjrpc_request_begin(mjrpc_request_writer_t *writer, char *buf,
+                         size_t size, const char *method, int64_t id);
+
+/**
+ * @brief Start writing a notification (a request without ID)
+ *
+ * @param writer Writer to (re)initialize
+ * @param buf Output buffer (may be NULL if @p size is 0, to measure)
+ * @param size Size of @p buf in bytes
+ * @param method Method name (escaped as needed)
+ */
+void mjrpc_notification_begin(mjrpc_request_writer_t *writer, char *buf,
+                              size_t size, const char *method);
+
+/**
+ * @brief Append an integer parameter
+ *
+ * @param writer Writer
+ * @param name Member name inside an object, NULL inside an array
+ * @param value Value
+ */
+void mjrpc_request_add_int(mjrpc_request_writer_t *writer, const char *name,
+                           int64_t value);
+
+/**
+ * @brief Append a number parameter
+ *
+ * Non-finite values are written as null, as cJSON does.
+ *
+ * @param writer Writer
+ * @param name Member name inside an object, NULL inside an array
+ * @param value Value
+ */
+void mjrpc_request_add_double(mjrpc_request_writer_t *writer, const char *name,
+                              double value);
+
+/**
+ * @brief Append a string parameter
+ *
+ * @param writer Writer
+ * @param name Member name inside an object, NULL inside an array
+ * @param value NUL-terminated string (escaped as needed; NULL writes null)
+ */
+void mjrpc_request_add_string(mjrpc_request_writer_t *writer, const char *name,
+                              const char *value);
+
+/**
+ * @brief Append a boolean parameter
+ *
+ * @param writer Writer
+ * @param name Member name inside an object, NULL inside an array
+ * @param value Value
+ */
+void mjrpc_request_add_bool(mjrpc_request_writer_t *writer, const char *name,
+                            bool value);
+
+/**
+ * @brief Append a null parameter
+ *
+ * @param writer Writer
+ * @param name Member name inside an object, NULL inside an array
+ */
+void mjrpc_request_add_null(mjrpc_request_writer_t *writer, const char *name);
+
+/**
+ * @brief Append already serialized JSON as a parameter
+ *
+ * The text is copied verbatim and not validated.
+ *
+ * @param writer Writer
+ * @param name Member name inside an object, NULL inside an array
+ * @param json JSON text
+ * @param len Length of @p json
+ */
+void mjrpc_request_add_raw(mjrpc_request_writer_t *writer, const char *name,
+                           const char *json, size_t len);
+
+/**
+ * @brief Open a nested array parameter; close it with mjrpc_request_close()
+ *
+ * @param writer Writer
+ * @param name Member name inside an object, NULL inside an array
+ */
+void mjrpc_request_open_array(mjrpc_request_writer_t *writer,
+                              const char *name);
+
+/**
+ * @brief Open a nested object parameter; close it with mjrpc_request_close()
+ *
+ * @param writer Writer
+ * @param name Member name inside an object, NULL inside an array
+ */
+void mjrpc_request_open_object(mjrpc_request_writer_t *writer,
+                               const char *name);
+
+/**
+ * @brief Close the innermost container opened with mjrpc_request_open_*()
+ *
+ * @param writer Writer
+ */
+void mjrpc_request_close(mjrpc_request_writer_t *writer);
+
+/**
+ * @brief Finish the request and NUL-terminate it
+ *
+ * @param writer Writer
+ * @param len Receives the length of the request without the terminator; on
+ *            MJRPC_RET_ERROR_TOO_LARGE the length it needs (may be NULL)
+ * @return Return code
+ * @retval MJRPC_RET_OK On success
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If an argument was NULL, named and
+ *         unnamed parameters were mixed, containers were left open or
+ *         nested deeper than MJRPC_WRITER_MAX_DEPTH
+ * @retval MJRPC_RET_ERROR_TOO_LARGE If the buffer is too small
+ */
+int mjrpc_request_end(mjrpc_request_writer_t *writer, size_t *len);
+
 /** @} */
 
 /**
@@ -451,6 +772,74 @@ cJSON *mjrpc_response_error(int code, const char *message, cJSON *id);
 
 /** @} */
 
+/**
+ * @defgroup params_access Params Access
+ * @brief Positional access to the params of a call
+ *
+ * cJSON arrays are linked lists, so cJSON_GetArrayItem() walks from the first
+ * element on every call. These functions count the params once per call and
+ * index them on first access, making every later lookup O(1). Up to
+ * MJRPC_PARAMS_INLINE params are indexed inside the context; longer params
+ * allocate one array with the memory hooks, freed when the method returns.
+ * Both array and object params are indexed, objects in member order.
+ *
+ * Named lookups on object params with more than MJRPC_PARAMS_INLINE members
+ * hash every name once, on first use, instead of comparing against each
+ * member on every lookup like cJSON_GetObjectItem(). Smaller objects are
+ * scanned directly.
+ * @{
+ */
+
+/**
+ * @brief Get the number of params of a call
+ *
+ * @param ctx Context received by the method
+ * @return Number of array elements or object members, 0 without params
+ */
+int mjrpc_params_size(mjrpc_func_ctx_t *ctx);
+
+/**
+ * @brief Get a param of a call by position
+ *
+ * @param ctx Context received by the method
+ * @param index Zero-based position
+ * @return The param, or NULL if index is out of range
+ *
+ * @note Only valid while the method runs, like the params themselves
+ */
+cJSON *mjrpc_params_at(mjrpc_func_ctx_t *ctx, int index);
+
+/**
+ * @brief Get a named param of a call, ignoring case
+ *
+ * Matches like cJSON_GetObjectItem(): ASCII case is ignored and the first of
+ * several matching members is returned.
+ *
+ * @param ctx Context received by the method
+ * @param name Member name
+ * @return The param, or NULL if params are not an object or have no such
+ *         member
+ *
+ * @note Only valid while the method runs, like the params themselves
+ */
+cJSON *mjrpc_params_get(mjrpc_func_ctx_t *ctx, const char *name);
+
+/**
+ * @brief Get a named param of a call, matching case exactly
+ *
+ * Like mjrpc_params_get() but matches like
+ * cJSON_GetObjectItemCaseSensitive(), which compares names faster.
+ *
+ * @param ctx Context received by the method
+ * @param name Member name
+ * @return The param, or NULL if params are not an object or have no such
+ *         member
+ */
+cJSON *mjrpc_params_get_case_sensitive(mjrpc_func_ctx_t *ctx,
+                                       const char *name);
+
+/** @} */
+
 /**
  * @defgroup handle_management Handle Management Functions
  * @brief Functions for creating and managing RPC handles
@@ -557,6 +946,42 @@ int mjrpc_destroy_handle(mjrpc_handle_t *handle);
 int mjrpc_add_method(mjrpc_handle_t *handle, mjrpc_func function_pointer,
                      const char *method_name, void *arg2func);
 
+/**
+ * @brief Register a new asynchronous RPC method
+ *
+ * Like mjrpc_add_method(), but the callback does not return a result.
+ * Instead it receives a token and delivers the result later, possibly from
+ * another thread, with mjrpc_complete() or mjrpc_fail().
+ *
+ * Asynchronous methods can only be reached through mjrpc_process_async();
+ * the synchronous entry points answer them with JSON_RPC_CODE_INTERNAL_ERROR.
+ *
+ * @param handle JSON-RPC handle (must not be NULL)
+ * @param function_pointer Asynchronous callback (must not be NULL)
+ * @param method_name Name of the method (must not be NULL)
+ * @param arg2func User argument passed to the callback function (can be NULL).
+ *                 Ownership rules are the same as for mjrpc_add_method().
+ *
+ * @return Error code from enum mjrpc_error_return
+ * @retval MJRPC_RET_OK If successful
+ * @retval MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED If handle is NULL
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If function_pointer or method_name is
+ * NULL
+ * @retval MJRPC_RET_ERROR_MEM_ALLOC_FAILED If memory allocation failed
+ *
+ * @par Example:
+ * @code
+ * void fetch(mjrpc_func_ctx_t *ctx, cJSON *params, cJSON *id,
+ *            mjrpc_async_token_t *token) {
+ *     start_backend_request(params, token); // completes the token later
+ * }
+ * mjrpc_add_async_method(handle, fetch, "fetch", NULL);
+ * @endcode
+ */
+int mjrpc_add_async_method(mjrpc_handle_t *handle,
+                           mjrpc_async_func function_pointer,
+                           const char *method_name, void *arg2func);
+
 /**
  * @brief Unregister an RPC method
  *
@@ -630,6 +1055,489 @@ int mjrpc_enum_methods(const mjrpc_handle_t *handle,
 
 /** @} */
 
+/**
+ * @defgroup namespace_routing Namespace Routing Functions
+ * @brief Functions for delegating whole method namespaces
+ *
+ * A namespace entry matches every method name of the form
+ * "<prefix>.<suffix>". Exact method entries always take precedence; among
+ * namespace entries the longest matching prefix wins. Prefixes are stored in
+ * a radix trie, so lookup cost is bounded by the length of the method name
+ * regardless of how many namespaces are registered.
+ * @{
+ */
+
+/** @brief Maximum depth of nested namespace delegation between handles */
+#define MJRPC_ROUTE_MAX_DEPTH 16
+
+/**
+ * @brief Delegate a method namespace to a child handle
+ *
+ * Calls to "<prefix>.<suffix>" that do not match an exact method in @p handle
+ * are dispatched to @p child as method "<suffix>". Child handles may register
+ * namespaces of their own, up to MJRPC_ROUTE_MAX_DEPTH levels.
+ *
+ * @param handle JSON-RPC handle (must not be NULL)
+ * @param prefix Namespace without the trailing dot, e.g. "storage.volume"
+ *               (must not be NULL)
+ * @param child Handle that serves the namespace (must not be NULL)
+ *
+ * @return Error code from enum mjrpc_error_return
+ * @retval MJRPC_RET_OK If successful
+ * @retval MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED If handle is NULL
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If prefix or child is NULL, or child
+ * is handle itself
+ * @retval MJRPC_RET_ERROR_MEM_ALLOC_FAILED If memory allocation failed
+ *
+ * @note The child handle is borrowed, not owned: it is not destroyed together
+ *       with @p handle and must outlive every request routed through it
+ * @note An existing entry for the same prefix is replaced
+ *
+ * @par Example:
+ * @code
+ * mjrpc_handle_t *storage = mjrpc_create_handle(0);
+ * mjrpc_add_method(storage, volume_create, "volume.create", NULL);
+ *
+ * mjrpc_handle_t *root = mjrpc_create_handle(0);
+ * mjrpc_add_namespace(root, "storage", storage);
+ * // "storage.volume.create" now reaches volume_create
+ * @endcode
+ */
+int mjrpc_add_namespace(mjrpc_handle_t *handle, const char *prefix,
+                        mjrpc_handle_t *child);
+
+/**
+ * @brief Register a wildcard handler for a method namespace
+ *
+ * Calls to "<prefix>.<suffix>" that do not match an exact method in @p handle
+ * invoke @p function_pointer. The remaining part of the name is available to
+ * the handler as mjrpc_func_ctx_t::method_suffix.
+ *
+ * @param handle JSON-RPC handle (must not be NULL)
+ * @param function_pointer Callback function for the namespace (must not be
+ * NULL)
+ * @param prefix Namespace without the trailing dot (must not be NULL)
+ * @param arg2func User argument passed to the callback function (can be NULL).
+ *                 Ownership rules are the same as for mjrpc_add_method().
+ *
+ * @return Error code from enum mjrpc_error_return
+ * @retval MJRPC_RET_OK If successful
+ * @retval MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED If handle is NULL
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If function_pointer or prefix is NULL
+ * @retval MJRPC_RET_ERROR_MEM_ALLOC_FAILED If memory allocation failed
+ *
+ * @par Example:
+ * @code
+ * cJSON *proxy(mjrpc_func_ctx_t *ctx, cJSON *params, cJSON *id) {
+ *     // ctx->method_suffix is "volume.create" for "storage.volume.create"
+ *     return forward_to_backend(ctx->method_suffix, params);
+ * }
+ * mjrpc_add_prefix_method(handle, proxy, "storage", NULL);
+ * @endcode
+ */
+int mjrpc_add_prefix_method(mjrpc_handle_t *handle,
+                            mjrpc_func function_pointer, const char *prefix,
+                            void *arg2func);
+
+/**
+ * @brief Remove a namespace entry
+ *
+ * Removes an entry added by mjrpc_add_namespace() or
+ * mjrpc_add_prefix_method(). The user argument of a wildcard handler is freed.
+ *
+ * @param handle JSON-RPC handle (must not be NULL)
+ * @param prefix Namespace without the trailing dot (must not be NULL)
+ *
+ * @return Error code from enum mjrpc_error_return
+ * @retval MJRPC_RET_OK If successful
+ * @retval MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED If handle is NULL
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If prefix is NULL
+ * @retval MJRPC_RET_ERROR_NOT_FOUND If no entry exists for the prefix
+ */
+int mjrpc_del_namespace(mjrpc_handle_t *handle, const char *prefix);
+
+/** @} */
+
+/**
+ * @defgroup response_cache Response Cache
+ * @brief Memoization of methods whose result depends only on their params
+ *
+ * Results of cacheable methods are kept in a bounded LRU per handle, keyed
+ * by method and params. Params are hashed canonically, so objects match
+ * regardless of member order, and a candidate is confirmed with a deep
+ * comparison. Only successful results of calls with an id are stored, as
+ * serialized JSON; a hit splices those bytes into the response as a
+ * cJSON_Raw item without calling the method. The cache is safe to use
+ * from several threads processing requests with the same handle.
+ *
+ * Single-flight methods go one step further for calls that are in
+ * progress: identical calls wait for the running one instead of starting
+ * their own.
+ * @{
+ */
+
+/** @brief Entries of a handle's cache unless set otherwise */
+#define MJRPC_CACHE_DEFAULT_ENTRIES 1024
+
+/**
+ * @struct mjrpc_cache_stats_t
+ * @brief Counters of a handle's response cache
+ */
+typedef struct {
+  /** @brief Calls answered from the cache */
+  uint64_t hits;
+  /** @brief Calls of cacheable methods that ran the method */
+  uint64_t misses;
+  /** @brief Entries dropped to make room */
+  uint64_t evictions;
+  /** @brief Entries dropped because their TTL had passed */
+  uint64_t expirations;
+  /** @brief Entries currently stored */
+  size_t entries;
+} mjrpc_cache_stats_t;
+
+/**
+ * @brief Add a method whose results are memoized
+ *
+ * Like mjrpc_add_method(), for methods that are pure functions of their
+ * params: identical calls within @p ttl_ms are answered from the cache.
+ * Replacing or deleting the method drops its cached results.
+ *
+ * @param handle JSON-RPC handle
+ * @param function_pointer Method implementation
+ * @param method_name Method name
+ * @param arg2func Argument passed as ctx->data, owned as by
+ *                 mjrpc_add_method()
+ * @param ttl_ms Lifetime of a result in milliseconds, 0 for unlimited
+ *
+ * @return Error code from enum mjrpc_error_return
+ * @retval MJRPC_RET_OK If successful
+ * @retval MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED If handle is NULL
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If function_pointer or method_name
+ *         is NULL
+ * @retval MJRPC_RET_ERROR_MEM_ALLOC_FAILED If memory allocation failed
+ */
+int mjrpc_add_cached_method(mjrpc_handle_t *handle,
+                            mjrpc_func function_pointer,
+                            const char *method_name, void *arg2func,
+                            uint32_t ttl_ms);
+
+/**
+ * @brief Set the number of results a handle's cache holds
+ *
+ * Drops all cached results. A capacity of 0 turns memoization off until it
+ * is set again. Safe to call while other threads process requests: the
+ * cache is emptied and resized under its lock.
+ *
+ * @param handle JSON-RPC handle
+ * @param max_entries Maximum number of cached results
+ *
+ * @return Error code from enum mjrpc_error_return
+ * @retval MJRPC_RET_OK If successful
+ * @retval MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED If handle is NULL
+ * @retval MJRPC_RET_ERROR_MEM_ALLOC_FAILED If memory allocation failed
+ */
+int mjrpc_set_cache_capacity(mjrpc_handle_t *handle, size_t max_entries);
+
+/**
+ * @brief Drop cached results
+ *
+ * @param handle JSON-RPC handle
+ * @param method_name Method whose results to drop, NULL for all methods
+ * @param params Drop only the result for these params (NULL for all
+ *               results of @p method_name)
+ *
+ * @return Error code from enum mjrpc_error_return
+ * @retval MJRPC_RET_OK If successful (also if nothing was cached)
+ * @retval MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED If handle is NULL
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If params is given without
+ *         method_name
+ */
+int mjrpc_cache_invalidate(const mjrpc_handle_t *handle,
+                           const char *method_name, const cJSON *params);
+
+/**
+ * @brief Read the counters of a handle's cache
+ *
+ * @param handle JSON-RPC handle
+ * @param stats Receives the counters (all zero if no cache exists)
+ *
+ * @return Error code from enum mjrpc_error_return
+ * @retval MJRPC_RET_OK If successful
+ * @retval MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED If handle is NULL
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If stats is NULL
+ */
+int mjrpc_get_cache_stats(const mjrpc_handle_t *handle,
+                          mjrpc_cache_stats_t *stats);
+
+/**
+ * @brief Let identical concurrent calls of a method share one run
+ *
+ * While a call of a single-flight method runs, calls with the same params
+ * (compared as for the cache) arriving from other threads wait for it and
+ * receive a copy of its response, result or error, carrying their own id.
+ * Combined with mjrpc_add_cached_method() this keeps an expiring entry from
+ * sending a burst of identical calls to the method. Notifications always
+ * run on their own. Replacing the method turns the mode off again.
+ *
+ * @param handle JSON-RPC handle
+ * @param method_name Name of a synchronous method of @p handle
+ * @param enabled Whether calls are coalesced
+ *
+ * @return Error code from enum mjrpc_error_return
+ * @retval MJRPC_RET_OK If successful
+ * @retval MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED If handle is NULL
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If method_name is NULL or names an
+ *         asynchronous method
+ * @retval MJRPC_RET_ERROR_NOT_FOUND If no such method exists
+ * @retval MJRPC_RET_ERROR_MEM_ALLOC_FAILED If memory allocation failed
+ */
+int mjrpc_set_single_flight(mjrpc_handle_t *handle, const char *method_name,
+                            bool enabled);
+
+/** @} */
+
+/**
+ * @defgroup interceptors Interceptors
+ * @brief Hooks run around every method call of a handle
+ *
+ * Interceptors implement cross-cutting concerns such as authentication,
+ * logging, tracing or quotas once per handle instead of in every method.
+ * Their "before" stages run in installation order ahead of the method and
+ * can reject the call with an error; the "after" stages of every
+ * interceptor whose "before" stage ran then see the response in reverse
+ * order. The chain is kept in a flat array; a handle without interceptors
+ * dispatches exactly as before.
+ *
+ * Interceptors belong to the handle a request is processed with; requests
+ * delegated to a child handle through a namespace do not run the child's
+ * interceptors. For asynchronous methods the "after" stages run when the
+ * token is passed to mjrpc_complete() or mjrpc_fail(), on that thread, with
+ * the response about to be delivered. The request is gone by then, so only
+ * ctx->method, ctx->data and ctx->state are set, and interceptors must not
+ * be removed while such calls are pending.
+ * @{
+ */
+
+/** @brief Maximum number of interceptors per handle */
+#define MJRPC_MAX_INTERCEPTORS 16
+
+/**
+ * @struct mjrpc_intercept_ctx_t
+ * @brief State of one call passed through the interceptor chain
+ */
+typedef struct {
+  /** @brief Requested method name */
+  const char *method;
+  /** @brief Request parameters (NULL if none, and in "after" of
+   *         asynchronous methods) */
+  cJSON *params;
+  /** @brief Request id, NULL for notifications (valid in "before" only) */
+  const cJSON *id;
+  /** @brief Argument given to mjrpc_add_interceptor() */
+  void *data;
+  /** @brief Free for the interceptor: set in "before", read back in
+   *         "after" of the same interceptor (e.g. a start time) */
+  void *state;
+  /** @brief Set non-zero in "before" to reject the call with this code */
+  int32_t error_code;
+  /** @brief Message of the rejection, allocated with the strdup hook and
+   *         freed by the library (may stay NULL) */
+  char *error_message;
+} mjrpc_intercept_ctx_t;
+
+/**
+ * @typedef mjrpc_before_func
+ * @brief Stage run before the method; sets ctx->error_code to reject
+ */
+typedef void (*mjrpc_before_func)(mjrpc_intercept_ctx_t *ctx);
+
+/**
+ * @typedef mjrpc_after_func
+ * @brief Stage run after the method or a rejection
+ *
+ * @param ctx Call state; error_code is the code of the rejection, if any
+ * @param response Response about to be returned (NULL for notifications);
+ *                 may be modified in place
+ */
+typedef void (*mjrpc_after_func)(mjrpc_intercept_ctx_t *ctx,
+                                 cJSON *response);
+
+/**
+ * @brief Append an interceptor to the chain of a handle
+ *
+ * @param handle JSON-RPC handle
+ * @param before Stage run before the method (can be NULL)
+ * @param after Stage run after the method (can be NULL)
+ * @param arg Argument passed as ctx->data (will be freed when the
+ *            interceptor is removed or the handle destroyed, like method
+ *            arguments)
+ *
+ * @return Error code from enum mjrpc_error_return
+ * @retval MJRPC_RET_OK If successful
+ * @retval MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED If handle is NULL
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If both stages are NULL
+ * @retval MJRPC_RET_ERROR_TOO_LARGE If MJRPC_MAX_INTERCEPTORS are installed
+ * @retval MJRPC_RET_ERROR_MEM_ALLOC_FAILED If memory allocation failed
+ *
+ * @par Example:
+ * @code
+ * void require_token(mjrpc_intercept_ctx_t *ctx) {
+ *     const cJSON *token = cJSON_GetObjectItem(ctx->params, "token");
+ *     if (!cJSON_IsString(token) || !token_valid(token->valuestring)) {
+ *         ctx->error_code = -32001;
+ *         ctx->error_message = strdup("Unauthorized.");
+ *     }
+ * }
+ * mjrpc_add_interceptor(handle, require_token, NULL, NULL);
+ * @endcode
+ */
+int mjrpc_add_interceptor(mjrpc_handle_t *handle, mjrpc_before_func before,
+                          mjrpc_after_func after, void *arg);
+
+/**
+ * @brief Remove the first interceptor with the given stages
+ *
+ * @param handle JSON-RPC handle
+ * @param before Stage given to mjrpc_add_interceptor()
+ * @param after Stage given to mjrpc_add_interceptor()
+ *
+ * @return Error code from enum mjrpc_error_return
+ * @retval MJRPC_RET_OK If successful
+ * @retval MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED If handle is NULL
+ * @retval MJRPC_RET_ERROR_NOT_FOUND If no such interceptor is installed
+ */
+int mjrpc_del_interceptor(mjrpc_handle_t *handle, mjrpc_before_func before,
+                          mjrpc_after_func after);
+
+/** @} */
+
+/**
+ * @defgroup method_stats Method Statistics
+ * @brief Optional per-method call counters and latency histograms
+ *
+ * Once enabled on a handle, every method entry counts its calls,
+ * notifications and errors (per error code) and records its latency in a
+ * log-linear histogram: four buckets per power of two nanoseconds, so a
+ * bucket bound is within 25% of any value it holds. Asynchronous calls are
+ * counted when they complete. Counters are updated with relaxed atomic
+ * increments, so requests may be processed on several threads while
+ * statistics are read. Handles without statistics pay one pointer test per
+ * call.
+ *
+ * Methods reached through namespace routes are counted by the handle that
+ * owns them; prefix handlers are not counted.
+ * @{
+ */
+
+/** @brief Number of latency histogram buckets */
+#define MJRPC_STATS_LATENCY_BUCKETS 160
+
+/** @brief Distinct error codes counted per method; more go to
+ *         mjrpc_method_stats_t::other_errors */
+#define MJRPC_STATS_ERROR_CODES 8
+
+/** @brief Name of the built-in statistics method */
+#define MJRPC_STATS_METHOD "rpc.stats"
+
+/**
+ * @struct mjrpc_method_stats_t
+ * @brief Snapshot of the statistics of one method
+ */
+typedef struct {
+  /** @brief Completed calls with an id */
+  uint64_t calls;
+  /** @brief Completed notifications */
+  uint64_t notifications;
+  /** @brief Calls and notifications that failed */
+  uint64_t errors;
+  /** @brief Failures per error code; entries with a zero count are unused */
+  struct {
+    int32_t code;
+    uint64_t count;
+  } error_codes[MJRPC_STATS_ERROR_CODES];
+  /** @brief Failures whose code did not fit into error_codes */
+  uint64_t other_errors;
+  /** @brief Sum of all latencies in nanoseconds */
+  uint64_t latency_total_ns;
+  /** @brief Latency histogram, see mjrpc_stats_bucket_upper_ns() */
+  uint64_t latency[MJRPC_STATS_LATENCY_BUCKETS];
+} mjrpc_method_stats_t;
+
+/**
+ * @brief Enable statistics for all current and future methods of a handle
+ *
+ * Statistics cannot be disabled again; use mjrpc_reset_stats() to start
+ * over. Not thread-safe with respect to other calls on the handle, like
+ * mjrpc_add_method().
+ *
+ * @param handle JSON-RPC handle
+ * @param add_method Also register the method MJRPC_STATS_METHOD, which
+ *                   returns the statistics of every method of @p handle as
+ *                   {"<method>":{"calls":n,"notifications":n,"errors":n,
+ *                   "error_codes":{"<code>":n},"latency_ns":{"mean":n,
+ *                   "p50":n,"p90":n,"p99":n,"max":n}}}
+ *
+ * @return Error code from enum mjrpc_error_return
+ * @retval MJRPC_RET_OK If successful
+ * @retval MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED If handle is NULL
+ * @retval MJRPC_RET_ERROR_MEM_ALLOC_FAILED If memory allocation failed
+ */
+int mjrpc_enable_stats(mjrpc_handle_t *handle, bool add_method);
+
+/**
+ * @brief Take a snapshot of the statistics of one method
+ *
+ * Counters are read one by one while calls may still be running, so a
+ * snapshot is not a single point in time.
+ *
+ * @param handle JSON-RPC handle
+ * @param name Method name
+ * @param stats Receives the snapshot
+ *
+ * @return Error code from enum mjrpc_error_return
+ * @retval MJRPC_RET_OK If successful
+ * @retval MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED If handle is NULL
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If name or stats is NULL
+ * @retval MJRPC_RET_ERROR_NOT_FOUND If the method does not exist or has no
+ *         statistics
+ */
+int mjrpc_get_method_stats(const mjrpc_handle_t *handle, const char *name,
+                           mjrpc_method_stats_t *stats);
+
+/**
+ * @brief Set all statistics of a handle back to zero
+ *
+ * @param handle JSON-RPC handle
+ *
+ * @return Error code from enum mjrpc_error_return
+ * @retval MJRPC_RET_OK If successful
+ * @retval MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED If handle is NULL
+ */
+int mjrpc_reset_stats(const mjrpc_handle_t *handle);
+
+/**
+ * @brief Upper bound of a latency histogram bucket
+ *
+ * @param bucket Bucket index
+ * @return Largest latency in nanoseconds counted in @p bucket (UINT64_MAX
+ *         for the last bucket)
+ */
+uint64_t mjrpc_stats_bucket_upper_ns(size_t bucket);
+
+/**
+ * @brief Estimate a latency percentile from a snapshot
+ *
+ * @param stats Snapshot
+ * @param percentile Percentile between 0 and 100
+ * @return Upper bound in nanoseconds of the bucket holding the percentile,
+ *         or 0 if nothing was recorded
+ */
+uint64_t mjrpc_stats_percentile_ns(const mjrpc_method_stats_t *stats,
+                                   double percentile);
+
+/** @} */
+
 /**
  * @defgroup request_processing Request Processing Functions
  * @brief Functions for processing JSON-RPC requests
@@ -668,6 +1576,77 @@ int mjrpc_enum_methods(const mjrpc_handle_t *handle,
 char *mjrpc_process_str(const mjrpc_handle_t *handle, const char *request_str,
                         int *ret_code);
 
+/**
+ * @brief Process a JSON-RPC request held in a length-delimited buffer
+ *
+ * Same as mjrpc_process_str(), but the request does not need to be
+ * NUL-terminated, so it can be processed straight from a receive buffer.
+ *
+ * @param handle JSON-RPC handle containing registered methods
+ * @param buf Request bytes
+ * @param len Number of bytes in @p buf
+ * @param ret_code Pointer to store the return code (can be NULL)
+ *
+ * @return Response string (caller must free), or NULL for notifications
+ */
+char *mjrpc_process_buf(const mjrpc_handle_t *handle, const char *buf,
+                        size_t len, int *ret_code);
+
+/**
+ * @brief Process a JSON-RPC request, parsing it in place
+ *
+ * Same as mjrpc_process_buf(), but strings and member names are unescaped
+ * inside @p buf and the request tree points into it instead of allocating
+ * a copy of each (see cJSON_ParseInSitu()). Meant for receive buffers whose
+ * contents are not needed after processing: @p buf is overwritten.
+ *
+ * Methods see the same params as with mjrpc_process_buf(), except that
+ * strings and member names carry cJSON_IsReference and cJSON_StringIsConst:
+ * test types with cJSON_IsString() and friends rather than comparing
+ * cJSON::type. Items kept beyond the call must be copied with
+ * cJSON_Duplicate(), which the library does itself for cached params.
+ *
+ * @param handle JSON-RPC handle containing registered methods
+ * @param buf Request bytes, modified by the call
+ * @param len Number of bytes in @p buf
+ * @param ret_code Pointer to store the return code (can be NULL)
+ *
+ * @return Response string (caller must free), or NULL for notifications
+ */
+char *mjrpc_process_buf_insitu(const mjrpc_handle_t *handle, char *buf,
+                               size_t len, int *ret_code);
+
+/**
+ * @brief Parse long numeric arrays in requests into typed arrays
+ *
+ * With this set, mjrpc_process_str(), mjrpc_process_buf(),
+ * mjrpc_process_buf_insitu() and mjrpc_process_msgpack() parse arrays of at
+ * least @p min_count numbers (and nothing else) nested inside params into
+ * cJSON_TypedArray items, which keep the elements in one block instead of
+ * one item each (see cJSON_ParseWithLengthTyped()). Methods read them with
+ * cJSON_GetTypedArrayDoubles() and friends rather than walking children.
+ * The params array itself is still made of items, so positional params
+ * behave as before. Methods may return typed arrays whether or not this is
+ * set (see cJSON_CreateTypedDoubleArray()).
+ *
+ * @param handle JSON-RPC handle
+ * @param min_count Shortest array to parse as typed, 0 to turn it off
+ *
+ * @return Error code from enum mjrpc_error_return
+ * @retval MJRPC_RET_OK If successful
+ * @retval MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED If handle is NULL
+ */
+int mjrpc_set_typed_arrays(mjrpc_handle_t *handle, size_t min_count);
+
+/**
+ * @brief Get the shortest array parsed as typed
+ *
+ * @param handle JSON-RPC handle
+ *
+ * @return Count set with mjrpc_set_typed_arrays(), 0 if off or handle is NULL
+ */
+size_t mjrpc_get_typed_arrays(const mjrpc_handle_t *handle);
+
 /**
  * @brief Process a JSON-RPC request cJSON object
  *
@@ -701,6 +1680,79 @@ char *mjrpc_process_str(const mjrpc_handle_t *handle, const char *request_str,
 cJSON *mjrpc_process_cjson(const mjrpc_handle_t *handle,
                            const cJSON *request_cjson, int *ret_code);
 
+/**
+ * @brief Process a JSON-RPC request that may call asynchronous methods
+ *
+ * Works like mjrpc_process_cjson(), but the response is handed to
+ * @p on_response instead of being returned. The callback runs exactly once:
+ * immediately if every method completed synchronously, otherwise when the
+ * last pending token is completed (on the completing thread).
+ *
+ * @param handle JSON-RPC handle containing registered methods
+ * @param request_cjson JSON-RPC request cJSON object (only needs to stay
+ *                      valid until this function returns)
+ * @param on_response Callback receiving the response (must not be NULL)
+ * @param user_data User data pointer passed to @p on_response
+ *
+ * @return Same codes as the ret_code of mjrpc_process_cjson()
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If on_response is NULL (the callback
+ * is not invoked)
+ * @retval MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED If handle is NULL (the
+ * callback is not invoked)
+ *
+ * @note In a batch, synchronous elements are answered immediately and the
+ *       array is delivered once every asynchronous element has completed
+ */
+int mjrpc_process_async(const mjrpc_handle_t *handle,
+                        const cJSON *request_cjson,
+                        mjrpc_response_func on_response, void *user_data);
+
+/**
+ * @brief Complete an asynchronous call with a result
+ *
+ * @param token Token received by the asynchronous method (consumed)
+ * @param result Result of the call (will be owned by the response, NULL is
+ *               sent as JSON null)
+ *
+ * @return Error code from enum mjrpc_error_return
+ * @retval MJRPC_RET_OK If successful
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If token is NULL
+ *
+ * @note Can be called from any thread; the token must not be used afterwards
+ */
+int mjrpc_complete(mjrpc_async_token_t *token, cJSON *result);
+
+/**
+ * @brief Get the request id a token will answer
+ *
+ * @param token Token received by an asynchronous method
+ * @return Request id owned by the token, or NULL for notifications
+ */
+const cJSON *mjrpc_async_token_id(const mjrpc_async_token_t *token);
+
+/**
+ * @brief Check whether a token belongs to an element of a batch request
+ *
+ * @param token Token received by an asynchronous method
+ * @return true if the response will be part of a batch array
+ */
+bool mjrpc_async_token_in_batch(const mjrpc_async_token_t *token);
+
+/**
+ * @brief Complete an asynchronous call with an error
+ *
+ * @param token Token received by the asynchronous method (consumed)
+ * @param code Error code (standard JSON-RPC codes or custom codes)
+ * @param message Error message (copied, can be NULL)
+ *
+ * @return Error code from enum mjrpc_error_return
+ * @retval MJRPC_RET_OK If successful
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If token is NULL
+ *
+ * @note Can be called from any thread; the token must not be used afterwards
+ */
+int mjrpc_fail(mjrpc_async_token_t *token, int32_t code, const char *message);
+
 /** @} */
 /** @} */
 
@@ -0,0 +1,730 @@
+/**
+ * @file mjsonrpc.hpp
+ * @brief Header-only C++17 wrapper around the mjsonrpc C API
+ * @author Xiao
+ * @date 2026
+ * @version 3.0.0
+ *
+ * @details
+ * Provides RAII ownership for handles and cJSON trees and typed handler
+ * binding: the argument and return types of a handler are deduced from its
+ * signature, and positional or named params are decoded straight into those
+ * types before the call.
+ *
+ * @par Example:
+ * @code
+ * mjrpc::handle h;
+ * h.add("add", [](int a, int b) { return a + b; });
+ * h.add("greet", {"name"}, [](std::string name) { return "hi " + name; });
+ * std::optional<std::string> resp = h.process(
+ *     R"({"jsonrpc":"2.0","method":"add","params":[1,2],"id":1})");
+ * @endcode
+ *
+ * Handlers report JSON-RPC errors by throwing mjrpc::error; any other
+ * exception becomes an internal error. Exceptions never cross into the C
+ * library.
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2026 Xiao
+ */
+
+#ifndef MJSONRPC_HPP_
+#define MJSONRPC_HPP_
+
+#include "mjsonrpc.h"
+
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mjrpc {
+
+/**
+ * @class json
+ * @brief Move-only owner of a cJSON tree
+ */
+class json {
+public:
+  json() noexcept = default;
+  explicit json(cJSON *item) noexcept : item_(item) {}
+  json(const json &) = delete;
+  json &operator=(const json &) = delete;
+  json(json &&other) noexcept : item_(other.release()) {}
+  json &operator=(json &&other) noexcept {
+    if (this != &other)
+      reset(other.release());
+    return *this;
+  }
+  ~json() { cJSON_Delete(item_); }
+
+  /** @brief Parse JSON text; the result is empty if parsing failed */
+  static json parse(std::string_view text) {
+    return json(cJSON_ParseWithLength(text.data(), text.size()));
+  }
+
+  cJSON *get() const noexcept { return item_; }
+  cJSON *release() noexcept { return std::exchange(item_, nullptr); }
+  void reset(cJSON *item = nullptr) noexcept {
+    cJSON_Delete(std::exchange(item_, item));
+  }
+  explicit operator bool() const noexcept { return item_ != nullptr; }
+
+  /** @brief Serialize without formatting (empty string if empty) */
+  std::string dump() const {
+    if (item_ == nullptr)
+      return std::string();
+    char *text = cJSON_PrintUnformatted(item_);
+    if (text == nullptr)
+      throw std::bad_alloc();
+    std::string out(text);
+    cJSON_free(text);
+    return out;
+  }
+
+private:
+  cJSON *item_ = nullptr;
+};
+
+/**
+ * @class error
+ * @brief Exception a handler throws to produce a JSON-RPC error response
+ */
+class error : public std::runtime_error {
+public:
+  error(int32_t code, const std::string &message)
+      : std::runtime_error(message), code_(code) {}
+  int32_t code() const noexcept { return code_; }
+
+private:
+  int32_t code_;
+};
+
+/**
+ * @brief Conversion between C++ values and cJSON nodes
+ *
+ * Specialize for user types with two static members:
+ * `static bool decode(const cJSON *item, T &out)` and
+ * `static cJSON *encode(const T &value)`.
+ */
+template <typename T, typename Enable = void> struct codec;
+
+template <> struct codec<bool> {
+  static bool decode(const cJSON *item, bool &out) {
+    if (!cJSON_IsBool(item))
+      return false;
+    out = cJSON_IsTrue(item);
+    return true;
+  }
+  static cJSON *encode(bool value) { return cJSON_CreateBool(value); }
+};
+
+template <typename T>
+struct codec<T, std::enable_if_t<std::is_integral_v<T> &&
+                                 !std::is_same_v<T, bool>>> {
+  static bool decode(const cJSON *item, T &out) {
+    if (!cJSON_IsNumber(item))
+      return false;
+    const double v = item->valuedouble;
+    /* max() rounds up to 2^digits as a double, so bound it exclusively */
+    if (std::trunc(v) != v ||
+        v < static_cast<double>(std::numeric_limits<T>::min()) ||
+        v >= std::ldexp(1.0, std::numeric_limits<T>::digits))
+      return false;
+    out = static_cast<T>(v);
+    return true;
+  }
+  static cJSON *encode(T value) {
+    return cJSON_CreateNumber(static_cast<double>(value));
+  }
+};
+
+template <typename T>
+struct codec<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+  static bool decode(const cJSON *item, T &out) {
+    if (!cJSON_IsNumber(item))
+      return false;
+    out = static_cast<T>(item->valuedouble);
+    return true;
+  }
+  static cJSON *encode(T value) {
+    return cJSON_CreateNumber(static_cast<double>(value));
+  }
+};
+
+template <> struct codec<std::string> {
+  static bool decode(const cJSON *item, std::string &out) {
+    if (!cJSON_IsString(item))
+      return false;
+    out.assign(item->valuestring);
+    return true;
+  }
+  static cJSON *encode(const std::string &value) {
+    return cJSON_CreateString(value.c_str());
+  }
+};
+
+/* Views borrow from the request and are only valid during the call */
+template <> struct codec<std::string_view> {
+  static bool decode(const cJSON *item, std::string_view &out) {
+    if (!cJSON_IsString(item))
+      return false;
+    out = item->valuestring;
+    return true;
+  }
+  static cJSON *encode(std::string_view value) {
+    return cJSON_CreateString(std::string(value).c_str());
+  }
+};
+
+template <> struct codec<const char *> {
+  static cJSON *encode(const char *value) {
+    return value ? cJSON_CreateString(value) : cJSON_CreateNull();
+  }
+};
+
+template <> struct codec<std::nullptr_t> {
+  static cJSON *encode(std::nullptr_t) { return cJSON_CreateNull(); }
+};
+
+template <> struct codec<json> {
+  static bool decode(const cJSON *item, json &out) {
+    out.reset(cJSON_Duplicate(item, true));
+    return static_cast<bool>(out);
+  }
+  static cJSON *encode(json value) {
+    return value ? value.release() : cJSON_CreateNull();
+  }
+};
+
+template <typename T> struct codec<std::optional<T>> {
+  static bool decode(const cJSON *item, std::optional<T> &out) {
+    if (item == nullptr || cJSON_IsNull(item)) {
+      out.reset();
+      return true;
+    }
+    T value{};
+    if (!codec<T>::decode(item, value))
+      return false;
+    out = std::move(value);
+    return true;
+  }
+  static cJSON *encode(const std::optional<T> &value) {
+    return value ? codec<T>::encode(*value) : cJSON_CreateNull();
+  }
+};
+
+/* Numbers that survive a round trip through long long */
+template <typename T>
+inline constexpr bool fits_int64_v =
+    std::is_integral_v<T> && !std::is_same_v<T, bool> &&
+    (std::is_signed_v<T> || sizeof(T) < sizeof(long long));
+
+template <typename T> struct codec<std::vector<T>> {
+  static bool decode(const cJSON *item, std::vector<T> &out) {
+    if constexpr (std::is_floating_point_v<T> || fits_int64_v<T>) {
+      if (cJSON_IsTypedArray(item))
+        return decode_typed(item, out);
+    }
+    if (!cJSON_IsArray(item))
+      return false;
+    out.clear();
+    for (const cJSON *elem = item->child; elem != nullptr; elem = elem->next) {
+      T value{};
+      if (!codec<T>::decode(elem, value))
+        return false;
+      out.push_back(std::move(value));
+    }
+    return true;
+  }
+  static cJSON *encode(const std::vector<T> &value) {
+    cJSON *array = cJSON_CreateArray();
+    if (array == nullptr)
+      return nullptr;
+    for (const T &elem : value) {
+      cJSON *node = codec<T>::encode(elem);
+      if (node == nullptr || !cJSON_AddItemToArray(array, node)) {
+        cJSON_Delete(node);
+        cJSON_Delete(array);
+        return nullptr;
+      }
+    }
+    return array;
+  }
+
+private:
+  static bool decode_typed(const cJSON *item, std::vector<T> &out) {
+    const size_t count = cJSON_GetTypedArraySize(item);
+    out.clear();
+    out.reserve(count);
+    if constexpr (std::is_integral_v<T>) {
+      /* Read int64 blocks directly; a double would round past 2^53 */
+      if (cJSON_GetTypedArrayKind(item) == cJSON_TypedInt64) {
+        const long long *ints = cJSON_GetTypedArrayInt64s(item);
+        for (size_t i = 0; i < count; i++) {
+          const long long v = ints[i];
+          if constexpr (std::is_signed_v<T>) {
+            if (v < static_cast<long long>(std::numeric_limits<T>::min()) ||
+                v > static_cast<long long>(std::numeric_limits<T>::max()))
+              return false;
+          } else {
+            if (v < 0 || static_cast<unsigned long long>(v) >
+                             std::numeric_limits<T>::max())
+              return false;
+          }
+          out.push_back(static_cast<T>(v));
+        }
+        return true;
+      }
+    }
+    for (size_t i = 0; i < count; i++) {
+      /* A stand-in item applies the element codec's checks */
+      cJSON number{};
+      number.type = cJSON_Number;
+      number.valuedouble = cJSON_GetTypedArrayNumber(item, i);
+      T value{};
+      if (!codec<T>::decode(&number, value))
+        return false;
+      out.push_back(value);
+    }
+    return true;
+  }
+};
+
+/**
+ * @brief std::vector of numbers encoded as one typed array
+ *
+ * std::vector encodes one item per element, which any cJSON code can walk.
+ * Return typed_vector instead to put the numbers in a single block (see
+ * cJSON_CreateTypedDoubleArray()); it prints the same. Both decode from
+ * items and from typed arrays.
+ */
+template <typename T> struct typed_vector : std::vector<T> {
+  static_assert(std::is_floating_point_v<T> || fits_int64_v<T>,
+                "typed arrays hold doubles or long longs");
+  using std::vector<T>::vector;
+  typed_vector() = default;
+  typed_vector(std::vector<T> value) : std::vector<T>(std::move(value)) {}
+};
+
+template <typename T> struct codec<typed_vector<T>> {
+  static bool decode(const cJSON *item, typed_vector<T> &out) {
+    return codec<std::vector<T>>::decode(item, out);
+  }
+  static cJSON *encode(const typed_vector<T> &value) {
+    if constexpr (std::is_same_v<T, double>) {
+      return cJSON_CreateTypedDoubleArray(value.data(), value.size());
+    } else if constexpr (std::is_same_v<T, long long>) {
+      return cJSON_CreateTypedInt64Array(value.data(), value.size());
+    } else if constexpr (std::is_integral_v<T>) {
+      cJSON *array = cJSON_CreateTypedInt64Array(nullptr, value.size());
+      if (array == nullptr)
+        return nullptr;
+      long long *ints = cJSON_GetTypedArrayInt64s(array);
+      for (size_t i = 0; i < value.size(); i++)
+        ints[i] = static_cast<long long>(value[i]);
+      return array;
+    } else {
+      cJSON *array = cJSON_CreateTypedDoubleArray(nullptr, value.size());
+      if (array == nullptr)
+        return nullptr;
+      double *doubles = cJSON_GetTypedArrayDoubles(array);
+      for (size_t i = 0; i < value.size(); i++)
+        doubles[i] = static_cast<double>(value[i]);
+      return array;
+    }
+  }
+};
+
+namespace detail {
+
+/* String literals arrive as arrays; encode them as C strings */
+template <typename T> cJSON *encode_value(const T &value) {
+  if constexpr (std::is_array_v<T>)
+    return codec<const char *>::encode(value);
+  else
+    return codec<T>::encode(value);
+}
+
+template <typename T> struct is_optional : std::false_type {};
+template <typename T> struct is_optional<std::optional<T>> : std::true_type {};
+
+/** @brief Argument and return types of a callable */
+template <typename F>
+struct signature : signature<decltype(&std::decay_t<F>::operator())> {};
+template <typename R, typename... A> struct signature<R (*)(A...)> {
+  using result = R;
+  using args = std::tuple<std::decay_t<A>...>;
+};
+template <typename R, typename... A>
+struct signature<R (*)(A...) noexcept> : signature<R (*)(A...)> {};
+template <typename R, typename... A>
+struct signature<R(A...)> : signature<R (*)(A...)> {};
+template <typename C, typename R, typename... A>
+struct signature<R (C::*)(A...)> : signature<R (*)(A...)> {};
+template <typename C, typename R, typename... A>
+struct signature<R (C::*)(A...) const> : signature<R (*)(A...)> {};
+template <typename C, typename R, typename... A>
+struct signature<R (C::*)(A...) noexcept> : signature<R (*)(A...)> {};
+template <typename C, typename R, typename... A>
+struct signature<R (C::*)(A...) const noexcept> : signature<R (*)(A...)> {};
+
+/* Error messages are released by the C library with its free hook */
+inline void set_error(mjrpc_func_ctx_t *ctx, int32_t code, const char *msg) {
+  ctx->error_code = code;
+  ctx->error_message = mjrpc_strdup(msg);
+}
+
+/* Named params match case-insensitively, like mjrpc_params_get() */
+inline bool name_equals(const std::string &name, const char *key) {
+  size_t i = 0;
+  for (; key[i] != '\0'; i++) {
+    if (i == name.size() ||
+        std::tolower(static_cast<unsigned char>(name[i])) !=
+            std::tolower(static_cast<unsigned char>(key[i])))
+      return false;
+  }
+  return i == name.size();
+}
+
+/** @brief Owned state behind a registered method (see handle::bind) */
+struct binding_base {
+  virtual ~binding_base() = default;
+};
+
+struct sync_binding : binding_base {
+  virtual cJSON *call(mjrpc_func_ctx_t *ctx, cJSON *params) = 0;
+
+  static cJSON *trampoline(mjrpc_func_ctx_t *ctx, cJSON *params, cJSON *id) {
+    (void)id;
+    auto *self = static_cast<sync_binding *>(*static_cast<binding_base **>(
+        ctx->data));
+    try {
+      return self->call(ctx, params);
+    } catch (const error &e) {
+      set_error(ctx, e.code(), e.what());
+    } catch (const std::exception &e) {
+      set_error(ctx, JSON_RPC_CODE_INTERNAL_ERROR, e.what());
+    } catch (...) {
+      set_error(ctx, JSON_RPC_CODE_INTERNAL_ERROR, "Unknown exception.");
+    }
+    return nullptr;
+  }
+};
+
+template <typename F> class binding final : public sync_binding {
+  using sig = signature<F>;
+  using args_t = typename sig::args;
+  static constexpr size_t arity = std::tuple_size_v<args_t>;
+
+public:
+  binding(F fn, std::vector<std::string> names)
+      : fn_(std::move(fn)), names_(std::move(names)) {}
+
+  cJSON *call(mjrpc_func_ctx_t *ctx, cJSON *params) override {
+    std::array<const cJSON *, arity> slots{};
+    if (!collect(ctx, params, slots)) {
+      set_error(ctx, JSON_RPC_CODE_INVALID_PARAMS, "Invalid params.");
+      return nullptr;
+    }
+    args_t args;
+    if (!decode_all(slots, args, std::make_index_sequence<arity>{})) {
+      set_error(ctx, JSON_RPC_CODE_INVALID_PARAMS, "Invalid params.");
+      return nullptr;
+    }
+    using R = typename sig::result;
+    if constexpr (std::is_void_v<R>) {
+      std::apply(fn_, std::move(args));
+      return cJSON_CreateNull();
+    } else {
+      return codec<std::decay_t<R>>::encode(std::apply(fn_, std::move(args)));
+    }
+  }
+
+private:
+  /* One pass over params, filling the slot of each argument */
+  bool collect(const mjrpc_func_ctx_t *ctx, const cJSON *params,
+               std::array<const cJSON *, arity> &slots) const {
+    if (ctx->params_type == 1) {
+      /* Typed params have no items to bind */
+      if (cJSON_IsTypedArray(params))
+        return false;
+      size_t i = 0;
+      for (const cJSON *item = params->child; item; item = item->next) {
+        if (i == arity)
+          return false;
+        slots[i++] = item;
+      }
+      return true;
+    }
+    if (ctx->params_type == 0) {
+      if (names_.size() != arity)
+        return arity == 0 && params->child == nullptr;
+      for (const cJSON *item = params->child; item; item = item->next) {
+        for (size_t i = 0; i < arity; i++) {
+          if (slots[i] == nullptr && name_equals(names_[i], item->string)) {
+            slots[i] = item;
+            break;
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  template <size_t... I>
+  static bool decode_all(const std::array<const cJSON *, arity> &slots,
+                         args_t &args, std::index_sequence<I...>) {
+    return (decode_one(slots[I], std::get<I>(args)) && ...);
+  }
+
+  template <typename T> static bool decode_one(const cJSON *item, T &out) {
+    if (item == nullptr)
+      return is_optional<T>::value; /* only optionals may be omitted */
+    return codec<T>::decode(item, out);
+  }
+
+  F fn_;
+  std::vector<std::string> names_;
+};
+
+} // namespace detail
+
+/**
+ * @class handle
+ * @brief Move-only owner of an mjrpc_handle_t with typed method binding
+ */
+class handle {
+public:
+  explicit handle(size_t initial_capacity = 0)
+      : handle_(mjrpc_create_handle(initial_capacity)) {
+    if (handle_ == nullptr)
+      throw std::bad_alloc();
+  }
+  handle(const handle &) = delete;
+  handle &operator=(const handle &) = delete;
+  handle(handle &&other) noexcept
+      : handle_(std::exchange(other.handle_, nullptr)),
+        bindings_(std::move(other.bindings_)) {}
+  handle &operator=(handle &&other) noexcept {
+    if (this != &other) {
+      if (handle_ != nullptr)
+        mjrpc_destroy_handle(handle_);
+      handle_ = std::exchange(other.handle_, nullptr);
+      bindings_ = std::move(other.bindings_);
+    }
+    return *this;
+  }
+  ~handle() {
+    if (handle_ != nullptr)
+      mjrpc_destroy_handle(handle_);
+  }
+
+  /**
+   * @brief Register a handler taking positional params
+   *
+   * Argument types are deduced from the handler signature. Trailing
+   * std::optional arguments may be omitted by the caller.
+   */
+  template <typename F> void add(const char *method_name, F &&fn) {
+    add(method_name, {}, std::forward<F>(fn));
+  }
+
+  /**
+   * @brief Register a handler taking positional or named params
+   *
+   * @param names Parameter names in argument order, used to decode object
+   *              params; must match the handler arity
+   */
+  template <typename F>
+  void add(const char *method_name, std::initializer_list<const char *> names,
+           F &&fn) {
+    using binding_t = detail::binding<std::decay_t<F>>;
+    constexpr size_t arity =
+        std::tuple_size_v<typename detail::signature<std::decay_t<F>>::args>;
+    if (names.size() != 0 && names.size() != arity)
+      throw std::invalid_argument("parameter name count must match arity");
+
+    bind(method_name,
+         std::make_unique<binding_t>(
+             std::forward<F>(fn),
+             std::vector<std::string>(names.begin(), names.end())),
+         [](mjrpc_handle_t *h, const char *name, void *arg) {
+           return mjrpc_add_method(h, &detail::sync_binding::trampoline, name,
+                                   arg);
+         });
+  }
+
+  /**
+   * @brief Register a binding through a C registration function
+   *
+   * Extension point for other registration kinds (see mjsonrpc_coro.hpp).
+   * @p reg is called as `reg(handle, method_name, arg)` and must return an
+   * mjrpc_error_return code; the callback finds the binding through
+   * `*(detail::binding_base **)ctx->data`.
+   */
+  template <typename Register>
+  void bind(const char *method_name, std::unique_ptr<detail::binding_base> bound,
+            Register reg) {
+    /* The C library frees arg2func through its free hook, so allocate the
+     * box pointing at the binding this object owns through the same hooks */
+    auto **box = static_cast<detail::binding_base **>(
+        mjrpc_malloc(sizeof(detail::binding_base *)));
+    if (box == nullptr)
+      throw std::bad_alloc();
+    *box = bound.get();
+    if (reg(handle_, method_name, static_cast<void *>(box)) != MJRPC_RET_OK) {
+      mjrpc_free(box);
+      throw std::bad_alloc();
+    }
+    bindings_[method_name] = std::move(bound);
+  }
+
+  /** @brief Unregister a method; returns false if it was not registered */
+  bool remove(const char *method_name) {
+    bindings_.erase(method_name);
+    return mjrpc_del_method(handle_, method_name) == MJRPC_RET_OK;
+  }
+
+  /** @brief Process a parsed request; the result is empty for notifications */
+  json process(const json &request, int *ret_code = nullptr) const {
+    return json(mjrpc_process_cjson(handle_, request.get(), ret_code));
+  }
+
+  /** @brief Process request text; returns no value for notifications */
+  std::optional<std::string> process(const std::string &request,
+                                     int *ret_code = nullptr) const {
+    char *resp = mjrpc_process_str(handle_, request.c_str(), ret_code);
+    if (resp == nullptr)
+      return std::nullopt;
+    std::string out(resp);
+    cJSON_free(resp);
+    return out;
+  }
+
+  size_t size() const noexcept { return mjrpc_get_method_count(handle_); }
+  mjrpc_handle_t *get() const noexcept { return handle_; }
+
+private:
+  mjrpc_handle_t *handle_;
+  std::unordered_map<std::string, std::unique_ptr<detail::binding_base>>
+      bindings_;
+};
+
+/**
+ * @class request
+ * @brief Move-only JSON-RPC request built from typed arguments
+ */
+class request {
+public:
+  /** @brief Build a call with positional params; a null id is allowed */
+  template <typename Id, typename... A>
+  static request call(const char *method, const Id &id, const A &...args) {
+    return request(method, positional(args...),
+                   json(detail::encode_value(id)));
+  }
+
+  /** @brief Build a notification (no id) with positional params */
+  template <typename... A>
+  static request notify(const char *method, const A &...args) {
+    return request(method, positional(args...), json());
+  }
+
+  request(const char *method, json params, json id)
+      : json_(mjrpc_request_cjson(method, params.release(), id.release())) {
+    if (!json_)
+      throw std::bad_alloc();
+  }
+
+  const json &get() const noexcept { return json_; }
+  std::string dump() const { return json_.dump(); }
+
+private:
+  template <typename... A> static json positional(const A &...args) {
+    if constexpr (sizeof...(A) == 0) {
+      return json();
+    } else {
+      json array(cJSON_CreateArray());
+      if (!array)
+        throw std::bad_alloc();
+      bool ok = (cJSON_AddItemToArray(array.get(),
+                                       detail::encode_value(args)) &&
+                 ...);
+      if (!ok)
+        throw std::bad_alloc();
+      return array;
+    }
+  }
+
+  json json_;
+};
+
+/**
+ * @class response
+ * @brief Move-only view of a parsed JSON-RPC response
+ */
+class response {
+public:
+  explicit response(json parsed) : json_(std::move(parsed)) {}
+  static response parse(std::string_view text) {
+    return response(json::parse(text));
+  }
+
+  bool ok() const noexcept { return result_item() != nullptr; }
+
+  /** @brief Decode the result; throws mjrpc::error for error responses */
+  template <typename T> T result() const {
+    const cJSON *item = result_item();
+    if (item == nullptr)
+      throw error(error_code(), error_message());
+    T out{};
+    if (!codec<T>::decode(item, out))
+      throw std::invalid_argument("result type mismatch");
+    return out;
+  }
+
+  int32_t error_code() const noexcept {
+    const cJSON *code = cJSON_GetObjectItemCaseSensitive(error_item(), "code");
+    return cJSON_IsNumber(code) ? static_cast<int32_t>(code->valuedouble) : 0;
+  }
+
+  std::string error_message() const {
+    const cJSON *msg =
+        cJSON_GetObjectItemCaseSensitive(error_item(), "message");
+    return cJSON_IsString(msg) ? msg->valuestring : std::string();
+  }
+
+  const cJSON *id() const noexcept {
+    return cJSON_GetObjectItemCaseSensitive(json_.get(), "id");
+  }
+  const json &get() const noexcept { return json_; }
+
+private:
+  const cJSON *result_item() const noexcept {
+    return cJSON_GetObjectItemCaseSensitive(json_.get(), "result");
+  }
+  const cJSON *error_item() const noexcept {
+    return cJSON_GetObjectItemCaseSensitive(json_.get(), "error");
+  }
+
+  json json_;
+};
+
+} // namespace mjrpc
+
+#endif // MJSONRPC_HPP_
@@ -0,0 +1,460 @@
+/*
+    MIT License
+
+    Copyright (c) 2026 Xiao
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+ */
+
+#include "mjsonrpc_client.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** @brief Initial slot count of the pending table (power of two) */
+#define PENDING_INITIAL_CAPACITY 16
+
+/** @brief Initial size of the output buffer */
+#define CLIENT_OUTPUT_INITIAL 1024
+
+/*
+ * Pending calls live in an open-addressing table with linear probing. Ids are
+ * handed out consecutively, so after multiplicative hashing they rarely
+ * collide; deletion shifts later entries of the probe run back instead of
+ * leaving tombstones. Id 0 is never issued and marks a free slot.
+ */
+struct pending_call {
+  int64_t id;
+  mjrpc_client_callback callback;
+  void *user_data;
+};
+
+struct mjrpc_client {
+  mjrpc_client_config_t config;
+  mjrpc_framer_t *framer;
+  int64_t next_id;
+
+  struct pending_call *pending;
+  size_t pending_cap; /* power of two */
+  size_t pending_count;
+
+  /* Reused for serializing requests; the frame header is written right in
+   * front of the body */
+  char *out;
+  size_t out_cap;
+
+  /* Requests waiting to be sent together, NULL when none are queued */
+  cJSON *batch;
+  size_t batch_count;
+  int64_t batch_deadline; /* monotonic microseconds */
+};
+
+/*--- pending table ---*/
+
+static size_t pending_slot(const mjrpc_client_t *c, int64_t id) {
+  uint64_t h = (uint64_t)id * 0x9E3779B97F4A7C15ULL;
+  return (size_t)(h ^ (h >> 32)) & (c->pending_cap - 1);
+}
+
+static bool pending_grow(mjrpc_client_t *c) {
+  size_t cap = c->pending_cap ? c->pending_cap * 2 : PENDING_INITIAL_CAPACITY;
+  struct pending_call *old = c->pending;
+  size_t old_cap = c->pending_cap;
+  struct pending_call *table = calloc(cap, sizeof(*table));
+  if (table == NULL)
+    return false;
+  c->pending = table;
+  c->pending_cap = cap;
+  for (size_t i = 0; i < old_cap; i++) {
+    if (old[i].id == 0)
+      continue;
+    size_t slot = pending_slot(c, old[i].id);
+    while (table[slot].id != 0)
+      slot = (slot + 1) & (cap - 1);
+    table[slot] = old[i];
+  }
+  free(old);
+  return true;
+}
+
+static bool pending_insert(mjrpc_client_t *c, int64_t id,
+                           mjrpc_client_callback callback, void *user_data) {
+  /* Keep the load factor at or below one half */
+  if ((c->pending_count + 1) * 2 > c->pending_cap && !pending_grow(c))
+    return false;
+  size_t slot = pending_slot(c, id);
+  while (c->pending[slot].id != 0)
+    slot = (slot + 1) & (c->pending_cap - 1);
+  c->pending[slot].id = id;
+  c->pending[slot].callback = callback;
+  c->pending[slot].user_data = user_data;
+  c->pending_count++;
+  return true;
+}
+
+/**
+ * @brief Remove a call from the table
+ * @return false if it was not pending
+ */
+static bool pending_take(mjrpc_client_t *c, int64_t id,
+                         struct pending_call *out) {
+  if (c->pending_count == 0 || id == 0)
+    return false;
+  size_t mask = c->pending_cap - 1;
+  size_t slot = pending_slot(c, id);
+  while (c->pending[slot].id != id) {
+    if (c->pending[slot].id == 0)
+      return false;
+    slot = (slot + 1) & mask;
+  }
+  *out = c->pending[slot];
+
+  /* Backward-shift deletion: pull later entries of the run into the hole
+   * unless that would move them in front of their home slot */
+  size_t hole = slot;
+  for (size_t next = (hole + 1) & mask; c->pending[next].id != 0;
+       next = (next + 1) & mask) {
+    size_t home = pending_slot(c, c->pending[next].id);
+    if (((next - home) & mask) >= ((next - hole) & mask)) {
+      c->pending[hole] = c->pending[next];
+      hole = next;
+    }
+  }
+  c->pending[hole].id = 0;
+  c->pending_count--;
+  return true;
+}
+
+/*--- output ---*/
+
+/**
+ * @brief Serialize a request or batch, frame it and pass it to the transport
+ */
+static int client_send(mjrpc_client_t *c, cJSON *message) {
+  /* Room for the header in front and the trailer behind the body */
+  const size_t reserved = MJRPC_FRAME_HEADER_MAX + 1;
+  for (;;) {
+    if (c->out_cap > reserved &&
+        cJSON_PrintPreallocated(message, c->out + MJRPC_FRAME_HEADER_MAX,
+                                (int)(c->out_cap - reserved), false))
+      break;
+    size_t cap = c->out_cap ? c->out_cap * 2 : CLIENT_OUTPUT_INITIAL;
+    char *grown = cap <= (size_t)INT32_MAX ? malloc(cap) : NULL;
+    if (grown == NULL)
+      return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+    free(c->out);
+    c->out = grown;
+    c->out_cap = cap;
+  }
+
+  char *body = c->out + MJRPC_FRAME_HEADER_MAX;
+  size_t body_len = strlen(body);
+  char header[MJRPC_FRAME_HEADER_MAX];
+  size_t header_len;
+  int ret =
+      mjrpc_frame_header(c->config.framing, body_len, header, &header_len);
+  if (ret != MJRPC_RET_OK)
+    return ret;
+  size_t trailer_len;
+  const char *trailer = mjrpc_frame_trailer(c->config.framing, &trailer_len);
+  memcpy(body - header_len, header, header_len);
+  memcpy(body + body_len, trailer, trailer_len);
+
+  if (c->config.send(body - header_len, header_len + body_len + trailer_len,
+                     c->config.send_data) != 0)
+    return MJRPC_RET_ERROR_SYSTEM;
+  return MJRPC_RET_OK;
+}
+
+/*--- batching ---*/
+
+static int64_t client_now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static bool client_batching(const mjrpc_client_t *c) {
+  return c->config.batch_max_calls > 1;
+}
+
+static int client_enqueue(mjrpc_client_t *c, cJSON *request) {
+  if (c->batch == NULL) {
+    c->batch = cJSON_CreateArray();
+    if (c->batch == NULL)
+      return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+    c->batch_count = 0;
+    c->batch_deadline = client_now_us() + c->config.batch_window_us;
+  }
+  cJSON_AddItemToArray(c->batch, request);
+  c->batch_count++;
+  return MJRPC_RET_OK;
+}
+
+static bool client_batch_due(const mjrpc_client_t *c) {
+  return c->batch_count >= c->config.batch_max_calls ||
+         (c->config.batch_window_us > 0 &&
+          client_now_us() >= c->batch_deadline);
+}
+
+/**
+ * @brief Send the queued batch
+ *
+ * If that fails, every call in it is completed with the error, except
+ * @p quiet_id whose failure the caller reports itself.
+ */
+static int client_flush(mjrpc_client_t *c, int64_t quiet_id) {
+  cJSON *batch = c->batch;
+  if (batch == NULL)
+    return MJRPC_RET_OK;
+  /* Detached first: callbacks run below may queue new calls */
+  c->batch = NULL;
+  c->batch_count = 0;
+
+  cJSON *message = batch->child;
+  if (message != NULL && message->next != NULL)
+    message = batch;
+  int ret = client_send(c, message);
+  if (ret != MJRPC_RET_OK) {
+    const cJSON *request;
+    cJSON_ArrayForEach(request, batch) {
+      const cJSON *id = cJSON_GetObjectItem(request, "id");
+      struct pending_call call;
+      if (!cJSON_IsNumber(id) ||
+          !pending_take(c, (int64_t)id->valuedouble, &call))
+        continue;
+      if (call.callback && call.id != quiet_id)
+        call.callback(ret, NULL, NULL, call.user_data);
+    }
+  }
+  cJSON_Delete(batch);
+  return ret;
+}
+
+/**
+ * @brief Send a request now or queue it, depending on the configuration
+ *
+ * Takes ownership of @p request.
+ */
+static int client_submit(mjrpc_client_t *c, cJSON *request, int64_t id) {
+  if (!client_batching(c)) {
+    int ret = client_send(c, request);
+    cJSON_Delete(request);
+    return ret;
+  }
+  int ret = client_enqueue(c, request);
+  if (ret != MJRPC_RET_OK) {
+    cJSON_Delete(request);
+    return ret;
+  }
+  return client_batch_due(c) ? client_flush(c, id) : MJRPC_RET_OK;
+}
+
+/*--- input ---*/
+
+/**
+ * @brief Complete the call a single response belongs to
+ */
+static int client_dispatch(mjrpc_client_t *c, cJSON *response) {
+  if (!cJSON_IsObject(response))
+    return MJRPC_RET_ERROR_PARSE_FAILED;
+  cJSON *id = cJSON_GetObjectItem(response, "id");
+  cJSON *result = cJSON_GetObjectItem(response, "result");
+  cJSON *error = cJSON_GetObjectItem(response, "error");
+  if (id == NULL || (result == NULL) == (error == NULL))
+    return MJRPC_RET_ERROR_PARSE_FAILED;
+
+  /* Ids we issue are positive integers; anything else is not ours */
+  double value = cJSON_IsNumber(id) ? id->valuedouble : 0;
+  if (!(value >= 1 && value <= 9007199254740992.0) ||
+      (double)(int64_t)value != value)
+    return MJRPC_RET_ERROR_NOT_FOUND;
+  struct pending_call call;
+  if (!pending_take(c, (int64_t)value, &call))
+    return MJRPC_RET_ERROR_NOT_FOUND;
+  if (call.callback)
+    call.callback(MJRPC_RET_OK, result, error, call.user_data);
+  return MJRPC_RET_OK;
+}
+
+static int client_process(mjrpc_client_t *c, const char *message, size_t len) {
+  cJSON *json = cJSON_ParseWithLength(message, len);
+  if (json == NULL)
+    return MJRPC_RET_ERROR_PARSE_FAILED;
+
+  int ret = MJRPC_RET_OK;
+  if (cJSON_IsArray(json)) {
+    cJSON *item;
+    cJSON_ArrayForEach(item, json) {
+      int item_ret = client_dispatch(c, item);
+      if (ret == MJRPC_RET_OK)
+        ret = item_ret;
+    }
+  } else {
+    ret = client_dispatch(c, json);
+  }
+  cJSON_Delete(json);
+  return ret;
+}
+
+/*--- public API ---*/
+
+void mjrpc_client_config_init(mjrpc_client_config_t *config) {
+  if (config == NULL)
+    return;
+  memset(config, 0, sizeof(*config));
+  config->framing = MJRPC_FRAMING_NDJSON;
+  config->max_message_size = 16 * 1024 * 1024;
+}
+
+mjrpc_client_t *mjrpc_client_create(const mjrpc_client_config_t *config) {
+  if (config == NULL || config->send == NULL)
+    return NULL;
+  mjrpc_client_t *c = calloc(1, sizeof(*c));
+  if (c == NULL)
+    return NULL;
+  c->config = *config;
+  c->next_id = 1;
+  c->framer = mjrpc_framer_create(config->framing, config->max_message_size);
+  if (c->framer == NULL || !pending_grow(c)) {
+    mjrpc_framer_destroy(c->framer);
+    free(c);
+    return NULL;
+  }
+  return c;
+}
+
+void mjrpc_client_destroy(mjrpc_client_t *client) {
+  if (client == NULL)
+    return;
+  cJSON_Delete(client->batch);
+  for (size_t i = 0; i < client->pending_cap; i++) {
+    struct pending_call *call = &client->pending[i];
+    if (call->id != 0 && call->callback)
+      call->callback(MJRPC_RET_ERROR_CANCELLED, NULL, NULL, call->user_data);
+  }
+  mjrpc_framer_destroy(client->framer);
+  free(client->pending);
+  free(client->out);
+  free(client);
+}
+
+int mjrpc_client_call(mjrpc_client_t *client, const char *method,
+                      cJSON *params, mjrpc_client_callback callback,
+                      void *user_data, int64_t *id) {
+  if (client == NULL || method == NULL) {
+    cJSON_Delete(params);
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  }
+
+  int64_t call_id = client->next_id++;
+  cJSON *request =
+      mjrpc_request_cjson(method, params, cJSON_CreateNumber((double)call_id));
+  if (request == NULL)
+    return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+  /* Registered first: the transport may deliver the response from inside
+   * the send function */
+  if (!pending_insert(client, call_id, callback, user_data)) {
+    cJSON_Delete(request);
+    return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+  }
+
+  int ret = client_submit(client, request, call_id);
+  if (ret != MJRPC_RET_OK) {
+    /* Already gone if a failed batch took it along */
+    struct pending_call call;
+    pending_take(client, call_id, &call);
+    return ret;
+  }
+  if (id)
+    *id = call_id;
+  return MJRPC_RET_OK;
+}
+
+int mjrpc_client_notify(mjrpc_client_t *client, const char *method,
+                        cJSON *params) {
+  if (client == NULL || method == NULL) {
+    cJSON_Delete(params);
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  }
+  cJSON *request = mjrpc_request_cjson(method, params, NULL);
+  if (request == NULL)
+    return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+  return client_submit(client, request, 0);
+}
+
+int mjrpc_client_cancel(mjrpc_client_t *client, int64_t id) {
+  if (client == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  struct pending_call call;
+  if (!pending_take(client, id, &call))
+    return MJRPC_RET_ERROR_NOT_FOUND;
+  if (call.callback)
+    call.callback(MJRPC_RET_ERROR_CANCELLED, NULL, NULL, call.user_data);
+  return MJRPC_RET_OK;
+}
+
+int mjrpc_client_flush(mjrpc_client_t *client) {
+  if (client == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  return client_flush(client, 0);
+}
+
+int64_t mjrpc_client_timeout_us(const mjrpc_client_t *client) {
+  if (client == NULL || client->batch == NULL ||
+      client->config.batch_window_us == 0)
+    return -1;
+  int64_t left = client->batch_deadline - client_now_us();
+  return left > 0 ? left : 0;
+}
+
+int mjrpc_client_tick(mjrpc_client_t *client) {
+  if (client == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  if (client->batch != NULL && client_batch_due(client))
+    return client_flush(client, 0);
+  return MJRPC_RET_OK;
+}
+
+int mjrpc_client_feed(mjrpc_client_t *client, const char *data, size_t len) {
+  if (client == NULL || (data == NULL && len > 0))
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  int ret = mjrpc_framer_feed(client->framer, data, len);
+  if (ret != MJRPC_RET_OK)
+    return ret;
+
+  const char *message;
+  size_t message_len;
+  while (mjrpc_framer_next(client->framer, &message, &message_len)) {
+    int message_ret = client_process(client, message, message_len);
+    if (ret == MJRPC_RET_OK)
+      ret = message_ret;
+  }
+  int framer_ret = mjrpc_framer_error(client->framer);
+  if (ret == MJRPC_RET_OK && framer_ret != MJRPC_RET_OK)
+    ret = framer_ret == MJRPC_RET_ERROR_TOO_LARGE ? framer_ret
+                                                  : MJRPC_RET_ERROR_PARSE_FAILED;
+  return ret;
+}
+
+size_t mjrpc_client_pending(const mjrpc_client_t *client) {
+  return client ? client->pending_count : 0;
+}
@@ -0,0 +1,264 @@
+/**
+ * @file mjsonrpc_client.h
+ * @brief JSON-RPC client with response correlation for pipelined calls
+ * @author Xiao
+ * @date 2026
+ * @version 3.0.0
+ *
+ * @details
+ * A client assigns every call a fresh integer id, remembers its completion
+ * callback in a pending table and hands the framed request to a
+ * user-supplied send function. Bytes received from the transport are passed
+ * to mjrpc_client_feed(), which splits them into messages (see
+ * mjsonrpc_framer.h), parses responses and batch arrays, and fires the
+ * callback of each matching call. Any number of calls may be outstanding on
+ * one connection.
+ *
+ * Optionally, calls and notifications issued close together are coalesced
+ * into one batch array (see mjrpc_client_config_t::batch_max_calls); the
+ * responses are matched to their callers by id as usual. A client has no
+ * timer of its own: call mjrpc_client_tick() when mjrpc_client_timeout_us()
+ * elapses, or mjrpc_client_flush() before waiting for responses.
+ *
+ * A client is not thread-safe; drive it from one thread at a time.
+ *
+ * @par Example:
+ * @code
+ * static int send_fn(const char *data, size_t len, void *user_data) {
+ *     return write(*(int *)user_data, data, len) == (ssize_t)len ? 0 : -1;
+ * }
+ *
+ * static void on_sum(int status, cJSON *result, cJSON *error, void *arg) {
+ *     if (status == MJRPC_RET_OK && result)
+ *         printf("sum = %g\n", result->valuedouble);
+ * }
+ *
+ * mjrpc_client_config_t config;
+ * mjrpc_client_config_init(&config);
+ * config.send = send_fn;
+ * config.send_data = &fd;
+ * mjrpc_client_t *client = mjrpc_client_create(&config);
+ *
+ * mjrpc_client_call(client, "sum", params, on_sum, NULL, NULL);
+ * ...
+ * ssize_t n = read(fd, buf, sizeof(buf));
+ * mjrpc_client_feed(client, buf, (size_t)n); // fires on_sum
+ * @endcode
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2026 Xiao
+ */
+
+#ifndef MJSONRPC_CLIENT_H_
+#define MJSONRPC_CLIENT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mjsonrpc.h"
+#include "mjsonrpc_framer.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Opaque client instance
+ */
+typedef struct mjrpc_client mjrpc_client_t;
+
+/**
+ * @brief Transport write function
+ *
+ * @param data Framed message (or several)
+ * @param len Number of bytes
+ * @param user_data mjrpc_client_config_t::send_data
+ * @return 0 on success, non-zero if the bytes could not be sent
+ */
+typedef int (*mjrpc_client_send_func)(const char *data, size_t len,
+                                      void *user_data);
+
+/**
+ * @brief Completion callback of a call
+ *
+ * @param status MJRPC_RET_OK when a response arrived (then exactly one of
+ *               @p result and @p error is set), MJRPC_RET_ERROR_CANCELLED if
+ *               the call was cancelled or the client destroyed, or the
+ *               error of mjrpc_client_flush() if the batch holding the call
+ *               could not be sent
+ * @param result "result" member of the response, owned by the client and
+ *               valid during the callback only
+ * @param error "error" member of the response, same lifetime as @p result
+ * @param user_data Pointer given to mjrpc_client_call()
+ */
+typedef void (*mjrpc_client_callback)(int status, cJSON *result, cJSON *error,
+                                      void *user_data);
+
+/**
+ * @struct mjrpc_client_config_t
+ * @brief Client settings, initialize with mjrpc_client_config_init()
+ */
+typedef struct {
+  /** @brief Writes framed requests to the transport (required) */
+  mjrpc_client_send_func send;
+  /** @brief Passed to @ref send */
+  void *send_data;
+  /** @brief Framing of requests and responses on the transport */
+  enum mjrpc_framing framing;
+  /** @brief Longer incoming messages break the stream */
+  size_t max_message_size;
+  /** @brief Queue up to this many calls and send them as one batch;
+   *         0 or 1 sends every call at once */
+  size_t batch_max_calls;
+  /** @brief Send a batch at the latest this many microseconds after its
+   *         first call was queued (0: only when full or flushed) */
+  uint32_t batch_window_us;
+} mjrpc_client_config_t;
+
+/**
+ * @brief Fill a configuration with defaults
+ *
+ * Defaults: no send function, newline-delimited framing, a 16 MiB
+ * maximum message size and no batching.
+ *
+ * @param config Configuration to initialize
+ */
+void mjrpc_client_config_init(mjrpc_client_config_t *config);
+
+/**
+ * @brief Create a client
+ *
+ * @param config Client settings (copied)
+ * @return New client, or NULL if @p config has no send function or memory
+ *         ran out
+ */
+mjrpc_client_t *mjrpc_client_create(const mjrpc_client_config_t *config);
+
+/**
+ * @brief Destroy a client
+ *
+ * Callbacks of calls still pending run with MJRPC_RET_ERROR_CANCELLED.
+ * Queued calls are not sent.
+ *
+ * @param client Client instance (may be NULL)
+ */
+void mjrpc_client_destroy(mjrpc_client_t *client);
+
+/**
+ * @brief Send a call and register its completion callback
+ *
+ * With batching enabled the request is queued; it goes out when the batch is
+ * full, when its window has passed at the next call or mjrpc_client_tick(),
+ * or on mjrpc_client_flush().
+ *
+ * @param client Client instance
+ * @param method Method name
+ * @param params Parameters (ownership is taken, may be NULL)
+ * @param callback Completion callback (may be NULL to ignore the response)
+ * @param user_data Passed to @p callback
+ * @param id Receives the id of the call (may be NULL)
+ * @return Return code
+ * @retval MJRPC_RET_OK On success
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If @p client or @p method is NULL
+ * @retval MJRPC_RET_ERROR_MEM_ALLOC_FAILED If memory ran out
+ * @retval MJRPC_RET_ERROR_SYSTEM If the send function failed; the call is
+ *         forgotten and its callback never runs (other calls of the same
+ *         batch complete with the same code)
+ */
+int mjrpc_client_call(mjrpc_client_t *client, const char *method,
+                      cJSON *params, mjrpc_client_callback callback,
+                      void *user_data, int64_t *id);
+
+/**
+ * @brief Send a notification (no response expected)
+ *
+ * @param client Client instance
+ * @param method Method name
+ * @param params Parameters (ownership is taken, may be NULL)
+ * @return Return code, as for mjrpc_client_call()
+ */
+int mjrpc_client_notify(mjrpc_client_t *client, const char *method,
+                        cJSON *params);
+
+/**
+ * @brief Forget a pending call
+ *
+ * Its callback runs immediately with MJRPC_RET_ERROR_CANCELLED; a response
+ * arriving later is ignored. A call that is still queued is sent anyway.
+ *
+ * @param client Client instance
+ * @param id Id returned by mjrpc_client_call()
+ * @return Return code
+ * @retval MJRPC_RET_OK On success
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If @p client is NULL
+ * @retval MJRPC_RET_ERROR_NOT_FOUND If no such call is pending
+ */
+int mjrpc_client_cancel(mjrpc_client_t *client, int64_t id);
+
+/**
+ * @brief Send the queued batch now
+ *
+ * A batch of one call is sent as a plain request.
+ *
+ * @param client Client instance
+ * @return Return code
+ * @retval MJRPC_RET_OK On success or if nothing was queued
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If @p client is NULL
+ * @retval MJRPC_RET_ERROR_MEM_ALLOC_FAILED If memory ran out
+ * @retval MJRPC_RET_ERROR_SYSTEM If the send function failed
+ *
+ * On failure the queued calls complete with the returned code.
+ */
+int mjrpc_client_flush(mjrpc_client_t *client);
+
+/**
+ * @brief Time left until the queued batch is due
+ *
+ * @param client Client instance
+ * @return Microseconds until mjrpc_client_tick() sends the batch (0 if it is
+ *         due), or -1 if nothing is queued or the batch has no window
+ */
+int64_t mjrpc_client_timeout_us(const mjrpc_client_t *client);
+
+/**
+ * @brief Send the queued batch if its window has passed
+ *
+ * @param client Client instance
+ * @return Return code, as for mjrpc_client_flush()
+ */
+int mjrpc_client_tick(mjrpc_client_t *client);
+
+/**
+ * @brief Process bytes received from the transport
+ *
+ * Completes the calls whose responses are contained in the bytes; a message
+ * cut short is kept until the rest arrives. Callbacks may issue new calls.
+ *
+ * @param client Client instance
+ * @param data Received bytes
+ * @param len Number of bytes
+ * @return Return code (the first problem; later messages are still
+ *         processed)
+ * @retval MJRPC_RET_OK On success
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If an argument is NULL
+ * @retval MJRPC_RET_ERROR_PARSE_FAILED If a message is not a valid response
+ *         or the framing is broken
+ * @retval MJRPC_RET_ERROR_NOT_FOUND If a response matched no pending call
+ * @retval MJRPC_RET_ERROR_TOO_LARGE If a message exceeds the size limit
+ */
+int mjrpc_client_feed(mjrpc_client_t *client, const char *data, size_t len);
+
+/**
+ * @brief Number of calls waiting for a response
+ *
+ * @param client Client instance
+ * @return Pending call count
+ */
+size_t mjrpc_client_pending(const mjrpc_client_t *client);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MJSONRPC_CLIENT_H_
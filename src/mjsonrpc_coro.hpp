@@ -0,0 +1,250 @@
+/**
+ * @file mjsonrpc_coro.hpp
+ * @brief C++20 coroutine adapter for asynchronous mjsonrpc handlers
+ * @author Xiao
+ * @date 2026
+ * @version 3.0.0
+ *
+ * @details
+ * Lets a handler be written as a coroutine returning mjrpc::task<T>. The
+ * handler runs until its first suspension inside the dispatch call; whoever
+ * resumes it (typically an event loop completing I/O) drives it further, and
+ * the response is delivered through mjrpc_complete()/mjrpc_fail() when the
+ * coroutine finishes. Built on mjrpc_add_async_method() and
+ * mjrpc_process_async().
+ *
+ * @par Example:
+ * @code
+ * mjrpc::add_coroutine(h, "fetch", [&](mjrpc::json params)
+ *                                      -> mjrpc::task<mjrpc::json> {
+ *     std::string body = co_await loop.http_get(url_from(params));
+ *     co_return mjrpc::json(cJSON_CreateString(body.c_str()));
+ * });
+ * mjrpc::process_async(h, request, [](mjrpc::json response) {
+ *     send(response.dump());
+ * });
+ * @endcode
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2026 Xiao
+ */
+
+#ifndef MJSONRPC_CORO_HPP_
+#define MJSONRPC_CORO_HPP_
+
+#include "mjsonrpc.hpp"
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace mjrpc {
+
+namespace detail {
+
+/* Where a task keeps its result; task<void> has none */
+template <typename T> struct task_result {
+  std::optional<T> value;
+
+  template <typename U> void return_value(U &&v) {
+    value.emplace(std::forward<U>(v));
+  }
+  T take() { return std::move(*value); }
+};
+
+template <> struct task_result<void> {
+  void return_void() noexcept {}
+  void take() noexcept {}
+};
+
+} // namespace detail
+
+/**
+ * @class task
+ * @brief Lazily started coroutine producing a value of type T
+ *
+ * A task starts when it is awaited and resumes its awaiter on completion, so
+ * handlers can co_await other tasks as well as user-provided awaitables.
+ * T may be void, in which case a handler's result is null.
+ */
+template <typename T> class task {
+public:
+  struct promise_type : detail::task_result<T> {
+    std::exception_ptr error;
+    std::coroutine_handle<> continuation;
+
+    task get_return_object() {
+      return task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct final_awaiter {
+      bool await_ready() noexcept { return false; }
+      std::coroutine_handle<>
+      await_suspend(std::coroutine_handle<promise_type> self) noexcept {
+        std::coroutine_handle<> next = self.promise().continuation;
+        return next ? next : std::noop_coroutine();
+      }
+      void await_resume() noexcept {}
+    };
+    final_awaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { error = std::current_exception(); }
+  };
+
+  task(task &&other) noexcept : coro_(std::exchange(other.coro_, {})) {}
+  task &operator=(task &&other) noexcept {
+    if (this != &other) {
+      if (coro_)
+        coro_.destroy();
+      coro_ = std::exchange(other.coro_, {});
+    }
+    return *this;
+  }
+  task(const task &) = delete;
+  task &operator=(const task &) = delete;
+  ~task() {
+    if (coro_)
+      coro_.destroy();
+  }
+
+  bool await_ready() const noexcept { return !coro_ || coro_.done(); }
+  std::coroutine_handle<>
+  await_suspend(std::coroutine_handle<> awaiter) noexcept {
+    coro_.promise().continuation = awaiter;
+    return coro_;
+  }
+  T await_resume() {
+    promise_type &p = coro_.promise();
+    if (p.error)
+      std::rethrow_exception(p.error);
+    return p.take();
+  }
+
+private:
+  explicit task(std::coroutine_handle<promise_type> coro) : coro_(coro) {}
+  std::coroutine_handle<promise_type> coro_;
+};
+
+namespace detail {
+
+/* Fire-and-forget driver that owns a task until it delivers its result */
+struct detached {
+  struct promise_type {
+    detached get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+template <typename T>
+detached drive(task<T> work, mjrpc_async_token_t *token) {
+  int32_t code = 0;
+  std::string message;
+  try {
+    if constexpr (std::is_void_v<T>) {
+      co_await std::move(work);
+      mjrpc_complete(token, cJSON_CreateNull());
+    } else {
+      T result = co_await std::move(work);
+      mjrpc_complete(token, codec<T>::encode(std::move(result)));
+    }
+    co_return;
+  } catch (const error &e) {
+    code = e.code();
+    message = e.what();
+  } catch (const std::exception &e) {
+    code = JSON_RPC_CODE_INTERNAL_ERROR;
+    message = e.what();
+  } catch (...) {
+    code = JSON_RPC_CODE_INTERNAL_ERROR;
+    message = "Unknown exception.";
+  }
+  mjrpc_fail(token, code, message.c_str());
+}
+
+template <typename F> class coro_binding final : public binding_base {
+public:
+  explicit coro_binding(F fn) : fn_(std::move(fn)) {}
+
+  static void trampoline(mjrpc_func_ctx_t *ctx, cJSON *params, cJSON *id,
+                         mjrpc_async_token_t *token) {
+    (void)id;
+    auto *self = static_cast<coro_binding *>(
+        *static_cast<binding_base **>(ctx->data));
+    try {
+      /* params die with the request, the coroutine gets its own copy */
+      json owned(params ? cJSON_Duplicate(params, true) : nullptr);
+      drive(self->fn_(std::move(owned)), token);
+    } catch (const std::exception &e) {
+      mjrpc_fail(token, JSON_RPC_CODE_INTERNAL_ERROR, e.what());
+    } catch (...) {
+      mjrpc_fail(token, JSON_RPC_CODE_INTERNAL_ERROR, "Unknown exception.");
+    }
+  }
+
+private:
+  F fn_;
+};
+
+} // namespace detail
+
+/**
+ * @brief Register a coroutine handler
+ *
+ * @param h Handle that owns the handler
+ * @param method_name Name of the method
+ * @param fn Callable taking mjrpc::json params (empty if the request had none)
+ *           and returning mjrpc::task<T>, where T is void or has an
+ *           mjrpc::codec
+ *
+ * @note The callable is owned by @p h, so lambda captures stay valid while
+ *       coroutines started from it are running.
+ */
+template <typename F>
+void add_coroutine(handle &h, const char *method_name, F &&fn) {
+  using binding_t = detail::coro_binding<std::decay_t<F>>;
+  h.bind(method_name, std::make_unique<binding_t>(std::forward<F>(fn)),
+         [](mjrpc_handle_t *raw, const char *name, void *arg) {
+           return mjrpc_add_async_method(raw, &binding_t::trampoline, name,
+                                         arg);
+         });
+}
+
+/**
+ * @brief Process a request whose methods may be coroutines
+ *
+ * @param h Handle containing registered methods
+ * @param request Parsed request (only needs to stay valid during the call)
+ * @param on_response Called exactly once with the response (empty for
+ *                    notifications), possibly after this function returns
+ *                    and on another thread; must not throw
+ * @return Same codes as mjrpc_process_async()
+ */
+inline int process_async(const handle &h, const json &request,
+                         std::function<void(json)> on_response) {
+  auto *callback = new std::function<void(json)>(std::move(on_response));
+  int ret = mjrpc_process_async(
+      h.get(), request.get(),
+      [](cJSON *response, void *user_data) {
+        std::unique_ptr<std::function<void(json)>> cb(
+            static_cast<std::function<void(json)> *>(user_data));
+        (*cb)(json(response));
+      },
+      callback);
+  if (ret == MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED ||
+      ret == MJRPC_RET_ERROR_INVALID_PARAM)
+    delete callback; /* not invoked on these errors */
+  return ret;
+}
+
+} // namespace mjrpc
+
+#endif // MJSONRPC_CORO_HPP_
@@ -0,0 +1,447 @@
+/*
+    MIT License
+
+    Copyright (c) 2026 Xiao
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+ */
+
+#include "mjsonrpc_framer.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/** @brief Initial size of the framer buffer */
+#define FRAMER_INITIAL_CAPACITY 4096
+
+/** @brief Longest accepted Content-Length header block */
+#define FRAMER_HEADER_LIMIT 1024
+
+/** @brief Size of the length prefix */
+#define FRAMER_PREFIX_SIZE 4
+
+/*
+ * The unconsumed stream is buf[start, end) followed by ext[ext_pos, ext_len).
+ * Everything else describes the frame at the head of that stream, so it
+ * survives moving the head from the attached chunk into buf.
+ */
+struct mjrpc_framer {
+  enum mjrpc_framing framing;
+  size_t max;
+
+  char *buf;
+  size_t start, end, cap;
+
+  const char *ext;
+  size_t ext_pos, ext_len;
+
+  /* Bytes of the head frame known not to hold its delimiter */
+  size_t scanned;
+  /* Framing bytes before the body, 0 while unknown */
+  size_t header_len;
+  size_t body_len;
+
+  int error;
+};
+
+enum frame_status { FRAME_FOUND, FRAME_PARTIAL, FRAME_BROKEN };
+
+/*--- frame detection ---*/
+
+static void frame_reset(mjrpc_framer_t *f) {
+  f->scanned = 0;
+  f->header_len = 0;
+  f->body_len = 0;
+}
+
+static enum frame_status frame_fail(mjrpc_framer_t *f, int error) {
+  f->error = error;
+  return FRAME_BROKEN;
+}
+
+/**
+ * @brief Find the CRLF ending a header line, or @p end for the last line
+ *
+ * A lone CR is part of the line.
+ */
+static const char *line_end(const char *line, const char *end) {
+  const char *p = line;
+  while ((p = memchr(p, '\r', (size_t)(end - p))) != NULL) {
+    if (end - p >= 2 && p[1] == '\n')
+      return p;
+    p++;
+  }
+  return end;
+}
+
+/**
+ * @brief Parse a Content-Length header block
+ * @param block Header lines separated by CRLF, without the empty line
+ * @return false if no valid Content-Length header was found
+ */
+static bool parse_content_length(const char *block, size_t len, size_t *out) {
+  static const char name[] = "content-length:";
+  const char *line = block;
+  const char *end = block + len;
+  while (line < end) {
+    const char *eol = line_end(line, end);
+    size_t n = sizeof(name) - 1;
+    if ((size_t)(eol - line) > n) {
+      size_t i = 0;
+      while (i < n && (line[i] | 0x20) == name[i])
+        i++;
+      if (i == n) {
+        const char *p = line + n;
+        while (p < eol && (*p == ' ' || *p == '\t'))
+          p++;
+        if (p == eol)
+          return false;
+        size_t value = 0;
+        for (; p < eol && *p >= '0' && *p <= '9'; p++) {
+          if (value > (SIZE_MAX - 9) / 10)
+            return false;
+          value = value * 10 + (size_t)(*p - '0');
+        }
+        while (p < eol && (*p == ' ' || *p == '\t'))
+          p++;
+        if (p != eol)
+          return false;
+        *out = value;
+        return true;
+      }
+    }
+    if (eol == end)
+      break;
+    line = eol + 2;
+  }
+  return false;
+}
+
+/**
+ * @brief Look for the end of the head frame
+ *
+ * @param data Head of the stream
+ * @param len Bytes available at @p data
+ * @param body Receives the offset of the message within the frame
+ * @param body_len Receives the message length
+ * @param frame_len Receives the full frame length
+ * @param want Receives the full frame length if it is known before the frame
+ *             is complete, else 0
+ */
+static enum frame_status frame_scan(mjrpc_framer_t *f, const char *data,
+                                    size_t len, size_t *body, size_t *body_len,
+                                    size_t *frame_len, size_t *want) {
+  *want = 0;
+  switch (f->framing) {
+  case MJRPC_FRAMING_NDJSON: {
+    const char *nl = memchr(data + f->scanned, '\n', len - f->scanned);
+    if (nl == NULL) {
+      f->scanned = len;
+      return len > f->max ? frame_fail(f, MJRPC_RET_ERROR_TOO_LARGE)
+                          : FRAME_PARTIAL;
+    }
+    size_t n = (size_t)(nl - data);
+    *frame_len = n + 1;
+    if (n > 0 && data[n - 1] == '\r')
+      n--;
+    if (n > f->max)
+      return frame_fail(f, MJRPC_RET_ERROR_TOO_LARGE);
+    *body = 0;
+    *body_len = n;
+    return FRAME_FOUND;
+  }
+
+  case MJRPC_FRAMING_CONTENT_LENGTH:
+    if (f->header_len == 0) {
+      /* Resume three bytes back, the terminator may straddle reads */
+      size_t from = f->scanned > 3 ? f->scanned - 3 : 0;
+      const char *p = data + from;
+      const char *end = data + len;
+      const char *nl;
+      while ((nl = memchr(p, '\n', (size_t)(end - p))) != NULL) {
+        if (nl - data >= 3 && nl[-1] == '\r' && nl[-2] == '\n' &&
+            nl[-3] == '\r')
+          break;
+        p = nl + 1;
+      }
+      if (nl == NULL) {
+        f->scanned = len;
+        return len > FRAMER_HEADER_LIMIT
+                   ? frame_fail(f, MJRPC_RET_ERROR_TOO_LARGE)
+                   : FRAME_PARTIAL;
+      }
+      size_t header_len = (size_t)(nl - data) + 1;
+      if (header_len > FRAMER_HEADER_LIMIT)
+        return frame_fail(f, MJRPC_RET_ERROR_TOO_LARGE);
+      if (!parse_content_length(data, header_len - 4, &f->body_len))
+        return frame_fail(f, MJRPC_RET_ERROR_PARSE_FAILED);
+      if (f->body_len > f->max)
+        return frame_fail(f, MJRPC_RET_ERROR_TOO_LARGE);
+      f->header_len = header_len;
+    }
+    break;
+
+  case MJRPC_FRAMING_LENGTH_PREFIX:
+    if (f->header_len == 0) {
+      if (len < FRAMER_PREFIX_SIZE) {
+        *want = FRAMER_PREFIX_SIZE;
+        return FRAME_PARTIAL;
+      }
+      const unsigned char *p = (const unsigned char *)data;
+      f->body_len = (size_t)p[0] << 24 | (size_t)p[1] << 16 |
+                    (size_t)p[2] << 8 | (size_t)p[3];
+      if (f->body_len > f->max)
+        return frame_fail(f, MJRPC_RET_ERROR_TOO_LARGE);
+      f->header_len = FRAMER_PREFIX_SIZE;
+    }
+    break;
+  }
+
+  size_t total = f->header_len + f->body_len;
+  if (len < total) {
+    *want = total;
+    return FRAME_PARTIAL;
+  }
+  *body = f->header_len;
+  *body_len = f->body_len;
+  *frame_len = total;
+  return FRAME_FOUND;
+}
+
+/**
+ * @brief Check whether a line holds only whitespace (keep-alives)
+ */
+static bool is_blank(const char *message, size_t len) {
+  for (size_t i = 0; i < len; i++)
+    if (message[i] != ' ' && message[i] != '\t' && message[i] != '\r')
+      return false;
+  return true;
+}
+
+/*--- buffer management ---*/
+
+static char *buffer_reserve(mjrpc_framer_t *f, size_t min) {
+  if (f->start == f->end)
+    f->start = f->end = 0;
+  if (f->cap - f->end >= min)
+    return f->buf + f->end;
+
+  size_t used = f->end - f->start;
+  if (f->cap - used >= min) {
+    memmove(f->buf, f->buf + f->start, used);
+  } else {
+    size_t cap = f->cap ? f->cap * 2 : FRAMER_INITIAL_CAPACITY;
+    while (cap < used + min)
+      cap *= 2;
+    char *grown = mjrpc_malloc(cap);
+    if (grown == NULL) {
+      f->error = MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+      return NULL;
+    }
+    if (used > 0)
+      memcpy(grown, f->buf + f->start, used);
+    mjrpc_free(f->buf);
+    f->buf = grown;
+    f->cap = cap;
+  }
+  f->start = 0;
+  f->end = used;
+  return f->buf + f->end;
+}
+
+static bool buffer_append(mjrpc_framer_t *f, const char *data, size_t len) {
+  char *space = buffer_reserve(f, len);
+  if (space == NULL)
+    return false;
+  memcpy(space, data, len);
+  f->end += len;
+  return true;
+}
+
+/**
+ * @brief Move the rest of the attached chunk into the buffer
+ */
+static bool save_chunk(mjrpc_framer_t *f) {
+  size_t rest = f->ext_len - f->ext_pos;
+  bool ok = rest == 0 || buffer_append(f, f->ext + f->ext_pos, rest);
+  f->ext = NULL;
+  f->ext_pos = f->ext_len = 0;
+  return ok;
+}
+
+/*--- public API ---*/
+
+mjrpc_framer_t *mjrpc_framer_create(enum mjrpc_framing framing,
+                                    size_t max_message_size) {
+  if (framing > MJRPC_FRAMING_LENGTH_PREFIX)
+    return NULL;
+  mjrpc_framer_t *f = mjrpc_malloc(sizeof(*f));
+  if (f == NULL)
+    return NULL;
+  memset(f, 0, sizeof(*f));
+  f->framing = framing;
+  f->max = max_message_size;
+  f->error = MJRPC_RET_OK;
+  return f;
+}
+
+void mjrpc_framer_destroy(mjrpc_framer_t *framer) {
+  if (framer == NULL)
+    return;
+  mjrpc_free(framer->buf);
+  mjrpc_free(framer);
+}
+
+char *mjrpc_framer_reserve(mjrpc_framer_t *framer, size_t min, size_t *avail) {
+  if (framer == NULL || avail == NULL)
+    return NULL;
+  if (!save_chunk(framer))
+    return NULL;
+  char *space = buffer_reserve(framer, min > 0 ? min : 1);
+  if (space == NULL)
+    return NULL;
+  *avail = framer->cap - framer->end;
+  return space;
+}
+
+void mjrpc_framer_commit(mjrpc_framer_t *framer, size_t len) {
+  if (framer != NULL && len <= framer->cap - framer->end)
+    framer->end += len;
+}
+
+int mjrpc_framer_feed(mjrpc_framer_t *framer, const char *data, size_t len) {
+  if (framer == NULL || (data == NULL && len > 0))
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  if (!save_chunk(framer))
+    return MJRPC_RET_ERROR_MEM_ALLOC_FAILED;
+  framer->ext = data;
+  framer->ext_len = len;
+  return MJRPC_RET_OK;
+}
+
+bool mjrpc_framer_next(mjrpc_framer_t *framer, const char **message,
+                       size_t *len) {
+  if (framer == NULL || message == NULL || len == NULL)
+    return false;
+  mjrpc_framer_t *f = framer;
+  size_t body, body_len, frame_len, want;
+
+  while (f->error == MJRPC_RET_OK) {
+    const char *head;
+    size_t pending = f->end - f->start;
+    if (pending > 0) {
+      /* A frame continues from earlier bytes, complete it in the buffer */
+      head = f->buf + f->start;
+      enum frame_status status =
+          frame_scan(f, head, pending, &body, &body_len, &frame_len, &want);
+      if (status == FRAME_BROKEN)
+        return false;
+      if (status == FRAME_PARTIAL) {
+        size_t rest = f->ext_len - f->ext_pos;
+        if (rest == 0)
+          return false;
+        const char *from = f->ext + f->ext_pos;
+        size_t n = rest;
+        if (want > 0) {
+          n = want - pending < rest ? want - pending : rest;
+        } else if (f->framing == MJRPC_FRAMING_NDJSON) {
+          const char *nl = memchr(from, '\n', rest);
+          if (nl != NULL)
+            n = (size_t)(nl - from) + 1;
+        } else if (n > FRAMER_HEADER_LIMIT) {
+          n = FRAMER_HEADER_LIMIT;
+        }
+        if (!buffer_append(f, from, n))
+          return false;
+        f->ext_pos += n;
+        continue;
+      }
+      f->start += frame_len;
+    } else {
+      /* Nothing carried over, take the frame straight from the chunk */
+      size_t rest = f->ext_len - f->ext_pos;
+      if (rest == 0)
+        return false;
+      head = f->ext + f->ext_pos;
+      enum frame_status status =
+          frame_scan(f, head, rest, &body, &body_len, &frame_len, &want);
+      if (status == FRAME_BROKEN)
+        return false;
+      if (status == FRAME_PARTIAL) {
+        save_chunk(f);
+        return false;
+      }
+      f->ext_pos += frame_len;
+    }
+
+    frame_reset(f);
+    if (f->framing == MJRPC_FRAMING_NDJSON && is_blank(head, body_len))
+      continue;
+    *message = head + body;
+    *len = body_len;
+    return true;
+  }
+  return false;
+}
+
+int mjrpc_framer_error(const mjrpc_framer_t *framer) {
+  return framer ? framer->error : MJRPC_RET_ERROR_INVALID_PARAM;
+}
+
+size_t mjrpc_framer_pending(const mjrpc_framer_t *framer) {
+  if (framer == NULL)
+    return 0;
+  return framer->end - framer->start + framer->ext_len - framer->ext_pos;
+}
+
+int mjrpc_frame_header(enum mjrpc_framing framing, size_t len, char *out,
+                       size_t *header_len) {
+  if (out == NULL || header_len == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  *header_len = 0;
+  switch (framing) {
+  case MJRPC_FRAMING_NDJSON:
+    return MJRPC_RET_OK;
+  case MJRPC_FRAMING_CONTENT_LENGTH:
+    *header_len = (size_t)snprintf(out, MJRPC_FRAME_HEADER_MAX,
+                                   "Content-Length: %zu\r\n\r\n", len);
+    return MJRPC_RET_OK;
+  case MJRPC_FRAMING_LENGTH_PREFIX:
+    if (len > UINT32_MAX)
+      return MJRPC_RET_ERROR_TOO_LARGE;
+    out[0] = (char)(len >> 24);
+    out[1] = (char)(len >> 16);
+    out[2] = (char)(len >> 8);
+    out[3] = (char)len;
+    *header_len = FRAMER_PREFIX_SIZE;
+    return MJRPC_RET_OK;
+  default:
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  }
+}
+
+const char *mjrpc_frame_trailer(enum mjrpc_framing framing, size_t *len) {
+  if (framing == MJRPC_FRAMING_NDJSON) {
+    *len = 1;
+    return "\n";
+  }
+  *len = 0;
+  return "";
+}
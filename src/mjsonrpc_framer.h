@@ -0,0 +1,213 @@
+/**
+ * @file mjsonrpc_framer.h
+ * @brief Streaming message framing for byte-stream transports
+ * @author Xiao
+ * @date 2026
+ * @version 3.0.0
+ *
+ * @details
+ * A framer turns arbitrary chunks read from a socket into complete message
+ * slices that can be handed to mjrpc_process_buf(). Three framings are
+ * supported:
+ * - newline-delimited JSON (one message per line, CRLF accepted, blank
+ *   lines ignored)
+ * - `Content-Length: N` headers followed by an empty line, as used by LSP
+ * - a 4-byte big-endian length prefix
+ *
+ * Bytes can be supplied in two ways:
+ * - mjrpc_framer_reserve() and mjrpc_framer_commit() let the caller read
+ *   straight into the framer's buffer;
+ * - mjrpc_framer_feed() attaches a caller-owned chunk. Messages lying wholly
+ *   inside it are returned as slices of that chunk without copying; only a
+ *   message spanning chunks is assembled in the framer's buffer.
+ *
+ * The internal buffer is compacted only when the free space at its end is
+ * too small, and delimiters are found with memchr(). The framer and its
+ * buffer are allocated through the mjrpc_set_memory_hooks() hooks.
+ *
+ * @par Example:
+ * @code
+ * mjrpc_framer_t *framer = mjrpc_framer_create(MJRPC_FRAMING_NDJSON, 1 << 20);
+ * size_t avail;
+ * char *space = mjrpc_framer_reserve(framer, 4096, &avail);
+ * ssize_t n = read(fd, space, avail);
+ * mjrpc_framer_commit(framer, (size_t)n);
+ *
+ * const char *msg;
+ * size_t len;
+ * while (mjrpc_framer_next(framer, &msg, &len)) {
+ *     char *response = mjrpc_process_buf(handle, msg, len, NULL);
+ *     ...
+ * }
+ * if (mjrpc_framer_error(framer) != MJRPC_RET_OK)
+ *     ; // close the connection
+ * @endcode
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2026 Xiao
+ */
+
+#ifndef MJSONRPC_FRAMER_H_
+#define MJSONRPC_FRAMER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mjsonrpc.h"
+#include <stddef.h>
+
+/** @brief Space needed by mjrpc_frame_header() */
+#define MJRPC_FRAME_HEADER_MAX 48
+
+/**
+ * @enum mjrpc_framing
+ * @brief How messages are delimited on the stream
+ */
+enum mjrpc_framing {
+  /** @brief One message per line */
+  MJRPC_FRAMING_NDJSON,
+
+  /** @brief `Content-Length` header block before every message */
+  MJRPC_FRAMING_CONTENT_LENGTH,
+
+  /** @brief 4-byte big-endian length before every message */
+  MJRPC_FRAMING_LENGTH_PREFIX
+};
+
+/**
+ * @brief Opaque framer instance
+ */
+typedef struct mjrpc_framer mjrpc_framer_t;
+
+/**
+ * @brief Create a framer
+ *
+ * @param framing Framing of the stream
+ * @param max_message_size Larger messages put the framer in the
+ *                         MJRPC_RET_ERROR_TOO_LARGE state
+ * @return New framer, or NULL on allocation failure
+ */
+mjrpc_framer_t *mjrpc_framer_create(enum mjrpc_framing framing,
+                                    size_t max_message_size);
+
+/**
+ * @brief Destroy a framer
+ *
+ * @param framer Framer instance (may be NULL)
+ */
+void mjrpc_framer_destroy(mjrpc_framer_t *framer);
+
+/**
+ * @brief Get writable space at the end of the framer's buffer
+ *
+ * Moves unconsumed bytes to the front of the buffer only when the free
+ * space at its end is smaller than @p min, and grows it if that is not
+ * enough either.
+ *
+ * @param framer Framer instance
+ * @param min Minimum number of writable bytes
+ * @param avail Receives the number of writable bytes
+ * @return Start of the writable space, or NULL on allocation failure
+ */
+char *mjrpc_framer_reserve(mjrpc_framer_t *framer, size_t min, size_t *avail);
+
+/**
+ * @brief Mark bytes written after mjrpc_framer_reserve() as received
+ *
+ * @param framer Framer instance
+ * @param len Number of bytes written
+ */
+void mjrpc_framer_commit(mjrpc_framer_t *framer, size_t len);
+
+/**
+ * @brief Attach a received chunk without copying it
+ *
+ * The chunk must stay valid until mjrpc_framer_next() returns false; the
+ * bytes it has not consumed by then are copied into the framer.
+ *
+ * @param framer Framer instance
+ * @param data Received bytes
+ * @param len Number of bytes
+ * @return Return code
+ * @retval MJRPC_RET_OK On success
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If an argument is NULL
+ * @retval MJRPC_RET_ERROR_MEM_ALLOC_FAILED If an earlier chunk could not be
+ *         saved
+ */
+int mjrpc_framer_feed(mjrpc_framer_t *framer, const char *data, size_t len);
+
+/**
+ * @brief Get the next complete message
+ *
+ * The slice points into the attached chunk or the framer's buffer and stays
+ * valid until the next call on the framer. Framing bytes (header, length
+ * prefix, line terminator) are not part of it. The framer does not read the
+ * slice again, so if the chunks fed to it are writable the message can be
+ * parsed in place with mjrpc_process_buf_insitu().
+ *
+ * @param framer Framer instance
+ * @param message Receives the start of the message
+ * @param len Receives the length of the message
+ * @return true if a message was returned, false if more bytes are needed or
+ *         the stream is broken (see mjrpc_framer_error())
+ */
+bool mjrpc_framer_next(mjrpc_framer_t *framer, const char **message,
+                       size_t *len);
+
+/**
+ * @brief Get the error state of a framer
+ *
+ * Errors are permanent since the stream cannot be resynchronized.
+ *
+ * @param framer Framer instance
+ * @return Return code
+ * @retval MJRPC_RET_OK If the stream is intact
+ * @retval MJRPC_RET_ERROR_TOO_LARGE If a message exceeds the limit
+ * @retval MJRPC_RET_ERROR_PARSE_FAILED If a header block is malformed
+ * @retval MJRPC_RET_ERROR_MEM_ALLOC_FAILED If the buffer could not grow
+ */
+int mjrpc_framer_error(const mjrpc_framer_t *framer);
+
+/**
+ * @brief Get the number of received bytes not yet returned as messages
+ *
+ * @param framer Framer instance
+ * @return Buffered byte count
+ */
+size_t mjrpc_framer_pending(const mjrpc_framer_t *framer);
+
+/**
+ * @brief Write the bytes that precede an outgoing message
+ *
+ * @param framing Framing of the stream
+ * @param len Length of the message
+ * @param out Buffer of at least MJRPC_FRAME_HEADER_MAX bytes
+ * @param header_len Receives the number of bytes written (0 for
+ *                   newline-delimited framing)
+ * @return Error code from enum mjrpc_error_return
+ * @retval MJRPC_RET_OK If successful
+ * @retval MJRPC_RET_ERROR_TOO_LARGE If @p len does not fit the 4-byte length
+ *         prefix
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If @p framing is unknown or a
+ *         pointer is NULL
+ */
+int mjrpc_frame_header(enum mjrpc_framing framing, size_t len, char *out,
+                       size_t *header_len);
+
+/**
+ * @brief Get the bytes that follow an outgoing message
+ *
+ * @param framing Framing of the stream
+ * @param len Receives the number of bytes
+ * @return Static trailer ("\n" for newline-delimited framing, else empty)
+ */
+const char *mjrpc_frame_trailer(enum mjrpc_framing framing, size_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MJSONRPC_FRAMER_H_
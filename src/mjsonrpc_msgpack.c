@@ -0,0 +1,596 @@
+/*
+    MIT License
+
+    Copyright (c) 2026 Xiao
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+ */
+
+
+#include "mjsonrpc_msgpack.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** @brief Initial size of the encoder output */
+#define MSGPACK_OUTPUT_INITIAL 256
+
+/** @brief Initial depth of the container stacks */
+#define MSGPACK_STACK_INITIAL 16
+
+/*--- decoding ---*/
+
+struct reader {
+  const unsigned char *pos;
+  const unsigned char *end;
+};
+
+/* A number as read; integers keep their exact value for typed arrays */
+struct number {
+  bool is_int;
+  long long i;
+  double d;
+};
+
+/* A container whose elements are still being read */
+struct frame {
+  cJSON *container;
+  size_t remaining; /* elements, or key/value pairs of a map */
+  bool is_map;
+};
+
+static bool read_bytes(struct reader *r, size_t n,
+                       const unsigned char **out) {
+  if ((size_t)(r->end - r->pos) < n)
+    return false;
+  *out = r->pos;
+  r->pos += n;
+  return true;
+}
+
+/** @brief Read a big-endian unsigned field of @p n bytes */
+static bool read_uint(struct reader *r, size_t n, uint64_t *out) {
+  const unsigned char *p;
+  if (!read_bytes(r, n, &p))
+    return false;
+  uint64_t value = 0;
+  for (size_t i = 0; i < n; i++)
+    value = value << 8 | p[i];
+  *out = value;
+  return true;
+}
+
+/**
+ * @brief Read the next value if it is a number
+ * @return false, leaving the reader alone, if it is not a complete number
+ */
+static bool read_number(struct reader *r, struct number *n) {
+  struct reader at = *r;
+  if (at.pos == at.end)
+    return false;
+  unsigned char tag = *at.pos++;
+  uint64_t bits;
+  n->is_int = true;
+  if (tag <= 0x7f || tag >= 0xe0) {
+    n->i = (signed char)tag;
+  } else if (tag >= 0xcc && tag <= 0xcf) {
+    if (!read_uint(&at, (size_t)1 << (tag - 0xcc), &bits))
+      return false;
+    if (bits > INT64_MAX) {
+      n->is_int = false;
+      n->d = (double)bits;
+    } else {
+      n->i = (long long)bits;
+    }
+  } else if (tag >= 0xd0 && tag <= 0xd3) {
+    size_t size = (size_t)1 << (tag - 0xd0);
+    if (!read_uint(&at, size, &bits))
+      return false;
+    if (size == 8) {
+      int64_t value;
+      memcpy(&value, &bits, sizeof(value));
+      n->i = value;
+    } else {
+      /* Sign-extend */
+      int64_t sign = (int64_t)1 << (size * 8 - 1);
+      n->i = ((int64_t)bits ^ sign) - sign;
+    }
+  } else if (tag == 0xca) {
+    if (!read_uint(&at, 4, &bits))
+      return false;
+    uint32_t word = (uint32_t)bits;
+    float value;
+    memcpy(&value, &word, sizeof(value));
+    n->is_int = false;
+    n->d = value;
+  } else if (tag == 0xcb) {
+    if (!read_uint(&at, 8, &bits))
+      return false;
+    n->is_int = false;
+    memcpy(&n->d, &bits, sizeof(n->d));
+  } else {
+    return false;
+  }
+  if (n->is_int)
+    n->d = (double)n->i;
+  *r = at;
+  return true;
+}
+
+/**
+ * @brief Read a str header
+ * @return false, leaving the reader alone, if the next value is no str
+ */
+static bool read_str_header(struct reader *r, size_t *len) {
+  struct reader at = *r;
+  if (at.pos == at.end)
+    return false;
+  unsigned char tag = *at.pos++;
+  uint64_t value;
+  if (tag >= 0xa0 && tag <= 0xbf)
+    value = tag & 0x1f;
+  else if (tag < 0xd9 || tag > 0xdb ||
+           !read_uint(&at, (size_t)1 << (tag - 0xd9), &value))
+    return false;
+  if (value > (uint64_t)(at.end - at.pos))
+    return false;
+  *len = (size_t)value;
+  *r = at;
+  return true;
+}
+
+/** @brief Copy a str into a NUL-terminated string from the cJSON hooks */
+static char *read_str(struct reader *r) {
+  size_t len;
+  const unsigned char *p;
+  if (!read_str_header(r, &len) || !read_bytes(r, len, &p))
+    return NULL;
+  char *s = cJSON_malloc(len + 1);
+  if (s != NULL) {
+    memcpy(s, p, len);
+    s[len] = '\0';
+  }
+  return s;
+}
+
+/**
+ * @brief Decode @p count numbers into a typed array
+ * @return NULL, leaving the reader alone, unless all of them are numbers
+ */
+static cJSON *read_typed(struct reader *r, size_t count) {
+  struct reader scan = *r;
+  struct number n;
+  bool all_int = true;
+  for (size_t i = 0; i < count; i++) {
+    if (!read_number(&scan, &n))
+      return NULL;
+    all_int = all_int && n.is_int;
+  }
+  cJSON *typed = all_int ? cJSON_CreateTypedInt64Array(NULL, count)
+                         : cJSON_CreateTypedDoubleArray(NULL, count);
+  if (typed == NULL)
+    return NULL;
+  long long *ints = cJSON_GetTypedArrayInt64s(typed);
+  double *doubles = cJSON_GetTypedArrayDoubles(typed);
+  for (size_t i = 0; i < count; i++) {
+    read_number(r, &n);
+    if (all_int)
+      ints[i] = n.i;
+    else
+      doubles[i] = n.d;
+  }
+  return typed;
+}
+
+/**
+ * @brief Decode the next value, leaving the elements of a container
+ *
+ * @param typed_min Decode arrays of at least this many numbers into typed
+ *                  arrays, 0 for never
+ * @param count Receives the number of elements (pairs for a map) the
+ *              returned container still needs
+ */
+static cJSON *read_value(struct reader *r, size_t typed_min, size_t *count) {
+  *count = 0;
+  struct number n;
+  if (read_number(r, &n))
+    return cJSON_CreateNumber(n.d);
+  if (r->pos == r->end)
+    return NULL;
+  unsigned char tag = *r->pos;
+  if ((tag >= 0xa0 && tag <= 0xbf) || (tag >= 0xd9 && tag <= 0xdb)) {
+    char *s = read_str(r);
+    if (s == NULL)
+      return NULL;
+    cJSON *item = cJSON_CreateStringReference(s);
+    if (item == NULL) {
+      cJSON_free(s);
+      return NULL;
+    }
+    /* The item owns the copy */
+    item->type &= ~cJSON_IsReference;
+    return item;
+  }
+  r->pos++;
+  uint64_t size;
+  bool is_map;
+  if (tag == 0xc0)
+    return cJSON_CreateNull();
+  if (tag == 0xc2 || tag == 0xc3)
+    return cJSON_CreateBool(tag == 0xc3);
+  if (tag >= 0x80 && tag <= 0x9f) {
+    is_map = tag < 0x90;
+    size = tag & 0x0f;
+  } else if (tag >= 0xdc && tag <= 0xdf) {
+    is_map = tag >= 0xde;
+    if (!read_uint(r, (tag & 1) ? 4 : 2, &size))
+      return NULL;
+  } else {
+    /* bin, ext and the unused 0xc1 */
+    return NULL;
+  }
+
+  /* Every element takes at least one byte */
+  size_t left = (size_t)(r->end - r->pos);
+  if (size > left || (is_map && size > left / 2))
+    return NULL;
+  if (!is_map && typed_min != 0 && size >= typed_min) {
+    cJSON *typed = read_typed(r, (size_t)size);
+    if (typed != NULL)
+      return typed;
+  }
+  *count = (size_t)size;
+  return is_map ? cJSON_CreateObject() : cJSON_CreateArray();
+}
+
+/**
+ * @brief Decode a request or response
+ *
+ * @param typed_min Passed to read_value() for arrays nested inside params.
+ *                  Request members, params itself included, are never typed
+ *                  since positional params are read item by item.
+ */
+static cJSON *decode(const char *buf, size_t len, size_t typed_min) {
+  if (buf == NULL)
+    return NULL;
+  struct reader r = {(const unsigned char *)buf,
+                     (const unsigned char *)buf + len};
+  size_t count;
+  cJSON *root = read_value(&r, 0, &count);
+  if (root == NULL)
+    return NULL;
+  /* Depth of the members of a request: 1 in a single request, 2 in a batch */
+  size_t plain_depth = cJSON_IsArray(root) ? 2 : 1;
+
+  struct frame *stack = NULL;
+  size_t depth = 0, cap = 0;
+  bool ok = true;
+  cJSON *container = root;
+  while (ok) {
+    if (count > 0) {
+      if (depth == CJSON_NESTING_LIMIT) {
+        ok = false;
+        break;
+      }
+      if (depth == cap) {
+        size_t grown_cap = cap ? cap * 2 : MSGPACK_STACK_INITIAL;
+        struct frame *grown = realloc(stack, grown_cap * sizeof(*stack));
+        if (grown == NULL) {
+          ok = false;
+          break;
+        }
+        stack = grown;
+        cap = grown_cap;
+      }
+      stack[depth].container = container;
+      stack[depth].remaining = count;
+      stack[depth].is_map = cJSON_IsObject(container);
+      depth++;
+    }
+    while (depth > 0 && stack[depth - 1].remaining == 0)
+      depth--;
+    if (depth == 0)
+      break;
+
+    struct frame *top = &stack[depth - 1];
+    top->remaining--;
+    char *key = NULL;
+    if (top->is_map && (key = read_str(&r)) == NULL) {
+      ok = false;
+      break;
+    }
+    cJSON *item = read_value(&r, depth > plain_depth ? typed_min : 0, &count);
+    if (item == NULL) {
+      cJSON_free(key);
+      ok = false;
+      break;
+    }
+    item->string = key;
+    if (!cJSON_AddItemToArray(top->container, item)) {
+      cJSON_Delete(item);
+      ok = false;
+      break;
+    }
+    container = item;
+  }
+  free(stack);
+  if (!ok || r.pos != r.end) {
+    cJSON_Delete(root);
+    return NULL;
+  }
+  return root;
+}
+
+cJSON *mjrpc_msgpack_decode(const char *buf, size_t len) {
+  return decode(buf, len, 0);
+}
+
+/*--- encoding ---*/
+
+struct writer {
+  unsigned char *buf;
+  size_t len, cap;
+  bool failed;
+};
+
+/** @brief Append @p n bytes to the output and return where they go */
+static unsigned char *reserve(struct writer *w, size_t n) {
+  if (w->failed)
+    return NULL;
+  if (w->cap - w->len < n) {
+    size_t cap = w->cap ? w->cap : MSGPACK_OUTPUT_INITIAL;
+    while (cap - w->len < n) {
+      if (cap > SIZE_MAX / 2) {
+        w->failed = true;
+        return NULL;
+      }
+      cap *= 2;
+    }
+    unsigned char *grown = realloc(w->buf, cap);
+    if (grown == NULL) {
+      w->failed = true;
+      return NULL;
+    }
+    w->buf = grown;
+    w->cap = cap;
+  }
+  unsigned char *p = w->buf + w->len;
+  w->len += n;
+  return p;
+}
+
+static void put_byte(struct writer *w, unsigned char byte) {
+  unsigned char *p = reserve(w, 1);
+  if (p != NULL)
+    *p = byte;
+}
+
+/** @brief Write @p tag followed by the low @p n bytes of @p value */
+static void put_tagged(struct writer *w, unsigned char tag, uint64_t value,
+                       size_t n) {
+  unsigned char *p = reserve(w, 1 + n);
+  if (p == NULL)
+    return;
+  p[0] = tag;
+  for (size_t i = n; i > 0; i--) {
+    p[i] = (unsigned char)value;
+    value >>= 8;
+  }
+}
+
+static void put_uint(struct writer *w, uint64_t value) {
+  if (value <= 0x7f)
+    put_byte(w, (unsigned char)value);
+  else if (value <= UINT8_MAX)
+    put_tagged(w, 0xcc, value, 1);
+  else if (value <= UINT16_MAX)
+    put_tagged(w, 0xcd, value, 2);
+  else if (value <= UINT32_MAX)
+    put_tagged(w, 0xce, value, 4);
+  else
+    put_tagged(w, 0xcf, value, 8);
+}
+
+static void put_int(struct writer *w, long long value) {
+  if (value >= 0)
+    put_uint(w, (uint64_t)value);
+  else if (value >= -32)
+    put_byte(w, (unsigned char)value);
+  else if (value >= INT8_MIN)
+    put_tagged(w, 0xd0, (uint64_t)value, 1);
+  else if (value >= INT16_MIN)
+    put_tagged(w, 0xd1, (uint64_t)value, 2);
+  else if (value >= INT32_MIN)
+    put_tagged(w, 0xd2, (uint64_t)value, 4);
+  else
+    put_tagged(w, 0xd3, (uint64_t)value, 8);
+}
+
+static void put_number(struct writer *w, double d) {
+  if (isnan(d) || isinf(d)) {
+    put_byte(w, 0xc0);
+  } else if (d >= -9223372036854775808.0 && d < 9223372036854775808.0 &&
+             d == (double)(long long)d) {
+    put_int(w, (long long)d);
+  } else if (d >= 0 && d < 18446744073709551616.0 &&
+             d == (double)(uint64_t)d) {
+    put_uint(w, (uint64_t)d);
+  } else if (d >= -FLT_MAX && d <= FLT_MAX && (double)(float)d == d) {
+    float f = (float)d;
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    put_tagged(w, 0xca, bits, 4);
+  } else {
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    put_tagged(w, 0xcb, bits, 8);
+  }
+}
+
+static void put_str(struct writer *w, const char *s) {
+  size_t len = strlen(s);
+  if (len <= 31)
+    put_byte(w, (unsigned char)(0xa0 | len));
+  else if (len <= UINT8_MAX)
+    put_tagged(w, 0xd9, len, 1);
+  else if (len <= UINT16_MAX)
+    put_tagged(w, 0xda, len, 2);
+  else if (len <= UINT32_MAX)
+    put_tagged(w, 0xdb, len, 4);
+  else
+    w->failed = true;
+  unsigned char *p = reserve(w, len);
+  if (p != NULL)
+    memcpy(p, s, len);
+}
+
+/** @brief Write an array (@p fix 0x90) or map (0x80) header */
+static void put_container(struct writer *w, unsigned char fix,
+                          size_t count) {
+  /* array 16 is 0xdc, map 16 is 0xde; the 32-bit forms follow */
+  unsigned char tag16 = fix == 0x90 ? 0xdc : 0xde;
+  if (count <= 15)
+    put_byte(w, (unsigned char)(fix | count));
+  else if (count <= UINT16_MAX)
+    put_tagged(w, tag16, count, 2);
+  else if (count <= UINT32_MAX)
+    put_tagged(w, (unsigned char)(tag16 + 1), count, 4);
+  else
+    w->failed = true;
+}
+
+static void encode_tree(struct writer *w, const cJSON *root);
+
+/** @brief Write an item, or the header of a container with children */
+static void put_item(struct writer *w, const cJSON *item) {
+  if (cJSON_IsTypedArray(item)) {
+    size_t count = cJSON_GetTypedArraySize(item);
+    const long long *ints = cJSON_GetTypedArrayInt64s(item);
+    put_container(w, 0x90, count);
+    for (size_t i = 0; i < count; i++) {
+      if (ints != NULL)
+        put_int(w, ints[i]);
+      else
+        put_number(w, cJSON_GetTypedArrayNumber(item, i));
+    }
+  } else if (cJSON_IsArray(item) || cJSON_IsObject(item)) {
+    put_container(w, cJSON_IsArray(item) ? 0x90 : 0x80,
+                  (size_t)cJSON_GetArraySize(item));
+  } else if (cJSON_IsFalse(item)) {
+    put_byte(w, 0xc2);
+  } else if (cJSON_IsTrue(item)) {
+    put_byte(w, 0xc3);
+  } else if (cJSON_IsNumber(item)) {
+    put_number(w, item->valuedouble);
+  } else if (cJSON_IsString(item) && item->valuestring != NULL) {
+    put_str(w, item->valuestring);
+  } else if (cJSON_IsRaw(item) && item->valuestring != NULL) {
+    /* Raw JSON, such as a cached result; parsed trees hold no raw items */
+    cJSON *parsed = cJSON_ParseWithLength(item->valuestring,
+                                          strlen(item->valuestring));
+    if (parsed != NULL)
+      encode_tree(w, parsed);
+    else
+      put_byte(w, 0xc0);
+    cJSON_Delete(parsed);
+  } else {
+    put_byte(w, 0xc0);
+  }
+}
+
+/** @brief Write a tree depth-first without recursing into containers */
+static void encode_tree(struct writer *w, const cJSON *root) {
+  const cJSON **stack = NULL;
+  size_t depth = 0, cap = 0;
+  const cJSON *item = root;
+  for (;;) {
+    if (depth > 0 && cJSON_IsObject(stack[depth - 1]))
+      put_str(w, item->string ? item->string : "");
+    put_item(w, item);
+    if (w->failed)
+      break;
+    if ((cJSON_IsArray(item) || cJSON_IsObject(item)) && item->child != NULL) {
+      if (depth == cap) {
+        size_t grown_cap = cap ? cap * 2 : MSGPACK_STACK_INITIAL;
+        const cJSON **grown = realloc(stack, grown_cap * sizeof(*stack));
+        if (grown == NULL) {
+          w->failed = true;
+          break;
+        }
+        stack = grown;
+        cap = grown_cap;
+      }
+      stack[depth++] = item;
+      item = item->child;
+      continue;
+    }
+    while (depth > 0 && item->next == NULL)
+      item = stack[--depth];
+    if (depth == 0)
+      break;
+    item = item->next;
+  }
+  free(stack);
+}
+
+char *mjrpc_msgpack_encode(const cJSON *item, size_t *len) {
+  if (item == NULL || len == NULL)
+    return NULL;
+  struct writer w = {NULL, 0, 0, false};
+  encode_tree(&w, item);
+  if (w.failed) {
+    free(w.buf);
+    return NULL;
+  }
+  *len = w.len;
+  return (char *)w.buf;
+}
+
+char *mjrpc_process_msgpack(const mjrpc_handle_t *handle, const char *buf,
+                            size_t len, size_t *out_len, int *ret_code) {
+  if (out_len)
+    *out_len = 0;
+  cJSON *request =
+      decode(buf, len, handle ? mjrpc_get_typed_arrays(handle) : 0);
+  cJSON *response;
+  if (request == NULL) {
+    if (ret_code)
+      *ret_code = MJRPC_RET_ERROR_PARSE_FAILED;
+    response = mjrpc_response_error(
+        JSON_RPC_CODE_PARSE_ERROR,
+        "Invalid request received: Not a MessagePack formatted request.",
+        cJSON_CreateNull());
+  } else {
+    response = mjrpc_process_cjson(handle, request, ret_code);
+    cJSON_Delete(request);
+  }
+  if (response == NULL)
+    return NULL;
+
+  size_t response_len;
+  char *out = mjrpc_msgpack_encode(response, &response_len);
+  cJSON_Delete(response);
+  if (out != NULL && out_len)
+    *out_len = response_len;
+  return out;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file mjsonrpc_msgpack.h
+ * @brief MessagePack encoding of JSON-RPC messages
+ * @author Xiao
+ * @date 2026
+ * @version 3.0.0
+ *
+ * @details
+ * Lets clients send the same JSON-RPC envelopes encoded as MessagePack
+ * instead of JSON text. Requests are decoded straight into the cJSON tree
+ * the methods receive, so handlers, params views, the response cache and
+ * every other feature of the handle work unchanged, and responses are
+ * encoded from the response tree without printing JSON.
+ *
+ * Types map as follows:
+ * - nil, booleans, maps with string keys and arrays map to their JSON
+ *   counterparts
+ * - str maps to a string; a string ends at its first NUL byte, as it
+ *   does in cJSON
+ * - integers and floats map to numbers. Numbers are encoded as the smallest
+ *   integer that holds them exactly, as float32 when that is exact, and as
+ *   float64 otherwise. NaN and infinities are encoded as nil, like
+ *   cJSON_Print() prints them as null.
+ * - bin and ext have no JSON counterpart and make a request invalid
+ *
+ * Messages carry no delimiter of their own, so stream transports need
+ * MJRPC_FRAMING_LENGTH_PREFIX (see mjsonrpc_framer.h).
+ *
+ * @par Example:
+ * @code
+ * size_t len;
+ * int ret_code;
+ * char *response = mjrpc_process_msgpack(handle, msg, msg_len, &len, &ret_code);
+ * if (response) {
+ *     send(fd, response, len, 0);
+ *     free(response);
+ * }
+ * @endcode
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2026 Xiao
+ */
+
+#ifndef MJSONRPC_MSGPACK_H_
+#define MJSONRPC_MSGPACK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mjsonrpc.h"
+#include <stddef.h>
+
+/**
+ * @brief Process a MessagePack-encoded JSON-RPC request
+ *
+ * Same as mjrpc_process_buf(), but the request and the response are
+ * MessagePack. The buffer must hold exactly one value. Arrays of at least
+ * the mjrpc_set_typed_arrays() count of numbers nested inside params are
+ * decoded into typed arrays, as with JSON. Raw items in the response (such
+ * as cache hits) are parsed and encoded; one holding invalid JSON is sent
+ * as nil.
+ *
+ * @param handle JSON-RPC handle containing registered methods
+ * @param buf Request bytes
+ * @param len Number of bytes in @p buf
+ * @param out_len Receives the response length (0 when NULL is returned,
+ *                can be NULL)
+ * @param ret_code Pointer to store the return code (can be NULL)
+ *
+ * @return Response bytes (caller must free), or NULL for notifications
+ * @retval NULL If the request was a notification or an error occurred
+ *
+ * @note An undecodable request is answered with a parse error and sets
+ *       MJRPC_RET_ERROR_PARSE_FAILED
+ */
+char *mjrpc_process_msgpack(const mjrpc_handle_t *handle, const char *buf,
+                            size_t len, size_t *out_len, int *ret_code);
+
+/**
+ * @brief Encode a cJSON tree as MessagePack
+ *
+ * Clients use it to encode requests for mjrpc_process_msgpack(). Typed
+ * arrays are encoded as arrays of numbers.
+ *
+ * @param item Tree to encode
+ * @param len Receives the encoded length
+ * @return Encoded bytes (caller must free), or NULL if @p item or @p len is
+ *         NULL or on allocation failure
+ */
+char *mjrpc_msgpack_encode(const cJSON *item, size_t *len);
+
+/**
+ * @brief Decode one MessagePack value into a cJSON tree
+ *
+ * Clients use it to decode responses of mjrpc_process_msgpack(). Containers
+ * nested deeper than CJSON_NESTING_LIMIT are rejected.
+ *
+ * @param buf Encoded bytes
+ * @param len Number of bytes in @p buf, which must hold exactly one value
+ * @return Decoded tree (caller must cJSON_Delete()), or NULL if the bytes are
+ *         malformed or hold a type without JSON counterpart
+ */
+cJSON *mjrpc_msgpack_decode(const char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MJSONRPC_MSGPACK_H_
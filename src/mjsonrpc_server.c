@@ -0,0 +1,1359 @@
+/*
+    MIT License
+
+    Copyright (c) 2026 Xiao
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+ */
+
+#include "mjsonrpc_server.h"
+
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifdef MJRPC_SERVER_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+/** @brief Events fetched per epoll_wait() */
+#define SERVER_MAX_EVENTS 64
+
+/** @brief Responses gathered into one sendmsg() */
+#define SERVER_MAX_RESPONSES 64
+
+/** @brief Read only when at least this much buffer space is free */
+#define SERVER_MIN_READ 4096
+
+/*--- types ---*/
+
+/* First member of everything registered with epoll, to tell them apart */
+enum endpoint_kind { EP_LISTENER, EP_CONNECTION, EP_WAKEUP };
+
+struct listener {
+  enum endpoint_kind kind;
+  int fd;
+};
+
+struct reactor;
+
+struct connection {
+  enum endpoint_kind kind;
+  int fd;
+  struct reactor *reactor;
+  struct connection *prev, *next;
+
+  /* Splits received bytes into messages */
+  mjrpc_framer_t *framer;
+
+  /* Bytes the socket did not accept yet, sent from woff */
+  char *wbuf;
+  size_t wlen, woff, wcap;
+
+  /* Responses of the current read, sent together: header, body, trailer */
+  struct iovec iov[SERVER_MAX_RESPONSES * 3];
+  char headers[SERVER_MAX_RESPONSES][MJRPC_FRAME_HEADER_MAX];
+  int iov_count;
+
+  /* Peer finished sending; close once the write buffer drains */
+  bool eof;
+};
+
+struct reactor {
+  struct mjrpc_server *server;
+  int epfd;
+  struct listener tcp;
+  struct listener wakeup;
+  struct connection *connections;
+  pthread_t thread;
+};
+
+struct mjrpc_server {
+  const mjrpc_handle_t *handle;
+  mjrpc_server_config_t config;
+  char *tcp_host;
+  char *unix_path;
+  struct listener unix_listener;
+  uint16_t tcp_port;
+  enum mjrpc_server_backend backend;
+  int reactor_count;
+  struct reactor *reactors;
+  bool running;
+};
+
+/*--- connections ---*/
+
+static void connection_close(struct connection *c) {
+  struct reactor *r = c->reactor;
+  for (int i = 1; i < c->iov_count; i += 3)
+    cJSON_free(c->iov[i].iov_base);
+  if (c->prev)
+    c->prev->next = c->next;
+  else
+    r->connections = c->next;
+  if (c->next)
+    c->next->prev = c->prev;
+  close(c->fd);
+  mjrpc_framer_destroy(c->framer);
+  free(c->wbuf);
+  free(c);
+}
+
+/**
+ * @brief Append bytes to the write buffer
+ * @return false if the buffer could not grow
+ */
+static bool wbuf_append(struct connection *c, const char *data, size_t len) {
+  if (len == 0)
+    return true;
+  if (c->woff > 0 && c->wlen + len > c->wcap) {
+    memmove(c->wbuf, c->wbuf + c->woff, c->wlen - c->woff);
+    c->wlen -= c->woff;
+    c->woff = 0;
+  }
+  if (c->wlen + len > c->wcap) {
+    size_t cap = c->wcap ? c->wcap : c->reactor->server->config.buffer_size;
+    while (cap < c->wlen + len)
+      cap *= 2;
+    char *grown = realloc(c->wbuf, cap);
+    if (grown == NULL)
+      return false;
+    c->wbuf = grown;
+    c->wcap = cap;
+  }
+  memcpy(c->wbuf + c->wlen, data, len);
+  c->wlen += len;
+  return true;
+}
+
+/**
+ * @brief Send buffered bytes until the socket would block
+ * @return false if the connection failed
+ */
+static bool connection_flush_wbuf(struct connection *c) {
+  while (c->woff < c->wlen) {
+    ssize_t n =
+        send(c->fd, c->wbuf + c->woff, c->wlen - c->woff, MSG_NOSIGNAL);
+    if (n > 0) {
+      c->woff += (size_t)n;
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return true;
+    } else {
+      return false;
+    }
+  }
+  c->woff = c->wlen = 0;
+  return true;
+}
+
+/**
+ * @brief Send the gathered responses
+ *
+ * Goes straight to a vectored send when nothing is queued in front of
+ * them; what the socket does not take is copied to the write buffer.
+ *
+ * @return false if the connection failed
+ */
+static bool connection_flush_iov(struct connection *c) {
+  if (c->iov_count == 0)
+    return true;
+
+  bool ok = true;
+  int first = 0;
+  size_t skip = 0;
+  if (c->woff == c->wlen) {
+    struct msghdr msg = {0};
+    msg.msg_iov = c->iov;
+    msg.msg_iovlen = (size_t)c->iov_count;
+    ssize_t n;
+    do {
+      n = sendmsg(c->fd, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+      ok = false;
+    size_t sent = n > 0 ? (size_t)n : 0;
+    while (first < c->iov_count && sent >= c->iov[first].iov_len) {
+      sent -= c->iov[first].iov_len;
+      first++;
+    }
+    skip = sent;
+  }
+
+  for (int i = first; ok && i < c->iov_count; i++) {
+    ok = wbuf_append(c, (char *)c->iov[i].iov_base + skip,
+                     c->iov[i].iov_len - skip);
+    skip = 0;
+  }
+  for (int i = 1; i < c->iov_count; i += 3)
+    cJSON_free(c->iov[i].iov_base);
+  c->iov_count = 0;
+  return ok;
+}
+
+/**
+ * @brief Process one message
+ * @return false if the connection failed
+ */
+static bool connection_dispatch(struct connection *c, const char *message,
+                                size_t len) {
+  const struct mjrpc_server *server = c->reactor->server;
+  /* The message lies in the framer's buffer and is not read again */
+  char *response =
+      mjrpc_process_buf_insitu(server->handle, (char *)message, len, NULL);
+  if (response == NULL)
+    return true;
+
+  if (c->iov_count == SERVER_MAX_RESPONSES * 3 && !connection_flush_iov(c)) {
+    cJSON_free(response);
+    return false;
+  }
+  enum mjrpc_framing framing = server->config.framing;
+  struct iovec *iov = c->iov + c->iov_count;
+  size_t response_len = strlen(response);
+  iov[0].iov_base = c->headers[c->iov_count / 3];
+  if (mjrpc_frame_header(framing, response_len, iov[0].iov_base,
+                         &iov[0].iov_len) != MJRPC_RET_OK) {
+    cJSON_free(response);
+    return false;
+  }
+  iov[1].iov_base = response;
+  iov[1].iov_len = response_len;
+  iov[2].iov_base = (char *)mjrpc_frame_trailer(framing, &iov[2].iov_len);
+  c->iov_count += 3;
+  return true;
+}
+
+/**
+ * @brief Dispatch every complete message received so far
+ * @return false if the connection must be closed
+ */
+static bool connection_process(struct connection *c) {
+  const char *message;
+  size_t len;
+  while (mjrpc_framer_next(c->framer, &message, &len))
+    if (!connection_dispatch(c, message, len))
+      return false;
+  if (!connection_flush_iov(c))
+    return false;
+  return mjrpc_framer_error(c->framer) == MJRPC_RET_OK;
+}
+
+/**
+ * @brief Read until the socket would block
+ *
+ * Reads go straight into the framer, which keeps the unfinished tail of the
+ * stream and moves it only when the space behind it runs short.
+ *
+ * @return false if the connection was closed
+ */
+static bool connection_read(struct connection *c) {
+  for (;;) {
+    size_t avail;
+    char *space = mjrpc_framer_reserve(c->framer, SERVER_MIN_READ, &avail);
+    if (space == NULL) {
+      connection_close(c);
+      return false;
+    }
+
+    ssize_t n = read(c->fd, space, avail);
+    if (n > 0) {
+      mjrpc_framer_commit(c->framer, (size_t)n);
+      if (!connection_process(c)) {
+        connection_close(c);
+        return false;
+      }
+    } else if (n == 0) {
+      c->eof = true;
+      if (c->woff == c->wlen) {
+        connection_close(c);
+        return false;
+      }
+      return true;
+    } else if (errno == EINTR) {
+      continue;
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return true;
+    } else {
+      connection_close(c);
+      return false;
+    }
+  }
+}
+
+static void connection_event(struct connection *c, uint32_t events) {
+  if (events & EPOLLERR) {
+    connection_close(c);
+    return;
+  }
+  if ((events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) && !c->eof &&
+      !connection_read(c))
+    return;
+  if (c->woff < c->wlen && !connection_flush_wbuf(c)) {
+    connection_close(c);
+    return;
+  }
+  if (c->eof && c->woff == c->wlen)
+    connection_close(c);
+}
+
+static void reactor_accept(struct reactor *r, struct listener *l) {
+  for (;;) {
+    int fd = accept4(l->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      return; /* EAGAIN, or out of descriptors until a peer leaves */
+    }
+
+    int one = 1;
+    (void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    const mjrpc_server_config_t *config = &r->server->config;
+    struct connection *c = calloc(1, sizeof(struct connection));
+    mjrpc_framer_t *framer =
+        c ? mjrpc_framer_create(config->framing, config->max_message_size)
+          : NULL;
+    if (framer == NULL) {
+      free(c);
+      close(fd);
+      continue;
+    }
+    c->kind = EP_CONNECTION;
+    c->fd = fd;
+    c->reactor = r;
+    c->framer = framer;
+    size_t avail;
+    (void)mjrpc_framer_reserve(framer, config->buffer_size, &avail);
+
+    struct epoll_event ev = {0};
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    ev.data.ptr = c;
+    if (epoll_ctl(r->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+      mjrpc_framer_destroy(framer);
+      free(c);
+      close(fd);
+      continue;
+    }
+    c->next = r->connections;
+    if (r->connections)
+      r->connections->prev = c;
+    r->connections = c;
+  }
+}
+
+static void *reactor_main(void *arg) {
+  struct reactor *r = arg;
+  struct epoll_event events[SERVER_MAX_EVENTS];
+  bool stop = false;
+
+  while (!stop) {
+    int n = epoll_wait(r->epfd, events, SERVER_MAX_EVENTS, -1);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    for (int i = 0; i < n; i++) {
+      enum endpoint_kind *kind = events[i].data.ptr;
+      switch (*kind) {
+      case EP_WAKEUP:
+        stop = true;
+        break;
+      case EP_LISTENER:
+        reactor_accept(r, (struct listener *)kind);
+        break;
+      case EP_CONNECTION:
+        connection_event((struct connection *)kind, events[i].events);
+        break;
+      }
+    }
+  }
+
+  while (r->connections)
+    connection_close(r->connections);
+  return NULL;
+}
+
+#ifdef MJRPC_SERVER_IO_URING
+
+/*--- io_uring backend ---*/
+
+/** @brief Submission queue entries per reactor */
+#define URING_ENTRIES 1024
+
+/** @brief Receive buffers in the provided buffer ring (power of two) */
+#define URING_RECV_BUFFERS 256
+
+/** @brief Registered send slots shared by the connections of a reactor */
+#define URING_SEND_SLOTS 64
+
+/** @brief Buffer group id of the receive buffers */
+#define URING_BGID 0
+
+/* Operation tag, stored in the top byte of user_data */
+enum uring_op {
+  OP_ACCEPT = 1,
+  OP_RECV,
+  OP_SEND_FIXED,
+  OP_SEND,
+  OP_WAKEUP,
+  OP_CANCEL
+};
+
+#define URING_TAG(ptr, op) ((uint64_t)(uintptr_t)(ptr) | ((uint64_t)(op) << 56))
+#define URING_PTR(data) ((void *)(uintptr_t)((data) & ((1ULL << 56) - 1)))
+#define URING_OP(data) ((enum uring_op)((data) >> 56))
+
+struct uring {
+  int fd;
+  unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+  unsigned sq_entries, sq_local_tail;
+  struct io_uring_sqe *sqes;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+  struct io_uring_cqe *cqes;
+  void *sq_ptr, *cq_ptr;
+  size_t sq_size, cq_size, sqes_size;
+};
+
+struct uring_reactor;
+
+struct uring_conn {
+  int fd;
+  struct uring_reactor *u;
+  struct uring_conn *prev, *next;
+
+  /* Splits received buffers into messages */
+  mjrpc_framer_t *framer;
+
+  /* Output of the current send chain: registered slot, then heap spill */
+  char *slot;
+  int slot_index;
+  size_t slot_len, slot_off;
+  char *spill;
+  size_t spill_len, spill_off, spill_cap;
+
+  /* Output produced while a chain is in flight */
+  char *next_out;
+  size_t next_len, next_cap;
+
+  int sends; /* send operations of the current chain in flight */
+  int ops;   /* all operations in flight, including the receive */
+  bool send_failed, eof, closing;
+};
+
+struct uring_reactor {
+  struct reactor *base;
+  struct uring ring;
+
+  struct io_uring_buf_ring *buf_ring;
+  size_t buf_ring_size;
+  uint16_t buf_tail;
+  char *recv_bufs;
+  size_t buf_size;
+
+  /* Registered send arena, NULL if registration was refused */
+  char *send_arena;
+  int free_slots[URING_SEND_SLOTS];
+  int free_slot_count;
+
+  struct uring_conn *conns;
+  uint64_t wakeup_value;
+  unsigned inflight; /* terminal completions still expected */
+  bool stopping;
+};
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *p) {
+  return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                              unsigned flags) {
+  return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                      NULL, 0);
+}
+
+static int sys_io_uring_register(int fd, unsigned opcode, void *arg,
+                                 unsigned nr_args) {
+  return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static void uring_exit(struct uring *ring) {
+  if (ring->sqes != NULL && ring->sqes != MAP_FAILED)
+    munmap(ring->sqes, ring->sqes_size);
+  if (ring->cq_ptr != NULL && ring->cq_ptr != MAP_FAILED &&
+      ring->cq_ptr != ring->sq_ptr)
+    munmap(ring->cq_ptr, ring->cq_size);
+  if (ring->sq_ptr != NULL && ring->sq_ptr != MAP_FAILED)
+    munmap(ring->sq_ptr, ring->sq_size);
+  if (ring->fd >= 0)
+    close(ring->fd);
+  memset(ring, 0, sizeof(*ring));
+  ring->fd = -1;
+}
+
+static bool uring_init(struct uring *ring, unsigned entries) {
+  memset(ring, 0, sizeof(*ring));
+  struct io_uring_params p = {0};
+  /* Completions are only reaped by this thread: let the kernel defer task
+   * work until we wait, if it knows how */
+  p.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+  ring->fd = sys_io_uring_setup(entries, &p);
+  if (ring->fd < 0 && errno == EINVAL) {
+    memset(&p, 0, sizeof(p));
+    ring->fd = sys_io_uring_setup(entries, &p);
+  }
+  if (ring->fd < 0)
+    return false;
+
+  ring->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  ring->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    if (ring->cq_size > ring->sq_size)
+      ring->sq_size = ring->cq_size;
+    ring->cq_size = ring->sq_size;
+  }
+  ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  if (ring->sq_ptr == MAP_FAILED)
+    goto fail;
+  if (p.features & IORING_FEAT_SINGLE_MMAP)
+    ring->cq_ptr = ring->sq_ptr;
+  else
+    ring->cq_ptr =
+        mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+  if (ring->cq_ptr == MAP_FAILED)
+    goto fail;
+  ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  if (ring->sqes == MAP_FAILED)
+    goto fail;
+
+  char *sq = ring->sq_ptr, *cq = ring->cq_ptr;
+  ring->sq_head = (unsigned *)(sq + p.sq_off.head);
+  ring->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+  ring->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+  ring->sq_array = (unsigned *)(sq + p.sq_off.array);
+  ring->sq_entries = p.sq_entries;
+  ring->sq_local_tail = *ring->sq_tail;
+  ring->cq_head = (unsigned *)(cq + p.cq_off.head);
+  ring->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+  ring->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+  return true;
+
+fail:
+  uring_exit(ring);
+  return false;
+}
+
+/**
+ * @brief Publish queued entries and optionally wait for one completion
+ */
+static void uring_submit(struct uring *ring, bool wait) {
+  __atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+  unsigned to_submit =
+      ring->sq_local_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+  if (to_submit == 0 && !wait)
+    return;
+  (void)sys_io_uring_enter(ring->fd, to_submit, wait ? 1 : 0,
+                           wait ? IORING_ENTER_GETEVENTS : 0);
+}
+
+/**
+ * @brief Make room for @p n entries that must go into the same submission
+ */
+static bool uring_reserve(struct uring *ring, unsigned n) {
+  unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+  if (ring->sq_local_tail - head + n <= ring->sq_entries)
+    return true;
+  uring_submit(ring, false);
+  head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+  return ring->sq_local_tail - head + n <= ring->sq_entries;
+}
+
+static struct io_uring_sqe *uring_sqe(struct uring *ring) {
+  if (!uring_reserve(ring, 1))
+    return NULL;
+  unsigned index = ring->sq_local_tail & *ring->sq_mask;
+  struct io_uring_sqe *sqe = &ring->sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  ring->sq_array[index] = index;
+  ring->sq_local_tail++;
+  return sqe;
+}
+
+/**
+ * @brief Check that the kernel has every feature the backend relies on
+ */
+static bool uring_probe(void) {
+  struct uring ring;
+  if (!uring_init(&ring, 8))
+    return false;
+
+  size_t size = sizeof(struct io_uring_probe) +
+                256 * sizeof(struct io_uring_probe_op);
+  struct io_uring_probe *probe = calloc(1, size);
+  bool ok = probe != NULL &&
+            sys_io_uring_register(ring.fd, IORING_REGISTER_PROBE, probe, 256) ==
+                0;
+  /* IORING_OP_SEND_ZC arrived in 6.0 together with multishot receive */
+  static const int needed[] = {IORING_OP_ACCEPT,     IORING_OP_RECV,
+                               IORING_OP_SEND,       IORING_OP_WRITE_FIXED,
+                               IORING_OP_READ,       IORING_OP_ASYNC_CANCEL,
+                               IORING_OP_SEND_ZC};
+  for (size_t i = 0; ok && i < sizeof(needed) / sizeof(needed[0]); i++)
+    ok = needed[i] <= probe->last_op &&
+         (probe->ops[needed[i]].flags & IO_URING_OP_SUPPORTED);
+  free(probe);
+  uring_exit(&ring);
+  return ok;
+}
+
+static void uring_recycle(struct uring_reactor *u, uint16_t bid) {
+  struct io_uring_buf *buf =
+      &u->buf_ring->bufs[u->buf_tail & (URING_RECV_BUFFERS - 1)];
+  buf->addr = (uint64_t)(uintptr_t)(u->recv_bufs + (size_t)bid * u->buf_size);
+  buf->len = (uint32_t)u->buf_size;
+  buf->bid = bid;
+  u->buf_tail++;
+  __atomic_store_n(&u->buf_ring->tail, u->buf_tail, __ATOMIC_RELEASE);
+}
+
+static void uring_arm_recv(struct uring_conn *c) {
+  struct io_uring_sqe *sqe = uring_sqe(&c->u->ring);
+  if (sqe == NULL)
+    return;
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = c->fd;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = URING_BGID;
+  sqe->user_data = URING_TAG(c, OP_RECV);
+  c->ops++;
+  c->u->inflight++;
+}
+
+static void uring_arm_accept(struct uring_reactor *u, struct listener *l) {
+  struct io_uring_sqe *sqe = uring_sqe(&u->ring);
+  if (sqe == NULL)
+    return;
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = l->fd;
+  sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+  sqe->accept_flags = SOCK_CLOEXEC;
+  sqe->user_data = URING_TAG(l, OP_ACCEPT);
+  u->inflight++;
+}
+
+static void uring_arm_wakeup(struct uring_reactor *u) {
+  struct io_uring_sqe *sqe = uring_sqe(&u->ring);
+  if (sqe == NULL)
+    return;
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = u->base->wakeup.fd;
+  sqe->addr = (uint64_t)(uintptr_t)&u->wakeup_value;
+  sqe->len = sizeof(u->wakeup_value);
+  sqe->user_data = URING_TAG(u, OP_WAKEUP);
+  u->inflight++;
+}
+
+static void uring_conn_free(struct uring_conn *c) {
+  struct uring_reactor *u = c->u;
+  if (c->prev)
+    c->prev->next = c->next;
+  else
+    u->conns = c->next;
+  if (c->next)
+    c->next->prev = c->prev;
+  if (c->slot != NULL)
+    u->free_slots[u->free_slot_count++] = c->slot_index;
+  close(c->fd);
+  mjrpc_framer_destroy(c->framer);
+  free(c->spill);
+  free(c->next_out);
+  free(c);
+}
+
+/**
+ * @brief Start closing a connection
+ *
+ * Shutting the socket down makes its pending operations complete; the
+ * connection is released with the last of them.
+ */
+static void uring_conn_close(struct uring_conn *c) {
+  if (!c->closing) {
+    c->closing = true;
+    shutdown(c->fd, SHUT_RDWR);
+  }
+  if (c->ops == 0)
+    uring_conn_free(c);
+}
+
+static bool grow_append(char **buf, size_t *len, size_t *cap, const char *data,
+                        size_t n, size_t initial) {
+  if (*len + n > *cap) {
+    size_t new_cap = *cap ? *cap : initial;
+    while (new_cap < *len + n)
+      new_cap *= 2;
+    char *grown = realloc(*buf, new_cap);
+    if (grown == NULL)
+      return false;
+    *buf = grown;
+    *cap = new_cap;
+  }
+  memcpy(*buf + *len, data, n);
+  *len += n;
+  return true;
+}
+
+/**
+ * @brief Stage output bytes for the next send chain
+ * @return false if memory ran out
+ */
+static bool uring_stage(struct uring_conn *c, const char *data, size_t len) {
+  size_t initial = c->u->buf_size;
+  if (len == 0)
+    return true;
+  if (c->sends > 0)
+    return grow_append(&c->next_out, &c->next_len, &c->next_cap, data, len,
+                       initial);
+  if (c->slot != NULL && c->spill_len == 0) {
+    size_t room = c->u->buf_size - c->slot_len;
+    size_t n = len < room ? len : room;
+    memcpy(c->slot + c->slot_len, data, n);
+    c->slot_len += n;
+    data += n;
+    len -= n;
+  }
+  return len == 0 ||
+         grow_append(&c->spill, &c->spill_len, &c->spill_cap, data, len,
+                     initial);
+}
+
+/**
+ * @brief Send whatever is staged as one linked chain
+ *
+ * The registered slot goes out with IORING_OP_WRITE_FIXED, linked to a plain
+ * send of the heap spill so both arrive in order.
+ */
+static void uring_flush(struct uring_conn *c) {
+  if (c->sends > 0 || c->closing)
+    return;
+  size_t fixed = c->slot_len - c->slot_off;
+  size_t heap = c->spill_len - c->spill_off;
+  if (fixed == 0 && heap == 0)
+    return;
+  struct uring *ring = &c->u->ring;
+  if (!uring_reserve(ring, (fixed > 0) + (heap > 0))) {
+    uring_conn_close(c);
+    return;
+  }
+
+  if (fixed > 0) {
+    struct io_uring_sqe *sqe = uring_sqe(ring);
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->fd = c->fd;
+    sqe->addr = (uint64_t)(uintptr_t)(c->slot + c->slot_off);
+    sqe->len = (uint32_t)fixed;
+    sqe->buf_index = 0;
+    sqe->flags = heap > 0 ? IOSQE_IO_LINK : 0;
+    sqe->user_data = URING_TAG(c, OP_SEND_FIXED);
+    c->sends++;
+  }
+  if (heap > 0) {
+    struct io_uring_sqe *sqe = uring_sqe(ring);
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = c->fd;
+    sqe->addr = (uint64_t)(uintptr_t)(c->spill + c->spill_off);
+    sqe->len = (uint32_t)heap;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = URING_TAG(c, OP_SEND);
+    c->sends++;
+  }
+  c->ops += c->sends;
+  c->u->inflight += (unsigned)c->sends;
+}
+
+static void uring_send_done(struct uring_conn *c, enum uring_op op, int res) {
+  c->sends--;
+  c->ops--;
+  c->u->inflight--;
+  if (res > 0) {
+    if (op == OP_SEND_FIXED)
+      c->slot_off += (size_t)res;
+    else
+      c->spill_off += (size_t)res;
+  } else if (res != -ECANCELED) {
+    /* A short first send cancels the linked one; only real errors count */
+    c->send_failed = true;
+  }
+  if (c->sends > 0)
+    return;
+
+  if (c->send_failed || c->closing) {
+    uring_conn_close(c);
+    return;
+  }
+  if (c->slot_off < c->slot_len || c->spill_off < c->spill_len) {
+    uring_flush(c);
+    return;
+  }
+
+  c->slot_len = c->slot_off = 0;
+  c->spill_len = c->spill_off = 0;
+  if (c->next_len > 0) {
+    size_t len = c->next_len;
+    c->next_len = 0;
+    if (!uring_stage(c, c->next_out, len)) {
+      uring_conn_close(c);
+      return;
+    }
+  }
+  uring_flush(c);
+  if (c->eof && c->sends == 0)
+    uring_conn_close(c);
+}
+
+static bool uring_dispatch(struct uring_conn *c, const char *message,
+                           size_t len) {
+  const struct mjrpc_server *server = c->u->base->server;
+  /* The message lies in a ring buffer or the framer's buffer, both ours */
+  char *response =
+      mjrpc_process_buf_insitu(server->handle, (char *)message, len, NULL);
+  if (response == NULL)
+    return true;
+  enum mjrpc_framing framing = server->config.framing;
+  size_t response_len = strlen(response);
+  char header[MJRPC_FRAME_HEADER_MAX];
+  size_t header_len;
+  if (mjrpc_frame_header(framing, response_len, header, &header_len) !=
+      MJRPC_RET_OK) {
+    cJSON_free(response);
+    return false;
+  }
+  size_t trailer_len;
+  const char *trailer = mjrpc_frame_trailer(framing, &trailer_len);
+  bool ok = uring_stage(c, header, header_len) &&
+            uring_stage(c, response, response_len) &&
+            uring_stage(c, trailer, trailer_len);
+  cJSON_free(response);
+  return ok;
+}
+
+/**
+ * @brief Dispatch the complete messages of one receive buffer
+ *
+ * Messages wholly inside the buffer are parsed where the kernel put them;
+ * the framer copies only a message spanning buffers.
+ *
+ * @return false if the connection must be closed
+ */
+static bool uring_consume(struct uring_conn *c, const char *data, size_t len) {
+  if (mjrpc_framer_feed(c->framer, data, len) != MJRPC_RET_OK)
+    return false;
+  const char *message;
+  size_t message_len;
+  while (mjrpc_framer_next(c->framer, &message, &message_len))
+    if (!uring_dispatch(c, message, message_len))
+      return false;
+  return mjrpc_framer_error(c->framer) == MJRPC_RET_OK;
+}
+
+static void uring_on_recv(struct uring_conn *c, const struct io_uring_cqe *cqe) {
+  bool more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+  if (!more) {
+    c->ops--;
+    c->u->inflight--;
+  }
+
+  if (cqe->res > 0 && (cqe->flags & IORING_CQE_F_BUFFER)) {
+    uint16_t bid = (uint16_t)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+    const char *data = c->u->recv_bufs + (size_t)bid * c->u->buf_size;
+    bool ok = c->closing || uring_consume(c, data, (size_t)cqe->res);
+    uring_recycle(c->u, bid);
+    if (!ok) {
+      uring_conn_close(c);
+      return;
+    }
+    if (!c->closing) {
+      uring_flush(c);
+      if (!more)
+        uring_arm_recv(c);
+    }
+  } else if (cqe->res == -ENOBUFS && !c->closing) {
+    uring_arm_recv(c); /* buffers ran out, they are back by now */
+  } else if (cqe->res == 0 && !c->closing) {
+    c->eof = true;
+    if (c->sends == 0)
+      uring_conn_close(c);
+    return;
+  } else {
+    uring_conn_close(c);
+    return;
+  }
+  if (c->closing && c->ops == 0)
+    uring_conn_free(c);
+}
+
+static void uring_on_accept(struct uring_reactor *u, struct listener *l,
+                            const struct io_uring_cqe *cqe) {
+  if (!(cqe->flags & IORING_CQE_F_MORE)) {
+    u->inflight--;
+    if (!u->stopping)
+      uring_arm_accept(u, l);
+  }
+  if (cqe->res < 0)
+    return;
+
+  int fd = cqe->res;
+  const mjrpc_server_config_t *config = &u->base->server->config;
+  struct uring_conn *c = u->stopping ? NULL : calloc(1, sizeof(*c));
+  mjrpc_framer_t *framer =
+      c ? mjrpc_framer_create(config->framing, config->max_message_size)
+        : NULL;
+  if (framer == NULL) {
+    free(c);
+    close(fd);
+    return;
+  }
+  c->framer = framer;
+  int one = 1;
+  (void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  c->fd = fd;
+  c->u = u;
+  if (u->send_arena != NULL && u->free_slot_count > 0) {
+    c->slot_index = u->free_slots[--u->free_slot_count];
+    c->slot = u->send_arena + (size_t)c->slot_index * u->buf_size;
+  }
+  c->next = u->conns;
+  if (u->conns)
+    u->conns->prev = c;
+  u->conns = c;
+  uring_arm_recv(c);
+}
+
+static void uring_on_wakeup(struct uring_reactor *u) {
+  u->inflight--;
+  u->stopping = true;
+  struct io_uring_sqe *sqe = uring_sqe(&u->ring);
+  if (sqe != NULL) {
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+    sqe->user_data = URING_TAG(u, OP_CANCEL);
+    u->inflight++;
+  }
+  struct uring_conn *c = u->conns;
+  while (c != NULL) {
+    struct uring_conn *next = c->next;
+    uring_conn_close(c);
+    c = next;
+  }
+}
+
+static void uring_reactor_free(struct uring_reactor *u) {
+  while (u->conns)
+    uring_conn_free(u->conns);
+  uring_exit(&u->ring);
+  if (u->buf_ring != NULL && u->buf_ring != MAP_FAILED)
+    munmap(u->buf_ring, u->buf_ring_size);
+  free(u->recv_bufs);
+  free(u->send_arena);
+  free(u);
+}
+
+static struct uring_reactor *uring_reactor_new(struct reactor *r) {
+  struct uring_reactor *u = calloc(1, sizeof(*u));
+  if (u == NULL)
+    return NULL;
+  u->base = r;
+  u->buf_size = r->server->config.buffer_size;
+  if (!uring_init(&u->ring, URING_ENTRIES)) {
+    free(u);
+    return NULL;
+  }
+
+  /* Provided buffer ring for multishot receive */
+  u->buf_ring_size = URING_RECV_BUFFERS * sizeof(struct io_uring_buf);
+  u->buf_ring = mmap(NULL, u->buf_ring_size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  u->recv_bufs = malloc(URING_RECV_BUFFERS * u->buf_size);
+  struct io_uring_buf_reg reg = {0};
+  reg.ring_addr = (uint64_t)(uintptr_t)u->buf_ring;
+  reg.ring_entries = URING_RECV_BUFFERS;
+  reg.bgid = URING_BGID;
+  if (u->buf_ring == MAP_FAILED || u->recv_bufs == NULL ||
+      sys_io_uring_register(u->ring.fd, IORING_REGISTER_PBUF_RING, &reg, 1) <
+          0) {
+    uring_reactor_free(u);
+    return NULL;
+  }
+  for (uint16_t bid = 0; bid < URING_RECV_BUFFERS; bid++)
+    uring_recycle(u, bid);
+
+  /* Registered send slots; without them every send uses the heap path */
+  u->send_arena = malloc(URING_SEND_SLOTS * u->buf_size);
+  struct iovec arena = {u->send_arena, URING_SEND_SLOTS * u->buf_size};
+  if (u->send_arena != NULL &&
+      sys_io_uring_register(u->ring.fd, IORING_REGISTER_BUFFERS, &arena, 1) ==
+          0) {
+    for (int i = 0; i < URING_SEND_SLOTS; i++)
+      u->free_slots[i] = URING_SEND_SLOTS - 1 - i;
+    u->free_slot_count = URING_SEND_SLOTS;
+  } else {
+    free(u->send_arena);
+    u->send_arena = NULL;
+  }
+  return u;
+}
+
+/**
+ * @brief Run a reactor on io_uring until it is stopped
+ * @return false if the ring could not be set up (nothing was started)
+ */
+static bool uring_reactor_run(struct reactor *r) {
+  struct uring_reactor *u = uring_reactor_new(r);
+  if (u == NULL)
+    return false;
+
+  uring_arm_wakeup(u);
+  if (r->tcp.fd >= 0)
+    uring_arm_accept(u, &r->tcp);
+  if (r->server->unix_listener.fd >= 0)
+    uring_arm_accept(u, &r->server->unix_listener);
+
+  while (!u->stopping || u->inflight > 0) {
+    uring_submit(&u->ring, true);
+    for (;;) {
+      unsigned head = *u->ring.cq_head;
+      if (head == __atomic_load_n(u->ring.cq_tail, __ATOMIC_ACQUIRE))
+        break;
+      struct io_uring_cqe cqe = u->ring.cqes[head & *u->ring.cq_mask];
+      __atomic_store_n(u->ring.cq_head, head + 1, __ATOMIC_RELEASE);
+
+      void *target = URING_PTR(cqe.user_data);
+      switch (URING_OP(cqe.user_data)) {
+      case OP_ACCEPT:
+        uring_on_accept(u, target, &cqe);
+        break;
+      case OP_RECV:
+        uring_on_recv(target, &cqe);
+        break;
+      case OP_SEND_FIXED:
+      case OP_SEND:
+        uring_send_done(target, URING_OP(cqe.user_data), cqe.res);
+        break;
+      case OP_WAKEUP:
+        uring_on_wakeup(u);
+        break;
+      case OP_CANCEL:
+        u->inflight--;
+        break;
+      }
+    }
+  }
+
+  uring_reactor_free(u);
+  return true;
+}
+
+#endif /* MJRPC_SERVER_IO_URING */
+
+static void *reactor_thread(void *arg) {
+  struct reactor *r = arg;
+#ifdef MJRPC_SERVER_IO_URING
+  if (r->server->backend == MJRPC_SERVER_BACKEND_IO_URING &&
+      uring_reactor_run(r))
+    return NULL;
+#endif
+  return reactor_main(r);
+}
+
+/*--- listeners ---*/
+
+static int listen_tcp(const mjrpc_server_config_t *config, uint16_t port,
+                      bool reuse_port) {
+  char service[8];
+  snprintf(service, sizeof(service), "%u", (unsigned)port);
+  struct addrinfo hints = {0};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+  struct addrinfo *info = NULL;
+  if (getaddrinfo(config->tcp_host, service, &hints, &info) != 0)
+    return -1;
+
+  int fd = socket(info->ai_family,
+                  info->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                  info->ai_protocol);
+  if (fd >= 0) {
+    int one = 1;
+    (void)setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if ((reuse_port &&
+         setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0) ||
+        bind(fd, info->ai_addr, info->ai_addrlen) < 0 ||
+        listen(fd, config->backlog) < 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(info);
+  return fd;
+}
+
+static int listen_unix(const mjrpc_server_config_t *config) {
+  struct sockaddr_un addr = {0};
+  addr.sun_family = AF_UNIX;
+  if (strlen(config->unix_path) >= sizeof(addr.sun_path))
+    return -1;
+  strcpy(addr.sun_path, config->unix_path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+    return -1;
+  unlink(config->unix_path);
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      listen(fd, config->backlog) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static uint16_t bound_port(int fd) {
+  struct sockaddr_storage addr;
+  socklen_t len = sizeof(addr);
+  if (getsockname(fd, (struct sockaddr *)&addr, &len) < 0)
+    return 0;
+  if (addr.ss_family == AF_INET)
+    return ntohs(((struct sockaddr_in *)&addr)->sin_port);
+  if (addr.ss_family == AF_INET6)
+    return ntohs(((struct sockaddr_in6 *)&addr)->sin6_port);
+  return 0;
+}
+
+static bool epoll_watch(int epfd, int fd, uint32_t events, void *ptr) {
+  struct epoll_event ev = {0};
+  ev.events = events;
+  ev.data.ptr = ptr;
+  return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+static bool reactor_init(struct mjrpc_server *server, struct reactor *r,
+                         bool reuse_port) {
+  r->server = server;
+  r->tcp.kind = EP_LISTENER;
+  r->wakeup.kind = EP_WAKEUP;
+  r->epfd = epoll_create1(EPOLL_CLOEXEC);
+  r->wakeup.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (r->epfd < 0 || r->wakeup.fd < 0 ||
+      !epoll_watch(r->epfd, r->wakeup.fd, EPOLLIN, &r->wakeup))
+    return false;
+
+  if (server->config.tcp_host != NULL) {
+    r->tcp.fd = listen_tcp(&server->config, server->tcp_port, reuse_port);
+    if (r->tcp.fd < 0 || !epoll_watch(r->epfd, r->tcp.fd, EPOLLIN, &r->tcp))
+      return false;
+    if (server->tcp_port == 0)
+      server->tcp_port = bound_port(r->tcp.fd);
+  }
+  if (server->unix_listener.fd >= 0 &&
+      !epoll_watch(r->epfd, server->unix_listener.fd, EPOLLIN | EPOLLEXCLUSIVE,
+                   &server->unix_listener))
+    return false;
+  return true;
+}
+
+/*--- public API ---*/
+
+void mjrpc_server_config_init(mjrpc_server_config_t *config) {
+  if (config == NULL)
+    return;
+  memset(config, 0, sizeof(*config));
+  config->reactors = 1;
+  config->backlog = 128;
+  config->buffer_size = 16 * 1024;
+  config->max_message_size = 16 * 1024 * 1024;
+}
+
+mjrpc_server_t *mjrpc_server_create(const mjrpc_handle_t *handle,
+                                    const mjrpc_server_config_t *config) {
+  if (handle == NULL || config == NULL ||
+      (config->tcp_host == NULL && config->unix_path == NULL) ||
+      config->framing > MJRPC_FRAMING_LENGTH_PREFIX)
+    return NULL;
+
+  mjrpc_server_t *server = calloc(1, sizeof(mjrpc_server_t));
+  if (server == NULL)
+    return NULL;
+  server->handle = handle;
+  server->config = *config;
+  server->tcp_port = config->tcp_port;
+  server->unix_listener.kind = EP_LISTENER;
+  server->unix_listener.fd = -1;
+  if (server->config.buffer_size < SERVER_MIN_READ * 2)
+    server->config.buffer_size = SERVER_MIN_READ * 2;
+  server->backend = MJRPC_SERVER_BACKEND_EPOLL;
+#ifdef MJRPC_SERVER_IO_URING
+  if (config->backend == MJRPC_SERVER_BACKEND_IO_URING && uring_probe())
+    server->backend = MJRPC_SERVER_BACKEND_IO_URING;
+#endif
+
+  int count = config->reactors;
+  if (count <= 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    count = cpus > 0 ? (int)cpus : 1;
+  }
+
+  bool ok = true;
+  if (config->tcp_host != NULL) {
+    server->tcp_host = strdup(config->tcp_host);
+    server->config.tcp_host = server->tcp_host;
+    ok = server->tcp_host != NULL;
+  }
+  if (ok && config->unix_path != NULL) {
+    server->unix_path = strdup(config->unix_path);
+    server->config.unix_path = server->unix_path;
+    ok = server->unix_path != NULL &&
+         (server->unix_listener.fd = listen_unix(&server->config)) >= 0;
+  }
+
+  server->reactors = ok ? calloc((size_t)count, sizeof(struct reactor)) : NULL;
+  if (server->reactors != NULL) {
+    for (int i = 0; i < count; i++) {
+      server->reactors[i].epfd = -1;
+      server->reactors[i].tcp.fd = -1;
+      server->reactors[i].wakeup.fd = -1;
+    }
+    server->reactor_count = count;
+    for (int i = 0; ok && i < count; i++)
+      ok = reactor_init(server, &server->reactors[i], count > 1);
+  }
+
+  if (!ok || server->reactors == NULL) {
+    mjrpc_server_destroy(server);
+    return NULL;
+  }
+  return server;
+}
+
+int mjrpc_server_start(mjrpc_server_t *server) {
+  if (server == NULL || server->running)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+
+  /* Reactor threads inherit a blocked SIGPIPE: a peer closing early must
+   * not kill the process, and io_uring writes cannot pass MSG_NOSIGNAL */
+  sigset_t pipe_set, old_set;
+  sigemptyset(&pipe_set);
+  sigaddset(&pipe_set, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &pipe_set, &old_set);
+
+  int started = 0;
+  while (started < server->reactor_count &&
+         pthread_create(&server->reactors[started].thread, NULL,
+                        reactor_thread, &server->reactors[started]) == 0)
+    started++;
+  pthread_sigmask(SIG_SETMASK, &old_set, NULL);
+
+  if (started < server->reactor_count) {
+    for (int j = 0; j < started; j++) {
+      uint64_t one = 1;
+      (void)!write(server->reactors[j].wakeup.fd, &one, sizeof(one));
+      pthread_join(server->reactors[j].thread, NULL);
+    }
+    return MJRPC_RET_ERROR_SYSTEM;
+  }
+  server->running = true;
+  return MJRPC_RET_OK;
+}
+
+int mjrpc_server_stop(mjrpc_server_t *server) {
+  if (server == NULL || !server->running)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+
+  for (int i = 0; i < server->reactor_count; i++) {
+    uint64_t one = 1;
+    (void)!write(server->reactors[i].wakeup.fd, &one, sizeof(one));
+  }
+  for (int i = 0; i < server->reactor_count; i++) {
+    struct reactor *r = &server->reactors[i];
+    pthread_join(r->thread, NULL);
+    uint64_t value;
+    (void)!read(r->wakeup.fd, &value, sizeof(value));
+  }
+  server->running = false;
+  return MJRPC_RET_OK;
+}
+
+void mjrpc_server_destroy(mjrpc_server_t *server) {
+  if (server == NULL)
+    return;
+  if (server->running)
+    mjrpc_server_stop(server);
+
+  for (int i = 0; i < server->reactor_count; i++) {
+    struct reactor *r = &server->reactors[i];
+    if (r->tcp.fd >= 0)
+      close(r->tcp.fd);
+    if (r->wakeup.fd >= 0)
+      close(r->wakeup.fd);
+    if (r->epfd >= 0)
+      close(r->epfd);
+  }
+  free(server->reactors);
+  if (server->unix_listener.fd >= 0) {
+    close(server->unix_listener.fd);
+    unlink(server->unix_path);
+  }
+  free(server->tcp_host);
+  free(server->unix_path);
+  free(server);
+}
+
+uint16_t mjrpc_server_tcp_port(const mjrpc_server_t *server) {
+  if (server == NULL || server->config.tcp_host == NULL)
+    return 0;
+  return server->tcp_port;
+}
+
+enum mjrpc_server_backend
+mjrpc_server_get_backend(const mjrpc_server_t *server) {
+  if (server == NULL)
+    return MJRPC_SERVER_BACKEND_EPOLL;
+  return server->backend;
+}
@@ -0,0 +1,185 @@
+/**
+ * @file mjsonrpc_server.h
+ * @brief Optional socket transport serving an mjrpc_handle_t over TCP and
+ *        Unix domain sockets
+ * @author Xiao
+ * @date 2026
+ * @version 3.0.0
+ *
+ * @details
+ * Each reactor thread runs an event loop over its listening sockets and
+ * connections. Incoming bytes are split into messages by a framer (see
+ * mjsonrpc_framer.h), newline-delimited by default; every complete message
+ * is dispatched in place through mjrpc_process_buf() and the response (if
+ * any) is written back with the same framing.
+ *
+ * Two backends are available:
+ * - epoll (default): edge-triggered readiness with per-connection read and
+ *   write buffers reused for the lifetime of the connection; the responses
+ *   produced by one read go out in a single vectored send.
+ * - io_uring: multishot accept and receive into a provided buffer ring, so
+ *   requests are parsed straight from kernel-filled buffers; responses are
+ *   staged in registered (fixed) buffers and sent as linked operations. It
+ *   falls back to epoll when the kernel lacks the needed features.
+ *
+ * With more than one reactor, every reactor binds its own TCP socket with
+ * SO_REUSEPORT so the kernel spreads connections across them; a Unix socket
+ * listener is shared and woken exclusively.
+ *
+ * Requests are answered synchronously on the reactor thread, so methods
+ * registered with mjrpc_add_async_method() are answered with an error.
+ *
+ * @par Example:
+ * @code
+ * mjrpc_server_config_t config;
+ * mjrpc_server_config_init(&config);
+ * config.tcp_host = "127.0.0.1";
+ * config.tcp_port = 4000;
+ * config.reactors = 0; // one per CPU
+ *
+ * mjrpc_server_t *server = mjrpc_server_create(handle, &config);
+ * mjrpc_server_start(server);
+ * ...
+ * mjrpc_server_destroy(server);
+ * @endcode
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2026 Xiao
+ */
+
+#ifndef MJSONRPC_SERVER_H_
+#define MJSONRPC_SERVER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mjsonrpc.h"
+#include "mjsonrpc_framer.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Opaque server instance
+ */
+typedef struct mjrpc_server mjrpc_server_t;
+
+/**
+ * @enum mjrpc_server_backend
+ * @brief I/O backend of the reactor threads
+ */
+enum mjrpc_server_backend {
+  /** @brief Edge-triggered epoll */
+  MJRPC_SERVER_BACKEND_EPOLL,
+
+  /** @brief io_uring (Linux 6.0+), falls back to epoll if unavailable */
+  MJRPC_SERVER_BACKEND_IO_URING
+};
+
+/**
+ * @struct mjrpc_server_config_t
+ * @brief Server settings, initialize with mjrpc_server_config_init()
+ */
+typedef struct {
+  /** @brief Address to listen on for TCP, NULL disables TCP */
+  const char *tcp_host;
+  /** @brief TCP port, 0 picks a free one (see mjrpc_server_tcp_port()) */
+  uint16_t tcp_port;
+  /** @brief Path of a Unix domain socket, NULL disables it */
+  const char *unix_path;
+  /** @brief Number of reactor threads, 0 for one per online CPU */
+  int reactors;
+  /** @brief Listen backlog */
+  int backlog;
+  /** @brief Initial size of the per-connection buffers */
+  size_t buffer_size;
+  /** @brief Connections sending a longer message are closed */
+  size_t max_message_size;
+  /** @brief Requested I/O backend */
+  enum mjrpc_server_backend backend;
+  /** @brief Message framing of requests and responses */
+  enum mjrpc_framing framing;
+} mjrpc_server_config_t;
+
+/**
+ * @brief Fill a configuration with defaults
+ *
+ * Defaults: no listeners, one reactor, backlog 128, 16 KiB buffers,
+ * 16 MiB maximum message size, the epoll backend and newline-delimited
+ * framing.
+ *
+ * @param config Configuration to initialize
+ */
+void mjrpc_server_config_init(mjrpc_server_config_t *config);
+
+/**
+ * @brief Create a server and bind its listening sockets
+ *
+ * @param handle Handle used to process requests; must outlive the server and
+ *               must not be modified while the server is running
+ * @param config Server settings (copied)
+ * @return New server, or NULL if no listener was configured, the framing is
+ *         unknown or binding failed
+ */
+mjrpc_server_t *mjrpc_server_create(const mjrpc_handle_t *handle,
+                                    const mjrpc_server_config_t *config);
+
+/**
+ * @brief Start the reactor threads
+ *
+ * @param server Server instance
+ * @return Return code
+ * @retval MJRPC_RET_OK On success
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If the server is NULL or running
+ * @retval MJRPC_RET_ERROR_SYSTEM If a thread could not be started
+ */
+int mjrpc_server_start(mjrpc_server_t *server);
+
+/**
+ * @brief Stop the reactor threads and close all connections
+ *
+ * Listening sockets stay bound, so the server can be started again.
+ *
+ * @param server Server instance
+ * @return Return code
+ * @retval MJRPC_RET_OK On success
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If the server is NULL or not running
+ */
+int mjrpc_server_stop(mjrpc_server_t *server);
+
+/**
+ * @brief Stop the server if needed and release it
+ *
+ * Closes the listening sockets and removes the Unix socket file.
+ *
+ * @param server Server instance (may be NULL)
+ */
+void mjrpc_server_destroy(mjrpc_server_t *server);
+
+/**
+ * @brief Get the bound TCP port
+ *
+ * @param server Server instance
+ * @return Port in host byte order, or 0 if TCP is disabled
+ */
+uint16_t mjrpc_server_tcp_port(const mjrpc_server_t *server);
+
+/**
+ * @brief Get the backend the server actually uses
+ *
+ * Differs from the requested one when io_uring is not compiled in or not
+ * supported by the running kernel.
+ *
+ * @param server Server instance
+ * @return Active backend
+ */
+enum mjrpc_server_backend
+mjrpc_server_get_backend(const mjrpc_server_t *server);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MJSONRPC_SERVER_H_
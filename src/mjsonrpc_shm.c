@@ -0,0 +1,505 @@
+/*
+    MIT License
+
+    Copyright (c) 2026 Xiao
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+ */
+
+#include "mjsonrpc_shm.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/** @brief Identifies a mapping as an mjsonrpc channel ("MJSH") */
+#define SHM_MAGIC 0x4d4a5348u
+
+/** @brief Layout version of the mapping */
+#define SHM_VERSION 1u
+
+/** @brief Smallest ring size */
+#define SHM_MIN_CAPACITY 4096
+
+/** @brief Polls of an empty or full ring before sleeping (multi-core only) */
+#define SHM_SPIN_LIMIT 4096
+
+/** @brief Record length marking the unused end of the ring */
+#define SHM_WRAP UINT32_MAX
+
+/** @brief Records start on this boundary */
+#define SHM_ALIGN 8
+
+#define SHM_CACHE_LINE 64
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define cpu_relax() __asm__ __volatile__("yield")
+#else
+#define cpu_relax() ((void)0)
+#endif
+
+/*
+ * One direction of the channel. Positions count bytes since creation; the
+ * offset in the ring is the position modulo the capacity. Each record is a
+ * 32-bit length followed by the message, padded to SHM_ALIGN, and never
+ * wraps: a record that does not fit before the end is preceded by a
+ * SHM_WRAP marker covering the rest of the ring, which the consumer skips
+ * on its own.
+ *
+ * A side that finds nothing to do registers in a waiter count and sleeps on
+ * the matching sequence word; the other side bumps the word after moving its
+ * position and calls futex_wake() only if someone is registered.
+ */
+struct shm_ring {
+  /* Written by the consumer */
+  _Alignas(SHM_CACHE_LINE) _Atomic uint64_t head;
+  _Atomic uint32_t space_seq;
+  _Atomic uint32_t space_waiters;
+
+  /* Written by the producer */
+  _Alignas(SHM_CACHE_LINE) _Atomic uint64_t tail;
+  _Atomic uint32_t data_seq;
+  _Atomic uint32_t data_waiters;
+};
+
+struct shm_header {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t capacity;
+  _Atomic uint32_t closed;
+  /* Requests (client to server), then responses */
+  struct shm_ring rings[2];
+};
+
+#define SHM_DATA_OFFSET                                                        \
+  ((sizeof(struct shm_header) + SHM_CACHE_LINE - 1) & ~(size_t)(SHM_CACHE_LINE - 1))
+
+struct mjrpc_shm {
+  int fd;
+  char *name; /* owned by the server endpoint, unlinked on close */
+  struct shm_header *header;
+  size_t map_size;
+  uint64_t capacity;
+
+  struct shm_ring *tx, *rx;
+  char *tx_data, *rx_data;
+  bool server;
+
+  /* Ring bytes taken by the message handed out by mjrpc_shm_recv() */
+  uint64_t rx_taken;
+
+  /* Polls before sleeping; 0 on a single CPU where the peer cannot run */
+  int spin_limit;
+};
+
+/*--- futex wait/wake ---*/
+
+static void futex_wake(_Atomic uint32_t *word) {
+  syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+static int64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * @brief Wait until a position moves away from @p seen
+ *
+ * Spins for a while, then sleeps on the sequence word. The waiter count is
+ * raised before the position is checked a last time, so a peer that moves
+ * the position afterwards is bound to see it and wake us.
+ */
+static int wait_for_move(const mjrpc_shm_t *shm, _Atomic uint64_t *position,
+                         uint64_t seen, _Atomic uint32_t *seq,
+                         _Atomic uint32_t *waiters, int timeout_ms) {
+  struct shm_header *header = shm->header;
+  if (timeout_ms == 0)
+    return atomic_load(position) != seen ? MJRPC_RET_OK
+                                         : MJRPC_RET_ERROR_TIMEOUT;
+  for (int i = 0; i < shm->spin_limit; i++) {
+    if (atomic_load_explicit(position, memory_order_acquire) != seen)
+      return MJRPC_RET_OK;
+    cpu_relax();
+  }
+
+  int64_t deadline = timeout_ms > 0 ? now_ns() + (int64_t)timeout_ms * 1000000
+                                    : 0;
+  for (;;) {
+    uint32_t observed = atomic_load(seq);
+    atomic_fetch_add(waiters, 1);
+    if (atomic_load(position) != seen || atomic_load(&header->closed)) {
+      atomic_fetch_sub(waiters, 1);
+      break;
+    }
+
+    struct timespec ts, *timeout = NULL;
+    if (timeout_ms > 0) {
+      int64_t left = deadline - now_ns();
+      if (left <= 0) {
+        atomic_fetch_sub(waiters, 1);
+        return MJRPC_RET_ERROR_TIMEOUT;
+      }
+      ts.tv_sec = (time_t)(left / 1000000000);
+      ts.tv_nsec = (long)(left % 1000000000);
+      timeout = &ts;
+    }
+    syscall(SYS_futex, (uint32_t *)seq, FUTEX_WAIT, observed, timeout, NULL,
+            0);
+    atomic_fetch_sub(waiters, 1);
+    if (atomic_load(position) != seen || atomic_load(&header->closed))
+      break;
+  }
+  return MJRPC_RET_OK;
+}
+
+/**
+ * @brief Publish a new position and wake the peer if it sleeps
+ */
+static void publish(_Atomic uint64_t *position, uint64_t value,
+                    _Atomic uint32_t *seq, _Atomic uint32_t *waiters) {
+  atomic_store(position, value);
+  atomic_fetch_add(seq, 1);
+  if (atomic_load(waiters) > 0)
+    futex_wake(seq);
+}
+
+/*--- mapping ---*/
+
+static size_t record_size(size_t len) {
+  return (sizeof(uint32_t) + len + SHM_ALIGN - 1) & ~(size_t)(SHM_ALIGN - 1);
+}
+
+static mjrpc_shm_t *shm_map(int fd, bool server) {
+  mjrpc_shm_t *shm = calloc(1, sizeof(*shm));
+  if (shm == NULL)
+    return NULL;
+  shm->fd = fd;
+  shm->server = server;
+  shm->spin_limit = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SHM_SPIN_LIMIT : 0;
+
+  struct stat st;
+  if (fstat(fd, &st) < 0 || (size_t)st.st_size < SHM_DATA_OFFSET)
+    goto fail_inval;
+  void *map = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED)
+    goto fail;
+  shm->header = map;
+  shm->map_size = (size_t)st.st_size;
+
+  struct shm_header *h = shm->header;
+  if (h->magic != SHM_MAGIC || h->version != SHM_VERSION ||
+      SHM_DATA_OFFSET + 2 * h->capacity != shm->map_size) {
+    munmap(map, shm->map_size);
+    goto fail_inval;
+  }
+  shm->capacity = h->capacity;
+  char *data = (char *)map + SHM_DATA_OFFSET;
+  shm->tx = &h->rings[server ? 1 : 0];
+  shm->rx = &h->rings[server ? 0 : 1];
+  shm->tx_data = data + (server ? shm->capacity : 0);
+  shm->rx_data = data + (server ? 0 : shm->capacity);
+  return shm;
+
+fail_inval:
+  errno = EINVAL;
+fail:
+  free(shm);
+  return NULL;
+}
+
+mjrpc_shm_t *mjrpc_shm_create(const char *name, size_t capacity) {
+  size_t cap = SHM_MIN_CAPACITY;
+  while (cap < capacity) {
+    if (cap > SIZE_MAX / 4) {
+      errno = EINVAL;
+      return NULL;
+    }
+    cap *= 2;
+  }
+
+  char *saved_name = NULL;
+  int fd;
+  if (name != NULL) {
+    saved_name = strdup(name);
+    if (saved_name == NULL)
+      return NULL;
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+  } else {
+    fd = memfd_create("mjsonrpc", MFD_CLOEXEC);
+  }
+  if (fd < 0) {
+    free(saved_name);
+    return NULL;
+  }
+
+  size_t size = SHM_DATA_OFFSET + 2 * cap;
+  if (ftruncate(fd, (off_t)size) < 0)
+    goto fail;
+  struct shm_header *h =
+      mmap(NULL, SHM_DATA_OFFSET, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (h == MAP_FAILED)
+    goto fail;
+  h->capacity = cap;
+  h->version = SHM_VERSION;
+  atomic_thread_fence(memory_order_release);
+  h->magic = SHM_MAGIC;
+  munmap(h, SHM_DATA_OFFSET);
+
+  mjrpc_shm_t *shm = shm_map(fd, true);
+  if (shm == NULL)
+    goto fail;
+  shm->name = saved_name;
+  return shm;
+
+fail:;
+  int saved_errno = errno;
+  if (name != NULL)
+    shm_unlink(name);
+  close(fd);
+  free(saved_name);
+  errno = saved_errno;
+  return NULL;
+}
+
+mjrpc_shm_t *mjrpc_shm_attach(int fd) {
+  int dup_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+  if (dup_fd < 0)
+    return NULL;
+  mjrpc_shm_t *shm = shm_map(dup_fd, false);
+  if (shm == NULL) {
+    int saved_errno = errno;
+    close(dup_fd);
+    errno = saved_errno;
+  }
+  return shm;
+}
+
+mjrpc_shm_t *mjrpc_shm_attach_named(const char *name) {
+  if (name == NULL) {
+    errno = EINVAL;
+    return NULL;
+  }
+  int fd = shm_open(name, O_RDWR | O_CLOEXEC, 0);
+  if (fd < 0)
+    return NULL;
+  mjrpc_shm_t *shm = shm_map(fd, false);
+  if (shm == NULL) {
+    int saved_errno = errno;
+    close(fd);
+    errno = saved_errno;
+  }
+  return shm;
+}
+
+void mjrpc_shm_close(mjrpc_shm_t *shm) {
+  if (shm == NULL)
+    return;
+  munmap(shm->header, shm->map_size);
+  close(shm->fd);
+  if (shm->name != NULL) {
+    shm_unlink(shm->name);
+    free(shm->name);
+  }
+  free(shm);
+}
+
+int mjrpc_shm_fd(const mjrpc_shm_t *shm) { return shm ? shm->fd : -1; }
+
+size_t mjrpc_shm_max_message(const mjrpc_shm_t *shm) {
+  return shm ? (size_t)shm->capacity - sizeof(uint32_t) : 0;
+}
+
+/*--- messaging ---*/
+
+int mjrpc_shm_send(mjrpc_shm_t *shm, const char *message, size_t len,
+                   int timeout_ms) {
+  if (shm == NULL || (message == NULL && len > 0))
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+  if (len > mjrpc_shm_max_message(shm))
+    return MJRPC_RET_ERROR_TOO_LARGE;
+
+  struct shm_ring *ring = shm->tx;
+  uint64_t cap = shm->capacity;
+  uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  uint64_t size = record_size(len);
+
+  for (;;) {
+    if (atomic_load_explicit(&shm->header->closed, memory_order_relaxed)) {
+      errno = EPIPE;
+      return MJRPC_RET_ERROR_SYSTEM;
+    }
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint64_t offset = tail & (cap - 1);
+    uint64_t to_end = cap - offset;
+    uint64_t free_space = cap - (tail - head);
+    if (size > to_end && free_space >= to_end) {
+      /* Skip the end of the ring; publish the marker alone if the record
+       * cannot follow yet, so the consumer frees the space it covers */
+      uint32_t wrap = SHM_WRAP;
+      memcpy(shm->tx_data + offset, &wrap, sizeof(wrap));
+      tail += to_end;
+      offset = 0;
+      free_space -= to_end;
+      if (free_space < size) {
+        publish(&ring->tail, tail, &ring->data_seq, &ring->data_waiters);
+        continue;
+      }
+    }
+    if (size <= cap - offset && free_space >= size) {
+      uint32_t len32 = (uint32_t)len;
+      memcpy(shm->tx_data + offset, &len32, sizeof(len32));
+      if (len > 0)
+        memcpy(shm->tx_data + offset + sizeof(len32), message, len);
+      publish(&ring->tail, tail + size, &ring->data_seq, &ring->data_waiters);
+      return MJRPC_RET_OK;
+    }
+    int ret = wait_for_move(shm, &ring->head, head, &ring->space_seq,
+                            &ring->space_waiters, timeout_ms);
+    if (ret != MJRPC_RET_OK)
+      return ret;
+  }
+}
+
+/**
+ * @brief Give up on a channel whose peer published an impossible record
+ * @return MJRPC_RET_ERROR_SYSTEM with errno set to EPROTO
+ */
+static int shm_corrupt(mjrpc_shm_t *shm) {
+  mjrpc_shm_shutdown(shm);
+  errno = EPROTO;
+  return MJRPC_RET_ERROR_SYSTEM;
+}
+
+int mjrpc_shm_recv(mjrpc_shm_t *shm, const char **message, size_t *len,
+                   int timeout_ms) {
+  if (shm == NULL || message == NULL || len == NULL)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+
+  struct shm_ring *ring = shm->rx;
+  uint64_t cap = shm->capacity;
+  uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+  for (;;) {
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (tail != head) {
+      /* The peer writes tail and the lengths; trust neither beyond the
+       * ring */
+      uint64_t avail = tail - head;
+      uint64_t offset = head & (cap - 1);
+      uint32_t len32;
+      memcpy(&len32, shm->rx_data + offset, sizeof(len32));
+      if (len32 == SHM_WRAP) {
+        if (avail > cap || cap - offset > avail)
+          return shm_corrupt(shm);
+        head += cap - offset;
+        publish(&ring->head, head, &ring->space_seq, &ring->space_waiters);
+        continue;
+      }
+      if (avail > cap || len32 > cap - offset - sizeof(len32) ||
+          record_size(len32) > avail)
+        return shm_corrupt(shm);
+      *message = shm->rx_data + offset + sizeof(len32);
+      *len = len32;
+      shm->rx_taken = record_size(len32);
+      return MJRPC_RET_OK;
+    }
+    if (atomic_load(&shm->header->closed)) {
+      errno = EPIPE;
+      return MJRPC_RET_ERROR_SYSTEM;
+    }
+    int ret = wait_for_move(shm, &ring->tail, tail, &ring->data_seq,
+                            &ring->data_waiters, timeout_ms);
+    if (ret != MJRPC_RET_OK)
+      return ret;
+  }
+}
+
+void mjrpc_shm_release(mjrpc_shm_t *shm) {
+  if (shm == NULL || shm->rx_taken == 0)
+    return;
+  struct shm_ring *ring = shm->rx;
+  uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  publish(&ring->head, head + shm->rx_taken, &ring->space_seq,
+          &ring->space_waiters);
+  shm->rx_taken = 0;
+}
+
+int mjrpc_shm_serve(mjrpc_shm_t *shm, const mjrpc_handle_t *handle) {
+  if (shm == NULL || handle == NULL || !shm->server)
+    return MJRPC_RET_ERROR_INVALID_PARAM;
+
+  const char *request;
+  size_t len;
+  for (;;) {
+    int ret = mjrpc_shm_recv(shm, &request, &len, -1);
+    if (ret != MJRPC_RET_OK)
+      return ret == MJRPC_RET_ERROR_SYSTEM && errno == EPIPE ? MJRPC_RET_OK
+                                                             : ret;
+    char *response = mjrpc_process_buf(handle, request, len, NULL);
+    mjrpc_shm_release(shm);
+    if (response == NULL)
+      continue;
+
+    size_t response_len = strlen(response);
+    if (response_len > mjrpc_shm_max_message(shm)) {
+      cJSON_free(response);
+      cJSON *error = mjrpc_response_error(
+          JSON_RPC_CODE_INTERNAL_ERROR,
+          "Response exceeds the shared memory ring.", cJSON_CreateNull());
+      response = error ? cJSON_PrintUnformatted(error) : NULL;
+      cJSON_Delete(error);
+      if (response == NULL)
+        continue;
+      response_len = strlen(response);
+    }
+    ret = mjrpc_shm_send(shm, response, response_len, -1);
+    cJSON_free(response);
+    if (ret != MJRPC_RET_OK)
+      return ret == MJRPC_RET_ERROR_SYSTEM && errno == EPIPE ? MJRPC_RET_OK
+                                                             : ret;
+  }
+}
+
+void mjrpc_shm_shutdown(mjrpc_shm_t *shm) {
+  if (shm == NULL)
+    return;
+  atomic_store(&shm->header->closed, 1);
+  for (int i = 0; i < 2; i++) {
+    struct shm_ring *ring = &shm->header->rings[i];
+    atomic_fetch_add(&ring->data_seq, 1);
+    atomic_fetch_add(&ring->space_seq, 1);
+    futex_wake(&ring->data_seq);
+    futex_wake(&ring->space_seq);
+  }
+}
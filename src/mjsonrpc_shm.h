@@ -0,0 +1,197 @@
+/**
+ * @file mjsonrpc_shm.h
+ * @brief Optional shared-memory transport for JSON-RPC between processes on
+ *        the same host
+ * @author Xiao
+ * @date 2026
+ * @version 3.0.0
+ *
+ * @details
+ * A channel is one shared mapping (memfd or POSIX shared memory) holding two
+ * single-producer/single-consumer rings: requests from client to server and
+ * responses back. Messages are written once into the ring by the sender and
+ * read where they lie by the receiver, so mjrpc_shm_serve() parses every
+ * request directly from the mapping.
+ *
+ * Receivers spin briefly on an empty ring and then sleep on a futex; senders
+ * issue a wake-up only when the other side is actually asleep, so a busy
+ * channel runs without system calls.
+ *
+ * Each direction of a channel must be driven by one thread at a time. A
+ * client must read its responses: once both rings are full, a client that
+ * only sends blocks forever.
+ *
+ * @par Example:
+ * @code
+ * // server process
+ * mjrpc_shm_t *shm = mjrpc_shm_create(NULL, 1 << 20);
+ * // ... pass mjrpc_shm_fd(shm) to the client (fork, SCM_RIGHTS)
+ * mjrpc_shm_serve(shm, handle);
+ *
+ * // client process
+ * mjrpc_shm_t *shm = mjrpc_shm_attach(fd);
+ * mjrpc_shm_send(shm, request, strlen(request), -1);
+ * const char *response;
+ * size_t len;
+ * mjrpc_shm_recv(shm, &response, &len, -1);
+ * ...
+ * mjrpc_shm_release(shm);
+ * @endcode
+ *
+ * @copyright
+ * MIT License
+ *
+ * Copyright (c) 2026 Xiao
+ */
+
+#ifndef MJSONRPC_SHM_H_
+#define MJSONRPC_SHM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mjsonrpc.h"
+#include <stddef.h>
+
+/**
+ * @brief Opaque endpoint of a shared-memory channel
+ */
+typedef struct mjrpc_shm mjrpc_shm_t;
+
+/**
+ * @brief Create a channel as its server endpoint
+ *
+ * @param name POSIX shared memory name (e.g. "/myrpc"), or NULL for an
+ *             anonymous memfd shared by passing mjrpc_shm_fd()
+ * @param capacity Bytes per ring, rounded up to a power of two (minimum
+ *                 4 KiB); also bounds the message size
+ * @return New endpoint, or NULL on failure (errno is set)
+ */
+mjrpc_shm_t *mjrpc_shm_create(const char *name, size_t capacity);
+
+/**
+ * @brief Attach to a channel by file descriptor as its client endpoint
+ *
+ * @param fd Descriptor from mjrpc_shm_fd() of the server endpoint (the
+ *           descriptor is duplicated)
+ * @return New endpoint, or NULL on failure (errno is set)
+ */
+mjrpc_shm_t *mjrpc_shm_attach(int fd);
+
+/**
+ * @brief Attach to a named channel as its client endpoint
+ *
+ * @param name Name given to mjrpc_shm_create()
+ * @return New endpoint, or NULL on failure (errno is set)
+ */
+mjrpc_shm_t *mjrpc_shm_attach_named(const char *name);
+
+/**
+ * @brief Release an endpoint
+ *
+ * Unmaps the channel; the server endpoint also removes its name. The peer
+ * is not notified, use mjrpc_shm_shutdown() first for that.
+ *
+ * @param shm Endpoint (may be NULL)
+ */
+void mjrpc_shm_close(mjrpc_shm_t *shm);
+
+/**
+ * @brief Get the descriptor of the shared mapping
+ *
+ * @param shm Endpoint
+ * @return File descriptor, or -1 if @p shm is NULL
+ */
+int mjrpc_shm_fd(const mjrpc_shm_t *shm);
+
+/**
+ * @brief Largest message the channel can carry
+ *
+ * @param shm Endpoint
+ * @return Size in bytes
+ */
+size_t mjrpc_shm_max_message(const mjrpc_shm_t *shm);
+
+/**
+ * @brief Send a message to the peer
+ *
+ * Blocks while the ring has no room for it. A message longer than half the
+ * ring may have to wait until the receiver has drained it completely.
+ *
+ * @param shm Endpoint
+ * @param message Message bytes (need not be NUL-terminated)
+ * @param len Message length
+ * @param timeout_ms Longest time to wait for room, -1 waits forever
+ * @return Return code
+ * @retval MJRPC_RET_OK On success
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If an argument is NULL
+ * @retval MJRPC_RET_ERROR_TOO_LARGE If the message exceeds
+ *         mjrpc_shm_max_message()
+ * @retval MJRPC_RET_ERROR_TIMEOUT If no room was made in time
+ * @retval MJRPC_RET_ERROR_SYSTEM If the channel was shut down (errno is
+ *         EPIPE)
+ */
+int mjrpc_shm_send(mjrpc_shm_t *shm, const char *message, size_t len,
+                   int timeout_ms);
+
+/**
+ * @brief Receive the next message from the peer in place
+ *
+ * The message stays in the shared mapping until mjrpc_shm_release(); every
+ * successful call must be followed by one release before the next receive.
+ *
+ * @param shm Endpoint
+ * @param message Receives the start of the message (not NUL-terminated)
+ * @param len Receives the message length
+ * @param timeout_ms Longest time to wait, -1 waits forever, 0 only polls
+ * @return Return code
+ * @retval MJRPC_RET_OK On success
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If an argument is NULL
+ * @retval MJRPC_RET_ERROR_TIMEOUT If no message arrived in time
+ * @retval MJRPC_RET_ERROR_SYSTEM If the channel was shut down and drained
+ *         (errno is EPIPE), or if the peer published a record that does not
+ *         fit the ring, which shuts the channel down (errno is EPROTO)
+ */
+int mjrpc_shm_recv(mjrpc_shm_t *shm, const char **message, size_t *len,
+                   int timeout_ms);
+
+/**
+ * @brief Hand the message returned by mjrpc_shm_recv() back to the ring
+ *
+ * @param shm Endpoint
+ */
+void mjrpc_shm_release(mjrpc_shm_t *shm);
+
+/**
+ * @brief Process requests until the channel is shut down
+ *
+ * Requests are parsed straight from the ring with mjrpc_process_buf() and
+ * every response is written to the response ring. A response larger than
+ * mjrpc_shm_max_message() is replaced by an internal error.
+ *
+ * @param shm Server endpoint
+ * @param handle Handle used to process requests
+ * @return Return code
+ * @retval MJRPC_RET_OK When the channel was shut down
+ * @retval MJRPC_RET_ERROR_INVALID_PARAM If an argument is NULL or @p shm is a
+ *         client endpoint
+ * @retval MJRPC_RET_ERROR_SYSTEM If the client published a corrupt record
+ *         (errno is EPROTO)
+ */
+int mjrpc_shm_serve(mjrpc_shm_t *shm, const mjrpc_handle_t *handle);
+
+/**
+ * @brief Shut the channel down for both endpoints
+ *
+ * Wakes every waiter; messages already in a ring can still be received.
+ *
+ * @param shm Either endpoint
+ */
+void mjrpc_shm_shutdown(mjrpc_shm_t *shm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MJSONRPC_SHM_H_
@@ -0,0 +1,339 @@
+/**
+ * @file async_test.c
+ * @brief Tests for asynchronous methods and deferred responses
+ *
+ * Covers:
+ *   - Deferred completion with mjrpc_complete / mjrpc_fail
+ *   - Completion from inside the handler
+ *   - Notifications routed to asynchronous methods
+ *   - Synchronous methods through mjrpc_process_async
+ *   - Synchronous entry points rejecting asynchronous methods
+ *   - Batches mixing synchronous and asynchronous elements
+ *   - Completion from other threads
+ */
+
+#include "unity.h"
+#include "mjsonrpc.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+/* Tokens parked by the "later" method until the test completes them */
+static mjrpc_async_token_t* parked = NULL;
+
+typedef struct {
+    int calls;
+    cJSON* response;
+} sink_t;
+
+static void sink_response(cJSON* response, void* user_data)
+{
+    sink_t* sink = (sink_t*) user_data;
+    sink->calls++;
+    cJSON_Delete(sink->response);
+    sink->response = response;
+}
+
+static void later_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id,
+                       mjrpc_async_token_t* token)
+{
+    (void) ctx;
+    (void) params;
+    (void) id;
+    parked = token;
+}
+
+/* Tokens queued by the "queued" method, in arrival order */
+static mjrpc_async_token_t* queue[64];
+static int queue_len = 0;
+
+static void queued_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id,
+                        mjrpc_async_token_t* token)
+{
+    (void) ctx;
+    (void) params;
+    (void) id;
+    queue[queue_len++] = token;
+}
+
+static void now_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id, mjrpc_async_token_t* token)
+{
+    (void) ctx;
+    (void) id;
+    mjrpc_complete(token, cJSON_Duplicate(params, 1));
+}
+
+static cJSON* sync_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) ctx;
+    (void) params;
+    (void) id;
+    return cJSON_CreateString("sync");
+}
+
+static cJSON* parse(const char* text)
+{
+    cJSON* req = cJSON_Parse(text);
+    TEST_ASSERT_NOT_NULL(req);
+    return req;
+}
+
+void test_deferred_complete(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_async_method(h, later_func, "later", NULL);
+    sink_t sink = {0};
+
+    cJSON* req = parse("{\"jsonrpc\":\"2.0\",\"method\":\"later\",\"id\":7}");
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_process_async(h, req, sink_response, &sink));
+    cJSON_Delete(req);
+
+    /* Nothing is delivered until the token completes */
+    TEST_ASSERT_EQUAL_INT(0, sink.calls);
+    TEST_ASSERT_NOT_NULL(parked);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_complete(parked, cJSON_CreateNumber(42)));
+    parked = NULL;
+
+    TEST_ASSERT_EQUAL_INT(1, sink.calls);
+    TEST_ASSERT_EQUAL_INT(42, cJSON_GetObjectItem(sink.response, "result")->valueint);
+    TEST_ASSERT_EQUAL_INT(7, cJSON_GetObjectItem(sink.response, "id")->valueint);
+
+    cJSON_Delete(sink.response);
+    mjrpc_destroy_handle(h);
+}
+
+void test_deferred_fail(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_async_method(h, later_func, "later", NULL);
+    sink_t sink = {0};
+
+    cJSON* req = parse("{\"jsonrpc\":\"2.0\",\"method\":\"later\",\"id\":\"a\"}");
+    mjrpc_process_async(h, req, sink_response, &sink);
+    cJSON_Delete(req);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_fail(parked, -32001, "backend down"));
+    parked = NULL;
+
+    TEST_ASSERT_EQUAL_INT(1, sink.calls);
+    cJSON* error = cJSON_GetObjectItem(sink.response, "error");
+    TEST_ASSERT_EQUAL_INT(-32001, cJSON_GetObjectItem(error, "code")->valueint);
+    TEST_ASSERT_EQUAL_STRING("backend down", cJSON_GetObjectItem(error, "message")->valuestring);
+    TEST_ASSERT_EQUAL_STRING("a", cJSON_GetObjectItem(sink.response, "id")->valuestring);
+
+    cJSON_Delete(sink.response);
+    mjrpc_destroy_handle(h);
+}
+
+void test_complete_inside_handler(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_async_method(h, now_func, "now", NULL);
+    sink_t sink = {0};
+
+    cJSON* req = parse("{\"jsonrpc\":\"2.0\",\"method\":\"now\",\"params\":[1,2],\"id\":1}");
+    mjrpc_process_async(h, req, sink_response, &sink);
+    cJSON_Delete(req);
+
+    TEST_ASSERT_EQUAL_INT(1, sink.calls);
+    TEST_ASSERT_EQUAL_INT(2, cJSON_GetArraySize(cJSON_GetObjectItem(sink.response, "result")));
+
+    cJSON_Delete(sink.response);
+    mjrpc_destroy_handle(h);
+}
+
+void test_async_notification(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_async_method(h, later_func, "later", NULL);
+    sink_t sink = {0};
+
+    cJSON* req = parse("{\"jsonrpc\":\"2.0\",\"method\":\"later\"}");
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK_NOTIFICATION,
+                          mjrpc_process_async(h, req, sink_response, &sink));
+    cJSON_Delete(req);
+    TEST_ASSERT_EQUAL_INT(0, sink.calls);
+
+    /* The callback still fires once, without a response */
+    mjrpc_complete(parked, cJSON_CreateTrue());
+    parked = NULL;
+    TEST_ASSERT_EQUAL_INT(1, sink.calls);
+    TEST_ASSERT_NULL(sink.response);
+
+    mjrpc_destroy_handle(h);
+}
+
+void test_sync_method_through_async_entry(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, sync_func, "sync", NULL);
+    sink_t sink = {0};
+
+    cJSON* req = parse("{\"jsonrpc\":\"2.0\",\"method\":\"sync\",\"id\":3}");
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_process_async(h, req, sink_response, &sink));
+    cJSON_Delete(req);
+    TEST_ASSERT_EQUAL_INT(1, sink.calls);
+    TEST_ASSERT_EQUAL_STRING("sync", cJSON_GetObjectItem(sink.response, "result")->valuestring);
+
+    cJSON_Delete(sink.response);
+    mjrpc_destroy_handle(h);
+}
+
+void test_sync_entry_rejects_async_method(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_async_method(h, later_func, "later", NULL);
+
+    int code = -1;
+    char* resp =
+        mjrpc_process_str(h, "{\"jsonrpc\":\"2.0\",\"method\":\"later\",\"id\":1}", &code);
+    TEST_ASSERT_NOT_NULL(resp);
+    TEST_ASSERT_NULL(parked);
+    cJSON* json = cJSON_Parse(resp);
+    cJSON* error = cJSON_GetObjectItem(json, "error");
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_INTERNAL_ERROR,
+                          cJSON_GetObjectItem(error, "code")->valueint);
+    cJSON_Delete(json);
+    free(resp);
+    mjrpc_destroy_handle(h);
+}
+
+void test_async_invalid_params(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM,
+                          mjrpc_add_async_method(h, NULL, "x", NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED,
+                          mjrpc_add_async_method(NULL, later_func, "x", NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_process_async(h, NULL, NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_complete(NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_fail(NULL, 1, NULL));
+    mjrpc_destroy_handle(h);
+}
+
+void test_batch_assembled_after_last_completion(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_async_method(h, queued_func, "queued", NULL);
+    mjrpc_add_method(h, sync_func, "sync", NULL);
+    sink_t sink = {0};
+    queue_len = 0;
+
+    cJSON* req = parse("[{\"jsonrpc\":\"2.0\",\"method\":\"queued\",\"id\":1},"
+                       "{\"jsonrpc\":\"2.0\",\"method\":\"sync\",\"id\":2},"
+                       "{\"jsonrpc\":\"2.0\",\"method\":\"queued\"},"
+                       "{\"jsonrpc\":\"2.0\",\"method\":\"queued\",\"id\":4}]");
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_process_async(h, req, sink_response, &sink));
+    cJSON_Delete(req);
+    TEST_ASSERT_EQUAL_INT(3, queue_len);
+    TEST_ASSERT_TRUE(mjrpc_async_token_in_batch(queue[0]));
+    TEST_ASSERT_EQUAL_INT(4, mjrpc_async_token_id(queue[2])->valueint);
+    TEST_ASSERT_NULL(mjrpc_async_token_id(queue[1]));
+
+    /* Complete out of order; nothing is delivered until the last one */
+    mjrpc_complete(queue[2], cJSON_CreateNumber(40));
+    mjrpc_complete(queue[1], NULL);
+    TEST_ASSERT_EQUAL_INT(0, sink.calls);
+    mjrpc_fail(queue[0], -32001, "late");
+    TEST_ASSERT_EQUAL_INT(1, sink.calls);
+
+    /* Responses keep request order; the notification has no entry */
+    TEST_ASSERT_EQUAL_INT(3, cJSON_GetArraySize(sink.response));
+    cJSON* first = cJSON_GetArrayItem(sink.response, 0);
+    TEST_ASSERT_EQUAL_INT(1, cJSON_GetObjectItem(first, "id")->valueint);
+    TEST_ASSERT_NOT_NULL(cJSON_GetObjectItem(first, "error"));
+    cJSON* second = cJSON_GetArrayItem(sink.response, 1);
+    TEST_ASSERT_EQUAL_STRING("sync", cJSON_GetObjectItem(second, "result")->valuestring);
+    cJSON* third = cJSON_GetArrayItem(sink.response, 2);
+    TEST_ASSERT_EQUAL_INT(40, cJSON_GetObjectItem(third, "result")->valueint);
+
+    cJSON_Delete(sink.response);
+    mjrpc_destroy_handle(h);
+}
+
+void test_batch_of_async_notifications(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_async_method(h, queued_func, "queued", NULL);
+    mjrpc_add_async_method(h, now_func, "now", NULL);
+    sink_t sink = {0};
+    queue_len = 0;
+
+    cJSON* req = parse("[{\"jsonrpc\":\"2.0\",\"method\":\"queued\"},"
+                       "{\"jsonrpc\":\"2.0\",\"method\":\"now\"}]");
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK_NOTIFICATION,
+                          mjrpc_process_async(h, req, sink_response, &sink));
+    cJSON_Delete(req);
+    TEST_ASSERT_EQUAL_INT(0, sink.calls);
+    mjrpc_complete(queue[0], NULL);
+    TEST_ASSERT_EQUAL_INT(1, sink.calls);
+    TEST_ASSERT_NULL(sink.response);
+
+    /* A batch completed entirely inside its handlers is delivered at once */
+    req = parse("[{\"jsonrpc\":\"2.0\",\"method\":\"now\",\"params\":[1],\"id\":1}]");
+    mjrpc_process_async(h, req, sink_response, &sink);
+    cJSON_Delete(req);
+    TEST_ASSERT_EQUAL_INT(2, sink.calls);
+    TEST_ASSERT_EQUAL_INT(1, cJSON_GetArraySize(sink.response));
+
+    cJSON_Delete(sink.response);
+    mjrpc_destroy_handle(h);
+}
+
+static void* complete_from_thread(void* arg)
+{
+    mjrpc_complete((mjrpc_async_token_t*) arg, cJSON_CreateTrue());
+    return NULL;
+}
+
+void test_batch_completed_from_threads(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_async_method(h, queued_func, "queued", NULL);
+    enum { N = 32 };
+
+    for (int round = 0; round < 20; round++)
+    {
+        sink_t sink = {0};
+        queue_len = 0;
+        cJSON* req = cJSON_CreateArray();
+        for (int i = 0; i < N; i++)
+            cJSON_AddItemToArray(req, mjrpc_request_cjson("queued", NULL, cJSON_CreateNumber(i)));
+        mjrpc_process_async(h, req, sink_response, &sink);
+        cJSON_Delete(req);
+        TEST_ASSERT_EQUAL_INT(N, queue_len);
+
+        pthread_t threads[N];
+        for (int i = 0; i < N; i++)
+            pthread_create(&threads[i], NULL, complete_from_thread, queue[i]);
+        for (int i = 0; i < N; i++)
+            pthread_join(threads[i], NULL);
+
+        TEST_ASSERT_EQUAL_INT(1, sink.calls);
+        TEST_ASSERT_EQUAL_INT(N, cJSON_GetArraySize(sink.response));
+        for (int i = 0; i < N; i++)
+            TEST_ASSERT_EQUAL_INT(
+                i, cJSON_GetObjectItem(cJSON_GetArrayItem(sink.response, i), "id")->valueint);
+        cJSON_Delete(sink.response);
+    }
+    mjrpc_destroy_handle(h);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_deferred_complete);
+    RUN_TEST(test_deferred_fail);
+    RUN_TEST(test_complete_inside_handler);
+    RUN_TEST(test_async_notification);
+    RUN_TEST(test_sync_method_through_async_entry);
+    RUN_TEST(test_sync_entry_rejects_async_method);
+    RUN_TEST(test_async_invalid_params);
+    RUN_TEST(test_batch_assembled_after_last_completion);
+    RUN_TEST(test_batch_of_async_notifications);
+    RUN_TEST(test_batch_completed_from_threads);
+    return UNITY_END();
+}
@@ -8,6 +8,7 @@
  *   - Special character method names
  *   - Maximum length method names
  *   - Unicode method names
+ *   - Length-delimited requests that are not NUL-terminated
  */
 
 #include "unity.h"
@@ -407,6 +408,76 @@ void test_single_char_method_name(void)
     mjrpc_destroy_handle(h);
 }
 
+/* ================================================================== */
+/*  Length-delimited processing                                       */
+/* ================================================================== */
+
+void test_process_buf_without_terminator(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(8);
+    mjrpc_add_method(h, echo_func, "echo", NULL);
+
+    /* Two requests back to back, only the first one is processed */
+    const char* stream = "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[1],\"id\":1}"
+                         "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[2],\"id\":2}";
+    size_t first_len = strlen(stream) / 2;
+    int code = -1;
+    char* resp = mjrpc_process_buf(h, stream, first_len, &code);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, code);
+    cJSON* json = cJSON_Parse(resp);
+    TEST_ASSERT_EQUAL_INT(1, cJSON_GetObjectItem(json, "id")->valueint);
+    cJSON_Delete(json);
+    free(resp);
+
+    /* A truncated request is a parse error */
+    resp = mjrpc_process_buf(h, stream, first_len - 1, &code);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_PARSE_FAILED, code);
+    free(resp);
+
+    resp = mjrpc_process_buf(h, NULL, 0, &code);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_PARSE_FAILED, code);
+    free(resp);
+
+    mjrpc_destroy_handle(h);
+}
+
+static cJSON* mirror_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) ctx;
+    (void) id;
+    return cJSON_Duplicate(params, true);
+}
+
+void test_process_buf_insitu(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(8);
+    mjrpc_add_method(h, mirror_func, "echo", NULL);
+
+    char stream[] = "{\"jsonrpc\":\"2.0\",\"method\":\"echo\","
+                    "\"params\":{\"say\":\"tab\\there \\u00e9\",\"n\":[1,\"x\"]},\"id\":\"abc\"}"
+                    "{\"trailing\":true}";
+    size_t len = strlen(stream) - strlen("{\"trailing\":true}");
+    int code = -1;
+    char* resp = mjrpc_process_buf_insitu(h, stream, len, &code);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, code);
+    TEST_ASSERT_EQUAL_STRING("{\"jsonrpc\":\"2.0\",\"result\":{\"say\":\"tab\\there \xc3\xa9\","
+                             "\"n\":[1,\"x\"]},\"id\":\"abc\"}",
+                             resp);
+    free(resp);
+    /* Bytes after the request are left alone */
+    TEST_ASSERT_EQUAL_STRING("{\"trailing\":true}", stream + len);
+
+    char broken[] = "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"id\":1";
+    resp = mjrpc_process_buf_insitu(h, broken, strlen(broken), &code);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_PARSE_FAILED, code);
+    free(resp);
+    resp = mjrpc_process_buf_insitu(h, NULL, 0, &code);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_PARSE_FAILED, code);
+    free(resp);
+
+    mjrpc_destroy_handle(h);
+}
+
 /* ================================================================== */
 /*  main                                                              */
 /* ================================================================== */
@@ -438,5 +509,9 @@ int main(void)
     /* Single character tests */
     RUN_TEST(test_single_char_method_name);
 
+    /* Length-delimited processing */
+    RUN_TEST(test_process_buf_without_terminator);
+    RUN_TEST(test_process_buf_insitu);
+
     return UNITY_END();
 }
@@ -0,0 +1,321 @@
+/**
+ * @file cache_test.c
+ * @brief Tests for memoized (cacheable) methods
+ *
+ * Covers:
+ *   - Hits for equal params, regardless of object member order
+ *   - Responses identical to uncached ones, with the caller's id
+ *   - Notifications and errors bypassing the cache
+ *   - TTL expiry, LRU eviction and capacity changes
+ *   - Explicit invalidation, method replacement and deletion
+ *   - Concurrent lookups from several threads, and resizing meanwhile
+ */
+
+#include "unity.h"
+#include "mjsonrpc.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static atomic_int invocations;
+
+/* Echoes its params back inside an object */
+static cJSON* lookup_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) ctx;
+    (void) id;
+    atomic_fetch_add(&invocations, 1);
+    cJSON* result = cJSON_CreateObject();
+    cJSON_AddItemToObject(result, "echo", params ? cJSON_Duplicate(params, true) : cJSON_CreateNull());
+    cJSON_AddStringToObject(result, "note", "a \"quoted\" value");
+    return result;
+}
+
+static cJSON* failing_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) params;
+    (void) id;
+    atomic_fetch_add(&invocations, 1);
+    ctx->error_code = JSON_RPC_CODE_INVALID_PARAMS;
+    return NULL;
+}
+
+static char* call(mjrpc_handle_t* h, const char* request)
+{
+    int ret;
+    return mjrpc_process_str(h, request, &ret);
+}
+
+static void call_and_free(mjrpc_handle_t* h, const char* request)
+{
+    free(call(h, request));
+}
+
+void test_cache_hits_equal_params(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_add_cached_method(h, lookup_func, "lookup", NULL, 0));
+    atomic_store(&invocations, 0);
+
+    char* first = call(h, "{\"jsonrpc\":\"2.0\",\"method\":\"lookup\","
+                          "\"params\":{\"a\":1,\"b\":[true,\"x\"]},\"id\":1}");
+    char* second = call(h, "{\"jsonrpc\":\"2.0\",\"method\":\"lookup\","
+                           "\"params\":{\"b\":[true,\"x\"],\"a\":1},\"id\":1}");
+    TEST_ASSERT_EQUAL_INT(1, atomic_load(&invocations));
+    TEST_ASSERT_EQUAL_STRING(first, second);
+    free(second);
+
+    /* The caller's id is used */
+    second = call(h, "{\"jsonrpc\":\"2.0\",\"method\":\"lookup\","
+                     "\"params\":{\"a\":1,\"b\":[true,\"x\"]},\"id\":\"other\"}");
+    TEST_ASSERT_NOT_NULL(strstr(second, "\"id\":\"other\""));
+    TEST_ASSERT_EQUAL_INT(1, atomic_load(&invocations));
+    free(second);
+    free(first);
+
+    /* Different params, array order and no params are distinct keys */
+    call_and_free(h, "{\"jsonrpc\":\"2.0\",\"method\":\"lookup\","
+                     "\"params\":{\"a\":2,\"b\":[true,\"x\"]},\"id\":1}");
+    call_and_free(h, "{\"jsonrpc\":\"2.0\",\"method\":\"lookup\","
+                     "\"params\":{\"a\":1,\"b\":[\"x\",true]},\"id\":1}");
+    call_and_free(h, "{\"jsonrpc\":\"2.0\",\"method\":\"lookup\",\"id\":1}");
+    call_and_free(h, "{\"jsonrpc\":\"2.0\",\"method\":\"lookup\",\"id\":2}");
+    TEST_ASSERT_EQUAL_INT(4, atomic_load(&invocations));
+
+    mjrpc_cache_stats_t stats;
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_get_cache_stats(h, &stats));
+    TEST_ASSERT_EQUAL_UINT64(3, stats.hits);
+    TEST_ASSERT_EQUAL_UINT64(4, stats.misses);
+    TEST_ASSERT_EQUAL_size_t(4, stats.entries);
+
+    /* The cJSON response carries the cached result as raw JSON */
+    cJSON* request = cJSON_Parse("{\"jsonrpc\":\"2.0\",\"method\":\"lookup\",\"id\":5}");
+    cJSON* response = mjrpc_process_cjson(h, request, NULL);
+    TEST_ASSERT_TRUE(cJSON_IsRaw(cJSON_GetObjectItem(response, "result")));
+    cJSON_Delete(response);
+    cJSON_Delete(request);
+    mjrpc_destroy_handle(h);
+}
+
+void test_cache_bypassed_for_notifications_and_errors(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_cached_method(h, lookup_func, "lookup", NULL, 0);
+    mjrpc_add_cached_method(h, failing_func, "fail", NULL, 0);
+    atomic_store(&invocations, 0);
+    call_and_free(h, "{\"jsonrpc\":\"2.0\",\"method\":\"lookup\"}");
+    call_and_free(h, "{\"jsonrpc\":\"2.0\",\"method\":\"lookup\"}");
+    call_and_free(h, "{\"jsonrpc\":\"2.0\",\"method\":\"fail\",\"id\":1}");
+    call_and_free(h, "{\"jsonrpc\":\"2.0\",\"method\":\"fail\",\"id\":1}");
+    TEST_ASSERT_EQUAL_INT(4, atomic_load(&invocations));
+    mjrpc_cache_stats_t stats;
+    mjrpc_get_cache_stats(h, &stats);
+    TEST_ASSERT_EQUAL_size_t(0, stats.entries);
+    mjrpc_destroy_handle(h);
+}
+
+void test_cache_ttl_expiry(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_cached_method(h, lookup_func, "lookup", NULL, 20);
+    atomic_store(&invocations, 0);
+    const char* request = "{\"jsonrpc\":\"2.0\",\"method\":\"lookup\",\"params\":[1],\"id\":1}";
+    call_and_free(h, request);
+    call_and_free(h, request);
+    TEST_ASSERT_EQUAL_INT(1, atomic_load(&invocations));
+    usleep(30000);
+    call_and_free(h, request);
+    TEST_ASSERT_EQUAL_INT(2, atomic_load(&invocations));
+    mjrpc_cache_stats_t stats;
+    mjrpc_get_cache_stats(h, &stats);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.expirations);
+    TEST_ASSERT_EQUAL_size_t(1, stats.entries);
+    mjrpc_destroy_handle(h);
+}
+
+void test_cache_lru_eviction(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_cached_method(h, lookup_func, "lookup", NULL, 0);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_set_cache_capacity(h, 2));
+    atomic_store(&invocations, 0);
+    const char* a = "{\"jsonrpc\":\"2.0\",\"method\":\"lookup\",\"params\":[\"a\"],\"id\":1}";
+    const char* b = "{\"jsonrpc\":\"2.0\",\"method\":\"lookup\",\"params\":[\"b\"],\"id\":1}";
+    const char* c = "{\"jsonrpc\":\"2.0\",\"method\":\"lookup\",\"params\":[\"c\"],\"id\":1}";
+    call_and_free(h, a);
+    call_and_free(h, b);
+    call_and_free(h, a); /* a is now the most recent */
+    call_and_free(h, c); /* evicts b */
+    TEST_ASSERT_EQUAL_INT(3, atomic_load(&invocations));
+    call_and_free(h, a);
+    TEST_ASSERT_EQUAL_INT(3, atomic_load(&invocations));
+    call_and_free(h, b);
+    TEST_ASSERT_EQUAL_INT(4, atomic_load(&invocations));
+    mjrpc_cache_stats_t stats;
+    mjrpc_get_cache_stats(h, &stats);
+    TEST_ASSERT_EQUAL_UINT64(2, stats.evictions);
+    TEST_ASSERT_EQUAL_size_t(2, stats.entries);
+
+    /* Capacity 0 turns memoization off */
+    mjrpc_set_cache_capacity(h, 0);
+    call_and_free(h, a);
+    call_and_free(h, a);
+    TEST_ASSERT_EQUAL_INT(6, atomic_load(&invocations));
+    mjrpc_destroy_handle(h);
+}
+
+void test_cache_invalidation(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_cached_method(h, lookup_func, "one", NULL, 0);
+    mjrpc_add_cached_method(h, lookup_func, "two", NULL, 0);
+    const char* one1 = "{\"jsonrpc\":\"2.0\",\"method\":\"one\",\"params\":{\"k\":1},\"id\":1}";
+    const char* one2 = "{\"jsonrpc\":\"2.0\",\"method\":\"one\",\"params\":{\"k\":2},\"id\":1}";
+    const char* two = "{\"jsonrpc\":\"2.0\",\"method\":\"two\",\"id\":1}";
+    call_and_free(h, one1);
+    call_and_free(h, one2);
+    call_and_free(h, two);
+    mjrpc_cache_stats_t stats;
+
+    cJSON* params = cJSON_Parse("{\"k\":1}");
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_cache_invalidate(h, "one", params));
+    cJSON_Delete(params);
+    mjrpc_get_cache_stats(h, &stats);
+    TEST_ASSERT_EQUAL_size_t(2, stats.entries);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_cache_invalidate(h, "one", NULL));
+    mjrpc_get_cache_stats(h, &stats);
+    TEST_ASSERT_EQUAL_size_t(1, stats.entries);
+    call_and_free(h, one1);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_cache_invalidate(h, NULL, NULL));
+    mjrpc_get_cache_stats(h, &stats);
+    TEST_ASSERT_EQUAL_size_t(0, stats.entries);
+
+    /* Replacing or deleting a method drops its results */
+    call_and_free(h, one1);
+    call_and_free(h, two);
+    mjrpc_add_method(h, lookup_func, "one", NULL);
+    mjrpc_get_cache_stats(h, &stats);
+    TEST_ASSERT_EQUAL_size_t(1, stats.entries);
+    atomic_store(&invocations, 0);
+    call_and_free(h, one1);
+    call_and_free(h, one1);
+    TEST_ASSERT_EQUAL_INT(2, atomic_load(&invocations));
+    mjrpc_del_method(h, "two");
+    mjrpc_get_cache_stats(h, &stats);
+    TEST_ASSERT_EQUAL_size_t(0, stats.entries);
+
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_cache_invalidate(h, "missing", NULL));
+    params = cJSON_CreateArray();
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_cache_invalidate(h, NULL, params));
+    cJSON_Delete(params);
+    mjrpc_destroy_handle(h);
+}
+
+#define CACHE_THREADS 4
+#define CACHE_CALLS 2000
+
+static void* hammer(void* arg)
+{
+    mjrpc_handle_t* h = arg;
+    char request[96];
+    for (int i = 0; i < CACHE_CALLS; i++)
+    {
+        snprintf(request, sizeof(request),
+                 "{\"jsonrpc\":\"2.0\",\"method\":\"lookup\",\"params\":[%d],\"id\":%d}", i % 50, i);
+        char* response = call(h, request);
+        TEST_ASSERT_NOT_NULL(strstr(response, "\"result\""));
+        free(response);
+    }
+    return NULL;
+}
+
+void test_cache_concurrent_lookups(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_cached_method(h, lookup_func, "lookup", NULL, 0);
+    mjrpc_set_cache_capacity(h, 32);
+    pthread_t threads[CACHE_THREADS];
+    for (int i = 0; i < CACHE_THREADS; i++)
+        pthread_create(&threads[i], NULL, hammer, h);
+    for (int i = 0; i < CACHE_THREADS; i++)
+        pthread_join(threads[i], NULL);
+    mjrpc_cache_stats_t stats;
+    mjrpc_get_cache_stats(h, &stats);
+    TEST_ASSERT_EQUAL_UINT64(CACHE_THREADS * CACHE_CALLS, stats.hits + stats.misses);
+    TEST_ASSERT_TRUE(stats.entries <= 32);
+    mjrpc_destroy_handle(h);
+}
+
+static atomic_int hammers_left;
+
+static void* hammer_and_count(void* arg)
+{
+    hammer(arg);
+    atomic_fetch_sub(&hammers_left, 1);
+    return NULL;
+}
+
+void test_cache_resize_while_processing(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_cached_method(h, lookup_func, "lookup", NULL, 0);
+    atomic_store(&hammers_left, CACHE_THREADS);
+    pthread_t threads[CACHE_THREADS];
+    for (int i = 0; i < CACHE_THREADS; i++)
+        pthread_create(&threads[i], NULL, hammer_and_count, h);
+
+    /* Resizing swaps the buckets under the lock the lookups take */
+    static const size_t capacities[] = {8, 0, 64, 1};
+    for (int i = 0; atomic_load(&hammers_left) > 0; i++)
+        TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_set_cache_capacity(h, capacities[i % 4]));
+    for (int i = 0; i < CACHE_THREADS; i++)
+        pthread_join(threads[i], NULL);
+
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_set_cache_capacity(h, 16));
+    call_and_free(h, "{\"jsonrpc\":\"2.0\",\"method\":\"lookup\",\"params\":[1],\"id\":1}");
+    mjrpc_cache_stats_t stats;
+    mjrpc_get_cache_stats(h, &stats);
+    TEST_ASSERT_EQUAL_size_t(1, stats.entries);
+    mjrpc_destroy_handle(h);
+}
+
+void test_cache_invalid_params(void)
+{
+    mjrpc_cache_stats_t stats;
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED,
+                          mjrpc_add_cached_method(NULL, lookup_func, "x", NULL, 0));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM,
+                          mjrpc_add_cached_method(h, NULL, "x", NULL, 0));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM,
+                          mjrpc_add_cached_method(h, lookup_func, NULL, NULL, 0));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED, mjrpc_set_cache_capacity(NULL, 1));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED,
+                          mjrpc_cache_invalidate(NULL, NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED, mjrpc_get_cache_stats(NULL, &stats));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_get_cache_stats(h, NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_get_cache_stats(h, &stats));
+    TEST_ASSERT_EQUAL_UINT64(0, stats.hits);
+    mjrpc_destroy_handle(h);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_cache_hits_equal_params);
+    RUN_TEST(test_cache_bypassed_for_notifications_and_errors);
+    RUN_TEST(test_cache_ttl_expiry);
+    RUN_TEST(test_cache_lru_eviction);
+    RUN_TEST(test_cache_invalidation);
+    RUN_TEST(test_cache_concurrent_lookups);
+    RUN_TEST(test_cache_resize_while_processing);
+    RUN_TEST(test_cache_invalid_params);
+    return UNITY_END();
+}
@@ -98,6 +98,122 @@ void test_client_build_no_method_name_request_str(void)
     TEST_ASSERT_NULL(ret);
 }
 
+void test_client_writer_matches_request_str(void)
+{
+    cJSON* params = cJSON_CreateObject();
+    cJSON_AddStringToObject(params, "name", "quote\" back\\ tab\t ctl\x01 \xc3\xa9");
+    cJSON_AddNumberToObject(params, "n", -42);
+    cJSON_AddNumberToObject(params, "x", 0.1);
+    cJSON_AddNumberToObject(params, "big", 1e300);
+    cJSON_AddTrueToObject(params, "t");
+    cJSON_AddNullToObject(params, "z");
+    cJSON* list = cJSON_AddArrayToObject(params, "list");
+    cJSON_AddItemToArray(list, cJSON_CreateNumber(1));
+    cJSON_AddItemToArray(list, cJSON_CreateObject());
+    cJSON_AddItemToArray(list, cJSON_CreateArray());
+    char* expected = mjrpc_request_str("do\nit", params, cJSON_CreateNumber(99));
+
+    char buf[512];
+    size_t len;
+    mjrpc_request_writer_t w;
+    mjrpc_request_begin(&w, buf, sizeof(buf), "do\nit", 99);
+    mjrpc_request_add_string(&w, "name", "quote\" back\\ tab\t ctl\x01 \xc3\xa9");
+    mjrpc_request_add_int(&w, "n", -42);
+    mjrpc_request_add_double(&w, "x", 0.1);
+    mjrpc_request_add_double(&w, "big", 1e300);
+    mjrpc_request_add_bool(&w, "t", true);
+    mjrpc_request_add_null(&w, "z");
+    mjrpc_request_open_array(&w, "list");
+    mjrpc_request_add_int(&w, NULL, 1);
+    mjrpc_request_open_object(&w, NULL);
+    mjrpc_request_close(&w);
+    mjrpc_request_open_array(&w, NULL);
+    mjrpc_request_close(&w);
+    mjrpc_request_close(&w);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_request_end(&w, &len));
+    TEST_ASSERT_EQUAL_STRING(expected, buf);
+    TEST_ASSERT_EQUAL_size_t(strlen(expected), len);
+    free(expected);
+}
+
+void test_client_writer_positional_and_notification(void)
+{
+    char buf[128];
+    size_t len;
+    mjrpc_request_writer_t w;
+    mjrpc_request_begin(&w, buf, sizeof(buf), "sum", -3);
+    mjrpc_request_add_int(&w, NULL, INT64_MAX);
+    mjrpc_request_add_double(&w, NULL, 1.0 / 0.0);
+    mjrpc_request_add_raw(&w, NULL, "{\"a\":[1]}", 9);
+    mjrpc_request_add_string(&w, NULL, NULL);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_request_end(&w, &len));
+    TEST_ASSERT_EQUAL_STRING("{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":"
+                             "[9223372036854775807,null,{\"a\":[1]},null],\"id\":-3}",
+                             buf);
+
+    /* The writer is reusable and needs no params */
+    mjrpc_notification_begin(&w, buf, sizeof(buf), "ping");
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_request_end(&w, &len));
+    TEST_ASSERT_EQUAL_STRING("{\"jsonrpc\":\"2.0\",\"method\":\"ping\"}", buf);
+    TEST_ASSERT_EQUAL_size_t(strlen(buf), len);
+}
+
+void test_client_writer_too_large_reports_size(void)
+{
+    char buf[64];
+    size_t needed, len;
+    mjrpc_request_writer_t w;
+    mjrpc_request_begin(&w, NULL, 0, "method", 1);
+    mjrpc_request_add_string(&w, "key", "a fairly long value that will not fit");
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_TOO_LARGE, mjrpc_request_end(&w, &needed));
+
+    mjrpc_request_begin(&w, buf, sizeof(buf), "method", 1);
+    mjrpc_request_add_string(&w, "key", "a fairly long value that will not fit");
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_TOO_LARGE, mjrpc_request_end(&w, &len));
+    TEST_ASSERT_EQUAL_size_t(needed, len);
+
+    char* big = malloc(needed + 1);
+    mjrpc_request_begin(&w, big, needed + 1, "method", 1);
+    mjrpc_request_add_string(&w, "key", "a fairly long value that will not fit");
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_request_end(&w, &len));
+    TEST_ASSERT_EQUAL_size_t(needed, len);
+    TEST_ASSERT_EQUAL_size_t(needed, strlen(big));
+    free(big);
+}
+
+void test_client_writer_misuse(void)
+{
+    char buf[256];
+    mjrpc_request_writer_t w;
+    /* Mixed named and unnamed parameters */
+    mjrpc_request_begin(&w, buf, sizeof(buf), "m", 1);
+    mjrpc_request_add_int(&w, "a", 1);
+    mjrpc_request_add_int(&w, NULL, 2);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_request_end(&w, NULL));
+    /* Unbalanced containers */
+    mjrpc_request_begin(&w, buf, sizeof(buf), "m", 1);
+    mjrpc_request_open_array(&w, NULL);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_request_end(&w, NULL));
+    mjrpc_request_begin(&w, buf, sizeof(buf), "m", 1);
+    mjrpc_request_add_int(&w, NULL, 1);
+    mjrpc_request_close(&w);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_request_end(&w, NULL));
+    /* Too deep */
+    mjrpc_request_begin(&w, buf, sizeof(buf), "m", 1);
+    for (int i = 0; i < MJRPC_WRITER_MAX_DEPTH; i++)
+        mjrpc_request_open_array(&w, NULL);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_request_end(&w, NULL));
+    /* Missing arguments */
+    mjrpc_request_begin(&w, buf, sizeof(buf), NULL, 1);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_request_end(&w, NULL));
+    mjrpc_request_begin(&w, buf, sizeof(buf), "m", 1);
+    mjrpc_request_add_raw(&w, NULL, NULL, 0);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_request_end(&w, NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_request_end(NULL, NULL));
+    mjrpc_request_add_int(NULL, NULL, 1);
+    mjrpc_request_close(NULL);
+}
+
 int main(void)
 {
     UNITY_BEGIN();
@@ -109,5 +225,9 @@ int main(void)
     RUN_TEST(test_client_build_with_params_request_str);
     RUN_TEST(test_client_build_no_method_name_request_cjson);
     RUN_TEST(test_client_build_no_method_name_request_str);
+    RUN_TEST(test_client_writer_matches_request_str);
+    RUN_TEST(test_client_writer_positional_and_notification);
+    RUN_TEST(test_client_writer_too_large_reports_size);
+    RUN_TEST(test_client_writer_misuse);
     return UNITY_END();
 }
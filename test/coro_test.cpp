@@ -0,0 +1,189 @@
+/**
+ * @file coro_test.cpp
+ * @brief Tests for the C++20 coroutine adapter (mjsonrpc_coro.hpp)
+ *
+ * Covers:
+ *   - Coroutine handlers suspended on an external event loop
+ *   - Nested tasks and typed results
+ *   - Exceptions thrown after suspension
+ *   - Handlers that never suspend
+ *   - task<void> handlers and non-standard exceptions
+ */
+
+#include "unity.h"
+#include "mjsonrpc_coro.hpp"
+
+#include <deque>
+#include <string>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+/* Minimal event loop: awaiting `loop.next()` parks the coroutine */
+struct event_loop
+{
+    std::deque<std::coroutine_handle<>> ready;
+
+    struct awaiter
+    {
+        event_loop* loop;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { loop->ready.push_back(h); }
+        void await_resume() const noexcept {}
+    };
+
+    awaiter next() { return awaiter{this}; }
+
+    int run()
+    {
+        int steps = 0;
+        while (!ready.empty())
+        {
+            std::coroutine_handle<> h = ready.front();
+            ready.pop_front();
+            h.resume();
+            steps++;
+        }
+        return steps;
+    }
+};
+
+static mjrpc::task<int> slow_double(event_loop& loop, int v)
+{
+    co_await loop.next();
+    co_return v * 2;
+}
+
+static mjrpc::json parse(const char* text)
+{
+    mjrpc::json req = mjrpc::json::parse(text);
+    TEST_ASSERT_TRUE(static_cast<bool>(req));
+    return req;
+}
+
+void test_coroutine_resumed_by_loop(void)
+{
+    event_loop loop;
+    mjrpc::handle h;
+    mjrpc::add_coroutine(h, "double", [&loop](mjrpc::json params) -> mjrpc::task<int> {
+        int v = 0;
+        mjrpc::codec<int>::decode(cJSON_GetArrayItem(params.get(), 0), v);
+        int twice = co_await slow_double(loop, v);
+        co_await loop.next();
+        co_return twice + 1;
+    });
+
+    std::string out;
+    int calls = 0;
+    int ret = mjrpc::process_async(
+        h, parse(R"({"jsonrpc":"2.0","method":"double","params":[20],"id":1})"),
+        [&](mjrpc::json resp) {
+            calls++;
+            out = resp.dump();
+        });
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, ret);
+    TEST_ASSERT_EQUAL_INT(0, calls);
+
+    TEST_ASSERT_EQUAL_INT(2, loop.run());
+    TEST_ASSERT_EQUAL_INT(1, calls);
+    TEST_ASSERT_EQUAL_STRING(R"({"jsonrpc":"2.0","result":41,"id":1})", out.c_str());
+}
+
+void test_coroutine_error_after_suspend(void)
+{
+    event_loop loop;
+    mjrpc::handle h;
+    mjrpc::add_coroutine(h, "fail", [&loop](mjrpc::json) -> mjrpc::task<mjrpc::json> {
+        co_await loop.next();
+        throw mjrpc::error(-32010, "backend timeout");
+    });
+
+    mjrpc::json result;
+    mjrpc::process_async(h, parse(R"({"jsonrpc":"2.0","method":"fail","id":2})"),
+                         [&](mjrpc::json resp) { result = std::move(resp); });
+    loop.run();
+
+    mjrpc::response resp(std::move(result));
+    TEST_ASSERT_EQUAL_INT(-32010, resp.error_code());
+    TEST_ASSERT_EQUAL_STRING("backend timeout", resp.error_message().c_str());
+}
+
+void test_coroutine_without_suspension(void)
+{
+    mjrpc::handle h;
+    mjrpc::add_coroutine(h, "echo", [](mjrpc::json params) -> mjrpc::task<mjrpc::json> {
+        co_return params;
+    });
+    h.add("sync", []() { return std::string("plain"); });
+
+    std::string out;
+    mjrpc::process_async(h, parse(R"({"jsonrpc":"2.0","method":"echo","params":{"a":1},"id":3})"),
+                         [&](mjrpc::json resp) { out = resp.dump(); });
+    TEST_ASSERT_EQUAL_STRING(R"({"jsonrpc":"2.0","result":{"a":1},"id":3})", out.c_str());
+
+    mjrpc::process_async(h, parse(R"({"jsonrpc":"2.0","method":"sync","id":4})"),
+                         [&](mjrpc::json resp) { out = resp.dump(); });
+    TEST_ASSERT_EQUAL_STRING(R"({"jsonrpc":"2.0","result":"plain","id":4})", out.c_str());
+}
+
+void test_many_in_flight(void)
+{
+    event_loop loop;
+    mjrpc::handle h;
+    mjrpc::add_coroutine(h, "inc", [&loop](mjrpc::json params) -> mjrpc::task<int> {
+        int v = 0;
+        mjrpc::codec<int>::decode(cJSON_GetArrayItem(params.get(), 0), v);
+        co_await loop.next();
+        co_return v + 1;
+    });
+
+    int sum = 0;
+    for (int i = 0; i < 1000; i++)
+    {
+        mjrpc::request req = mjrpc::request::call("inc", i, i);
+        mjrpc::process_async(h, req.get(), [&](mjrpc::json resp) {
+            sum += mjrpc::response(std::move(resp)).result<int>();
+        });
+    }
+    TEST_ASSERT_EQUAL_INT(0, sum);
+    TEST_ASSERT_EQUAL_INT(1000, loop.run());
+    TEST_ASSERT_EQUAL_INT(500500, sum);
+}
+
+void test_void_and_unknown_exception(void)
+{
+    event_loop loop;
+    mjrpc::handle h;
+    int touched = 0;
+    mjrpc::add_coroutine(h, "touch", [&](mjrpc::json) -> mjrpc::task<void> {
+        co_await loop.next();
+        touched++;
+    });
+    /* Not a coroutine, so it throws before any task exists */
+    mjrpc::add_coroutine(h, "odd", [](mjrpc::json) -> mjrpc::task<int> { throw 42; });
+
+    std::string out;
+    mjrpc::process_async(h, parse(R"({"jsonrpc":"2.0","method":"touch","id":5})"),
+                         [&](mjrpc::json resp) { out = resp.dump(); });
+    TEST_ASSERT_EQUAL_INT(1, loop.run());
+    TEST_ASSERT_EQUAL_INT(1, touched);
+    TEST_ASSERT_EQUAL_STRING(R"({"jsonrpc":"2.0","result":null,"id":5})", out.c_str());
+
+    mjrpc::json result;
+    mjrpc::process_async(h, parse(R"({"jsonrpc":"2.0","method":"odd","id":6})"),
+                         [&](mjrpc::json resp) { result = std::move(resp); });
+    mjrpc::response resp(std::move(result));
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_INTERNAL_ERROR, resp.error_code());
+    TEST_ASSERT_EQUAL_STRING("Unknown exception.", resp.error_message().c_str());
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_coroutine_resumed_by_loop);
+    RUN_TEST(test_coroutine_error_after_suspend);
+    RUN_TEST(test_coroutine_without_suspension);
+    RUN_TEST(test_many_in_flight);
+    RUN_TEST(test_void_and_unknown_exception);
+    return UNITY_END();
+}
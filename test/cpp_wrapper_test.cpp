@@ -0,0 +1,278 @@
+/**
+ * @file cpp_wrapper_test.cpp
+ * @brief Tests for the header-only C++ wrapper (mjsonrpc.hpp)
+ *
+ * Covers:
+ *   - Typed positional and named parameter decoding
+ *   - Optional trailing arguments and type mismatches
+ *   - Integer bounds at 2^digits
+ *   - Exceptions mapped to JSON-RPC errors
+ *   - Allocations through the library's memory hooks
+ *   - Move-only request/response/handle objects
+ *   - Numeric vectors to and from typed arrays
+ */
+
+#include "unity.h"
+#include "mjsonrpc.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static mjrpc::response call(const mjrpc::handle& h, const mjrpc::request& req)
+{
+    return mjrpc::response(h.process(req.get()));
+}
+
+void test_positional_params(void)
+{
+    mjrpc::handle h;
+    h.add("add", [](int a, int b) { return a + b; });
+
+    mjrpc::response resp = call(h, mjrpc::request::call("add", 1, 2, 3));
+    TEST_ASSERT_TRUE(resp.ok());
+    TEST_ASSERT_EQUAL_INT(5, resp.result<int>());
+    TEST_ASSERT_EQUAL_INT(1, (int) resp.id()->valuedouble);
+
+    /* Too many arguments */
+    resp = call(h, mjrpc::request::call("add", 2, 1, 2, 3));
+    TEST_ASSERT_FALSE(resp.ok());
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_INVALID_PARAMS, resp.error_code());
+
+    /* Wrong type */
+    resp = call(h, mjrpc::request::call("add", 3, "x", 2));
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_INVALID_PARAMS, resp.error_code());
+
+    /* Non-integral number for an int argument */
+    resp = call(h, mjrpc::request::call("add", 4, 1.5, 2));
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_INVALID_PARAMS, resp.error_code());
+}
+
+void test_integer_bounds(void)
+{
+    mjrpc::handle h;
+    h.add("ll", [](long long v) { return v == std::numeric_limits<long long>::min(); });
+    h.add("u64", [](std::uint64_t v) { return v > 0; });
+    h.add("i32", [](std::int32_t v) { return v; });
+
+    /* 2^63, 2^64 and 2^31 are one past the largest value and must not convert */
+    std::optional<std::string> out =
+        h.process(R"({"jsonrpc":"2.0","method":"ll","params":[9223372036854775808],"id":1})");
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_INVALID_PARAMS, mjrpc::response::parse(*out).error_code());
+    out = h.process(R"({"jsonrpc":"2.0","method":"u64","params":[18446744073709551616],"id":2})");
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_INVALID_PARAMS, mjrpc::response::parse(*out).error_code());
+    out = h.process(R"({"jsonrpc":"2.0","method":"i32","params":[2147483648],"id":3})");
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_INVALID_PARAMS, mjrpc::response::parse(*out).error_code());
+
+    /* The bounds themselves still convert */
+    out = h.process(R"({"jsonrpc":"2.0","method":"ll","params":[-9223372036854775808],"id":4})");
+    TEST_ASSERT_TRUE(mjrpc::response::parse(*out).result<bool>());
+    out = h.process(R"({"jsonrpc":"2.0","method":"u64","params":[18446744073709549568],"id":5})");
+    TEST_ASSERT_TRUE(mjrpc::response::parse(*out).result<bool>());
+    out = h.process(R"({"jsonrpc":"2.0","method":"i32","params":[2147483647],"id":6})");
+    TEST_ASSERT_EQUAL_INT(2147483647, mjrpc::response::parse(*out).result<int>());
+}
+
+void test_named_params(void)
+{
+    mjrpc::handle h;
+    h.add("greet", {"name", "punct"},
+          [](std::string name, std::optional<std::string> punct) {
+              return "hi " + name + punct.value_or(".");
+          });
+
+    std::optional<std::string> out = h.process(
+        R"({"jsonrpc":"2.0","method":"greet","params":{"punct":"!","name":"bob"},"id":1})");
+    TEST_ASSERT_TRUE(out.has_value());
+    mjrpc::response resp = mjrpc::response::parse(*out);
+    TEST_ASSERT_EQUAL_STRING("hi bob!", resp.result<std::string>().c_str());
+
+    /* Optional argument omitted */
+    out = h.process(R"({"jsonrpc":"2.0","method":"greet","params":{"name":"amy"},"id":2})");
+    resp = mjrpc::response::parse(*out);
+    TEST_ASSERT_EQUAL_STRING("hi amy.", resp.result<std::string>().c_str());
+
+    /* Names match case-insensitively, as in mjrpc_params_get() */
+    out = h.process(R"({"jsonrpc":"2.0","method":"greet","params":{"Name":"kim","PUNCT":"?"},"id":4})");
+    resp = mjrpc::response::parse(*out);
+    TEST_ASSERT_EQUAL_STRING("hi kim?", resp.result<std::string>().c_str());
+
+    /* Positional works for named handlers too */
+    resp = call(h, mjrpc::request::call("greet", 3, "joe"));
+    TEST_ASSERT_EQUAL_STRING("hi joe.", resp.result<std::string>().c_str());
+
+    /* Required argument missing */
+    out = h.process(R"({"jsonrpc":"2.0","method":"greet","params":{},"id":4})");
+    resp = mjrpc::response::parse(*out);
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_INVALID_PARAMS, resp.error_code());
+}
+
+void test_vectors_and_void(void)
+{
+    mjrpc::handle h;
+    int calls = 0;
+    h.add("sum", [](const std::vector<double>& v) {
+        double s = 0;
+        for (double d : v)
+            s += d;
+        return s;
+    });
+    h.add("touch", [&calls]() { calls++; });
+
+    mjrpc::response resp =
+        call(h, mjrpc::request::call("sum", 1, std::vector<double>{1.5, 2.5, 3.0}));
+    TEST_ASSERT_TRUE(resp.result<double>() == 7.0);
+
+    resp = call(h, mjrpc::request::call("touch", 2));
+    TEST_ASSERT_TRUE(resp.ok());
+    TEST_ASSERT_EQUAL_INT(1, calls);
+
+    /* Notifications return nothing */
+    int code = -1;
+    mjrpc::json none = h.process(mjrpc::request::notify("touch").get(), &code);
+    TEST_ASSERT_FALSE(static_cast<bool>(none));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK_NOTIFICATION, code);
+    TEST_ASSERT_EQUAL_INT(2, calls);
+}
+
+void test_typed_vectors(void)
+{
+    mjrpc::handle h;
+    mjrpc_set_typed_arrays(h.get(), 2);
+    h.add("scale", [](mjrpc::typed_vector<double> v, double factor) {
+        for (double& d : v)
+            d *= factor;
+        return v;
+    });
+    h.add("count", [](const std::vector<int>& v) { return v.size(); });
+    h.add("exact", [](const std::vector<long long>& v) { return v.at(0) == 9007199254740993LL; });
+    h.add("narrow", [](const std::vector<int32_t>& v) { return v.size(); });
+
+    /* Typed in, typed out, printed like items */
+    std::optional<std::string> out =
+        h.process(R"({"jsonrpc":"2.0","method":"scale","params":[[1,2.5,-3],2],"id":1})");
+    TEST_ASSERT_EQUAL_STRING(R"({"jsonrpc":"2.0","result":[2,5,-6],"id":1})", out->c_str());
+
+    /* Element checks still apply to typed arrays */
+    out = h.process(R"({"jsonrpc":"2.0","method":"count","params":[[1,2,3]],"id":2})");
+    TEST_ASSERT_EQUAL_INT(3, mjrpc::response::parse(*out).result<int>());
+    out = h.process(R"({"jsonrpc":"2.0","method":"count","params":[[1,2.5,3]],"id":3})");
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_INVALID_PARAMS, mjrpc::response::parse(*out).error_code());
+
+    /* Integers past 2^53 decode without rounding; range checks still apply */
+    out = h.process(R"({"jsonrpc":"2.0","method":"exact","params":[[9007199254740993,1]],"id":4})");
+    TEST_ASSERT_TRUE(mjrpc::response::parse(*out).result<bool>());
+    out = h.process(R"({"jsonrpc":"2.0","method":"narrow","params":[[1,2147483648]],"id":5})");
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_INVALID_PARAMS, mjrpc::response::parse(*out).error_code());
+
+    /* Plain vectors stay items; typed_vector opts into one block */
+    mjrpc::json items(mjrpc::codec<std::vector<int>>::encode({4, 5}));
+    TEST_ASSERT_TRUE(cJSON_IsArray(items.get()));
+    TEST_ASSERT_EQUAL_STRING("[4,5]", items.dump().c_str());
+    mjrpc::json typed(mjrpc::codec<mjrpc::typed_vector<int>>::encode({4, 5}));
+    TEST_ASSERT_EQUAL_INT(cJSON_TypedInt64, cJSON_GetTypedArrayKind(typed.get()));
+    TEST_ASSERT_EQUAL_STRING("[4,5]", typed.dump().c_str());
+}
+
+void test_exceptions_become_errors(void)
+{
+    mjrpc::handle h;
+    h.add("fail", [](int code) -> int { throw mjrpc::error(code, "custom failure"); });
+    h.add("boom", []() -> int { throw std::runtime_error("boom"); });
+
+    mjrpc::response resp = call(h, mjrpc::request::call("fail", 1, -32001));
+    TEST_ASSERT_EQUAL_INT(-32001, resp.error_code());
+    TEST_ASSERT_EQUAL_STRING("custom failure", resp.error_message().c_str());
+
+    bool thrown = false;
+    try
+    {
+        resp.result<int>();
+    }
+    catch (const mjrpc::error& e)
+    {
+        thrown = e.code() == -32001;
+    }
+    TEST_ASSERT_TRUE(thrown);
+
+    resp = call(h, mjrpc::request::call("boom", 2));
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_INTERNAL_ERROR, resp.error_code());
+    TEST_ASSERT_EQUAL_STRING("boom", resp.error_message().c_str());
+}
+
+static long live_blocks = 0;
+
+static void* counting_malloc(size_t size)
+{
+    void* ptr = malloc(size);
+    if (ptr)
+        live_blocks++;
+    return ptr;
+}
+
+static void counting_free(void* ptr)
+{
+    if (ptr)
+        live_blocks--;
+    free(ptr);
+}
+
+static char* counting_strdup(const char* str)
+{
+    char* copy = static_cast<char*>(counting_malloc(strlen(str) + 1));
+    if (copy)
+        strcpy(copy, str);
+    return copy;
+}
+
+void test_memory_hooks(void)
+{
+    /* Bindings and error messages go through the library's hooks */
+    mjrpc_set_memory_hooks(counting_malloc, counting_free, counting_strdup);
+    live_blocks = 0;
+    {
+        mjrpc::handle h;
+        h.add("fail", []() -> int { throw mjrpc::error(-32001, "custom failure"); });
+        mjrpc::response resp = call(h, mjrpc::request::call("fail", 1));
+        TEST_ASSERT_EQUAL_STRING("custom failure", resp.error_message().c_str());
+    }
+    TEST_ASSERT_EQUAL_INT(0, live_blocks);
+    mjrpc_set_memory_hooks(NULL, NULL, NULL);
+}
+
+void test_replace_remove_and_move(void)
+{
+    mjrpc::handle h;
+    h.add("v", []() { return 1; });
+    h.add("v", []() { return 2; });
+    TEST_ASSERT_EQUAL_UINT(1, h.size());
+
+    mjrpc::handle moved(std::move(h));
+    mjrpc::response resp = call(moved, mjrpc::request::call("v", 1));
+    TEST_ASSERT_EQUAL_INT(2, resp.result<int>());
+
+    TEST_ASSERT_TRUE(moved.remove("v"));
+    TEST_ASSERT_FALSE(moved.remove("v"));
+    resp = call(moved, mjrpc::request::call("v", 2));
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_METHOD_NOT_FOUND, resp.error_code());
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_positional_params);
+    RUN_TEST(test_integer_bounds);
+    RUN_TEST(test_named_params);
+    RUN_TEST(test_vectors_and_void);
+    RUN_TEST(test_typed_vectors);
+    RUN_TEST(test_exceptions_become_errors);
+    RUN_TEST(test_memory_hooks);
+    RUN_TEST(test_replace_remove_and_move);
+    return UNITY_END();
+}
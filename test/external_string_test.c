@@ -0,0 +1,259 @@
+/**
+ * @file external_string_test.c
+ * @brief Tests for external string and raw items in the bundled cJSON
+ *
+ * Covers:
+ *   - Printing and releasing external strings and raws
+ *   - Duplicates sharing the value, released after the last one
+ *   - References and cJSON_SetValuestring() leaving the value alone
+ *   - Creation failures releasing right away
+ *   - Duplicates deleted on several threads
+ *   - Methods returning external strings, and cache hits sharing their text
+ *   - Items from node slabs next to external items
+ */
+
+#include "unity.h"
+#include "mjsonrpc.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int release_count = 0;
+static const char* released_value = NULL;
+static void* released_user_data = NULL;
+
+static void count_release(const char* value, void* user_data)
+{
+    __atomic_add_fetch(&release_count, 1, __ATOMIC_RELAXED);
+    released_value = value;
+    released_user_data = user_data;
+}
+
+void setUp(void)
+{
+    release_count = 0;
+    released_value = NULL;
+    released_user_data = NULL;
+}
+
+void tearDown(void)
+{
+    cJSON_InitHooks(NULL);
+}
+
+void test_print_and_release(void)
+{
+    static const char value[] = "a \"quoted\" value";
+    int user_data = 0;
+    cJSON* item = cJSON_CreateStringExternal(value, count_release, &user_data);
+    TEST_ASSERT_TRUE(cJSON_IsString(item));
+    TEST_ASSERT_TRUE(item->valuestring == value);
+
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddItemToObject(root, "s", item);
+    cJSON_AddItemToObject(root, "r", cJSON_CreateRawExternal("{\"raw\":[1,2]}", count_release, NULL));
+    TEST_ASSERT_TRUE(cJSON_IsRaw(cJSON_GetObjectItem(root, "r")));
+    char* printed = cJSON_PrintUnformatted(root);
+    TEST_ASSERT_EQUAL_STRING("{\"s\":\"a \\\"quoted\\\" value\",\"r\":{\"raw\":[1,2]}}", printed);
+    free(printed);
+    TEST_ASSERT_EQUAL_INT(0, release_count);
+
+    cJSON_DeleteItemFromObject(root, "s");
+    TEST_ASSERT_EQUAL_INT(1, release_count);
+    TEST_ASSERT_TRUE(released_value == value);
+    TEST_ASSERT_TRUE(released_user_data == &user_data);
+    cJSON_Delete(root);
+    TEST_ASSERT_EQUAL_INT(2, release_count);
+
+    /* Without a callback the value is just never given back */
+    cJSON_Delete(cJSON_CreateStringExternal(value, NULL, NULL));
+}
+
+void test_duplicates_share_the_value(void)
+{
+    char* value = strdup("shared");
+    cJSON* root = cJSON_CreateArray();
+    cJSON_AddItemToArray(root, cJSON_CreateStringExternal(value, count_release, NULL));
+    cJSON* copy = cJSON_Duplicate(root, true);
+    cJSON* single = cJSON_Duplicate(cJSON_GetArrayItem(root, 0), false);
+    TEST_ASSERT_TRUE(cJSON_GetArrayItem(copy, 0)->valuestring == value);
+    TEST_ASSERT_TRUE(single->valuestring == value);
+    TEST_ASSERT_TRUE(cJSON_Compare(root, copy, true));
+
+    cJSON_Delete(root);
+    cJSON_Delete(single);
+    TEST_ASSERT_EQUAL_INT(0, release_count);
+    char* printed = cJSON_PrintUnformatted(copy);
+    TEST_ASSERT_EQUAL_STRING("[\"shared\"]", printed);
+    free(printed);
+    cJSON_Delete(copy);
+    TEST_ASSERT_EQUAL_INT(1, release_count);
+    free(value);
+}
+
+void test_references_and_set_valuestring(void)
+{
+    static const char value[] = "fixed";
+    cJSON* item = cJSON_CreateStringExternal(value, count_release, NULL);
+    TEST_ASSERT_NULL(cJSON_SetValuestring(item, "x"));
+    TEST_ASSERT_EQUAL_STRING("fixed", item->valuestring);
+
+    /* A reference borrows the item's value without keeping it alive */
+    cJSON* array = cJSON_CreateArray();
+    cJSON_AddItemReferenceToArray(array, item);
+    char* printed = cJSON_PrintUnformatted(array);
+    TEST_ASSERT_EQUAL_STRING("[\"fixed\"]", printed);
+    free(printed);
+    cJSON_Delete(array);
+    TEST_ASSERT_EQUAL_INT(0, release_count);
+    cJSON_Delete(item);
+    TEST_ASSERT_EQUAL_INT(1, release_count);
+}
+
+static int allocations_left = 0;
+
+static void* failing_malloc(size_t size)
+{
+    if (allocations_left-- <= 0)
+        return NULL;
+    return malloc(size);
+}
+
+void test_failures_release_right_away(void)
+{
+    int user_data = 0;
+    TEST_ASSERT_NULL(cJSON_CreateStringExternal(NULL, count_release, &user_data));
+    TEST_ASSERT_EQUAL_INT(1, release_count);
+    TEST_ASSERT_NULL(released_value);
+
+    cJSON_Hooks hooks = {failing_malloc, free};
+    cJSON_InitHooks(&hooks);
+    for (int fail_at = 0; fail_at < 2; fail_at++)
+    {
+        allocations_left = fail_at;
+        TEST_ASSERT_NULL(cJSON_CreateRawExternal("1", count_release, &user_data));
+        TEST_ASSERT_EQUAL_INT(2 + fail_at, release_count);
+        TEST_ASSERT_EQUAL_STRING("1", released_value);
+    }
+
+    /* A failed duplicate gives its share back */
+    allocations_left = 2;
+    cJSON* item = cJSON_CreateStringExternal("v", count_release, NULL);
+    TEST_ASSERT_NOT_NULL(item);
+    TEST_ASSERT_NULL(cJSON_Duplicate(item, true));
+    cJSON_Delete(item);
+    TEST_ASSERT_EQUAL_INT(4, release_count);
+}
+
+#define THREADS 4
+#define COPIES_PER_THREAD 2000
+
+static void* delete_copies(void* arg)
+{
+    cJSON** copies = arg;
+    for (int i = 0; i < COPIES_PER_THREAD; i++)
+        cJSON_Delete(copies[i]);
+    return NULL;
+}
+
+void test_duplicates_deleted_on_threads(void)
+{
+    static cJSON* copies[THREADS][COPIES_PER_THREAD];
+    cJSON* item = cJSON_CreateStringExternal("threads", count_release, NULL);
+    for (int t = 0; t < THREADS; t++)
+        for (int i = 0; i < COPIES_PER_THREAD; i++)
+            copies[t][i] = cJSON_Duplicate(item, false);
+    cJSON_Delete(item);
+
+    pthread_t threads[THREADS];
+    for (int t = 0; t < THREADS; t++)
+        pthread_create(&threads[t], NULL, delete_copies, copies[t]);
+    for (int t = 0; t < THREADS; t++)
+        pthread_join(threads[t], NULL);
+    TEST_ASSERT_EQUAL_INT(1, release_count);
+}
+
+static char big_value[1 << 16];
+static int big_calls = 0;
+
+static cJSON* big_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) ctx;
+    (void) params;
+    (void) id;
+    big_calls++;
+    return cJSON_CreateStringExternal(big_value, count_release, NULL);
+}
+
+void test_methods_returning_external_strings(void)
+{
+    memset(big_value, 'x', sizeof(big_value) - 1);
+    mjrpc_handle_t* h = mjrpc_create_handle(8);
+    mjrpc_add_method(h, big_func, "big", NULL);
+    mjrpc_add_cached_method(h, big_func, "cached", NULL, 0);
+
+    /* Released once the response is printed */
+    char* response = mjrpc_process_str(h, "{\"jsonrpc\":\"2.0\",\"method\":\"big\",\"id\":1}", NULL);
+    TEST_ASSERT_EQUAL_INT(1, release_count);
+    TEST_ASSERT_EQUAL_size_t(sizeof(big_value) - 1 + 36, strlen(response));
+    TEST_ASSERT_NOT_NULL(strstr(response, "\"result\":\"xxx"));
+    free(response);
+
+    /* The cache serializes the result once; hits print that text */
+    big_calls = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        response = mjrpc_process_str(h, "{\"jsonrpc\":\"2.0\",\"method\":\"cached\",\"id\":2}", NULL);
+        TEST_ASSERT_EQUAL_size_t(sizeof(big_value) - 1 + 36, strlen(response));
+        free(response);
+    }
+    TEST_ASSERT_EQUAL_INT(1, big_calls);
+    TEST_ASSERT_EQUAL_INT(2, release_count);
+
+    /* Hits share the cached text, which outlives the entry while in use */
+    cJSON* request = cJSON_Parse("{\"jsonrpc\":\"2.0\",\"method\":\"cached\",\"id\":3}");
+    cJSON* first = mjrpc_process_cjson(h, request, NULL);
+    cJSON* second = mjrpc_process_cjson(h, request, NULL);
+    cJSON_Delete(request);
+    const cJSON* result = cJSON_GetObjectItem(first, "result");
+    TEST_ASSERT_TRUE(cJSON_IsRaw(result));
+    TEST_ASSERT_TRUE(result->valuestring == cJSON_GetObjectItem(second, "result")->valuestring);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_cache_invalidate(h, "cached", NULL));
+    cJSON_Delete(first);
+    TEST_ASSERT_EQUAL_size_t(sizeof(big_value) + 1, strlen(cJSON_GetObjectItem(second, "result")->valuestring));
+    cJSON_Delete(second);
+    TEST_ASSERT_EQUAL_INT(1, big_calls);
+    mjrpc_destroy_handle(h);
+}
+
+/* Enables the slabs for the rest of the process, so it runs last */
+void test_next_to_node_slabs(void)
+{
+    if (!cJSON_UseNodeSlabs(true))
+        TEST_IGNORE_MESSAGE("built without node slabs");
+    cJSON* root = cJSON_CreateArray();
+    for (int i = 0; i < 100; i++)
+    {
+        cJSON_AddItemToArray(root, cJSON_CreateNumber(i));
+        cJSON_AddItemToArray(root, cJSON_CreateStringExternal("e", count_release, NULL));
+    }
+    cJSON* copy = cJSON_Duplicate(root, true);
+    cJSON_Delete(root);
+    TEST_ASSERT_EQUAL_INT(0, release_count);
+    cJSON_Delete(copy);
+    TEST_ASSERT_EQUAL_INT(100, release_count);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_print_and_release);
+    RUN_TEST(test_duplicates_share_the_value);
+    RUN_TEST(test_references_and_set_valuestring);
+    RUN_TEST(test_failures_release_right_away);
+    RUN_TEST(test_duplicates_deleted_on_threads);
+    RUN_TEST(test_methods_returning_external_strings);
+    RUN_TEST(test_next_to_node_slabs);
+    return UNITY_END();
+}
@@ -0,0 +1,357 @@
+/**
+ * @file framer_test.c
+ * @brief Tests for the streaming framer (mjsonrpc_framer.h)
+ *
+ * Covers:
+ *   - Newline-delimited, Content-Length and length-prefixed framing
+ *   - Messages returned in place from attached chunks
+ *   - Messages split at every possible byte boundary
+ *   - Reading straight into the framer buffer
+ *   - Size limits and malformed headers
+ *   - Header and trailer helpers
+ *   - Allocations through the memory hooks
+ */
+
+#include "unity.h"
+#include "mjsonrpc_framer.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+/* Frame a list of messages into one stream */
+static size_t build_stream(enum mjrpc_framing framing, const char** messages, int count,
+                           char* out)
+{
+    size_t len = 0;
+    for (int i = 0; i < count; i++)
+    {
+        size_t n = strlen(messages[i]);
+        size_t trailer_len;
+        const char* trailer = mjrpc_frame_trailer(framing, &trailer_len);
+        size_t header_len;
+        mjrpc_frame_header(framing, n, out + len, &header_len);
+        len += header_len;
+        memcpy(out + len, messages[i], n);
+        len += n;
+        memcpy(out + len, trailer, trailer_len);
+        len += trailer_len;
+    }
+    return len;
+}
+
+/* Feed the stream in chunks of the given size and check every message */
+static void check_chunked(enum mjrpc_framing framing, const char* stream, size_t len,
+                          size_t chunk, const char** messages, int count)
+{
+    mjrpc_framer_t* f = mjrpc_framer_create(framing, 1024);
+    TEST_ASSERT_NOT_NULL(f);
+    int seen = 0;
+    for (size_t off = 0; off < len; off += chunk)
+    {
+        size_t n = len - off < chunk ? len - off : chunk;
+        /* A private copy, so returned slices cannot outlive the chunk */
+        char* copy = malloc(n);
+        memcpy(copy, stream + off, n);
+        TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_framer_feed(f, copy, n));
+        const char* msg;
+        size_t msg_len;
+        while (mjrpc_framer_next(f, &msg, &msg_len))
+        {
+            TEST_ASSERT_TRUE(seen < count);
+            TEST_ASSERT_EQUAL_size_t(strlen(messages[seen]), msg_len);
+            TEST_ASSERT_EQUAL_MEMORY(messages[seen], msg, msg_len);
+            seen++;
+        }
+        free(copy);
+    }
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_framer_error(f));
+    TEST_ASSERT_EQUAL_INT(count, seen);
+    TEST_ASSERT_EQUAL_size_t(0, mjrpc_framer_pending(f));
+    mjrpc_framer_destroy(f);
+}
+
+static const char* messages[] = {
+    "{\"jsonrpc\":\"2.0\",\"method\":\"a\",\"id\":1}",
+    "[]",
+    "{\"jsonrpc\":\"2.0\",\"method\":\"b\",\"params\":[\"\\n\"],\"id\":2}",
+    "x",
+};
+
+void test_every_split_point(void)
+{
+    enum mjrpc_framing framings[] = {MJRPC_FRAMING_NDJSON, MJRPC_FRAMING_CONTENT_LENGTH,
+                                     MJRPC_FRAMING_LENGTH_PREFIX};
+    char stream[1024];
+    for (size_t i = 0; i < sizeof(framings) / sizeof(framings[0]); i++)
+    {
+        size_t len = build_stream(framings[i], messages, 4, stream);
+        for (size_t chunk = 1; chunk <= len; chunk++)
+            check_chunked(framings[i], stream, len, chunk, messages, 4);
+    }
+}
+
+void test_ndjson_in_place_and_blank_lines(void)
+{
+    static const char stream[] = "{\"a\":1}\r\n\n  \r\n{\"b\":2}\n{\"c\"";
+    mjrpc_framer_t* f = mjrpc_framer_create(MJRPC_FRAMING_NDJSON, 1024);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_framer_feed(f, stream, sizeof(stream) - 1));
+
+    const char* msg;
+    size_t len;
+    TEST_ASSERT_TRUE(mjrpc_framer_next(f, &msg, &len));
+    TEST_ASSERT_EQUAL_PTR(stream, msg);
+    TEST_ASSERT_EQUAL_size_t(7, len);
+    TEST_ASSERT_TRUE(mjrpc_framer_next(f, &msg, &len));
+    TEST_ASSERT_TRUE(msg > stream && msg < stream + sizeof(stream));
+    TEST_ASSERT_EQUAL_MEMORY("{\"b\":2}", msg, len);
+    TEST_ASSERT_FALSE(mjrpc_framer_next(f, &msg, &len));
+    TEST_ASSERT_EQUAL_size_t(4, mjrpc_framer_pending(f));
+
+    /* The tail was copied, the next chunk completes it */
+    static const char more[] = ":3}\n{\"d\":4}\n";
+    mjrpc_framer_feed(f, more, sizeof(more) - 1);
+    TEST_ASSERT_TRUE(mjrpc_framer_next(f, &msg, &len));
+    TEST_ASSERT_EQUAL_MEMORY("{\"c\":3}", msg, len);
+    TEST_ASSERT_TRUE(mjrpc_framer_next(f, &msg, &len));
+    TEST_ASSERT_EQUAL_PTR(more + 4, msg);
+    TEST_ASSERT_EQUAL_size_t(7, len);
+    TEST_ASSERT_FALSE(mjrpc_framer_next(f, &msg, &len));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_framer_error(f));
+    mjrpc_framer_destroy(f);
+}
+
+void test_reserve_and_commit(void)
+{
+    mjrpc_framer_t* f = mjrpc_framer_create(MJRPC_FRAMING_CONTENT_LENGTH, 1 << 20);
+    const char* msg;
+    size_t len;
+    size_t avail;
+
+    /* Many messages written through the buffer, with a partial tail each time */
+    char frame[64];
+    char body[16];
+    int next_expected = 0;
+    for (int i = 0; i < 2000; i++)
+    {
+        int n = snprintf(body, sizeof(body), "[%d]", i);
+        size_t frame_len;
+        mjrpc_frame_header(MJRPC_FRAMING_CONTENT_LENGTH, (size_t) n, frame, &frame_len);
+        memcpy(frame + frame_len, body, (size_t) n);
+        frame_len += (size_t) n;
+
+        size_t half = frame_len / 2;
+        char* space = mjrpc_framer_reserve(f, 16, &avail);
+        TEST_ASSERT_NOT_NULL(space);
+        TEST_ASSERT_TRUE(avail >= 16);
+        memcpy(space, frame, half);
+        mjrpc_framer_commit(f, half);
+        while (mjrpc_framer_next(f, &msg, &len))
+        {
+            snprintf(body, sizeof(body), "[%d]", next_expected++);
+            TEST_ASSERT_EQUAL_MEMORY(body, msg, len);
+        }
+        space = mjrpc_framer_reserve(f, frame_len - half, &avail);
+        memcpy(space, frame + half, frame_len - half);
+        mjrpc_framer_commit(f, frame_len - half);
+    }
+    while (mjrpc_framer_next(f, &msg, &len))
+        next_expected++;
+    TEST_ASSERT_EQUAL_INT(2000, next_expected);
+    TEST_ASSERT_EQUAL_size_t(0, mjrpc_framer_pending(f));
+    mjrpc_framer_destroy(f);
+}
+
+void test_content_length_headers(void)
+{
+    /* Case-insensitive name, extra headers, body containing CRLFs */
+    static const char stream[] = "content-type: application/json\r\n"
+                                 "CONTENT-LENGTH:  6 \r\n"
+                                 "\r\n"
+                                 "[\r\n\r\n]";
+    mjrpc_framer_t* f = mjrpc_framer_create(MJRPC_FRAMING_CONTENT_LENGTH, 1024);
+    mjrpc_framer_feed(f, stream, sizeof(stream) - 1);
+    const char* msg;
+    size_t len;
+    TEST_ASSERT_TRUE(mjrpc_framer_next(f, &msg, &len));
+    TEST_ASSERT_EQUAL_size_t(6, len);
+    TEST_ASSERT_EQUAL_PTR(stream + sizeof(stream) - 7, msg);
+    mjrpc_framer_destroy(f);
+
+    /* A lone CR stays inside its line and hides no header */
+    static const char lone_cr[] = "X-Note: a\rb\r\r\nContent-Length: 2\r\n\r\n{}";
+    f = mjrpc_framer_create(MJRPC_FRAMING_CONTENT_LENGTH, 1024);
+    mjrpc_framer_feed(f, lone_cr, sizeof(lone_cr) - 1);
+    TEST_ASSERT_TRUE(mjrpc_framer_next(f, &msg, &len));
+    TEST_ASSERT_EQUAL_size_t(2, len);
+    TEST_ASSERT_EQUAL_MEMORY("{}", msg, 2);
+    mjrpc_framer_destroy(f);
+
+    /* Missing or malformed length */
+    static const char* broken[] = {"Content-Type: x\r\n\r\n{}", "Content-Length: 1x\r\n\r\n{}",
+                                   "Content-Length:\r\n\r\n{}"};
+    for (int i = 0; i < 3; i++)
+    {
+        f = mjrpc_framer_create(MJRPC_FRAMING_CONTENT_LENGTH, 1024);
+        mjrpc_framer_feed(f, broken[i], strlen(broken[i]));
+        TEST_ASSERT_FALSE(mjrpc_framer_next(f, &msg, &len));
+        TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_PARSE_FAILED, mjrpc_framer_error(f));
+        /* Errors are permanent */
+        mjrpc_framer_feed(f, "Content-Length: 2\r\n\r\n{}", 23);
+        TEST_ASSERT_FALSE(mjrpc_framer_next(f, &msg, &len));
+        mjrpc_framer_destroy(f);
+    }
+}
+
+void test_size_limits(void)
+{
+    const char* msg;
+    size_t len;
+
+    /* A line without newline that outgrows the limit */
+    char junk[200];
+    memset(junk, 'x', sizeof(junk));
+    mjrpc_framer_t* f = mjrpc_framer_create(MJRPC_FRAMING_NDJSON, 100);
+    mjrpc_framer_feed(f, junk, 50);
+    TEST_ASSERT_FALSE(mjrpc_framer_next(f, &msg, &len));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_framer_error(f));
+    mjrpc_framer_feed(f, junk, sizeof(junk));
+    TEST_ASSERT_FALSE(mjrpc_framer_next(f, &msg, &len));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_TOO_LARGE, mjrpc_framer_error(f));
+    mjrpc_framer_destroy(f);
+
+    /* Announced lengths are rejected before the body arrives */
+    char header[MJRPC_FRAME_HEADER_MAX];
+    size_t n;
+    mjrpc_frame_header(MJRPC_FRAMING_LENGTH_PREFIX, 101, header, &n);
+    f = mjrpc_framer_create(MJRPC_FRAMING_LENGTH_PREFIX, 100);
+    mjrpc_framer_feed(f, header, n);
+    TEST_ASSERT_FALSE(mjrpc_framer_next(f, &msg, &len));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_TOO_LARGE, mjrpc_framer_error(f));
+    mjrpc_framer_destroy(f);
+
+    mjrpc_frame_header(MJRPC_FRAMING_CONTENT_LENGTH, 101, header, &n);
+    f = mjrpc_framer_create(MJRPC_FRAMING_CONTENT_LENGTH, 100);
+    mjrpc_framer_feed(f, header, n);
+    TEST_ASSERT_FALSE(mjrpc_framer_next(f, &msg, &len));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_TOO_LARGE, mjrpc_framer_error(f));
+    mjrpc_framer_destroy(f);
+
+    /* A header block that never ends */
+    f = mjrpc_framer_create(MJRPC_FRAMING_CONTENT_LENGTH, 1 << 20);
+    char line[] = "X-Padding: aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\r\n";
+    for (int i = 0; i < 100 && mjrpc_framer_error(f) == MJRPC_RET_OK; i++)
+    {
+        mjrpc_framer_feed(f, line, sizeof(line) - 1);
+        TEST_ASSERT_FALSE(mjrpc_framer_next(f, &msg, &len));
+    }
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_TOO_LARGE, mjrpc_framer_error(f));
+    mjrpc_framer_destroy(f);
+}
+
+void test_frame_helpers(void)
+{
+    char header[MJRPC_FRAME_HEADER_MAX];
+    size_t len;
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_frame_header(MJRPC_FRAMING_NDJSON, 10, header, &len));
+    TEST_ASSERT_EQUAL_size_t(0, len);
+    TEST_ASSERT_EQUAL_STRING("\n", mjrpc_frame_trailer(MJRPC_FRAMING_NDJSON, &len));
+    TEST_ASSERT_EQUAL_size_t(1, len);
+
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK,
+                          mjrpc_frame_header(MJRPC_FRAMING_CONTENT_LENGTH, 1234, header, &len));
+    TEST_ASSERT_EQUAL_MEMORY("Content-Length: 1234\r\n\r\n", header, len);
+    mjrpc_frame_trailer(MJRPC_FRAMING_CONTENT_LENGTH, &len);
+    TEST_ASSERT_EQUAL_size_t(0, len);
+
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK,
+                          mjrpc_frame_header(MJRPC_FRAMING_LENGTH_PREFIX, 0x01020304, header, &len));
+    TEST_ASSERT_EQUAL_size_t(4, len);
+    TEST_ASSERT_EQUAL_MEMORY("\x01\x02\x03\x04", header, 4);
+
+    /* Lengths past the 4-byte prefix are refused, not truncated */
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK,
+                          mjrpc_frame_header(MJRPC_FRAMING_LENGTH_PREFIX, UINT32_MAX, header, &len));
+#if SIZE_MAX > UINT32_MAX
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_TOO_LARGE,
+                          mjrpc_frame_header(MJRPC_FRAMING_LENGTH_PREFIX, (size_t) UINT32_MAX + 1,
+                                             header, &len));
+    TEST_ASSERT_EQUAL_size_t(0, len);
+#endif
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM,
+                          mjrpc_frame_header((enum mjrpc_framing) 42, 1, header, &len));
+}
+
+static long live_blocks = 0;
+
+static void* counting_malloc(size_t size)
+{
+    void* ptr = malloc(size);
+    if (ptr)
+        live_blocks++;
+    return ptr;
+}
+
+static void counting_free(void* ptr)
+{
+    if (ptr)
+        live_blocks--;
+    free(ptr);
+}
+
+static char* counting_strdup(const char* str)
+{
+    char* copy = counting_malloc(strlen(str) + 1);
+    if (copy)
+        strcpy(copy, str);
+    return copy;
+}
+
+void test_memory_hooks(void)
+{
+    mjrpc_set_memory_hooks(counting_malloc, counting_free, counting_strdup);
+    mjrpc_framer_t* f = mjrpc_framer_create(MJRPC_FRAMING_NDJSON, 1 << 20);
+    size_t avail;
+    TEST_ASSERT_NOT_NULL(mjrpc_framer_reserve(f, 100000, &avail));
+    TEST_ASSERT_EQUAL_INT(2, live_blocks);
+    mjrpc_framer_destroy(f);
+    TEST_ASSERT_EQUAL_INT(0, live_blocks);
+    mjrpc_set_memory_hooks(NULL, NULL, NULL);
+}
+
+void test_framer_invalid_params(void)
+{
+    const char* msg;
+    size_t len;
+    size_t avail;
+    TEST_ASSERT_NULL(mjrpc_framer_create((enum mjrpc_framing) 42, 10));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_framer_feed(NULL, "x", 1));
+    TEST_ASSERT_FALSE(mjrpc_framer_next(NULL, &msg, &len));
+    TEST_ASSERT_NULL(mjrpc_framer_reserve(NULL, 1, &avail));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_framer_error(NULL));
+    mjrpc_framer_destroy(NULL);
+
+    mjrpc_framer_t* f = mjrpc_framer_create(MJRPC_FRAMING_NDJSON, 10);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_framer_feed(f, NULL, 1));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_framer_feed(f, NULL, 0));
+    TEST_ASSERT_FALSE(mjrpc_framer_next(f, &msg, &len));
+    mjrpc_framer_destroy(f);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_every_split_point);
+    RUN_TEST(test_ndjson_in_place_and_blank_lines);
+    RUN_TEST(test_reserve_and_commit);
+    RUN_TEST(test_content_length_headers);
+    RUN_TEST(test_size_limits);
+    RUN_TEST(test_frame_helpers);
+    RUN_TEST(test_memory_hooks);
+    RUN_TEST(test_framer_invalid_params);
+    return UNITY_END();
+}
@@ -0,0 +1,265 @@
+/**
+ * @file interceptor_test.c
+ * @brief Tests for the interceptor chain
+ *
+ * Covers:
+ *   - Call order of before and after stages around the method
+ *   - Rejection short-circuiting the chain
+ *   - Per-interceptor state and response rewriting
+ *   - Notifications, batches and asynchronous methods
+ *   - Removal, limits and invalid parameters
+ */
+
+#include "unity.h"
+#include "mjsonrpc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static char trace[256];
+
+static void note(const char* what)
+{
+    strcat(trace, what);
+    strcat(trace, " ");
+}
+
+static cJSON* method_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) ctx;
+    (void) params;
+    (void) id;
+    note("m");
+    return cJSON_CreateString("done");
+}
+
+/* ctx->data is the interceptor's name, e.g. "1" */
+static void before_note(mjrpc_intercept_ctx_t* ctx)
+{
+    char what[16] = "b";
+    strcat(what, ctx->data);
+    note(what);
+}
+
+static void after_note(mjrpc_intercept_ctx_t* ctx, cJSON* response)
+{
+    (void) response;
+    char what[16] = "a";
+    strcat(what, ctx->data);
+    note(what);
+}
+
+static void reject(mjrpc_intercept_ctx_t* ctx)
+{
+    note("reject");
+    ctx->error_code = -32001;
+    ctx->error_message = strdup("Unauthorized.");
+}
+
+static void before_stamp(mjrpc_intercept_ctx_t* ctx)
+{
+    ctx->state = (void*) ctx->method;
+}
+
+static void after_stamp(mjrpc_intercept_ctx_t* ctx, cJSON* response)
+{
+    if (response)
+        cJSON_AddStringToObject(response, "traced", ctx->state);
+}
+
+static cJSON* process(mjrpc_handle_t* h, const char* request, int* ret)
+{
+    char* text = mjrpc_process_str(h, request, ret);
+    cJSON* response = text ? cJSON_Parse(text) : NULL;
+    free(text);
+    return response;
+}
+
+static mjrpc_handle_t* make_chain(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, method_func, "m", NULL);
+    mjrpc_add_interceptor(h, before_note, after_note, strdup("1"));
+    mjrpc_add_interceptor(h, before_note, NULL, strdup("2"));
+    mjrpc_add_interceptor(h, before_note, after_note, strdup("3"));
+    return h;
+}
+
+void test_interceptor_order(void)
+{
+    mjrpc_handle_t* h = make_chain();
+    trace[0] = '\0';
+    int ret;
+    cJSON* response = process(h, "{\"jsonrpc\":\"2.0\",\"method\":\"m\",\"id\":1}", &ret);
+    TEST_ASSERT_EQUAL_STRING("b1 b2 b3 m a3 a1 ", trace);
+    TEST_ASSERT_EQUAL_STRING("done", cJSON_GetObjectItem(response, "result")->valuestring);
+    cJSON_Delete(response);
+
+    /* Unknown methods pass through the chain as well */
+    trace[0] = '\0';
+    response = process(h, "{\"jsonrpc\":\"2.0\",\"method\":\"x\",\"id\":1}", &ret);
+    TEST_ASSERT_EQUAL_STRING("b1 b2 b3 a3 a1 ", trace);
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_METHOD_NOT_FOUND,
+                          cJSON_GetObjectItem(cJSON_GetObjectItem(response, "error"), "code")->valueint);
+    cJSON_Delete(response);
+    mjrpc_destroy_handle(h);
+}
+
+void test_interceptor_rejects(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, method_func, "m", NULL);
+    mjrpc_add_interceptor(h, before_note, after_note, strdup("1"));
+    mjrpc_add_interceptor(h, reject, after_note, strdup("2"));
+    mjrpc_add_interceptor(h, before_note, after_note, strdup("3"));
+
+    trace[0] = '\0';
+    int ret;
+    cJSON* response = process(h, "{\"jsonrpc\":\"2.0\",\"method\":\"m\",\"id\":7}", &ret);
+    TEST_ASSERT_EQUAL_STRING("b1 reject a2 a1 ", trace);
+    cJSON* error = cJSON_GetObjectItem(response, "error");
+    TEST_ASSERT_EQUAL_INT(-32001, cJSON_GetObjectItem(error, "code")->valueint);
+    TEST_ASSERT_EQUAL_STRING("Unauthorized.", cJSON_GetObjectItem(error, "message")->valuestring);
+    TEST_ASSERT_EQUAL_INT(7, cJSON_GetObjectItem(response, "id")->valueint);
+    cJSON_Delete(response);
+
+    /* A rejected notification produces no response */
+    trace[0] = '\0';
+    response = process(h, "{\"jsonrpc\":\"2.0\",\"method\":\"m\"}", &ret);
+    TEST_ASSERT_NULL(response);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK_NOTIFICATION, ret);
+    TEST_ASSERT_EQUAL_STRING("b1 reject a2 a1 ", trace);
+
+    /* Without the rejecting interceptor the call goes through again */
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_del_interceptor(h, reject, after_note));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_NOT_FOUND, mjrpc_del_interceptor(h, reject, after_note));
+    trace[0] = '\0';
+    response = process(h, "{\"jsonrpc\":\"2.0\",\"method\":\"m\",\"id\":1}", &ret);
+    TEST_ASSERT_EQUAL_STRING("b1 b3 m a3 a1 ", trace);
+    cJSON_Delete(response);
+    mjrpc_destroy_handle(h);
+}
+
+void test_interceptor_state_and_response(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, method_func, "m", NULL);
+    mjrpc_add_interceptor(h, before_stamp, after_stamp, NULL);
+    int ret;
+    cJSON* response = process(h, "[{\"jsonrpc\":\"2.0\",\"method\":\"m\",\"id\":1},"
+                                 "{\"jsonrpc\":\"2.0\",\"method\":\"m\"},"
+                                 "{\"jsonrpc\":\"2.0\",\"method\":\"m\",\"id\":2}]",
+                              &ret);
+    TEST_ASSERT_EQUAL_INT(2, cJSON_GetArraySize(response));
+    for (int i = 0; i < 2; i++)
+        TEST_ASSERT_EQUAL_STRING(
+            "m", cJSON_GetObjectItem(cJSON_GetArrayItem(response, i), "traced")->valuestring);
+    cJSON_Delete(response);
+    mjrpc_destroy_handle(h);
+}
+
+static mjrpc_async_token_t* parked = NULL;
+
+static void park_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id, mjrpc_async_token_t* token)
+{
+    (void) ctx;
+    (void) params;
+    (void) id;
+    note("m");
+    parked = token;
+}
+
+/* Stands in for a start time that outlives the request */
+static void before_clock(mjrpc_intercept_ctx_t* ctx)
+{
+    ctx->state = "t0";
+}
+
+/* Notes the method, the state of "before" and the response */
+static void after_seen(mjrpc_intercept_ctx_t* ctx, cJSON* response)
+{
+    note(ctx->method);
+    note(ctx->state ? ctx->state : "-");
+    char* text = response ? cJSON_PrintUnformatted(response) : NULL;
+    note(text ? text : "null");
+    free(text);
+}
+
+static void keep_response(cJSON* response, void* user_data)
+{
+    *(cJSON**) user_data = response;
+}
+
+void test_interceptor_async_method(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_async_method(h, park_func, "park", NULL);
+    mjrpc_add_interceptor(h, before_clock, after_seen, NULL);
+    trace[0] = '\0';
+    cJSON* request = cJSON_Parse("{\"jsonrpc\":\"2.0\",\"method\":\"park\",\"id\":3}");
+    cJSON* response = NULL;
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_process_async(h, request, keep_response, &response));
+    cJSON_Delete(request);
+
+    /* The "after" stage waits for the result, not the method's return */
+    TEST_ASSERT_EQUAL_STRING("m ", trace);
+    mjrpc_complete(parked, cJSON_CreateNumber(1));
+    TEST_ASSERT_EQUAL_STRING("m park t0 {\"jsonrpc\":\"2.0\",\"result\":1,\"id\":3} ", trace);
+    TEST_ASSERT_EQUAL_INT(3, cJSON_GetObjectItem(response, "id")->valueint);
+    cJSON_Delete(response);
+
+    /* Failures and batch elements are seen the same way */
+    trace[0] = '\0';
+    request = cJSON_Parse("[{\"jsonrpc\":\"2.0\",\"method\":\"park\",\"id\":4},"
+                          "{\"jsonrpc\":\"2.0\",\"method\":\"none\",\"id\":5}]");
+    response = NULL;
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_process_async(h, request, keep_response, &response));
+    cJSON_Delete(request);
+    TEST_ASSERT_EQUAL_STRING("m none t0 {\"jsonrpc\":\"2.0\",\"error\":{\"code\":-32601,"
+                             "\"message\":\"Method not found.\"},\"id\":5} ",
+                             trace);
+    TEST_ASSERT_NULL(response);
+    trace[0] = '\0';
+    mjrpc_fail(parked, -32002, "Busy.");
+    TEST_ASSERT_EQUAL_STRING("park t0 {\"jsonrpc\":\"2.0\",\"error\":{\"code\":-32002,"
+                             "\"message\":\"Busy.\"},\"id\":4} ",
+                             trace);
+    TEST_ASSERT_EQUAL_INT(2, cJSON_GetArraySize(response));
+    cJSON_Delete(response);
+    mjrpc_destroy_handle(h);
+}
+
+void test_interceptor_limits_and_invalid_params(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED,
+                          mjrpc_add_interceptor(NULL, before_note, NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_add_interceptor(h, NULL, NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED,
+                          mjrpc_del_interceptor(NULL, before_note, NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_NOT_FOUND, mjrpc_del_interceptor(h, before_note, NULL));
+
+    for (int i = 0; i < MJRPC_MAX_INTERCEPTORS; i++)
+        TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_add_interceptor(h, before_stamp, NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_TOO_LARGE,
+                          mjrpc_add_interceptor(h, before_stamp, NULL, NULL));
+    for (int i = 0; i < MJRPC_MAX_INTERCEPTORS; i++)
+        TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_del_interceptor(h, before_stamp, NULL));
+    TEST_ASSERT_EQUAL_size_t(0, h->interceptor_count);
+    TEST_ASSERT_NULL(h->interceptors);
+    mjrpc_destroy_handle(h);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_interceptor_order);
+    RUN_TEST(test_interceptor_rejects);
+    RUN_TEST(test_interceptor_state_and_response);
+    RUN_TEST(test_interceptor_async_method);
+    RUN_TEST(test_interceptor_limits_and_invalid_params);
+    return UNITY_END();
+}
@@ -0,0 +1,337 @@
+/**
+ * @file msgpack_test.c
+ * @brief Tests for mjrpc_process_msgpack() and the MessagePack codec
+ *
+ * Covers:
+ *   - Exact encodings of numbers, strings and containers
+ *   - Round trips of every JSON type, long strings and deep nesting
+ *   - Calls with named and positional params, notifications and batches
+ *   - Typed arrays nested in params, and cached results sent as raw JSON
+ *   - Malformed, truncated and unsupported input answered with a parse error
+ */
+
+#include "unity.h"
+#include "mjsonrpc_msgpack.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static mjrpc_handle_t* handle = NULL;
+
+void setUp(void)
+{
+    handle = mjrpc_create_handle(16);
+}
+
+void tearDown(void)
+{
+    mjrpc_destroy_handle(handle);
+    handle = NULL;
+}
+
+static cJSON* add(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) params;
+    (void) id;
+    cJSON* a = mjrpc_params_get(ctx, "a");
+    cJSON* b = mjrpc_params_get(ctx, "b");
+    if (a == NULL)
+        a = mjrpc_params_at(ctx, 0);
+    if (b == NULL)
+        b = mjrpc_params_at(ctx, 1);
+    if (!cJSON_IsNumber(a) || !cJSON_IsNumber(b))
+    {
+        ctx->error_code = JSON_RPC_CODE_INVALID_PARAMS;
+        ctx->error_message = strdup("a and b must be numbers");
+        return NULL;
+    }
+    return cJSON_CreateNumber(a->valuedouble + b->valuedouble);
+}
+
+static cJSON* describe(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) params;
+    (void) id;
+    cJSON* samples = mjrpc_params_get(ctx, "samples");
+    cJSON* result = cJSON_CreateObject();
+    cJSON_AddNumberToObject(result, "kind", cJSON_GetTypedArrayKind(samples));
+    cJSON_AddNumberToObject(result, "size", (double) cJSON_GetTypedArraySize(samples));
+    cJSON_AddItemToObject(result, "samples", cJSON_Duplicate(samples, true));
+    return result;
+}
+
+static void assert_bytes(const char* expected, size_t expected_len, const char* actual, size_t actual_len)
+{
+    TEST_ASSERT_EQUAL_size_t(expected_len, actual_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, actual, expected_len);
+}
+
+static void assert_encodes(const char* json, const char* expected, size_t expected_len)
+{
+    cJSON* item = cJSON_Parse(json);
+    size_t len = 0;
+    char* bytes = mjrpc_msgpack_encode(item, &len);
+    assert_bytes(expected, expected_len, bytes, len);
+    cJSON* decoded = mjrpc_msgpack_decode(bytes, len);
+    TEST_ASSERT_TRUE(cJSON_Compare(item, decoded, true));
+    cJSON_Delete(decoded);
+    cJSON_Delete(item);
+    free(bytes);
+}
+
+/* Encode a request, process it and decode the response */
+static cJSON* call(const char* json, int* ret_code)
+{
+    cJSON* request = cJSON_Parse(json);
+    TEST_ASSERT_NOT_NULL(request);
+    size_t len = 0;
+    char* bytes = mjrpc_msgpack_encode(request, &len);
+    cJSON_Delete(request);
+    size_t response_len = 1;
+    char* response = mjrpc_process_msgpack(handle, bytes, len, &response_len, ret_code);
+    free(bytes);
+    if (response == NULL)
+    {
+        TEST_ASSERT_EQUAL_size_t(0, response_len);
+        return NULL;
+    }
+    cJSON* decoded = mjrpc_msgpack_decode(response, response_len);
+    TEST_ASSERT_NOT_NULL(decoded);
+    free(response);
+    return decoded;
+}
+
+void test_exact_encodings(void)
+{
+    assert_encodes("null", "\xc0", 1);
+    assert_encodes("[true,false]", "\x92\xc3\xc2", 3);
+    assert_encodes("[0,127,128,255,256,65536]",
+                   "\x96\x00\x7f\xcc\x80\xcc\xff\xcd\x01\x00\xce\x00\x01\x00\x00", 15);
+    assert_encodes("[-1,-32,-33,-129,-32769]", "\x95\xff\xe0\xd0\xdf\xd1\xff\x7f\xd2\xff\xff\x7f\xff", 13);
+    assert_encodes("[1.5,0.1]", "\x92\xca\x3f\xc0\x00\x00\xcb\x3f\xb9\x99\x99\x99\x99\x99\x9a", 15);
+    assert_encodes("[4294967296]", "\x91\xcf\x00\x00\x00\x01\x00\x00\x00\x00", 10);
+    assert_encodes("{\"a\":\"bc\",\"d\":{}}", "\x82\xa1" "a" "\xa2" "bc" "\xa1" "d" "\x80", 9);
+
+    /* NaN has no JSON form and goes out as nil */
+    cJSON* nan = cJSON_CreateNumber(NAN);
+    size_t len = 0;
+    char* bytes = mjrpc_msgpack_encode(nan, &len);
+    assert_bytes("\xc0", 1, bytes, len);
+    free(bytes);
+    cJSON_Delete(nan);
+
+    TEST_ASSERT_NULL(mjrpc_msgpack_encode(NULL, &len));
+}
+
+void test_decodes_every_form(void)
+{
+    /* int8/16/32/64, uint64 beyond int64, float32, str8 key, array16, map16 */
+    static const char bytes[] = "\xde\x00\x03"
+                                "\xd9\x01" "i"
+                                "\xdc\x00\x04\xd0\x80\xd1\x80\x00\xd2\x80\x00\x00\x00\xd3\xff\xff\xff\xff\xff\xff\xff\xfe"
+                                "\xa1" "u"
+                                "\xcf\xff\xff\xff\xff\xff\xff\xff\xff"
+                                "\xa1" "f"
+                                "\xca\x40\x20\x00\x00";
+    cJSON* item = mjrpc_msgpack_decode(bytes, sizeof(bytes) - 1);
+    TEST_ASSERT_NOT_NULL(item);
+    cJSON* ints = cJSON_GetObjectItem(item, "i");
+    TEST_ASSERT_EQUAL_INT(4, cJSON_GetArraySize(ints));
+    TEST_ASSERT_TRUE(cJSON_GetArrayItem(ints, 0)->valuedouble == -128);
+    TEST_ASSERT_TRUE(cJSON_GetArrayItem(ints, 1)->valuedouble == -32768);
+    TEST_ASSERT_TRUE(cJSON_GetArrayItem(ints, 2)->valuedouble == -2147483648.0);
+    TEST_ASSERT_TRUE(cJSON_GetArrayItem(ints, 3)->valuedouble == -2);
+    TEST_ASSERT_TRUE(cJSON_GetObjectItem(item, "u")->valuedouble == 18446744073709551615.0);
+    TEST_ASSERT_TRUE(cJSON_GetObjectItem(item, "f")->valuedouble == 2.5);
+    cJSON_Delete(item);
+}
+
+void test_round_trips(void)
+{
+    cJSON* root = cJSON_CreateObject();
+    size_t sizes[] = {0, 31, 32, 255, 256, 65535, 65536};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        char* s = malloc(sizes[i] + 1);
+        memset(s, 'a' + (int) i, sizes[i]);
+        s[sizes[i]] = '\0';
+        cJSON_AddItemToObject(root, s, cJSON_CreateString(s));
+        free(s);
+    }
+    cJSON* big = cJSON_AddArrayToObject(root, "big");
+    for (int i = 0; i < 70000; i++)
+        cJSON_AddItemToArray(big, cJSON_CreateNumber(i % 3 ? i * 0.5 : -i));
+    cJSON_AddItemToObject(root, "unicode", cJSON_CreateString("\xc3\xa9\xe2\x82\xac"));
+
+    /* Deeper than any recursion would like, within the nesting limit */
+    cJSON* deep = cJSON_AddArrayToObject(root, "deep");
+    for (int i = 0; i < CJSON_NESTING_LIMIT - 3; i++)
+    {
+        cJSON* inner = cJSON_CreateArray();
+        cJSON_AddItemToArray(deep, inner);
+        deep = inner;
+    }
+
+    size_t len = 0;
+    char* bytes = mjrpc_msgpack_encode(root, &len);
+    TEST_ASSERT_NOT_NULL(bytes);
+    cJSON* decoded = mjrpc_msgpack_decode(bytes, len);
+    TEST_ASSERT_NOT_NULL(decoded);
+    TEST_ASSERT_TRUE(cJSON_Compare(root, decoded, true));
+    cJSON_Delete(decoded);
+    free(bytes);
+    cJSON_Delete(root);
+}
+
+void test_calls(void)
+{
+    mjrpc_add_method(handle, add, "add", NULL);
+    int ret = -1;
+
+    cJSON* response = call("{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":{\"a\":2,\"b\":3},\"id\":7}", &ret);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, ret);
+    TEST_ASSERT_EQUAL_STRING("2.0", cJSON_GetObjectItem(response, "jsonrpc")->valuestring);
+    TEST_ASSERT_TRUE(cJSON_GetObjectItem(response, "result")->valuedouble == 5);
+    TEST_ASSERT_TRUE(cJSON_GetObjectItem(response, "id")->valuedouble == 7);
+    cJSON_Delete(response);
+
+    response = call("{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":[1.25,-4],\"id\":\"x\"}", &ret);
+    TEST_ASSERT_TRUE(cJSON_GetObjectItem(response, "result")->valuedouble == -2.75);
+    TEST_ASSERT_EQUAL_STRING("x", cJSON_GetObjectItem(response, "id")->valuestring);
+    cJSON_Delete(response);
+
+    response = call("{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":[\"1\",2],\"id\":1}", &ret);
+    cJSON* error = cJSON_GetObjectItem(response, "error");
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_INVALID_PARAMS, cJSON_GetObjectItem(error, "code")->valueint);
+    cJSON_Delete(response);
+
+    TEST_ASSERT_NULL(call("{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":[1,2]}", &ret));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK_NOTIFICATION, ret);
+
+    response = call("[{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":[1,2],\"id\":1},"
+                    "{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":[3,4]},"
+                    "{\"jsonrpc\":\"2.0\",\"method\":\"nope\",\"id\":2}]",
+                    &ret);
+    TEST_ASSERT_EQUAL_INT(2, cJSON_GetArraySize(response));
+    TEST_ASSERT_TRUE(cJSON_GetObjectItem(cJSON_GetArrayItem(response, 0), "result")->valuedouble == 3);
+    error = cJSON_GetObjectItem(cJSON_GetArrayItem(response, 1), "error");
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_METHOD_NOT_FOUND, cJSON_GetObjectItem(error, "code")->valueint);
+    cJSON_Delete(response);
+}
+
+void test_typed_arrays_in_params(void)
+{
+    mjrpc_add_method(handle, describe, "describe", NULL);
+    mjrpc_add_method(handle, add, "add", NULL);
+    TEST_ASSERT_EQUAL_size_t(0, mjrpc_get_typed_arrays(handle));
+    mjrpc_set_typed_arrays(handle, 4);
+    TEST_ASSERT_EQUAL_size_t(4, mjrpc_get_typed_arrays(handle));
+    int ret;
+
+    cJSON* response =
+        call("{\"jsonrpc\":\"2.0\",\"method\":\"describe\",\"params\":{\"samples\":[1,-2,300000,4]},\"id\":1}", &ret);
+    cJSON* result = cJSON_GetObjectItem(response, "result");
+    TEST_ASSERT_EQUAL_INT(cJSON_TypedInt64, cJSON_GetObjectItem(result, "kind")->valueint);
+    TEST_ASSERT_EQUAL_INT(4, cJSON_GetObjectItem(result, "size")->valueint);
+    cJSON* expected = cJSON_Parse("[1,-2,300000,4]");
+    TEST_ASSERT_TRUE(cJSON_Compare(expected, cJSON_GetObjectItem(result, "samples"), true));
+    cJSON_Delete(expected);
+    cJSON_Delete(response);
+
+    response =
+        call("{\"jsonrpc\":\"2.0\",\"method\":\"describe\",\"params\":{\"samples\":[1,0.5,2,3]},\"id\":1}", &ret);
+    result = cJSON_GetObjectItem(response, "result");
+    TEST_ASSERT_EQUAL_INT(cJSON_TypedDouble, cJSON_GetObjectItem(result, "kind")->valueint);
+    cJSON_Delete(response);
+
+    /* Too short, or not numbers only: ordinary arrays */
+    response = call("{\"jsonrpc\":\"2.0\",\"method\":\"describe\",\"params\":{\"samples\":[1,2,\"3\",4]},\"id\":1}",
+                    &ret);
+    TEST_ASSERT_EQUAL_INT(0, cJSON_GetObjectItem(cJSON_GetObjectItem(response, "result"), "kind")->valueint);
+    cJSON_Delete(response);
+
+    /* The params array itself stays made of items, also in a batch */
+    response = call("[{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":[1,2,3,4,5],\"id\":1}]", &ret);
+    TEST_ASSERT_TRUE(cJSON_GetObjectItem(cJSON_GetArrayItem(response, 0), "result")->valuedouble == 3);
+    cJSON_Delete(response);
+    response = call("{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":[1,2,3,4,5],\"id\":1}", &ret);
+    TEST_ASSERT_TRUE(cJSON_GetObjectItem(response, "result")->valuedouble == 3);
+    cJSON_Delete(response);
+}
+
+void test_cached_results(void)
+{
+    mjrpc_add_cached_method(handle, add, "add", NULL, 0);
+    for (int i = 0; i < 3; i++)
+    {
+        int ret;
+        cJSON* response = call("{\"jsonrpc\":\"2.0\",\"method\":\"add\",\"params\":[40,2],\"id\":9}", &ret);
+        TEST_ASSERT_TRUE(cJSON_IsNumber(cJSON_GetObjectItem(response, "result")));
+        TEST_ASSERT_TRUE(cJSON_GetObjectItem(response, "result")->valuedouble == 42);
+        TEST_ASSERT_TRUE(cJSON_GetObjectItem(response, "id")->valuedouble == 9);
+        cJSON_Delete(response);
+    }
+    mjrpc_cache_stats_t stats;
+    mjrpc_get_cache_stats(handle, &stats);
+    TEST_ASSERT_EQUAL_UINT64(2, stats.hits);
+}
+
+static void assert_parse_error(const char* bytes, size_t len)
+{
+    int ret = 0;
+    size_t response_len = 0;
+    char* response = mjrpc_process_msgpack(handle, bytes, len, &response_len, &ret);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_PARSE_FAILED, ret);
+    cJSON* decoded = mjrpc_msgpack_decode(response, response_len);
+    cJSON* error = cJSON_GetObjectItem(decoded, "error");
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_PARSE_ERROR, cJSON_GetObjectItem(error, "code")->valueint);
+    TEST_ASSERT_TRUE(cJSON_IsNull(cJSON_GetObjectItem(decoded, "id")));
+    cJSON_Delete(decoded);
+    free(response);
+    TEST_ASSERT_NULL(mjrpc_msgpack_decode(bytes, len));
+}
+
+void test_malformed_input(void)
+{
+    mjrpc_add_method(handle, add, "add", NULL);
+    assert_parse_error("", 0);
+    assert_parse_error("\x81\xa1", 2);            /* truncated key */
+    assert_parse_error("\x81\xa1" "a", 3);        /* missing value */
+    assert_parse_error("\x81\x01\x02", 3);        /* non-string key */
+    assert_parse_error("\xc4\x01" "a", 3);        /* bin */
+    assert_parse_error("\xd4\x01\x02", 3);        /* fixext */
+    assert_parse_error("\xc1", 1);                /* never used */
+    assert_parse_error("\xcd\x01", 2);            /* truncated uint16 */
+    assert_parse_error("\xdb\xff\xff\xff\xff", 5); /* str32 past the end */
+    assert_parse_error("\xdd\xff\xff\xff\xff", 5); /* array32 claiming more than the bytes */
+    assert_parse_error("\xc0\xc0", 2);            /* trailing bytes */
+
+    /* Nesting past the limit */
+    char* deep = malloc(CJSON_NESTING_LIMIT + 2);
+    memset(deep, 0x91, CJSON_NESTING_LIMIT + 1);
+    deep[CJSON_NESTING_LIMIT + 1] = (char) 0xc0;
+    assert_parse_error(deep, CJSON_NESTING_LIMIT + 2);
+    free(deep);
+
+    int ret;
+    size_t len = 0;
+    char* response = mjrpc_process_msgpack(handle, NULL, 0, &len, &ret);
+    TEST_ASSERT_NOT_NULL(response);
+    TEST_ASSERT_NOT_EQUAL(0, len);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_PARSE_FAILED, ret);
+    free(response);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_exact_encodings);
+    RUN_TEST(test_decodes_every_form);
+    RUN_TEST(test_round_trips);
+    RUN_TEST(test_calls);
+    RUN_TEST(test_typed_arrays_in_params);
+    RUN_TEST(test_cached_results);
+    RUN_TEST(test_malformed_input);
+    return UNITY_END();
+}
@@ -0,0 +1,179 @@
+/**
+ * @file nesting_test.c
+ * @brief Tests for parsing, printing and deleting nested documents in the bundled cJSON
+ *
+ * Covers:
+ *   - Documents at CJSON_NESTING_LIMIT, parsed, printed and deleted on a
+ *     thread with a 64 KiB stack
+ *   - Trees built with the API far deeper than the limit
+ *   - The limit itself
+ *   - Formatted output of nested arrays and objects, empty ones included
+ *   - Deleting trees that hold references
+ */
+
+#include "unity.h"
+#include "cJSON.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#define SMALL_STACK (64 * 1024)
+
+/* "[{"a":[{"a":...0...}]}]" with depth brackets and braces in total */
+static char* nested_document(int depth)
+{
+    char* text = malloc((size_t) depth * 8 + 2);
+    size_t n = 0;
+    for (int i = 0; i < depth; i++)
+    {
+        if (i % 2)
+        {
+            memcpy(text + n, "{\"a\":", 5);
+            n += 5;
+        }
+        else
+            text[n++] = '[';
+    }
+    text[n++] = '0';
+    for (int i = depth - 1; i >= 0; i--)
+        text[n++] = i % 2 ? '}' : ']';
+    text[n] = '\0';
+    return text;
+}
+
+static void run_on_small_stack(void* (*func)(void*), void* arg)
+{
+    pthread_attr_t attr;
+    pthread_t thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, SMALL_STACK);
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, &attr, func, arg));
+    pthread_join(thread, NULL);
+    pthread_attr_destroy(&attr);
+}
+
+static void* round_trip_thread(void* arg)
+{
+    char* text = nested_document(CJSON_NESTING_LIMIT);
+    cJSON* item = cJSON_Parse(text);
+    char* printed = item ? cJSON_PrintUnformatted(item) : NULL;
+    *(bool*) arg = printed && strcmp(text, printed) == 0;
+    free(printed);
+    cJSON_Delete(item);
+    free(text);
+    return NULL;
+}
+
+void test_limit_depth_on_small_stack(void)
+{
+    bool ok = false;
+    run_on_small_stack(round_trip_thread, &ok);
+    TEST_ASSERT_TRUE(ok);
+}
+
+#define API_DEPTH 100000
+
+static void* deep_tree_thread(void* arg)
+{
+    cJSON* root = cJSON_CreateArray();
+    cJSON* inner = root;
+    for (int i = 1; i < API_DEPTH; i++)
+    {
+        cJSON* next = i % 2 ? cJSON_CreateObject() : cJSON_CreateArray();
+        if (cJSON_IsObject(inner))
+            cJSON_AddItemToObject(inner, "k", next);
+        else
+            cJSON_AddItemToArray(inner, next);
+        inner = next;
+    }
+    char* printed = cJSON_PrintUnformatted(root);
+    *(size_t*) arg = printed ? strlen(printed) : 0;
+    free(printed);
+    cJSON_Delete(root);
+    return NULL;
+}
+
+void test_deeper_than_limit_built_with_api(void)
+{
+    size_t length = 0;
+    run_on_small_stack(deep_tree_thread, &length);
+    /* every object level but the innermost one adds "k": */
+    TEST_ASSERT_EQUAL_size_t(2 * API_DEPTH + 4 * (API_DEPTH / 2 - 1), length);
+}
+
+void test_nesting_limit(void)
+{
+    char* text = nested_document(CJSON_NESTING_LIMIT);
+    cJSON* item = cJSON_Parse(text);
+    TEST_ASSERT_NOT_NULL(item);
+    cJSON_Delete(item);
+    free(text);
+
+    text = nested_document(CJSON_NESTING_LIMIT + 1);
+    TEST_ASSERT_NULL(cJSON_Parse(text));
+    /* The error points at the opening bracket beyond the limit */
+    TEST_ASSERT_EQUAL_INT('[', cJSON_GetErrorPtr()[0]);
+    TEST_ASSERT_EQUAL_INT('0', cJSON_GetErrorPtr()[1]);
+    free(text);
+
+    /* Unclosed and mismatched brackets at depth */
+    TEST_ASSERT_NULL(cJSON_Parse("[[[{\"a\":[1,2]}]]"));
+    TEST_ASSERT_NULL(cJSON_Parse("[[[{\"a\":[1,2]]]]]"));
+    TEST_ASSERT_NULL(cJSON_Parse("{\"a\":{\"b\":{\"c\"}}}"));
+}
+
+void test_formatted_output(void)
+{
+    cJSON* item = cJSON_Parse("{\"a\":[1,[],{}],\"b\":{\"c\":{\"d\":[true,{\"e\":null}]}},\"f\":\"x\"}");
+    char* printed = cJSON_Print(item);
+    TEST_ASSERT_EQUAL_STRING("{\n"
+                             "\t\"a\":\t[1, [], {\n"
+                             "\t\t}],\n"
+                             "\t\"b\":\t{\n"
+                             "\t\t\"c\":\t{\n"
+                             "\t\t\t\"d\":\t[true, {\n"
+                             "\t\t\t\t\t\"e\":\tnull\n"
+                             "\t\t\t\t}]\n"
+                             "\t\t}\n"
+                             "\t},\n"
+                             "\t\"f\":\t\"x\"\n"
+                             "}",
+                             printed);
+    free(printed);
+    cJSON_Delete(item);
+}
+
+void test_delete_keeps_references(void)
+{
+    cJSON* shared = cJSON_Parse("[[1,[2,[3]]],{\"x\":[4]}]");
+    cJSON* root = cJSON_CreateArray();
+    for (int i = 0; i < 3; i++)
+    {
+        cJSON* wrapper = cJSON_CreateObject();
+        cJSON_AddItemReferenceToObject(wrapper, "ref", shared);
+        cJSON_AddItemToObject(wrapper, "own", cJSON_Parse("[[5],[6,[7]]]"));
+        cJSON_AddItemToArray(root, wrapper);
+    }
+    cJSON_Delete(root);
+
+    char* printed = cJSON_PrintUnformatted(shared);
+    TEST_ASSERT_EQUAL_STRING("[[1,[2,[3]]],{\"x\":[4]}]", printed);
+    free(printed);
+    cJSON_Delete(shared);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_limit_depth_on_small_stack);
+    RUN_TEST(test_deeper_than_limit_built_with_api);
+    RUN_TEST(test_nesting_limit);
+    RUN_TEST(test_formatted_output);
+    RUN_TEST(test_delete_keeps_references);
+    return UNITY_END();
+}
@@ -0,0 +1,135 @@
+/**
+ * @file node_layout_test.c
+ * @brief Tests for the item layout of the bundled cJSON
+ *
+ * Passes with and without CJSON_COMPACT_NODES (-DMJSONRPC_CJSON_COMPACT_NODES=ON),
+ * where child, valuestring and valuedouble share their storage. Covers:
+ *   - Item size
+ *   - Array and object lookups on scalars finding nothing
+ *   - Setting numbers on non-numbers leaving their payload alone
+ *   - Duplicating, comparing, printing and deleting items of every type
+ */
+
+#include "unity.h"
+#include "cJSON.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static const char* document = "{\"s\":\"text\",\"n\":-12.5,\"i\":7,\"t\":true,\"f\":false,\"z\":null,"
+                              "\"a\":[1,\"two\",[3],{\"four\":4}],\"o\":{\"k\":\"v\",\"e\":{}},\"r\":[]}";
+
+void test_item_size(void)
+{
+#ifdef CJSON_COMPACT_NODES
+    if (sizeof(void*) == 8)
+        TEST_ASSERT_EQUAL_size_t(40, sizeof(cJSON));
+#else
+    if (sizeof(void*) == 8)
+        TEST_ASSERT_EQUAL_size_t(64, sizeof(cJSON));
+#endif
+}
+
+void test_scalars_have_no_children(void)
+{
+    cJSON* root = cJSON_Parse(document);
+    const char* names[] = {"s", "n", "i", "t", "f", "z"};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        cJSON* scalar = cJSON_GetObjectItem(root, names[i]);
+        TEST_ASSERT_NOT_NULL(scalar);
+        TEST_ASSERT_EQUAL_INT(0, cJSON_GetArraySize(scalar));
+        TEST_ASSERT_NULL(cJSON_GetArrayItem(scalar, 0));
+        TEST_ASSERT_NULL(cJSON_GetObjectItem(scalar, "k"));
+        TEST_ASSERT_NULL(cJSON_DetachItemFromArray(scalar, 0));
+        int visited = 0;
+        cJSON* element;
+        cJSON_ArrayForEach(element, scalar)
+            visited++;
+        TEST_ASSERT_EQUAL_INT(0, visited);
+    }
+    TEST_ASSERT_EQUAL_INT(4, cJSON_GetArraySize(cJSON_GetObjectItem(root, "a")));
+    TEST_ASSERT_EQUAL_INT(0, cJSON_GetArraySize(cJSON_GetObjectItem(root, "r")));
+    cJSON_Delete(root);
+}
+
+void test_set_number_keeps_other_payloads(void)
+{
+    cJSON* string = cJSON_CreateString("text");
+    cJSON* array = cJSON_CreateArray();
+    cJSON_AddItemToArray(array, cJSON_CreateTrue());
+    cJSON* number = cJSON_CreateNumber(1);
+
+    cJSON_SetNumberValue(number, 2.5);
+    cJSON_SetNumberValue(string, 3);
+    cJSON_SetNumberValue(array, 4);
+    TEST_ASSERT_EQUAL_INT(2, number->valueint);
+    TEST_ASSERT_EQUAL_INT(5, (int) (cJSON_GetNumberValue(number) * 2));
+    TEST_ASSERT_EQUAL_STRING("text", cJSON_GetStringValue(string));
+    TEST_ASSERT_TRUE(cJSON_IsTrue(cJSON_GetArrayItem(array, 0)));
+
+    cJSON_SetIntValue(number, 9);
+    TEST_ASSERT_EQUAL_INT(9, number->valueint);
+    TEST_ASSERT_EQUAL_INT(9, (int) cJSON_GetNumberValue(number));
+
+    cJSON_Delete(string);
+    cJSON_Delete(array);
+    cJSON_Delete(number);
+}
+
+void test_duplicate_compare_print(void)
+{
+    cJSON* root = cJSON_Parse(document);
+    char* expected = cJSON_PrintUnformatted(root);
+
+    cJSON* copy = cJSON_Duplicate(root, true);
+    TEST_ASSERT_TRUE(cJSON_Compare(root, copy, true));
+    char* printed = cJSON_PrintUnformatted(copy);
+    TEST_ASSERT_EQUAL_STRING(expected, printed);
+    free(printed);
+
+    /* A shallow copy of a container has no children of its own */
+    cJSON* shallow = cJSON_Duplicate(cJSON_GetObjectItem(root, "a"), false);
+    TEST_ASSERT_TRUE(cJSON_IsArray(shallow));
+    TEST_ASSERT_EQUAL_INT(0, cJSON_GetArraySize(shallow));
+    cJSON_Delete(shallow);
+
+    cJSON_Delete(root);
+    printed = cJSON_PrintUnformatted(copy);
+    TEST_ASSERT_EQUAL_STRING(expected, printed);
+    free(printed);
+    free(expected);
+    cJSON_Delete(copy);
+}
+
+void test_references_and_raw(void)
+{
+    cJSON* array = cJSON_CreateArray();
+    cJSON_AddItemToArray(array, cJSON_CreateNumber(1));
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddItemReferenceToObject(root, "ref", array);
+    cJSON_AddItemToObject(root, "raw", cJSON_CreateRaw("{\"x\":[1,2]}"));
+    cJSON_AddItemToObject(root, "const", cJSON_CreateStringReference("fixed"));
+
+    char* printed = cJSON_PrintUnformatted(root);
+    TEST_ASSERT_EQUAL_STRING("{\"ref\":[1],\"raw\":{\"x\":[1,2]},\"const\":\"fixed\"}", printed);
+    free(printed);
+    cJSON_Delete(root);
+    TEST_ASSERT_EQUAL_INT(1, cJSON_GetArraySize(array));
+    cJSON_Delete(array);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_item_size);
+    RUN_TEST(test_scalars_have_no_children);
+    RUN_TEST(test_set_number_keeps_other_payloads);
+    RUN_TEST(test_duplicate_compare_print);
+    RUN_TEST(test_references_and_raw);
+    return UNITY_END();
+}
@@ -0,0 +1,196 @@
+/**
+ * @file node_slab_test.c
+ * @brief Tests for the slab allocator for items of the bundled cJSON
+ *
+ * Covers:
+ *   - Cache-aligned items, freed items reused first
+ *   - Parse, print, duplicate and delete served from slabs, no malloc per item
+ *   - Items parsed on one thread and deleted on another being recycled
+ *     instead of growing the slabs
+ *   - Exiting threads handing their free items back
+ *   - Switching back to the hooks
+ */
+
+#include "unity.h"
+#include "cJSON.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+static atomic_size_t allocations;
+
+static void* counting_malloc(size_t size)
+{
+    atomic_fetch_add(&allocations, 1);
+    return malloc(size);
+}
+
+void setUp(void)
+{
+    cJSON_Hooks hooks = {counting_malloc, NULL};
+    cJSON_InitHooks(&hooks);
+    TEST_ASSERT_TRUE(cJSON_UseNodeSlabs(true));
+}
+
+void tearDown(void)
+{
+    cJSON_UseNodeSlabs(false);
+    cJSON_InitHooks(NULL);
+}
+
+void test_items_aligned_and_reused(void)
+{
+    cJSON* first = cJSON_CreateNull();
+    cJSON* second = cJSON_CreateNull();
+    TEST_ASSERT_NOT_NULL(first);
+    TEST_ASSERT_TRUE(first != second);
+    if (sizeof(cJSON) == 64)
+    {
+        TEST_ASSERT_EQUAL_size_t(0, (size_t) first % 64);
+        TEST_ASSERT_EQUAL_size_t(0, (size_t) second % 64);
+    }
+
+    cJSON_Delete(first);
+    cJSON* third = cJSON_CreateNumber(1);
+    TEST_ASSERT_TRUE(third == first);
+    TEST_ASSERT_NULL(third->next);
+    TEST_ASSERT_NULL(third->prev);
+    cJSON_Delete(second);
+    cJSON_Delete(third);
+}
+
+void test_parse_print_without_item_allocations(void)
+{
+    const char* json = "{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":[1,2,{\"a\":[true,null]}],\"id\":7}";
+    char buffer[128];
+
+    /* Warm up this thread's slab */
+    cJSON_Delete(cJSON_Parse(json));
+
+    strcpy(buffer, json);
+    atomic_store(&allocations, 0);
+    cJSON* item = cJSON_ParseInSitu(buffer, strlen(buffer));
+    TEST_ASSERT_NOT_NULL(item);
+    TEST_ASSERT_EQUAL_size_t(0, atomic_load(&allocations));
+
+    cJSON* copy = cJSON_Duplicate(item, true);
+    TEST_ASSERT_TRUE(cJSON_Compare(item, copy, true));
+    char* printed = cJSON_PrintUnformatted(copy);
+    TEST_ASSERT_EQUAL_STRING(json, printed);
+    free(printed);
+    cJSON_Delete(copy);
+    cJSON_Delete(item);
+}
+
+#define ROUNDS 2000
+#define TREE_ITEMS 1000
+
+static _Atomic(cJSON*) handoff;
+static atomic_int bad_trees;
+
+static void* producer(void* arg)
+{
+    (void) arg;
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        cJSON* tree = cJSON_CreateArray();
+        for (int i = 1; i < TREE_ITEMS; i++)
+            cJSON_AddItemToArray(tree, cJSON_CreateNumber(i));
+        cJSON* expected = NULL;
+        while (!atomic_compare_exchange_weak(&handoff, &expected, tree))
+            expected = NULL;
+    }
+    return NULL;
+}
+
+static void* consumer(void* arg)
+{
+    (void) arg;
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        cJSON* tree;
+        while ((tree = atomic_exchange(&handoff, NULL)) == NULL)
+        {
+        }
+        if (cJSON_GetArraySize(tree) != TREE_ITEMS - 1)
+            atomic_fetch_add(&bad_trees, 1);
+        cJSON_Delete(tree);
+    }
+    return NULL;
+}
+
+void test_cross_thread_delete_recycles(void)
+{
+    atomic_store(&allocations, 0);
+    pthread_t threads[2];
+    pthread_create(&threads[0], NULL, producer, NULL);
+    pthread_create(&threads[1], NULL, consumer, NULL);
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+    TEST_ASSERT_EQUAL_INT(0, atomic_load(&bad_trees));
+
+    /* 2M items would take ~2000 slabs without the depot; only three trees are alive at a time */
+    size_t slab_items = 64 * 1024 / sizeof(cJSON);
+    TEST_ASSERT_LESS_OR_EQUAL_size_t(4 * TREE_ITEMS / slab_items + 4, atomic_load(&allocations));
+}
+
+#define WAVES 100
+#define WAVE_THREADS 4
+
+static void* short_lived(void* arg)
+{
+    (void) arg;
+    cJSON* tree = cJSON_CreateArray();
+    for (int i = 0; i < 100; i++)
+        cJSON_AddItemToArray(tree, cJSON_CreateNumber(i));
+    cJSON_Delete(tree);
+    return NULL;
+}
+
+void test_exiting_threads_hand_back_items(void)
+{
+    atomic_store(&allocations, 0);
+    for (int wave = 0; wave < WAVES; wave++)
+    {
+        pthread_t threads[WAVE_THREADS];
+        for (int i = 0; i < WAVE_THREADS; i++)
+            pthread_create(&threads[i], NULL, short_lived, NULL);
+        for (int i = 0; i < WAVE_THREADS; i++)
+            pthread_join(threads[i], NULL);
+    }
+    /* One slab per thread alive at a time, not one per thread ever started */
+    TEST_ASSERT_LESS_OR_EQUAL_size_t(2 * WAVE_THREADS, atomic_load(&allocations));
+
+    /* Explicit flushes leave the thread able to allocate again */
+    cJSON_FlushThreadNodes();
+    cJSON* item = cJSON_CreateNull();
+    TEST_ASSERT_NOT_NULL(item);
+    cJSON_FlushThreadNodes();
+    cJSON_Delete(item);
+    cJSON_FlushThreadNodes();
+}
+
+void test_switch_back_to_hooks(void)
+{
+    cJSON_Delete(cJSON_CreateTrue());
+    TEST_ASSERT_TRUE(cJSON_UseNodeSlabs(false));
+
+    atomic_store(&allocations, 0);
+    cJSON* item = cJSON_CreateTrue();
+    TEST_ASSERT_EQUAL_size_t(1, atomic_load(&allocations));
+    cJSON_Delete(item);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_items_aligned_and_reused);
+    RUN_TEST(test_parse_print_without_item_allocations);
+    RUN_TEST(test_cross_thread_delete_recycles);
+    RUN_TEST(test_exiting_threads_hand_back_items);
+    RUN_TEST(test_switch_back_to_hooks);
+    return UNITY_END();
+}
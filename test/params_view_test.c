@@ -0,0 +1,363 @@
+/**
+ * @file params_view_test.c
+ * @brief Tests for mjrpc_params_size(), mjrpc_params_at() and mjrpc_params_get()
+ *
+ * Covers:
+ *   - Array params, inside and past the inline index
+ *   - Named lookups, small and hashed, ignoring case or not, with duplicates
+ *   - Object params in member order, and calls without params
+ *   - Out-of-range positions
+ *   - Index allocations going through the memory hooks and being freed
+ *   - Asynchronous methods
+ *   - Empty batches
+ */
+
+#include "unity.h"
+#include "mjsonrpc.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int malloc_count = 0;
+static int free_count = 0;
+
+static void* counting_malloc(size_t size)
+{
+    malloc_count++;
+    return malloc(size);
+}
+
+static void counting_free(void* ptr)
+{
+    if (ptr != NULL)
+        free_count++;
+    free(ptr);
+}
+
+static char* counting_strdup(const char* str)
+{
+    size_t len = strlen(str) + 1;
+    char* dup = counting_malloc(len);
+    if (dup != NULL)
+        memcpy(dup, str, len);
+    return dup;
+}
+
+void setUp(void)
+{
+    malloc_count = 0;
+    free_count = 0;
+}
+
+void tearDown(void)
+{
+    mjrpc_set_memory_hooks(NULL, NULL, NULL);
+}
+
+/* Sums the params back to front, then checks the positions past the end */
+static cJSON* sum_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) params;
+    (void) id;
+    int size = mjrpc_params_size(ctx);
+    double sum = 0;
+    for (int i = size - 1; i >= 0; i--)
+    {
+        cJSON* item = mjrpc_params_at(ctx, i);
+        if (!cJSON_IsNumber(item))
+        {
+            ctx->error_code = JSON_RPC_CODE_INVALID_PARAMS;
+            return NULL;
+        }
+        sum += item->valuedouble;
+    }
+    if (mjrpc_params_at(ctx, size) != NULL || mjrpc_params_at(ctx, -1) != NULL)
+        ctx->error_code = JSON_RPC_CODE_INTERNAL_ERROR;
+    return cJSON_CreateNumber(sum);
+}
+
+/* Returns the size only, never indexing */
+static cJSON* size_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) params;
+    (void) id;
+    return cJSON_CreateNumber(mjrpc_params_size(ctx));
+}
+
+/* Returns the names of the params in position order */
+static cJSON* names_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) params;
+    (void) id;
+    cJSON* names = cJSON_CreateArray();
+    for (int i = 0; i < mjrpc_params_size(ctx); i++)
+        cJSON_AddItemToArray(names, cJSON_CreateString(mjrpc_params_at(ctx, i)->string));
+    return names;
+}
+
+typedef struct
+{
+    const char* const* names;
+    bool case_sensitive;
+} lookup_t;
+
+/* Returns the values of the named params listed in the user data, 0 for missing ones */
+static cJSON* lookup_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) params;
+    (void) id;
+    const lookup_t* lookup = ctx->data;
+    cJSON* found = cJSON_CreateArray();
+    for (const char* const* name = lookup->names; *name != NULL; name++)
+    {
+        cJSON* item = lookup->case_sensitive ? mjrpc_params_get_case_sensitive(ctx, *name)
+                                             : mjrpc_params_get(ctx, *name);
+        cJSON_AddItemToArray(found, cJSON_CreateNumber(item ? item->valuedouble : 0));
+    }
+    return found;
+}
+
+static mjrpc_handle_t* create_handle(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(8);
+    mjrpc_add_method(h, sum_func, "sum", NULL);
+    mjrpc_add_method(h, size_func, "size", NULL);
+    mjrpc_add_method(h, names_func, "names", NULL);
+    return h;
+}
+
+static char* numbers_request(const char* method, int count)
+{
+    cJSON* params = cJSON_CreateArray();
+    for (int i = 0; i < count; i++)
+        cJSON_AddItemToArray(params, cJSON_CreateNumber(i));
+    cJSON* req = mjrpc_request_cjson(method, params, cJSON_CreateNumber(1));
+    char* text = cJSON_PrintUnformatted(req);
+    cJSON_Delete(req);
+    return text;
+}
+
+static int call_int(mjrpc_handle_t* h, const char* request)
+{
+    char* response = mjrpc_process_str(h, request, NULL);
+    TEST_ASSERT_NOT_NULL(response);
+    cJSON* parsed = cJSON_Parse(response);
+    cJSON* result = cJSON_GetObjectItem(parsed, "result");
+    TEST_ASSERT_TRUE_MESSAGE(cJSON_IsNumber(result), response);
+    int value = result->valueint;
+    cJSON_Delete(parsed);
+    free(response);
+    return value;
+}
+
+static char* lookup(const char* params, bool case_sensitive, const char* const* names)
+{
+    /* The handle frees the method argument with the memory hooks */
+    lookup_t* data = counting_malloc(sizeof(lookup_t));
+    data->names = names;
+    data->case_sensitive = case_sensitive;
+    mjrpc_handle_t* h = mjrpc_create_handle(8);
+    mjrpc_add_method(h, lookup_func, "lookup", data);
+    char request[8192];
+    snprintf(request, sizeof(request), "{\"jsonrpc\":\"2.0\",\"method\":\"lookup\",\"params\":%s,\"id\":1}", params);
+    char* response = mjrpc_process_str(h, request, NULL);
+    mjrpc_destroy_handle(h);
+    cJSON* parsed = cJSON_Parse(response);
+    char* result = cJSON_PrintUnformatted(cJSON_GetObjectItem(parsed, "result"));
+    cJSON_Delete(parsed);
+    free(response);
+    return result;
+}
+
+/* An object of count members "k0".."k<count-1>" valued 1..count, then "Dup":100 and "dup":200 */
+static char* named_params(int count)
+{
+    cJSON* params = cJSON_CreateObject();
+    char name[16];
+    for (int i = 0; i < count; i++)
+    {
+        snprintf(name, sizeof(name), "k%d", i);
+        cJSON_AddNumberToObject(params, name, i + 1);
+    }
+    cJSON_AddNumberToObject(params, "Dup", 100);
+    cJSON_AddNumberToObject(params, "dup", 200);
+    char* text = cJSON_PrintUnformatted(params);
+    cJSON_Delete(params);
+    return text;
+}
+
+void test_array_params(void)
+{
+    mjrpc_handle_t* h = create_handle();
+    const int counts[] = {0, 1, MJRPC_PARAMS_INLINE, MJRPC_PARAMS_INLINE + 1, 1000};
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+        char* request = numbers_request("sum", counts[c]);
+        TEST_ASSERT_EQUAL_INT(counts[c] * (counts[c] - 1) / 2, call_int(h, request));
+        free(request);
+        request = numbers_request("size", counts[c]);
+        TEST_ASSERT_EQUAL_INT(counts[c], call_int(h, request));
+        free(request);
+    }
+    mjrpc_destroy_handle(h);
+}
+
+void test_object_and_missing_params(void)
+{
+    mjrpc_handle_t* h = create_handle();
+    char* response =
+        mjrpc_process_str(h, "{\"jsonrpc\":\"2.0\",\"method\":\"names\",\"params\":{\"b\":1,\"a\":2,\"c\":3},\"id\":1}",
+                          NULL);
+    TEST_ASSERT_EQUAL_STRING("{\"jsonrpc\":\"2.0\",\"result\":[\"b\",\"a\",\"c\"],\"id\":1}", response);
+    free(response);
+
+    TEST_ASSERT_EQUAL_INT(0, call_int(h, "{\"jsonrpc\":\"2.0\",\"method\":\"size\",\"id\":1}"));
+    TEST_ASSERT_EQUAL_INT(0, call_int(h, "{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":{},\"id\":1}"));
+    mjrpc_destroy_handle(h);
+}
+
+void test_index_allocations(void)
+{
+    mjrpc_handle_t* h = create_handle();
+    mjrpc_set_memory_hooks(counting_malloc, counting_free, counting_strdup);
+
+    /* Indexing costs nothing up to MJRPC_PARAMS_INLINE params, one block past it */
+    for (int count = MJRPC_PARAMS_INLINE; count <= MJRPC_PARAMS_INLINE + 1; count++)
+    {
+        char* sum_request = numbers_request("sum", count);
+        char* size_request = numbers_request("size", count);
+        int before = malloc_count;
+        call_int(h, size_request);
+        int sized = malloc_count - before;
+        before = malloc_count;
+        call_int(h, sum_request);
+        int indexed = malloc_count - before;
+        TEST_ASSERT_EQUAL_INT(count > MJRPC_PARAMS_INLINE ? 1 : 0, indexed - sized);
+        free(sum_request);
+        free(size_request);
+    }
+
+    /* Named lookups hash objects past MJRPC_PARAMS_INLINE members into one block */
+    static const char* const none[] = {NULL};
+    static const char* const names[] = {"k0", "k1", "k2", NULL};
+    for (int count = MJRPC_PARAMS_INLINE - 2; count <= MJRPC_PARAMS_INLINE - 1; count++)
+    {
+        /* named_params() adds two more members */
+        char* params = named_params(count);
+        int before = malloc_count;
+        free(lookup(params, false, none));
+        int unused = malloc_count - before;
+        before = malloc_count;
+        free(lookup(params, false, names));
+        TEST_ASSERT_EQUAL_INT(count + 2 > MJRPC_PARAMS_INLINE ? 1 : 0, malloc_count - before - unused);
+        free(params);
+    }
+    TEST_ASSERT_EQUAL_INT(malloc_count, free_count);
+    mjrpc_set_memory_hooks(NULL, NULL, NULL);
+    mjrpc_destroy_handle(h);
+}
+
+void test_named_params(void)
+{
+    static const char* const names[] = {"k0", "K1", "k2", "DUP", "dup", "missing", "k", "", NULL};
+    /* Small objects are scanned, larger ones hashed; both must agree with cJSON */
+    const int counts[] = {3, MJRPC_PARAMS_INLINE + 1, 200};
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+        char* params = named_params(counts[c]);
+        char* result = lookup(params, false, names);
+        TEST_ASSERT_EQUAL_STRING("[1,2,3,100,100,0,0,0]", result);
+        free(result);
+        result = lookup(params, true, names);
+        TEST_ASSERT_EQUAL_STRING("[1,0,3,0,200,0,0,0]", result);
+        free(result);
+        free(params);
+    }
+}
+
+void test_named_params_every_member(void)
+{
+    static const char* names[202];
+    static char storage[200][16];
+    for (int i = 0; i < 200; i++)
+    {
+        snprintf(storage[i], sizeof(storage[i]), "k%d", 199 - i);
+        names[i] = storage[i];
+    }
+    names[200] = NULL;
+    char* params = named_params(200);
+    char* result = lookup(params, true, names);
+    cJSON* values = cJSON_Parse(result);
+    for (int i = 0; i < 200; i++)
+        TEST_ASSERT_EQUAL_INT(200 - i, cJSON_GetArrayItem(values, i)->valueint);
+    cJSON_Delete(values);
+    free(result);
+    free(params);
+
+    /* Array params have no names */
+    static const char* const first[] = {"0", NULL};
+    result = lookup("[5]", false, first);
+    TEST_ASSERT_EQUAL_STRING("[0]", result);
+    free(result);
+}
+
+static cJSON* async_result = NULL;
+
+static void sum_async_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id, mjrpc_async_token_t* token)
+{
+    cJSON* sum = sum_func(ctx, params, id);
+    if (ctx->error_code)
+    {
+        cJSON_Delete(sum);
+        mjrpc_fail(token, ctx->error_code, NULL);
+    }
+    else
+        mjrpc_complete(token, sum);
+}
+
+static void store_response(cJSON* response, void* user_data)
+{
+    (void) user_data;
+    async_result = response;
+}
+
+void test_async_method(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(8);
+    mjrpc_add_async_method(h, sum_async_func, "sum", NULL);
+    char* text = numbers_request("sum", 100);
+    cJSON* request = cJSON_Parse(text);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_process_async(h, request, store_response, NULL));
+    TEST_ASSERT_NOT_NULL(async_result);
+    TEST_ASSERT_EQUAL_INT(4950, cJSON_GetObjectItem(async_result, "result")->valueint);
+    cJSON_Delete(async_result);
+    cJSON_Delete(request);
+    free(text);
+    mjrpc_destroy_handle(h);
+}
+
+void test_empty_batch(void)
+{
+    mjrpc_handle_t* h = create_handle();
+    int code = -1;
+    char* response = mjrpc_process_str(h, "[]", &code);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_EMPTY_REQUEST, code);
+    TEST_ASSERT_NOT_NULL(strstr(response, "Empty JSON array"));
+    free(response);
+    mjrpc_destroy_handle(h);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_array_params);
+    RUN_TEST(test_object_and_missing_params);
+    RUN_TEST(test_named_params);
+    RUN_TEST(test_named_params_every_member);
+    RUN_TEST(test_index_allocations);
+    RUN_TEST(test_async_method);
+    RUN_TEST(test_empty_batch);
+    return UNITY_END();
+}
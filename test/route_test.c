@@ -0,0 +1,281 @@
+/**
+ * @file route_test.c
+ * @brief Tests for namespace routing (mjrpc_add_namespace and friends)
+ *
+ * Covers:
+ *   - Delegation of a namespace to a child handle
+ *   - Wildcard handlers receiving the method suffix
+ *   - Longest-prefix match and precedence of exact methods
+ *   - Edge splitting in the radix trie and entry removal
+ *   - Edge merging after removal, checked through the memory hooks
+ *   - Nested delegation and the depth limit
+ */
+
+#include "unity.h"
+#include "mjsonrpc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static cJSON* name_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) params;
+    (void) id;
+    return cJSON_CreateString((const char*) ctx->data);
+}
+
+static cJSON* suffix_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) params;
+    (void) id;
+    return cJSON_CreateString(ctx->method_suffix ? ctx->method_suffix : "(null)");
+}
+
+/* Call a method and return the string result (caller frees) or NULL */
+static char* call_str(mjrpc_handle_t* h, const char* method, int* error_code)
+{
+    cJSON* req = mjrpc_request_cjson(method, NULL, cJSON_CreateNumber(1));
+    cJSON* resp = mjrpc_process_cjson(h, req, NULL);
+    cJSON_Delete(req);
+    char* out = NULL;
+    *error_code = 0;
+    cJSON* result = cJSON_GetObjectItem(resp, "result");
+    if (cJSON_IsString(result))
+        out = strdup(result->valuestring);
+    cJSON* error = cJSON_GetObjectItem(resp, "error");
+    if (error)
+        *error_code = cJSON_GetObjectItem(error, "code")->valueint;
+    cJSON_Delete(resp);
+    return out;
+}
+
+void test_namespace_to_child_handle(void)
+{
+    mjrpc_handle_t* root = mjrpc_create_handle(0);
+    mjrpc_handle_t* storage = mjrpc_create_handle(0);
+    mjrpc_add_method(storage, name_func, "volume.create", strdup("create"));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_add_namespace(root, "storage", storage));
+
+    int err = 0;
+    char* out = call_str(root, "storage.volume.create", &err);
+    TEST_ASSERT_EQUAL_STRING("create", out);
+    free(out);
+
+    /* Unknown suffix is reported by the child */
+    out = call_str(root, "storage.volume.delete", &err);
+    TEST_ASSERT_NULL(out);
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_METHOD_NOT_FOUND, err);
+
+    /* Prefix must end on a namespace boundary */
+    out = call_str(root, "storagevolume.create", &err);
+    TEST_ASSERT_NULL(out);
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_METHOD_NOT_FOUND, err);
+
+    mjrpc_destroy_handle(root);
+    mjrpc_destroy_handle(storage);
+}
+
+void test_prefix_method_receives_suffix(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_add_prefix_method(h, suffix_func, "proxy", NULL));
+
+    int err = 0;
+    char* out = call_str(h, "proxy.a.b.c", &err);
+    TEST_ASSERT_EQUAL_STRING("a.b.c", out);
+    free(out);
+
+    /* Exact methods do not see a suffix */
+    mjrpc_add_method(h, suffix_func, "plain", NULL);
+    out = call_str(h, "plain", &err);
+    TEST_ASSERT_EQUAL_STRING("(null)", out);
+    free(out);
+
+    mjrpc_destroy_handle(h);
+}
+
+void test_longest_prefix_and_exact_precedence(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_prefix_method(h, name_func, "a", strdup("a"));
+    mjrpc_add_prefix_method(h, name_func, "a.b", strdup("a.b"));
+    mjrpc_add_prefix_method(h, name_func, "a.bc", strdup("a.bc"));
+    mjrpc_add_method(h, name_func, "a.b.exact", strdup("exact"));
+
+    int err = 0;
+    char* out = call_str(h, "a.x", &err);
+    TEST_ASSERT_EQUAL_STRING("a", out);
+    free(out);
+    out = call_str(h, "a.b.x", &err);
+    TEST_ASSERT_EQUAL_STRING("a.b", out);
+    free(out);
+    out = call_str(h, "a.bc.x", &err);
+    TEST_ASSERT_EQUAL_STRING("a.bc", out);
+    free(out);
+    out = call_str(h, "a.b.exact", &err);
+    TEST_ASSERT_EQUAL_STRING("exact", out);
+    free(out);
+
+    /* Removing the inner prefix falls back to the outer one */
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_del_namespace(h, "a.b"));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_NOT_FOUND, mjrpc_del_namespace(h, "a.b"));
+    out = call_str(h, "a.b.x", &err);
+    TEST_ASSERT_EQUAL_STRING("a", out);
+    free(out);
+    out = call_str(h, "a.bc.x", &err);
+    TEST_ASSERT_EQUAL_STRING("a.bc", out);
+    free(out);
+
+    mjrpc_destroy_handle(h);
+}
+
+void test_many_namespaces(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    char name[64];
+    for (int i = 0; i < 200; i++)
+    {
+        snprintf(name, sizeof(name), "svc%d.v%d", i, i % 7);
+        TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK,
+                              mjrpc_add_prefix_method(h, name_func, name, strdup(name)));
+    }
+    for (int i = 0; i < 200; i++)
+    {
+        char method[80];
+        snprintf(name, sizeof(name), "svc%d.v%d", i, i % 7);
+        snprintf(method, sizeof(method), "%s.call", name);
+        int err = 0;
+        char* out = call_str(h, method, &err);
+        TEST_ASSERT_EQUAL_STRING(name, out);
+        free(out);
+    }
+    mjrpc_destroy_handle(h);
+}
+
+static long live_blocks = 0;
+
+static void* counting_malloc(size_t size)
+{
+    void* ptr = malloc(size);
+    if (ptr)
+        live_blocks++;
+    return ptr;
+}
+
+static void counting_free(void* ptr)
+{
+    if (ptr)
+        live_blocks--;
+    free(ptr);
+}
+
+static char* counting_strdup(const char* str)
+{
+    char* copy = counting_malloc(strlen(str) + 1);
+    if (copy)
+        strcpy(copy, str);
+    return copy;
+}
+
+void test_removal_round_trip(void)
+{
+    mjrpc_set_memory_hooks(counting_malloc, counting_free, counting_strdup);
+
+    /* The trie of one namespace, built directly */
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    long empty = live_blocks;
+    mjrpc_add_prefix_method(h, name_func, "svc.alpha", NULL);
+    long single = live_blocks - empty;
+    mjrpc_destroy_handle(h);
+
+    /* Neighbours split its edges; removing them merges the edges back */
+    h = mjrpc_create_handle(0);
+    char name[64];
+    for (int round = 0; round < 3; round++)
+    {
+        mjrpc_add_prefix_method(h, name_func, "svc.alpha", NULL);
+        for (int i = 0; i < 50; i++)
+        {
+            snprintf(name, sizeof(name), "svc.al%d.x", i);
+            TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_add_prefix_method(h, name_func, name, NULL));
+        }
+        TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_add_prefix_method(h, name_func, "svc", NULL));
+        for (int i = 0; i < 50; i++)
+        {
+            snprintf(name, sizeof(name), "svc.al%d.x", i);
+            TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_del_namespace(h, name));
+        }
+        TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_del_namespace(h, "svc"));
+        TEST_ASSERT_EQUAL_INT(single, live_blocks - empty);
+
+        /* Lookups still follow the merged edge */
+        int err = 0;
+        char* out = call_str(h, "svc.alpha.go", &err);
+        TEST_ASSERT_EQUAL_INT(0, err);
+        free(out);
+        out = call_str(h, "svc.al1.x.go", &err);
+        TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_METHOD_NOT_FOUND, err);
+        TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_del_namespace(h, "svc.alpha"));
+    }
+    mjrpc_destroy_handle(h);
+    mjrpc_set_memory_hooks(NULL, NULL, NULL);
+}
+
+void test_nested_delegation_and_depth_limit(void)
+{
+    mjrpc_handle_t* a = mjrpc_create_handle(0);
+    mjrpc_handle_t* b = mjrpc_create_handle(0);
+    mjrpc_handle_t* c = mjrpc_create_handle(0);
+    mjrpc_add_namespace(a, "b", b);
+    mjrpc_add_namespace(b, "c", c);
+    mjrpc_add_method(c, name_func, "leaf", strdup("leaf"));
+
+    int err = 0;
+    char* out = call_str(a, "b.c.leaf", &err);
+    TEST_ASSERT_EQUAL_STRING("leaf", out);
+    free(out);
+
+    /* A cycle must terminate with "method not found" */
+    mjrpc_add_namespace(c, "loop", a);
+    mjrpc_add_namespace(a, "loop", b);
+    mjrpc_add_namespace(b, "loop", c);
+    out = call_str(a, "loop.loop.loop.loop.loop.loop.loop.loop.loop.loop.loop.loop."
+                      "loop.loop.loop.loop.loop.loop.loop.loop.x",
+                   &err);
+    TEST_ASSERT_NULL(out);
+    TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_METHOD_NOT_FOUND, err);
+
+    mjrpc_destroy_handle(a);
+    mjrpc_destroy_handle(b);
+    mjrpc_destroy_handle(c);
+}
+
+void test_namespace_invalid_params(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED,
+                          mjrpc_add_namespace(NULL, "x", h));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_add_namespace(h, NULL, h));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_add_namespace(h, "x", h));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM,
+                          mjrpc_add_prefix_method(h, NULL, "x", NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_NOT_FOUND, mjrpc_del_namespace(h, "x"));
+    mjrpc_destroy_handle(h);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_namespace_to_child_handle);
+    RUN_TEST(test_prefix_method_receives_suffix);
+    RUN_TEST(test_longest_prefix_and_exact_precedence);
+    RUN_TEST(test_many_namespaces);
+    RUN_TEST(test_removal_round_trip);
+    RUN_TEST(test_nested_delegation_and_depth_limit);
+    RUN_TEST(test_namespace_invalid_params);
+    return UNITY_END();
+}
@@ -0,0 +1,455 @@
+/**
+ * @file rpc_client_test.c
+ * @brief Tests for the pipelining client (mjsonrpc_client.h)
+ *
+ * Covers:
+ *   - Calls answered by a handle over an in-memory transport
+ *   - Responses arriving out of order, in batches and in fragments
+ *   - Error responses, notifications, cancellation and destruction
+ *   - Many pending calls completed in random order
+ *   - Unknown ids, malformed responses and send failures
+ *   - Coalescing calls into batches by count and by time window
+ */
+
+#include "unity.h"
+#include "mjsonrpc_client.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+/* In-memory transport: requests are collected on the wire */
+typedef struct {
+    char* data;
+    size_t len, cap;
+    int fail;
+    int sends;
+} wire_t;
+
+static void wire_append(wire_t* w, const char* data, size_t len)
+{
+    if (len == 0)
+        return;
+    if (w->len + len > w->cap)
+    {
+        w->cap = (w->len + len) * 2;
+        w->data = realloc(w->data, w->cap);
+    }
+    memcpy(w->data + w->len, data, len);
+    w->len += len;
+}
+
+static int wire_send(const char* data, size_t len, void* user_data)
+{
+    wire_t* w = user_data;
+    if (w->fail)
+        return -1;
+    w->sends++;
+    wire_append(w, data, len);
+    return 0;
+}
+
+typedef struct {
+    int calls;
+    int status;
+    int result;
+    int error_code;
+} outcome_t;
+
+static void record(int status, cJSON* result, cJSON* error, void* user_data)
+{
+    outcome_t* o = user_data;
+    o->calls++;
+    o->status = status;
+    o->result = result && cJSON_IsNumber(result) ? result->valueint : -1;
+    o->error_code = error ? cJSON_GetObjectItem(error, "code")->valueint : 0;
+}
+
+static cJSON* double_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) id;
+    cJSON* x = cJSON_GetArrayItem(params, 0);
+    if (!cJSON_IsNumber(x))
+    {
+        ctx->error_code = JSON_RPC_CODE_INVALID_PARAMS;
+        ctx->error_message = strdup("need a number");
+        return NULL;
+    }
+    return cJSON_CreateNumber(x->valuedouble * 2);
+}
+
+/* Answer every framed request on the wire with the handle, appending the
+ * framed responses to out */
+static void serve_wire(mjrpc_handle_t* h, enum mjrpc_framing framing, wire_t* in, wire_t* out)
+{
+    mjrpc_framer_t* f = mjrpc_framer_create(framing, 1 << 20);
+    mjrpc_framer_feed(f, in->data, in->len);
+    const char* msg;
+    size_t len;
+    while (mjrpc_framer_next(f, &msg, &len))
+    {
+        char* response = mjrpc_process_buf(h, msg, len, NULL);
+        if (response == NULL)
+            continue;
+        char header[MJRPC_FRAME_HEADER_MAX];
+        size_t response_len = strlen(response);
+        size_t header_len;
+        mjrpc_frame_header(framing, response_len, header, &header_len);
+        wire_append(out, header, header_len);
+        wire_append(out, response, response_len);
+        size_t trailer_len;
+        const char* trailer = mjrpc_frame_trailer(framing, &trailer_len);
+        wire_append(out, trailer, trailer_len);
+        free(response);
+    }
+    mjrpc_framer_destroy(f);
+    in->len = 0;
+}
+
+static mjrpc_client_t* make_batching_client(wire_t* w, enum mjrpc_framing framing,
+                                            size_t max_calls, uint32_t window_us)
+{
+    mjrpc_client_config_t config;
+    mjrpc_client_config_init(&config);
+    config.send = wire_send;
+    config.send_data = w;
+    config.framing = framing;
+    config.batch_max_calls = max_calls;
+    config.batch_window_us = window_us;
+    return mjrpc_client_create(&config);
+}
+
+static mjrpc_client_t* make_client(wire_t* w, enum mjrpc_framing framing)
+{
+    return make_batching_client(w, framing, 0, 0);
+}
+
+static cJSON* number_params(double x)
+{
+    cJSON* params = cJSON_CreateArray();
+    cJSON_AddItemToArray(params, cJSON_CreateNumber(x));
+    return params;
+}
+
+void test_pipelined_calls_through_handle(void)
+{
+    enum mjrpc_framing framings[] = {MJRPC_FRAMING_NDJSON, MJRPC_FRAMING_CONTENT_LENGTH,
+                                     MJRPC_FRAMING_LENGTH_PREFIX};
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, double_func, "double", NULL);
+
+    for (int f = 0; f < 3; f++)
+    {
+        wire_t requests = {0}, responses = {0};
+        mjrpc_client_t* client = make_client(&requests, framings[f]);
+        TEST_ASSERT_NOT_NULL(client);
+
+        outcome_t outcomes[50] = {0};
+        int64_t last_id = 0;
+        for (int i = 0; i < 50; i++)
+        {
+            int64_t id;
+            TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_client_call(client, "double", number_params(i),
+                                                                  record, &outcomes[i], &id));
+            TEST_ASSERT_TRUE(id > last_id);
+            last_id = id;
+        }
+        outcome_t bad = {0};
+        mjrpc_client_call(client, "double", cJSON_CreateArray(), record, &bad, NULL);
+        mjrpc_client_notify(client, "double", number_params(1));
+        TEST_ASSERT_EQUAL_size_t(51, mjrpc_client_pending(client));
+
+        serve_wire(h, framings[f], &requests, &responses);
+        /* Feed the responses in awkward fragments */
+        for (size_t off = 0; off < responses.len; off += 7)
+        {
+            size_t n = responses.len - off < 7 ? responses.len - off : 7;
+            TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK,
+                                  mjrpc_client_feed(client, responses.data + off, n));
+        }
+        for (int i = 0; i < 50; i++)
+        {
+            TEST_ASSERT_EQUAL_INT(1, outcomes[i].calls);
+            TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, outcomes[i].status);
+            TEST_ASSERT_EQUAL_INT(i * 2, outcomes[i].result);
+        }
+        TEST_ASSERT_EQUAL_INT(1, bad.calls);
+        TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_INVALID_PARAMS, bad.error_code);
+        TEST_ASSERT_EQUAL_size_t(0, mjrpc_client_pending(client));
+
+        mjrpc_client_destroy(client);
+        free(requests.data);
+        free(responses.data);
+    }
+    mjrpc_destroy_handle(h);
+}
+
+void test_batch_and_out_of_order_responses(void)
+{
+    wire_t w = {0};
+    mjrpc_client_t* client = make_client(&w, MJRPC_FRAMING_NDJSON);
+    outcome_t o[3] = {{0}};
+    int64_t ids[3];
+    for (int i = 0; i < 3; i++)
+        mjrpc_client_call(client, "m", NULL, record, &o[i], &ids[i]);
+
+    char text[256];
+    snprintf(text, sizeof(text),
+             "{\"jsonrpc\":\"2.0\",\"result\":30,\"id\":%lld}\n"
+             "[{\"jsonrpc\":\"2.0\",\"result\":10,\"id\":%lld},"
+             "{\"jsonrpc\":\"2.0\",\"error\":{\"code\":-1,\"message\":\"x\"},\"id\":%lld}]\n",
+             (long long) ids[2], (long long) ids[0], (long long) ids[1]);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_client_feed(client, text, strlen(text)));
+    TEST_ASSERT_EQUAL_INT(10, o[0].result);
+    TEST_ASSERT_EQUAL_INT(-1, o[1].error_code);
+    TEST_ASSERT_EQUAL_INT(30, o[2].result);
+
+    /* A duplicate response no longer matches */
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_NOT_FOUND, mjrpc_client_feed(client, text, strlen(text)));
+    TEST_ASSERT_EQUAL_INT(1, o[0].calls);
+
+    mjrpc_client_destroy(client);
+    free(w.data);
+}
+
+void test_many_pending_random_order(void)
+{
+    enum { COUNT = 10000 };
+    wire_t w = {0};
+    mjrpc_client_t* client = make_client(&w, MJRPC_FRAMING_NDJSON);
+    outcome_t* o = calloc(COUNT, sizeof(outcome_t));
+    int64_t* ids = malloc(COUNT * sizeof(int64_t));
+    for (int i = 0; i < COUNT; i++)
+        mjrpc_client_call(client, "m", NULL, record, &o[i], &ids[i]);
+    TEST_ASSERT_EQUAL_size_t(COUNT, mjrpc_client_pending(client));
+
+    /* Shuffle, then answer every other call before the rest */
+    srand(7);
+    int* order = malloc(COUNT * sizeof(int));
+    for (int i = 0; i < COUNT; i++)
+        order[i] = i;
+    for (int i = COUNT - 1; i > 0; i--)
+    {
+        int j = rand() % (i + 1);
+        int t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+    for (int pass = 0; pass < 2; pass++)
+        for (int k = pass; k < COUNT; k += 2)
+        {
+            int i = order[k];
+            char text[96];
+            int n = snprintf(text, sizeof(text), "{\"jsonrpc\":\"2.0\",\"result\":%d,\"id\":%lld}\n",
+                             i, (long long) ids[i]);
+            TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_client_feed(client, text, (size_t) n));
+        }
+    for (int i = 0; i < COUNT; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(1, o[i].calls);
+        TEST_ASSERT_EQUAL_INT(i, o[i].result);
+    }
+    TEST_ASSERT_EQUAL_size_t(0, mjrpc_client_pending(client));
+
+    free(order);
+    free(ids);
+    free(o);
+    mjrpc_client_destroy(client);
+    free(w.data);
+}
+
+void test_cancel_and_destroy(void)
+{
+    wire_t w = {0};
+    mjrpc_client_t* client = make_client(&w, MJRPC_FRAMING_NDJSON);
+    outcome_t a = {0}, b = {0};
+    int64_t id_a;
+    mjrpc_client_call(client, "m", NULL, record, &a, &id_a);
+    mjrpc_client_call(client, "m", NULL, record, &b, NULL);
+
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_client_cancel(client, id_a));
+    TEST_ASSERT_EQUAL_INT(1, a.calls);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_CANCELLED, a.status);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_NOT_FOUND, mjrpc_client_cancel(client, id_a));
+
+    mjrpc_client_destroy(client);
+    TEST_ASSERT_EQUAL_INT(1, b.calls);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_CANCELLED, b.status);
+    free(w.data);
+}
+
+void test_malformed_input_and_send_failure(void)
+{
+    wire_t w = {0};
+    mjrpc_client_t* client = make_client(&w, MJRPC_FRAMING_NDJSON);
+    outcome_t o = {0};
+    int64_t id;
+    mjrpc_client_call(client, "m", NULL, record, &o, &id);
+
+    const char* junk = "not json\n{\"jsonrpc\":\"2.0\",\"id\":1}\n"
+                       "{\"jsonrpc\":\"2.0\",\"result\":1,\"id\":\"1\"}\n"
+                       "{\"jsonrpc\":\"2.0\",\"result\":1,\"id\":1.5}\n";
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_PARSE_FAILED, mjrpc_client_feed(client, junk, strlen(junk)));
+    TEST_ASSERT_EQUAL_INT(0, o.calls);
+    /* Good responses after bad ones still complete */
+    char text[96];
+    snprintf(text, sizeof(text), "{\"jsonrpc\":\"2.0\",\"error\":{\"code\":-32000},\"id\":null}\n"
+                                 "{\"jsonrpc\":\"2.0\",\"result\":5,\"id\":%lld}\n",
+             (long long) id);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_NOT_FOUND, mjrpc_client_feed(client, text, strlen(text)));
+    TEST_ASSERT_EQUAL_INT(1, o.calls);
+
+    /* The request text that went out */
+    TEST_ASSERT_EQUAL_INT(1, w.sends);
+    TEST_ASSERT_EQUAL_MEMORY("{\"jsonrpc\":\"2.0\",\"method\":\"m\",\"id\":1}\n", w.data, w.len);
+
+    w.fail = 1;
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_SYSTEM,
+                          mjrpc_client_call(client, "m", NULL, record, &o, NULL));
+    TEST_ASSERT_EQUAL_size_t(0, mjrpc_client_pending(client));
+
+    mjrpc_client_destroy(client);
+    free(w.data);
+}
+
+void test_batching_by_count(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, double_func, "double", NULL);
+    wire_t requests = {0}, responses = {0};
+    mjrpc_client_t* client = make_batching_client(&requests, MJRPC_FRAMING_CONTENT_LENGTH, 4, 0);
+
+    outcome_t o[10] = {{0}};
+    for (int i = 0; i < 10; i++)
+        TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_client_call(client, "double", number_params(i),
+                                                              record, &o[i], NULL));
+    mjrpc_client_notify(client, "double", number_params(0));
+    TEST_ASSERT_EQUAL_INT(2, requests.sends);
+    TEST_ASSERT_EQUAL_INT64(-1, mjrpc_client_timeout_us(client));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_client_tick(client));
+    TEST_ASSERT_EQUAL_INT(2, requests.sends);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_client_flush(client));
+    TEST_ASSERT_EQUAL_INT(3, requests.sends);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_client_flush(client));
+    TEST_ASSERT_EQUAL_INT(3, requests.sends);
+
+    serve_wire(h, MJRPC_FRAMING_CONTENT_LENGTH, &requests, &responses);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_client_feed(client, responses.data, responses.len));
+    for (int i = 0; i < 10; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(1, o[i].calls);
+        TEST_ASSERT_EQUAL_INT(i * 2, o[i].result);
+    }
+    TEST_ASSERT_EQUAL_size_t(0, mjrpc_client_pending(client));
+
+    /* A batch of one goes out as a plain request */
+    requests.len = 0;
+    mjrpc_client_call(client, "m", NULL, NULL, NULL, NULL);
+    mjrpc_client_flush(client);
+    TEST_ASSERT_EQUAL_INT(4, requests.sends);
+    const char* single = "{\"jsonrpc\":\"2.0\",\"method\":\"m\",\"id\":11}";
+    TEST_ASSERT_TRUE(requests.len > strlen(single));
+    TEST_ASSERT_EQUAL_MEMORY(single, requests.data + requests.len - strlen(single), strlen(single));
+
+    mjrpc_client_destroy(client);
+    mjrpc_destroy_handle(h);
+    free(requests.data);
+    free(responses.data);
+}
+
+void test_batching_by_window(void)
+{
+    wire_t w = {0};
+    mjrpc_client_t* client = make_batching_client(&w, MJRPC_FRAMING_NDJSON, 100, 20000);
+    outcome_t o = {0};
+    mjrpc_client_call(client, "m", NULL, record, &o, NULL);
+    mjrpc_client_call(client, "m", NULL, record, &o, NULL);
+    int64_t left = mjrpc_client_timeout_us(client);
+    TEST_ASSERT_TRUE(left > 0 && left <= 20000);
+    TEST_ASSERT_EQUAL_INT(0, w.sends);
+
+    usleep(25000);
+    TEST_ASSERT_EQUAL_INT64(0, mjrpc_client_timeout_us(client));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_client_tick(client));
+    TEST_ASSERT_EQUAL_INT(1, w.sends);
+    TEST_ASSERT_EQUAL_INT64(-1, mjrpc_client_timeout_us(client));
+
+    /* A call after the window has passed takes the batch along */
+    mjrpc_client_call(client, "m", NULL, record, &o, NULL);
+    usleep(25000);
+    mjrpc_client_call(client, "m", NULL, record, &o, NULL);
+    TEST_ASSERT_EQUAL_INT(2, w.sends);
+    TEST_ASSERT_EQUAL_size_t(4, mjrpc_client_pending(client));
+
+    /* Queued calls are cancelled, not sent, on destroy */
+    mjrpc_client_call(client, "m", NULL, record, &o, NULL);
+    mjrpc_client_destroy(client);
+    TEST_ASSERT_EQUAL_INT(2, w.sends);
+    TEST_ASSERT_EQUAL_INT(5, o.calls);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_CANCELLED, o.status);
+    free(w.data);
+}
+
+void test_batch_send_failure(void)
+{
+    wire_t w = {0};
+    w.fail = 1;
+    mjrpc_client_t* client = make_batching_client(&w, MJRPC_FRAMING_NDJSON, 3, 0);
+    outcome_t o[3] = {{0}};
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_client_call(client, "m", NULL, record, &o[0], NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_client_call(client, "m", NULL, record, &o[1], NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_SYSTEM,
+                          mjrpc_client_call(client, "m", NULL, record, &o[2], NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_SYSTEM, o[0].status);
+    TEST_ASSERT_EQUAL_INT(1, o[1].calls);
+    TEST_ASSERT_EQUAL_INT(0, o[2].calls);
+    TEST_ASSERT_EQUAL_size_t(0, mjrpc_client_pending(client));
+
+    mjrpc_client_call(client, "m", NULL, record, &o[2], NULL);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_SYSTEM, mjrpc_client_flush(client));
+    TEST_ASSERT_EQUAL_INT(1, o[2].calls);
+    mjrpc_client_destroy(client);
+}
+
+void test_rpc_client_invalid_params(void)
+{
+    mjrpc_client_config_t config;
+    mjrpc_client_config_init(&config);
+    TEST_ASSERT_NULL(mjrpc_client_create(&config));
+    TEST_ASSERT_NULL(mjrpc_client_create(NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM,
+                          mjrpc_client_call(NULL, "m", cJSON_CreateArray(), NULL, NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_client_notify(NULL, "m", NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_client_feed(NULL, "x", 1));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_client_cancel(NULL, 1));
+    TEST_ASSERT_EQUAL_size_t(0, mjrpc_client_pending(NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_client_flush(NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_client_tick(NULL));
+    TEST_ASSERT_EQUAL_INT64(-1, mjrpc_client_timeout_us(NULL));
+    mjrpc_client_destroy(NULL);
+
+    wire_t w = {0};
+    mjrpc_client_t* client = make_client(&w, MJRPC_FRAMING_NDJSON);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM,
+                          mjrpc_client_call(client, NULL, NULL, NULL, NULL, NULL));
+    mjrpc_client_destroy(client);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_pipelined_calls_through_handle);
+    RUN_TEST(test_batch_and_out_of_order_responses);
+    RUN_TEST(test_many_pending_random_order);
+    RUN_TEST(test_cancel_and_destroy);
+    RUN_TEST(test_malformed_input_and_send_failure);
+    RUN_TEST(test_batching_by_count);
+    RUN_TEST(test_batching_by_window);
+    RUN_TEST(test_batch_send_failure);
+    RUN_TEST(test_rpc_client_invalid_params);
+    return UNITY_END();
+}
@@ -0,0 +1,373 @@
+/**
+ * @file server_test.c
+ * @brief Tests for the socket server (mjsonrpc_server.h)
+ *
+ * Covers:
+ *   - Newline-delimited requests over TCP and Unix sockets
+ *   - Messages split across writes and several messages per write
+ *   - Notifications producing no output
+ *   - Multiple reactors sharing a port
+ *   - Oversized messages closing the connection
+ *   - Responses larger than the connection buffers
+ *   - Content-Length and length-prefixed framing
+ *   - All of the above on the io_uring backend when the kernel has it
+ */
+
+#include "unity.h"
+#include "mjsonrpc_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+/* Backend under test, every test runs once per backend */
+static enum mjrpc_server_backend backend = MJRPC_SERVER_BACKEND_EPOLL;
+
+static void config_init(mjrpc_server_config_t* config)
+{
+    mjrpc_server_config_init(config);
+    config->backend = backend;
+}
+
+static cJSON* echo_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) ctx;
+    (void) id;
+    return cJSON_Duplicate(params, 1);
+}
+
+static mjrpc_handle_t* make_handle(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, echo_func, "echo", NULL);
+    return h;
+}
+
+static int connect_tcp(uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    TEST_ASSERT_EQUAL_INT(0, connect(fd, (struct sockaddr*) &addr, sizeof(addr)));
+    return fd;
+}
+
+static void send_all(int fd, const char* text)
+{
+    size_t len = strlen(text);
+    TEST_ASSERT_EQUAL_INT((int) len, (int) write(fd, text, len));
+}
+
+/* Read one newline-terminated line into buf (without the newline) */
+static int read_line(int fd, char* buf, size_t size)
+{
+    size_t len = 0;
+    while (len + 1 < size)
+    {
+        ssize_t n = read(fd, buf + len, 1);
+        if (n <= 0)
+            return -1;
+        if (buf[len] == '\n')
+            break;
+        len++;
+    }
+    buf[len] = '\0';
+    return (int) len;
+}
+
+static void expect_echo(int fd, int id, const char* value)
+{
+    char line[256];
+    TEST_ASSERT_TRUE(read_line(fd, line, sizeof(line)) > 0);
+    cJSON* resp = cJSON_Parse(line);
+    TEST_ASSERT_NOT_NULL(resp);
+    TEST_ASSERT_EQUAL_INT(id, cJSON_GetObjectItem(resp, "id")->valueint);
+    cJSON* result = cJSON_GetObjectItem(resp, "result");
+    TEST_ASSERT_EQUAL_STRING(value, cJSON_GetArrayItem(result, 0)->valuestring);
+    cJSON_Delete(resp);
+}
+
+void test_tcp_pipelined_and_split(void)
+{
+    mjrpc_handle_t* h = make_handle();
+    mjrpc_server_config_t config;
+    config_init(&config);
+    config.tcp_host = "127.0.0.1";
+    mjrpc_server_t* server = mjrpc_server_create(h, &config);
+    TEST_ASSERT_NOT_NULL(server);
+    TEST_ASSERT_NOT_EQUAL(0, mjrpc_server_tcp_port(server));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_server_start(server));
+
+    int fd = connect_tcp(mjrpc_server_tcp_port(server));
+    /* Two messages and a notification in one write */
+    send_all(fd, "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[\"a\"],\"id\":1}\n"
+                 "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[\"n\"]}\n"
+                 "\r\n"
+                 "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[\"b\"],\"id\":2}\n");
+    expect_echo(fd, 1, "a");
+    expect_echo(fd, 2, "b");
+
+    /* One message split across writes */
+    send_all(fd, "{\"jsonrpc\":\"2.0\",\"meth");
+    usleep(10000);
+    send_all(fd, "od\":\"echo\",\"params\":[\"c\"],\"id\":3}\n");
+    expect_echo(fd, 3, "c");
+
+    /* Parse errors are answered, the connection stays usable */
+    char line[256];
+    send_all(fd, "not json\n");
+    TEST_ASSERT_TRUE(read_line(fd, line, sizeof(line)) > 0);
+    TEST_ASSERT_NOT_NULL(strstr(line, "-32700"));
+    send_all(fd, "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[\"d\"],\"id\":4}\n");
+    expect_echo(fd, 4, "d");
+
+    close(fd);
+    mjrpc_server_destroy(server);
+    mjrpc_destroy_handle(h);
+}
+
+void test_unix_socket(void)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/mjrpc_server_test_%d.sock", (int) getpid());
+
+    mjrpc_handle_t* h = make_handle();
+    mjrpc_server_config_t config;
+    config_init(&config);
+    config.unix_path = path;
+    mjrpc_server_t* server = mjrpc_server_create(h, &config);
+    TEST_ASSERT_NOT_NULL(server);
+    TEST_ASSERT_EQUAL_INT(0, mjrpc_server_tcp_port(server));
+    mjrpc_server_start(server);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    TEST_ASSERT_EQUAL_INT(0, connect(fd, (struct sockaddr*) &addr, sizeof(addr)));
+    send_all(fd, "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[\"u\"],\"id\":9}\n");
+    expect_echo(fd, 9, "u");
+    close(fd);
+
+    mjrpc_server_destroy(server);
+    TEST_ASSERT_NOT_EQUAL(0, access(path, F_OK));
+    mjrpc_destroy_handle(h);
+}
+
+void test_multiple_reactors_and_restart(void)
+{
+    mjrpc_handle_t* h = make_handle();
+    mjrpc_server_config_t config;
+    config_init(&config);
+    config.tcp_host = "127.0.0.1";
+    config.reactors = 4;
+    mjrpc_server_t* server = mjrpc_server_create(h, &config);
+    TEST_ASSERT_NOT_NULL(server);
+
+    for (int round = 0; round < 2; round++)
+    {
+        TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_server_start(server));
+        TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_server_start(server));
+        int fds[16];
+        for (int i = 0; i < 16; i++)
+            fds[i] = connect_tcp(mjrpc_server_tcp_port(server));
+        for (int i = 0; i < 16; i++)
+        {
+            char req[128];
+            snprintf(req, sizeof(req),
+                     "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[\"x\"],\"id\":%d}\n", i);
+            send_all(fds[i], req);
+        }
+        for (int i = 0; i < 16; i++)
+        {
+            expect_echo(fds[i], i, "x");
+            close(fds[i]);
+        }
+        TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_server_stop(server));
+    }
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_server_stop(server));
+
+    mjrpc_server_destroy(server);
+    mjrpc_destroy_handle(h);
+}
+
+void test_oversized_message_closes_connection(void)
+{
+    mjrpc_handle_t* h = make_handle();
+    mjrpc_server_config_t config;
+    config_init(&config);
+    config.tcp_host = "127.0.0.1";
+    config.max_message_size = 1024;
+    mjrpc_server_t* server = mjrpc_server_create(h, &config);
+    mjrpc_server_start(server);
+
+    int fd = connect_tcp(mjrpc_server_tcp_port(server));
+    char junk[4096];
+    memset(junk, 'x', sizeof(junk) - 1);
+    junk[sizeof(junk) - 1] = '\0';
+    send_all(fd, junk);
+    char c;
+    TEST_ASSERT_TRUE(read(fd, &c, 1) <= 0);
+    close(fd);
+
+    mjrpc_server_destroy(server);
+    mjrpc_destroy_handle(h);
+}
+
+void test_large_responses(void)
+{
+    mjrpc_handle_t* h = make_handle();
+    mjrpc_server_config_t config;
+    config_init(&config);
+    config.tcp_host = "127.0.0.1";
+    mjrpc_server_t* server = mjrpc_server_create(h, &config);
+    mjrpc_server_start(server);
+
+    /* Several responses, each larger than the default 16 KiB buffers */
+    enum { SIZE = 40000, COUNT = 6 };
+    char* value = malloc(SIZE + 1);
+    memset(value, 'v', SIZE);
+    value[SIZE] = '\0';
+    size_t req_cap = SIZE + 128;
+    char* req = malloc(req_cap * COUNT);
+    size_t len = 0;
+    for (int i = 0; i < COUNT; i++)
+        len += (size_t) snprintf(req + len, req_cap,
+                                 "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[\"%s\"],"
+                                 "\"id\":%d}\n",
+                                 value, i);
+
+    int fd = connect_tcp(mjrpc_server_tcp_port(server));
+    for (size_t off = 0; off < len;)
+    {
+        ssize_t n = write(fd, req + off, len - off);
+        TEST_ASSERT_TRUE(n > 0);
+        off += (size_t) n;
+    }
+    char* line = malloc(SIZE + 256);
+    for (int i = 0; i < COUNT; i++)
+    {
+        TEST_ASSERT_TRUE(read_line(fd, line, SIZE + 256) > SIZE);
+        cJSON* resp = cJSON_Parse(line);
+        TEST_ASSERT_EQUAL_INT(i, cJSON_GetObjectItem(resp, "id")->valueint);
+        TEST_ASSERT_EQUAL_STRING(
+            value, cJSON_GetArrayItem(cJSON_GetObjectItem(resp, "result"), 0)->valuestring);
+        cJSON_Delete(resp);
+    }
+    close(fd);
+
+    free(line);
+    free(req);
+    free(value);
+    mjrpc_server_destroy(server);
+    mjrpc_destroy_handle(h);
+}
+
+/* Read exactly len bytes */
+static void read_exact(int fd, char* buf, size_t len)
+{
+    for (size_t off = 0; off < len;)
+    {
+        ssize_t n = read(fd, buf + off, len - off);
+        TEST_ASSERT_TRUE(n > 0);
+        off += (size_t) n;
+    }
+}
+
+void test_length_framings(void)
+{
+    enum mjrpc_framing framings[] = {MJRPC_FRAMING_CONTENT_LENGTH, MJRPC_FRAMING_LENGTH_PREFIX};
+    static const char body[] = "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[\"f\"],\"id\":7}";
+    static const char expected[] = "{\"jsonrpc\":\"2.0\",\"result\":[\"f\"],\"id\":7}";
+
+    for (int i = 0; i < 2; i++)
+    {
+        mjrpc_handle_t* h = make_handle();
+        mjrpc_server_config_t config;
+        config_init(&config);
+        config.tcp_host = "127.0.0.1";
+        config.framing = framings[i];
+        mjrpc_server_t* server = mjrpc_server_create(h, &config);
+        TEST_ASSERT_NOT_NULL(server);
+        mjrpc_server_start(server);
+        int fd = connect_tcp(mjrpc_server_tcp_port(server));
+
+        /* Two frames, the second split inside its header */
+        char frames[512];
+        size_t len = 0;
+        for (int k = 0; k < 2; k++)
+        {
+            size_t header_len;
+            mjrpc_frame_header(framings[i], sizeof(body) - 1, frames + len, &header_len);
+            len += header_len;
+            memcpy(frames + len, body, sizeof(body) - 1);
+            len += sizeof(body) - 1;
+        }
+        size_t first = len / 2 + 2;
+        TEST_ASSERT_EQUAL_INT((int) first, (int) write(fd, frames, first));
+        usleep(10000);
+        TEST_ASSERT_EQUAL_INT((int) (len - first), (int) write(fd, frames + first, len - first));
+
+        char header[MJRPC_FRAME_HEADER_MAX];
+        size_t header_len;
+        mjrpc_frame_header(framings[i], sizeof(expected) - 1, header, &header_len);
+        for (int k = 0; k < 2; k++)
+        {
+            char got[256];
+            read_exact(fd, got, header_len + sizeof(expected) - 1);
+            TEST_ASSERT_EQUAL_MEMORY(header, got, header_len);
+            TEST_ASSERT_EQUAL_MEMORY(expected, got + header_len, sizeof(expected) - 1);
+        }
+
+        close(fd);
+        mjrpc_server_destroy(server);
+        mjrpc_destroy_handle(h);
+    }
+}
+
+void test_server_invalid_params(void)
+{
+    mjrpc_handle_t* h = make_handle();
+    mjrpc_server_config_t config;
+    mjrpc_server_config_init(&config);
+    TEST_ASSERT_NULL(mjrpc_server_create(h, &config));
+    config.tcp_host = "127.0.0.1";
+    TEST_ASSERT_NULL(mjrpc_server_create(NULL, &config));
+    TEST_ASSERT_NULL(mjrpc_server_create(h, NULL));
+    config.framing = (enum mjrpc_framing) 42;
+    TEST_ASSERT_NULL(mjrpc_server_create(h, &config));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_server_start(NULL));
+    mjrpc_server_destroy(NULL);
+    mjrpc_destroy_handle(h);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_tcp_pipelined_and_split);
+    RUN_TEST(test_unix_socket);
+    RUN_TEST(test_multiple_reactors_and_restart);
+    RUN_TEST(test_oversized_message_closes_connection);
+    RUN_TEST(test_large_responses);
+    RUN_TEST(test_length_framings);
+    RUN_TEST(test_server_invalid_params);
+
+    backend = MJRPC_SERVER_BACKEND_IO_URING;
+    RUN_TEST(test_tcp_pipelined_and_split);
+    RUN_TEST(test_unix_socket);
+    RUN_TEST(test_multiple_reactors_and_restart);
+    RUN_TEST(test_oversized_message_closes_connection);
+    RUN_TEST(test_large_responses);
+    RUN_TEST(test_length_framings);
+    return UNITY_END();
+}
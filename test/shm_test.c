@@ -0,0 +1,386 @@
+/**
+ * @file shm_test.c
+ * @brief Tests for the shared-memory transport (mjsonrpc_shm.h)
+ *
+ * Covers:
+ *   - Raw messages across the ring end
+ *   - Messages of the maximum size
+ *   - Timeouts on empty and full rings
+ *   - Serving a handle to a thread and to a forked process
+ *   - Named channels
+ *   - Shutdown waking a blocked receiver
+ *   - Corrupt record lengths closing the channel
+ */
+
+#include "unity.h"
+#include "mjsonrpc_shm.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static cJSON* echo_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) ctx;
+    (void) id;
+    return cJSON_Duplicate(params, 1);
+}
+
+typedef struct {
+    mjrpc_shm_t* shm;
+    mjrpc_handle_t* handle;
+    int ret;
+} serve_args_t;
+
+static void* serve_thread(void* arg)
+{
+    serve_args_t* a = arg;
+    a->ret = mjrpc_shm_serve(a->shm, a->handle);
+    return NULL;
+}
+
+/* Send a request and return the response as a string (caller frees) */
+static char* call(mjrpc_shm_t* client, const char* request)
+{
+    if (mjrpc_shm_send(client, request, strlen(request), 1000) != MJRPC_RET_OK)
+        return NULL;
+    const char* msg;
+    size_t len;
+    if (mjrpc_shm_recv(client, &msg, &len, 1000) != MJRPC_RET_OK)
+        return NULL;
+    char* copy = malloc(len + 1);
+    memcpy(copy, msg, len);
+    copy[len] = '\0';
+    mjrpc_shm_release(client);
+    return copy;
+}
+
+void test_raw_messages_wrap_around(void)
+{
+    mjrpc_shm_t* server = mjrpc_shm_create(NULL, 4096);
+    TEST_ASSERT_NOT_NULL(server);
+    mjrpc_shm_t* client = mjrpc_shm_attach(mjrpc_shm_fd(server));
+    TEST_ASSERT_NOT_NULL(client);
+    size_t max = mjrpc_shm_max_message(client);
+    TEST_ASSERT_EQUAL_size_t(4092, max);
+
+    char* out = malloc(max);
+    const char* msg;
+    size_t len;
+    /* Odd sizes move the ring offset around so records hit the end; up to
+     * half the ring a record always fits once the ring is drained */
+    for (size_t i = 0; i < 500; i++)
+    {
+        size_t n = (i * 997) % (max / 2);
+        memset(out, (int) ('a' + i % 26), n);
+        TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_shm_send(client, out, n, 1000));
+        TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_shm_recv(server, &msg, &len, 1000));
+        TEST_ASSERT_EQUAL_size_t(n, len);
+        if (n > 0)
+            TEST_ASSERT_EQUAL_MEMORY(out, msg, n);
+        mjrpc_shm_release(server);
+    }
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_TOO_LARGE, mjrpc_shm_send(client, out, max + 1, 0));
+
+    /* Both directions are independent */
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_shm_send(server, "pong", 4, 0));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_shm_recv(client, &msg, &len, 0));
+    TEST_ASSERT_EQUAL_MEMORY("pong", msg, 4);
+    mjrpc_shm_release(client);
+
+    free(out);
+    mjrpc_shm_close(client);
+    mjrpc_shm_close(server);
+}
+
+static void* drain_max_size(void* arg)
+{
+    mjrpc_shm_t* server = arg;
+    static int ok;
+    const char* msg;
+    size_t len;
+    ok = 1;
+    for (int i = 0; i < 20; i++)
+    {
+        ok &= mjrpc_shm_recv(server, &msg, &len, 2000) == MJRPC_RET_OK &&
+              len == mjrpc_shm_max_message(server) - (size_t) (i % 3) && msg[len - 1] == 'z';
+        mjrpc_shm_release(server);
+    }
+    return &ok;
+}
+
+void test_max_size_messages(void)
+{
+    mjrpc_shm_t* server = mjrpc_shm_create(NULL, 4096);
+    mjrpc_shm_t* client = mjrpc_shm_attach(mjrpc_shm_fd(server));
+    size_t max = mjrpc_shm_max_message(client);
+    char* out = malloc(max);
+    memset(out, 'z', max);
+    pthread_t thread;
+    pthread_create(&thread, NULL, drain_max_size, server);
+    /* Each of these needs the whole ring, so the sender waits for the
+     * receiver to skip the end of the ring first */
+    for (int i = 0; i < 20; i++)
+        TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_shm_send(client, out, max - (size_t) (i % 3), 2000));
+    void* ok;
+    pthread_join(thread, &ok);
+    TEST_ASSERT_EQUAL_INT(1, *(int*) ok);
+    free(out);
+    mjrpc_shm_close(client);
+    mjrpc_shm_close(server);
+}
+
+void test_timeouts(void)
+{
+    mjrpc_shm_t* server = mjrpc_shm_create(NULL, 4096);
+    mjrpc_shm_t* client = mjrpc_shm_attach(mjrpc_shm_fd(server));
+    const char* msg;
+    size_t len;
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_TIMEOUT, mjrpc_shm_recv(server, &msg, &len, 0));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_TIMEOUT, mjrpc_shm_recv(server, &msg, &len, 20));
+
+    char block[1000] = {0};
+    int sent = 0;
+    while (mjrpc_shm_send(client, block, sizeof(block), 0) == MJRPC_RET_OK)
+        sent++;
+    TEST_ASSERT_EQUAL_INT(4, sent);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_TIMEOUT,
+                          mjrpc_shm_send(client, block, sizeof(block), 20));
+
+    /* Draining one record makes room again */
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_shm_recv(server, &msg, &len, 0));
+    mjrpc_shm_release(server);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_shm_send(client, block, sizeof(block), 0));
+
+    mjrpc_shm_close(client);
+    mjrpc_shm_close(server);
+}
+
+void test_serve_thread(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, echo_func, "echo", NULL);
+    serve_args_t args = {mjrpc_shm_create(NULL, 1 << 16), h, -1};
+    mjrpc_shm_t* client = mjrpc_shm_attach(mjrpc_shm_fd(args.shm));
+    pthread_t thread;
+    pthread_create(&thread, NULL, serve_thread, &args);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        char request[128];
+        snprintf(request, sizeof(request),
+                 "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[%d],\"id\":%d}", i, i);
+        char* response = call(client, request);
+        TEST_ASSERT_NOT_NULL(response);
+        cJSON* resp = cJSON_Parse(response);
+        TEST_ASSERT_EQUAL_INT(i, cJSON_GetObjectItem(resp, "id")->valueint);
+        TEST_ASSERT_EQUAL_INT(i, cJSON_GetArrayItem(cJSON_GetObjectItem(resp, "result"), 0)->valueint);
+        cJSON_Delete(resp);
+        free(response);
+    }
+
+    /* Notifications get no response, parse errors do */
+    const char* note = "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[0]}";
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_shm_send(client, note, strlen(note), 1000));
+    char* response = call(client, "{oops");
+    TEST_ASSERT_NOT_NULL(strstr(response, "-32700"));
+    free(response);
+
+    mjrpc_shm_shutdown(client);
+    pthread_join(thread, NULL);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, args.ret);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_SYSTEM, mjrpc_shm_send(client, "x", 1, 0));
+
+    mjrpc_shm_close(client);
+    mjrpc_shm_close(args.shm);
+    mjrpc_destroy_handle(h);
+}
+
+void test_serve_forked_process(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, echo_func, "echo", NULL);
+    mjrpc_shm_t* server = mjrpc_shm_create(NULL, 1 << 16);
+    int fd = mjrpc_shm_fd(server);
+
+    pid_t pid = fork();
+    TEST_ASSERT_TRUE(pid >= 0);
+    if (pid == 0)
+    {
+        mjrpc_shm_t* client = mjrpc_shm_attach(fd);
+        int status = client == NULL;
+        for (int i = 0; i < 200 && status == 0; i++)
+        {
+            char* response =
+                call(client, "{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"params\":[\"p\"],\"id\":5}");
+            status = response == NULL || strstr(response, "\"result\":[\"p\"]") == NULL;
+            free(response);
+        }
+        mjrpc_shm_shutdown(client);
+        _exit(status);
+    }
+
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_shm_serve(server, h));
+    int status;
+    TEST_ASSERT_EQUAL_INT(pid, waitpid(pid, &status, 0));
+    TEST_ASSERT_TRUE(WIFEXITED(status));
+    TEST_ASSERT_EQUAL_INT(0, WEXITSTATUS(status));
+
+    mjrpc_shm_close(server);
+    mjrpc_destroy_handle(h);
+}
+
+void test_named_channel(void)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "/mjrpc_shm_test_%d", (int) getpid());
+    mjrpc_shm_t* server = mjrpc_shm_create(name, 8192);
+    TEST_ASSERT_NOT_NULL(server);
+    /* Names are exclusive */
+    TEST_ASSERT_NULL(mjrpc_shm_create(name, 8192));
+    TEST_ASSERT_EQUAL_INT(EEXIST, errno);
+
+    mjrpc_shm_t* client = mjrpc_shm_attach_named(name);
+    TEST_ASSERT_NOT_NULL(client);
+    const char* msg;
+    size_t len;
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_shm_send(client, "hi", 2, 0));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_shm_recv(server, &msg, &len, 0));
+    TEST_ASSERT_EQUAL_MEMORY("hi", msg, 2);
+    mjrpc_shm_release(server);
+    mjrpc_shm_close(client);
+
+    mjrpc_shm_close(server);
+    TEST_ASSERT_NULL(mjrpc_shm_attach_named(name));
+}
+
+static void* blocked_recv(void* arg)
+{
+    const char* msg;
+    size_t len;
+    static int ret;
+    ret = mjrpc_shm_recv(arg, &msg, &len, -1);
+    return &ret;
+}
+
+void test_shutdown_wakes_receiver(void)
+{
+    mjrpc_shm_t* server = mjrpc_shm_create(NULL, 4096);
+    mjrpc_shm_t* client = mjrpc_shm_attach(mjrpc_shm_fd(server));
+    pthread_t thread;
+    pthread_create(&thread, NULL, blocked_recv, server);
+    usleep(50000); /* let it go to sleep on the futex */
+    mjrpc_shm_shutdown(client);
+    void* ret;
+    pthread_join(thread, &ret);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_SYSTEM, *(int*) ret);
+    mjrpc_shm_close(client);
+    mjrpc_shm_close(server);
+}
+
+/* Overwrite the length word of the record holding @p payload */
+static void corrupt_length(mjrpc_shm_t* shm, const char* payload, uint32_t len)
+{
+    struct stat st;
+    TEST_ASSERT_EQUAL_INT(0, fstat(mjrpc_shm_fd(shm), &st));
+    char* map = mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, mjrpc_shm_fd(shm), 0);
+    TEST_ASSERT_TRUE(map != MAP_FAILED);
+    size_t n = strlen(payload);
+    char* found = NULL;
+    for (size_t i = 0; found == NULL && i + n <= (size_t) st.st_size; i++)
+        if (memcmp(map + i, payload, n) == 0)
+            found = map + i;
+    TEST_ASSERT_NOT_NULL(found);
+    memcpy(found - sizeof(len), &len, sizeof(len));
+    munmap(map, (size_t) st.st_size);
+}
+
+void test_corrupt_records(void)
+{
+    /* Longer than the ring, then longer than what the peer published */
+    uint32_t lengths[] = {0x7ffffff0u, 1000};
+    for (int i = 0; i < 2; i++)
+    {
+        mjrpc_shm_t* server = mjrpc_shm_create(NULL, 4096);
+        mjrpc_shm_t* client = mjrpc_shm_attach(mjrpc_shm_fd(server));
+        const char* payload = "corrupt-record-payload";
+        TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_shm_send(client, payload, strlen(payload), 0));
+        corrupt_length(server, payload, lengths[i]);
+
+        if (i == 0)
+        {
+            const char* msg;
+            size_t len;
+            errno = 0;
+            TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_SYSTEM, mjrpc_shm_recv(server, &msg, &len, 0));
+        }
+        else
+        {
+            mjrpc_handle_t* handle = mjrpc_create_handle(0);
+            errno = 0;
+            TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_SYSTEM, mjrpc_shm_serve(server, handle));
+            mjrpc_destroy_handle(handle);
+        }
+        TEST_ASSERT_EQUAL_INT(EPROTO, errno);
+
+        /* The channel is closed for both sides */
+        TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_SYSTEM, mjrpc_shm_send(client, "x", 1, 0));
+        TEST_ASSERT_EQUAL_INT(EPIPE, errno);
+        mjrpc_shm_close(client);
+        mjrpc_shm_close(server);
+    }
+}
+
+void test_shm_invalid_params(void)
+{
+    const char* msg;
+    size_t len;
+    TEST_ASSERT_NULL(mjrpc_shm_attach(-1));
+    TEST_ASSERT_NULL(mjrpc_shm_attach_named(NULL));
+    TEST_ASSERT_EQUAL_INT(-1, mjrpc_shm_fd(NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_shm_send(NULL, "x", 1, 0));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_shm_recv(NULL, &msg, &len, 0));
+    mjrpc_shm_release(NULL);
+    mjrpc_shm_shutdown(NULL);
+    mjrpc_shm_close(NULL);
+
+    /* Descriptors that are not channels */
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+    TEST_ASSERT_NULL(mjrpc_shm_attach(fds[0]));
+    close(fds[0]);
+    close(fds[1]);
+
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_shm_t* server = mjrpc_shm_create(NULL, 4096);
+    mjrpc_shm_t* client = mjrpc_shm_attach(mjrpc_shm_fd(server));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_shm_serve(client, h));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_shm_serve(server, NULL));
+    mjrpc_shm_close(client);
+    mjrpc_shm_close(server);
+    mjrpc_destroy_handle(h);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_raw_messages_wrap_around);
+    RUN_TEST(test_max_size_messages);
+    RUN_TEST(test_timeouts);
+    RUN_TEST(test_serve_thread);
+    RUN_TEST(test_serve_forked_process);
+    RUN_TEST(test_named_channel);
+    RUN_TEST(test_shutdown_wakes_receiver);
+    RUN_TEST(test_corrupt_records);
+    RUN_TEST(test_shm_invalid_params);
+    return UNITY_END();
+}
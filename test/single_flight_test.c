@@ -0,0 +1,261 @@
+/**
+ * @file single_flight_test.c
+ * @brief Tests for single-flight coalescing of identical calls
+ *
+ * Covers:
+ *   - Concurrent identical calls sharing one run, each with its own id
+ *   - Distinct params, notifications and plain methods running separately
+ *   - Shared errors
+ *   - Interplay with the response cache
+ *   - Invalid parameters
+ */
+
+#include "unity.h"
+#include "mjsonrpc.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#define CALLERS 8
+
+static atomic_int invocations;
+
+/* Slow enough that every caller arrives while the first call runs */
+static cJSON* slow_square(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) id;
+    atomic_fetch_add(&invocations, 1);
+    usleep(100000);
+    cJSON* x = cJSON_GetArrayItem(params, 0);
+    if (!cJSON_IsNumber(x))
+    {
+        ctx->error_code = JSON_RPC_CODE_INVALID_PARAMS;
+        ctx->error_message = strdup("Expected a number.");
+        return NULL;
+    }
+    return cJSON_CreateNumber(x->valueint * x->valueint);
+}
+
+static cJSON* quick_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) ctx;
+    (void) params;
+    (void) id;
+    atomic_fetch_add(&invocations, 1);
+    return cJSON_CreateTrue();
+}
+
+static void async_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id, mjrpc_async_token_t* token)
+{
+    (void) ctx;
+    (void) params;
+    (void) id;
+    mjrpc_complete(token, cJSON_CreateNull());
+}
+
+typedef struct
+{
+    mjrpc_handle_t* handle;
+    const char* params;
+    int id;
+    bool notification;
+    cJSON* response;
+} caller_t;
+
+static void* call_thread(void* arg)
+{
+    caller_t* caller = arg;
+    char request[128];
+    if (caller->notification)
+        snprintf(request, sizeof(request),
+                 "{\"jsonrpc\":\"2.0\",\"method\":\"square\",\"params\":%s}", caller->params);
+    else
+        snprintf(request, sizeof(request),
+                 "{\"jsonrpc\":\"2.0\",\"method\":\"square\",\"params\":%s,\"id\":%d}",
+                 caller->params, caller->id);
+    int ret;
+    char* text = mjrpc_process_str(caller->handle, request, &ret);
+    caller->response = text ? cJSON_Parse(text) : NULL;
+    free(text);
+    return NULL;
+}
+
+/* Runs CALLERS concurrent calls; params[i % param_count] is used by caller i */
+static void run_callers(mjrpc_handle_t* h, caller_t* callers, const char** params, int param_count,
+                        bool notification)
+{
+    pthread_t threads[CALLERS];
+    for (int i = 0; i < CALLERS; i++)
+    {
+        callers[i] = (caller_t) {h, params[i % param_count], i + 1, notification, NULL};
+        pthread_create(&threads[i], NULL, call_thread, &callers[i]);
+    }
+    for (int i = 0; i < CALLERS; i++)
+        pthread_join(threads[i], NULL);
+}
+
+static void free_callers(caller_t* callers)
+{
+    for (int i = 0; i < CALLERS; i++)
+        cJSON_Delete(callers[i].response);
+}
+
+void test_single_flight_shares_one_run(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, slow_square, "square", NULL);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_set_single_flight(h, "square", true));
+    atomic_store(&invocations, 0);
+
+    caller_t callers[CALLERS];
+    const char* params[] = {"[7]"};
+    run_callers(h, callers, params, 1, false);
+    TEST_ASSERT_EQUAL_INT(1, atomic_load(&invocations));
+    for (int i = 0; i < CALLERS; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(49, cJSON_GetObjectItem(callers[i].response, "result")->valueint);
+        TEST_ASSERT_EQUAL_INT(i + 1, cJSON_GetObjectItem(callers[i].response, "id")->valueint);
+    }
+    free_callers(callers);
+
+    /* Distinct params each run once */
+    const char* two_params[] = {"[2]", "[3]"};
+    atomic_store(&invocations, 0);
+    run_callers(h, callers, two_params, 2, false);
+    TEST_ASSERT_EQUAL_INT(2, atomic_load(&invocations));
+    for (int i = 0; i < CALLERS; i++)
+        TEST_ASSERT_EQUAL_INT(i % 2 ? 9 : 4, cJSON_GetObjectItem(callers[i].response, "result")->valueint);
+    free_callers(callers);
+    mjrpc_destroy_handle(h);
+}
+
+void test_single_flight_shares_errors(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, slow_square, "square", NULL);
+    mjrpc_set_single_flight(h, "square", true);
+    atomic_store(&invocations, 0);
+
+    caller_t callers[CALLERS];
+    const char* params[] = {"[\"x\"]"};
+    run_callers(h, callers, params, 1, false);
+    TEST_ASSERT_EQUAL_INT(1, atomic_load(&invocations));
+    for (int i = 0; i < CALLERS; i++)
+    {
+        cJSON* error = cJSON_GetObjectItem(callers[i].response, "error");
+        TEST_ASSERT_EQUAL_INT(JSON_RPC_CODE_INVALID_PARAMS, cJSON_GetObjectItem(error, "code")->valueint);
+        TEST_ASSERT_EQUAL_STRING("Expected a number.", cJSON_GetObjectItem(error, "message")->valuestring);
+        TEST_ASSERT_EQUAL_INT(i + 1, cJSON_GetObjectItem(callers[i].response, "id")->valueint);
+    }
+    free_callers(callers);
+    mjrpc_destroy_handle(h);
+}
+
+void test_single_flight_bypasses(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, slow_square, "square", NULL);
+    caller_t callers[CALLERS];
+    const char* params[] = {"[5]"};
+
+    /* Off by default */
+    atomic_store(&invocations, 0);
+    run_callers(h, callers, params, 1, false);
+    TEST_ASSERT_EQUAL_INT(CALLERS, atomic_load(&invocations));
+    free_callers(callers);
+
+    /* Notifications always run */
+    mjrpc_set_single_flight(h, "square", true);
+    atomic_store(&invocations, 0);
+    run_callers(h, callers, params, 1, true);
+    TEST_ASSERT_EQUAL_INT(CALLERS, atomic_load(&invocations));
+    free_callers(callers);
+
+    /* Turned off again, and by replacing the method */
+    mjrpc_set_single_flight(h, "square", false);
+    atomic_store(&invocations, 0);
+    run_callers(h, callers, params, 1, false);
+    TEST_ASSERT_EQUAL_INT(CALLERS, atomic_load(&invocations));
+    free_callers(callers);
+    mjrpc_set_single_flight(h, "square", true);
+    mjrpc_add_method(h, slow_square, "square", NULL);
+    atomic_store(&invocations, 0);
+    run_callers(h, callers, params, 1, false);
+    TEST_ASSERT_EQUAL_INT(CALLERS, atomic_load(&invocations));
+    free_callers(callers);
+    mjrpc_destroy_handle(h);
+}
+
+void test_single_flight_with_cache(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_cached_method(h, slow_square, "square", NULL, 0);
+    mjrpc_set_single_flight(h, "square", true);
+    atomic_store(&invocations, 0);
+
+    caller_t callers[CALLERS];
+    const char* params[] = {"[4]"};
+    run_callers(h, callers, params, 1, false);
+    TEST_ASSERT_EQUAL_INT(1, atomic_load(&invocations));
+    for (int i = 0; i < CALLERS; i++)
+        TEST_ASSERT_EQUAL_INT(16, cJSON_GetObjectItem(callers[i].response, "result")->valueint);
+    free_callers(callers);
+
+    /* Only the leader stored its result; later calls hit it */
+    mjrpc_cache_stats_t stats;
+    mjrpc_get_cache_stats(h, &stats);
+    TEST_ASSERT_EQUAL_size_t(1, stats.entries);
+    run_callers(h, callers, params, 1, false);
+    TEST_ASSERT_EQUAL_INT(1, atomic_load(&invocations));
+    free_callers(callers);
+    mjrpc_destroy_handle(h);
+}
+
+void test_single_flight_sequential_calls(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, quick_func, "quick", NULL);
+    mjrpc_set_single_flight(h, "quick", true);
+    atomic_store(&invocations, 0);
+    for (int i = 0; i < 3; i++)
+    {
+        int ret;
+        char* text = mjrpc_process_str(h, "{\"jsonrpc\":\"2.0\",\"method\":\"quick\",\"id\":1}", &ret);
+        TEST_ASSERT_EQUAL_STRING("{\"jsonrpc\":\"2.0\",\"result\":true,\"id\":1}", text);
+        free(text);
+    }
+    TEST_ASSERT_EQUAL_INT(3, atomic_load(&invocations));
+    mjrpc_destroy_handle(h);
+}
+
+void test_single_flight_invalid_params(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, quick_func, "quick", NULL);
+    mjrpc_add_async_method(h, async_func, "later", NULL);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED,
+                          mjrpc_set_single_flight(NULL, "quick", true));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_set_single_flight(h, NULL, true));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_NOT_FOUND, mjrpc_set_single_flight(h, "missing", true));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_set_single_flight(h, "later", true));
+    mjrpc_destroy_handle(h);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_single_flight_shares_one_run);
+    RUN_TEST(test_single_flight_shares_errors);
+    RUN_TEST(test_single_flight_bypasses);
+    RUN_TEST(test_single_flight_with_cache);
+    RUN_TEST(test_single_flight_sequential_calls);
+    RUN_TEST(test_single_flight_invalid_params);
+    return UNITY_END();
+}
@@ -0,0 +1,308 @@
+/**
+ * @file stats_test.c
+ * @brief Tests for per-method statistics
+ *
+ * Covers:
+ *   - Handles without statistics
+ *   - Call, notification and per-code error counters
+ *   - Latency histogram buckets and percentiles
+ *   - Asynchronous calls counted at completion, also after deletion
+ *   - The built-in rpc.stats method
+ *   - Reset and concurrent updates
+ */
+
+#include "unity.h"
+#include "mjsonrpc.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static cJSON* ok_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) ctx;
+    (void) params;
+    (void) id;
+    return cJSON_CreateTrue();
+}
+
+/* Fails with the code given as first parameter */
+static cJSON* fail_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) id;
+    ctx->error_code = cJSON_GetArrayItem(params, 0)->valueint;
+    ctx->error_message = strdup("failed");
+    return NULL;
+}
+
+static cJSON* sleep_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) ctx;
+    (void) params;
+    (void) id;
+    usleep(2000);
+    return cJSON_CreateTrue();
+}
+
+static mjrpc_async_token_t* parked = NULL;
+
+static void park_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id, mjrpc_async_token_t* token)
+{
+    (void) ctx;
+    (void) params;
+    (void) id;
+    parked = token;
+}
+
+static void drop_response(cJSON* response, void* user_data)
+{
+    (void) user_data;
+    cJSON_Delete(response);
+}
+
+static void call(mjrpc_handle_t* h, const char* request)
+{
+    int ret;
+    char* response = mjrpc_process_str(h, request, &ret);
+    free(response);
+}
+
+static void call_async(mjrpc_handle_t* h, const char* request)
+{
+    cJSON* json = cJSON_Parse(request);
+    mjrpc_process_async(h, json, drop_response, NULL);
+    cJSON_Delete(json);
+}
+
+static uint64_t histogram_count(const mjrpc_method_stats_t* stats)
+{
+    uint64_t count = 0;
+    for (size_t i = 0; i < MJRPC_STATS_LATENCY_BUCKETS; i++)
+        count += stats->latency[i];
+    return count;
+}
+
+void test_stats_disabled_by_default(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, ok_func, "ok", NULL);
+    call(h, "{\"jsonrpc\":\"2.0\",\"method\":\"ok\",\"id\":1}");
+    mjrpc_method_stats_t stats;
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_NOT_FOUND, mjrpc_get_method_stats(h, "ok", &stats));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_NOT_FOUND,
+                          mjrpc_get_method_stats(h, MJRPC_STATS_METHOD, &stats));
+    mjrpc_destroy_handle(h);
+}
+
+void test_stats_counts_calls_and_errors(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, ok_func, "ok", NULL);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_enable_stats(h, false));
+    /* Methods added later get statistics as well */
+    mjrpc_add_method(h, fail_func, "fail", NULL);
+
+    for (int i = 0; i < 5; i++)
+        call(h, "{\"jsonrpc\":\"2.0\",\"method\":\"ok\",\"id\":1}");
+    call(h, "{\"jsonrpc\":\"2.0\",\"method\":\"ok\"}");
+    call(h, "[{\"jsonrpc\":\"2.0\",\"method\":\"ok\",\"id\":1},"
+            "{\"jsonrpc\":\"2.0\",\"method\":\"ok\",\"id\":2}]");
+    for (int code = 1; code <= 10; code++)
+    {
+        char request[96];
+        snprintf(request, sizeof(request),
+                 "{\"jsonrpc\":\"2.0\",\"method\":\"fail\",\"params\":[%d],\"id\":1}", code);
+        call(h, request);
+        call(h, request);
+    }
+
+    mjrpc_method_stats_t stats;
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_get_method_stats(h, "ok", &stats));
+    TEST_ASSERT_EQUAL_UINT64(7, stats.calls);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.notifications);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.errors);
+    TEST_ASSERT_EQUAL_UINT64(8, histogram_count(&stats));
+
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_get_method_stats(h, "fail", &stats));
+    TEST_ASSERT_EQUAL_UINT64(20, stats.calls);
+    TEST_ASSERT_EQUAL_UINT64(20, stats.errors);
+    for (int i = 0; i < MJRPC_STATS_ERROR_CODES; i++)
+    {
+        TEST_ASSERT_EQUAL_INT32(i + 1, stats.error_codes[i].code);
+        TEST_ASSERT_EQUAL_UINT64(2, stats.error_codes[i].count);
+    }
+    TEST_ASSERT_EQUAL_UINT64(20 - 2 * MJRPC_STATS_ERROR_CODES, stats.other_errors);
+
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_reset_stats(h));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_get_method_stats(h, "fail", &stats));
+    TEST_ASSERT_EQUAL_UINT64(0, stats.calls);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.error_codes[0].count);
+    TEST_ASSERT_EQUAL_UINT64(0, histogram_count(&stats));
+    mjrpc_destroy_handle(h);
+}
+
+void test_stats_latency_histogram(void)
+{
+    /* Bucket bounds grow monotonically by at most a quarter */
+    TEST_ASSERT_EQUAL_UINT64(0, mjrpc_stats_bucket_upper_ns(0));
+    TEST_ASSERT_EQUAL_UINT64(4, mjrpc_stats_bucket_upper_ns(4));
+    TEST_ASSERT_EQUAL_UINT64(9, mjrpc_stats_bucket_upper_ns(8));
+    for (size_t i = 8; i < MJRPC_STATS_LATENCY_BUCKETS - 1; i++)
+    {
+        uint64_t lower = mjrpc_stats_bucket_upper_ns(i - 1) + 1;
+        uint64_t upper = mjrpc_stats_bucket_upper_ns(i);
+        TEST_ASSERT_TRUE(upper >= lower);
+        TEST_ASSERT_TRUE(upper - lower <= lower / 4);
+    }
+    TEST_ASSERT_EQUAL_UINT64(UINT64_MAX,
+                             mjrpc_stats_bucket_upper_ns(MJRPC_STATS_LATENCY_BUCKETS - 1));
+
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, sleep_func, "sleep", NULL);
+    mjrpc_enable_stats(h, false);
+    for (int i = 0; i < 5; i++)
+        call(h, "{\"jsonrpc\":\"2.0\",\"method\":\"sleep\",\"id\":1}");
+    mjrpc_method_stats_t stats;
+    mjrpc_get_method_stats(h, "sleep", &stats);
+    uint64_t p50 = mjrpc_stats_percentile_ns(&stats, 50);
+    uint64_t max = mjrpc_stats_percentile_ns(&stats, 100);
+    TEST_ASSERT_TRUE(p50 >= 2000000);
+    TEST_ASSERT_TRUE(max >= p50);
+    TEST_ASSERT_TRUE(stats.latency_total_ns >= 5 * 2000000ull);
+    TEST_ASSERT_TRUE(mjrpc_stats_percentile_ns(&stats, 0) <= p50);
+
+    memset(&stats, 0, sizeof(stats));
+    TEST_ASSERT_EQUAL_UINT64(0, mjrpc_stats_percentile_ns(&stats, 50));
+    stats.latency[4] = 3;
+    stats.latency[8] = 1;
+    TEST_ASSERT_EQUAL_UINT64(4, mjrpc_stats_percentile_ns(&stats, 75));
+    TEST_ASSERT_EQUAL_UINT64(9, mjrpc_stats_percentile_ns(&stats, 76));
+    mjrpc_destroy_handle(h);
+}
+
+void test_stats_async_methods(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_async_method(h, park_func, "park", NULL);
+    mjrpc_enable_stats(h, false);
+    mjrpc_method_stats_t stats;
+
+    call_async(h, "{\"jsonrpc\":\"2.0\",\"method\":\"park\",\"id\":1}");
+    mjrpc_get_method_stats(h, "park", &stats);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.calls);
+    mjrpc_complete(parked, NULL);
+    call_async(h, "{\"jsonrpc\":\"2.0\",\"method\":\"park\",\"id\":2}");
+    mjrpc_fail(parked, JSON_RPC_CODE_INVALID_PARAMS, "no");
+    mjrpc_get_method_stats(h, "park", &stats);
+    TEST_ASSERT_EQUAL_UINT64(2, stats.calls);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.errors);
+    TEST_ASSERT_EQUAL_INT32(JSON_RPC_CODE_INVALID_PARAMS, stats.error_codes[0].code);
+
+    /* The synchronous entry point rejects it as an internal error */
+    call(h, "{\"jsonrpc\":\"2.0\",\"method\":\"park\",\"id\":3}");
+    mjrpc_get_method_stats(h, "park", &stats);
+    TEST_ASSERT_EQUAL_INT32(JSON_RPC_CODE_INTERNAL_ERROR, stats.error_codes[1].code);
+
+    /* Completing after the method was deleted is still safe */
+    call_async(h, "{\"jsonrpc\":\"2.0\",\"method\":\"park\",\"id\":4}");
+    mjrpc_del_method(h, "park");
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_NOT_FOUND, mjrpc_get_method_stats(h, "park", &stats));
+    mjrpc_complete(parked, NULL);
+    mjrpc_destroy_handle(h);
+}
+
+void test_stats_builtin_method(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, ok_func, "ok", NULL);
+    mjrpc_add_method(h, fail_func, "fail", NULL);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_enable_stats(h, true));
+    call(h, "{\"jsonrpc\":\"2.0\",\"method\":\"ok\",\"id\":1}");
+    call(h, "{\"jsonrpc\":\"2.0\",\"method\":\"fail\",\"params\":[-32602],\"id\":1}");
+
+    int ret;
+    char* text = mjrpc_process_str(h, "{\"jsonrpc\":\"2.0\",\"method\":\"rpc.stats\",\"id\":9}", &ret);
+    cJSON* response = cJSON_Parse(text);
+    free(text);
+    cJSON* result = cJSON_GetObjectItem(response, "result");
+    TEST_ASSERT_NOT_NULL(result);
+
+    cJSON* ok = cJSON_GetObjectItem(result, "ok");
+    TEST_ASSERT_EQUAL_INT(1, cJSON_GetObjectItem(ok, "calls")->valueint);
+    TEST_ASSERT_EQUAL_INT(0, cJSON_GetObjectItem(ok, "errors")->valueint);
+    cJSON* latency = cJSON_GetObjectItem(ok, "latency_ns");
+    TEST_ASSERT_TRUE(cJSON_GetObjectItem(latency, "p99")->valuedouble >=
+                     cJSON_GetObjectItem(latency, "p50")->valuedouble);
+    TEST_ASSERT_NOT_NULL(cJSON_GetObjectItem(latency, "max"));
+
+    cJSON* fail = cJSON_GetObjectItem(result, "fail");
+    cJSON* codes = cJSON_GetObjectItem(fail, "error_codes");
+    TEST_ASSERT_EQUAL_INT(1, cJSON_GetObjectItem(codes, "-32602")->valueint);
+    TEST_ASSERT_NOT_NULL(cJSON_GetObjectItem(result, MJRPC_STATS_METHOD));
+    cJSON_Delete(response);
+
+    /* Enabling twice is harmless */
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_enable_stats(h, true));
+    TEST_ASSERT_EQUAL_size_t(3, mjrpc_get_method_count(h));
+    mjrpc_destroy_handle(h);
+}
+
+#define STATS_THREADS 4
+#define STATS_CALLS_PER_THREAD 5000
+
+static void* hammer(void* arg)
+{
+    mjrpc_handle_t* h = arg;
+    for (int i = 0; i < STATS_CALLS_PER_THREAD; i++)
+        call(h, "{\"jsonrpc\":\"2.0\",\"method\":\"ok\",\"id\":1}");
+    return NULL;
+}
+
+void test_stats_concurrent_updates(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    mjrpc_add_method(h, ok_func, "ok", NULL);
+    mjrpc_enable_stats(h, false);
+    pthread_t threads[STATS_THREADS];
+    for (int i = 0; i < STATS_THREADS; i++)
+        pthread_create(&threads[i], NULL, hammer, h);
+    for (int i = 0; i < STATS_THREADS; i++)
+        pthread_join(threads[i], NULL);
+    mjrpc_method_stats_t stats;
+    mjrpc_get_method_stats(h, "ok", &stats);
+    TEST_ASSERT_EQUAL_UINT64(STATS_THREADS * STATS_CALLS_PER_THREAD, stats.calls);
+    TEST_ASSERT_EQUAL_UINT64(STATS_THREADS * STATS_CALLS_PER_THREAD, histogram_count(&stats));
+    mjrpc_destroy_handle(h);
+}
+
+void test_stats_invalid_params(void)
+{
+    mjrpc_method_stats_t stats;
+    mjrpc_handle_t* h = mjrpc_create_handle(0);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED, mjrpc_enable_stats(NULL, true));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED,
+                          mjrpc_get_method_stats(NULL, "x", &stats));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_get_method_stats(h, NULL, &stats));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_INVALID_PARAM, mjrpc_get_method_stats(h, "x", NULL));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED, mjrpc_reset_stats(NULL));
+    TEST_ASSERT_EQUAL_UINT64(0, mjrpc_stats_percentile_ns(NULL, 50));
+    mjrpc_destroy_handle(h);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_stats_disabled_by_default);
+    RUN_TEST(test_stats_counts_calls_and_errors);
+    RUN_TEST(test_stats_latency_histogram);
+    RUN_TEST(test_stats_async_methods);
+    RUN_TEST(test_stats_builtin_method);
+    RUN_TEST(test_stats_concurrent_updates);
+    RUN_TEST(test_stats_invalid_params);
+    return UNITY_END();
+}
@@ -0,0 +1,233 @@
+/**
+ * @file string_test.c
+ * @brief Tests for string handling in the bundled cJSON
+ *
+ * Covers:
+ *   - Printing strings of every length around the 16/32 byte blocks with a
+ *     character that needs escaping at every position
+ *   - Parsing the printed form back, including \u and surrogate escapes
+ *   - Bytes >= 0x80 passing through unescaped
+ *   - Unterminated strings and trailing backslashes at block boundaries
+ *   - In situ parsing: strings and names pointing into the input, no
+ *     allocations for them, copies made by cJSON_Duplicate()
+ */
+
+#include "unity.h"
+#include "cJSON.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#define MAX_LENGTH 80
+
+/* Byte-by-byte reference for print_string_ptr */
+static void reference_escape(const char* input, char* output)
+{
+    *output++ = '"';
+    for (const unsigned char* p = (const unsigned char*) input; *p; p++)
+    {
+        switch (*p)
+        {
+        case '"': output += sprintf(output, "\\\""); break;
+        case '\\': output += sprintf(output, "\\\\"); break;
+        case '\b': output += sprintf(output, "\\b"); break;
+        case '\f': output += sprintf(output, "\\f"); break;
+        case '\n': output += sprintf(output, "\\n"); break;
+        case '\r': output += sprintf(output, "\\r"); break;
+        case '\t': output += sprintf(output, "\\t"); break;
+        default:
+            if (*p < 32)
+                output += sprintf(output, "\\u%04x", *p);
+            else
+                *output++ = (char) *p;
+        }
+    }
+    *output++ = '"';
+    *output = '\0';
+}
+
+static void check_round_trip(const char* input)
+{
+    char expected[MAX_LENGTH * 6 + 3];
+    reference_escape(input, expected);
+
+    cJSON* item = cJSON_CreateString(input);
+    char* printed = cJSON_PrintUnformatted(item);
+    TEST_ASSERT_EQUAL_STRING(expected, printed);
+    cJSON_Delete(item);
+
+    item = cJSON_Parse(printed);
+    TEST_ASSERT_NOT_NULL(item);
+    TEST_ASSERT_EQUAL_STRING(input, cJSON_GetStringValue(item));
+    cJSON_Delete(item);
+    free(printed);
+}
+
+void test_print_and_parse_every_position(void)
+{
+    const char specials[] = {'"', '\\', '\n', '\t', '\x01', '\x1f', '/'};
+    char input[MAX_LENGTH + 1];
+    for (int length = 0; length <= MAX_LENGTH; length++)
+    {
+        for (int i = 0; i < length; i++)
+            input[i] = (char) ('a' + i % 26);
+        input[length] = '\0';
+        check_round_trip(input);
+        for (int pos = 0; pos < length; pos++)
+        {
+            for (size_t s = 0; s < sizeof(specials); s++)
+            {
+                char saved = input[pos];
+                input[pos] = specials[s];
+                check_round_trip(input);
+                input[pos] = saved;
+            }
+        }
+    }
+}
+
+void test_high_bytes_are_not_escaped(void)
+{
+    /* UTF-8 text is signed-negative per byte; it must not count as control */
+    const char* text = "\xc3\xa9t\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 plus enough padding to fill 32 bytes";
+    cJSON* item = cJSON_CreateString(text);
+    char* printed = cJSON_PrintUnformatted(item);
+    TEST_ASSERT_EQUAL_size_t(strlen(text) + 2, strlen(printed));
+    free(printed);
+    cJSON_Delete(item);
+
+    item = cJSON_Parse("\"0123456789abcdef0123456789abcdef\\u00e9\\ud83d\\ude00 tail\"");
+    TEST_ASSERT_EQUAL_STRING("0123456789abcdef0123456789abcdef\xc3\xa9\xf0\x9f\x98\x80 tail",
+                             cJSON_GetStringValue(item));
+    cJSON_Delete(item);
+}
+
+void test_malformed_strings(void)
+{
+    char text[MAX_LENGTH + 4];
+    for (int length = 0; length <= MAX_LENGTH; length++)
+    {
+        /* Unterminated */
+        text[0] = '"';
+        memset(text + 1, 'x', (size_t) length);
+        text[length + 1] = '\0';
+        TEST_ASSERT_NULL(cJSON_ParseWithLength(text, (size_t) length + 1));
+
+        /* Trailing backslash */
+        text[length + 1] = '\\';
+        text[length + 2] = '\0';
+        TEST_ASSERT_NULL(cJSON_ParseWithLength(text, (size_t) length + 2));
+
+        /* Escaped quote is not the terminator */
+        text[length + 2] = '"';
+        text[length + 3] = '\0';
+        TEST_ASSERT_NULL(cJSON_ParseWithLength(text, (size_t) length + 3));
+    }
+
+    /* Closing quote beyond the given length is not seen */
+    TEST_ASSERT_NULL(cJSON_ParseWithLength("\"0123456789abcdef0123456789abcdef\"", 33));
+    TEST_ASSERT_NULL(cJSON_Parse("\"0123456789abcdef0123456789\\x\""));
+}
+
+static size_t allocations;
+
+static void* counting_malloc(size_t size)
+{
+    allocations++;
+    return malloc(size);
+}
+
+static void set_counting_hooks(bool counting)
+{
+    cJSON_Hooks hooks = {counting ? counting_malloc : NULL, NULL};
+    cJSON_InitHooks(&hooks);
+}
+
+void test_in_situ_parse(void)
+{
+    const char* json = "{\"name\":\"plain\",\"esc\\u0061ped\":\"a\\\"b\\\\c\\n\\u00e9\\ud83d\\ude00\","
+                       "\"list\":[\"0123456789abcdef0123456789abcdef0123\",{\"k\":\"\"}],\"n\":-1.5e3}";
+    cJSON* reference = cJSON_Parse(json);
+    char* expected = cJSON_PrintUnformatted(reference);
+
+    char buffer[256];
+    strcpy(buffer, json);
+    cJSON* item = cJSON_ParseInSitu(buffer, strlen(buffer));
+    TEST_ASSERT_NOT_NULL(item);
+    TEST_ASSERT_TRUE(cJSON_Compare(reference, item, true));
+    char* printed = cJSON_PrintUnformatted(item);
+    TEST_ASSERT_EQUAL_STRING(expected, printed);
+    free(printed);
+
+    /* Strings and names point into the buffer */
+    cJSON* name = cJSON_GetObjectItem(item, "name");
+    TEST_ASSERT_TRUE(name->valuestring >= buffer && name->valuestring < buffer + sizeof(buffer));
+    TEST_ASSERT_TRUE(name->string >= buffer && name->string < buffer + sizeof(buffer));
+    TEST_ASSERT_TRUE(name->type & cJSON_IsReference);
+    TEST_ASSERT_TRUE(name->type & cJSON_StringIsConst);
+    TEST_ASSERT_EQUAL_STRING("a\"b\\c\n\xc3\xa9\xf0\x9f\x98\x80",
+                             cJSON_GetObjectItem(item, "escaped")->valuestring);
+
+    /* A duplicate owns all of its strings */
+    cJSON* copy = cJSON_Duplicate(item, true);
+    cJSON_Delete(item);
+    memset(buffer, 'x', sizeof(buffer));
+    printed = cJSON_PrintUnformatted(copy);
+    TEST_ASSERT_EQUAL_STRING(expected, printed);
+    free(printed);
+    cJSON_Delete(copy);
+    free(expected);
+    cJSON_Delete(reference);
+}
+
+void test_in_situ_allocations(void)
+{
+    const char* json = "{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":{\"a\":1,\"b\":\"two\"},\"id\":\"x\"}";
+    char buffer[128];
+
+    set_counting_hooks(true);
+    allocations = 0;
+    cJSON* item = cJSON_Parse(json);
+    size_t copied = allocations;
+    cJSON_Delete(item);
+
+    strcpy(buffer, json);
+    allocations = 0;
+    item = cJSON_ParseInSitu(buffer, strlen(buffer));
+    size_t in_situ = allocations;
+    cJSON_Delete(item);
+    set_counting_hooks(false);
+
+    /* Only the 7 items; their 6 names and 4 string values are not copied */
+    TEST_ASSERT_EQUAL_size_t(7, in_situ);
+    TEST_ASSERT_EQUAL_size_t(in_situ + 10, copied);
+}
+
+void test_in_situ_malformed(void)
+{
+    const char* inputs[] = {"{\"a\":\"b", "{\"a\" \"b\"}", "{\"a\":tru}", "[\"\\x\"]", "{\"a\":[\"b\",}"};
+    char buffer[32];
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++)
+    {
+        strcpy(buffer, inputs[i]);
+        TEST_ASSERT_NULL(cJSON_ParseInSitu(buffer, strlen(buffer)));
+    }
+    TEST_ASSERT_NULL(cJSON_ParseInSitu(NULL, 0));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_print_and_parse_every_position);
+    RUN_TEST(test_high_bytes_are_not_escaped);
+    RUN_TEST(test_malformed_strings);
+    RUN_TEST(test_in_situ_parse);
+    RUN_TEST(test_in_situ_allocations);
+    RUN_TEST(test_in_situ_malformed);
+    return UNITY_END();
+}
@@ -0,0 +1,285 @@
+/**
+ * @file typed_array_test.c
+ * @brief Tests for typed numeric arrays in the bundled cJSON and mjrpc_set_typed_arrays()
+ *
+ * Passes with and without CJSON_COMPACT_NODES. Covers:
+ *   - Which arrays the Typed parse variants turn into typed arrays
+ *   - Output identical to arrays of number items, formatted or not
+ *   - Parse errors reported at the same position
+ *   - long long elements beyond 2^53, and promotion to double
+ *   - Creating, duplicating, comparing and expanding typed arrays
+ *   - Methods reading typed arrays nested in params and returning them
+ *   - Positional params and numbers-only batches behaving as before
+ */
+
+#include "unity.h"
+#include "mjsonrpc.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static cJSON* parse_typed(const char* text, size_t typed_min)
+{
+    return cJSON_ParseWithLengthTyped(text, strlen(text), typed_min);
+}
+
+void test_which_arrays_become_typed(void)
+{
+    cJSON* item = parse_typed("[1,2,3]", 3);
+    TEST_ASSERT_TRUE(cJSON_IsTypedArray(item));
+    TEST_ASSERT_FALSE(cJSON_IsArray(item));
+    TEST_ASSERT_EQUAL_INT(cJSON_TypedInt64, cJSON_GetTypedArrayKind(item));
+    TEST_ASSERT_EQUAL_size_t(3, cJSON_GetTypedArraySize(item));
+    TEST_ASSERT_EQUAL_INT(0, cJSON_GetArraySize(item));
+    cJSON_Delete(item);
+
+    item = parse_typed(" [ 1.5 , -2 ,3e2 ] ", 1);
+    TEST_ASSERT_EQUAL_INT(cJSON_TypedDouble, cJSON_GetTypedArrayKind(item));
+    TEST_ASSERT_TRUE(cJSON_GetTypedArrayDoubles(item)[2] == 300.0);
+    TEST_ASSERT_NULL(cJSON_GetTypedArrayInt64s(item));
+    cJSON_Delete(item);
+
+    /* Too short, mixed, empty, or typed arrays switched off */
+    const char* regular[][2] = {{"[1,2]", "3"}, {"[1,\"2\",3]", "1"}, {"[1,[2],3]", "1"},
+                                {"[1,2,null]", "1"}, {"[]", "1"}, {"[1,2,3]", "0"}};
+    for (size_t i = 0; i < sizeof(regular) / sizeof(regular[0]); i++)
+    {
+        item = parse_typed(regular[i][0], (size_t) atoi(regular[i][1]));
+        TEST_ASSERT_TRUE_MESSAGE(cJSON_IsArray(item), regular[i][0]);
+        TEST_ASSERT_FALSE(cJSON_IsTypedArray(item));
+        cJSON_Delete(item);
+    }
+
+    /* Nested arrays are typed wherever they are */
+    item = parse_typed("{\"a\":[1,2],\"b\":[[3.5,4],[\"x\"]]}", 2);
+    TEST_ASSERT_TRUE(cJSON_IsTypedArray(cJSON_GetObjectItem(item, "a")));
+    TEST_ASSERT_TRUE(cJSON_IsArray(cJSON_GetObjectItem(item, "b")));
+    TEST_ASSERT_TRUE(cJSON_IsTypedArray(cJSON_GetArrayItem(cJSON_GetObjectItem(item, "b"), 0)));
+    TEST_ASSERT_TRUE(cJSON_IsArray(cJSON_GetArrayItem(cJSON_GetObjectItem(item, "b"), 1)));
+    cJSON_Delete(item);
+}
+
+void test_output_matches_items(void)
+{
+    const char* documents[] = {
+        "[1,2,3,4]",
+        "[-0,0.1,1e300,-2.5e-300,123456.789,1.7976931348623157e308]",
+        "{\"x\":[0.30000000000000004, 1, 2],\"y\":{\"z\":[7,8,9,10]},\"e\":[]}",
+        "[[1,2],[3.25,4],[5,\"six\"],[2147483648,-2147483649,3]]",
+        "[999999999999999,-999999999999999,0,5]",
+    };
+    for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); i++)
+    {
+        cJSON* items = cJSON_Parse(documents[i]);
+        cJSON* typed = parse_typed(documents[i], 2);
+        TEST_ASSERT_NOT_NULL(typed);
+
+        char* expected = cJSON_PrintUnformatted(items);
+        char* printed = cJSON_PrintUnformatted(typed);
+        TEST_ASSERT_EQUAL_STRING(expected, printed);
+        free(expected);
+        free(printed);
+
+        expected = cJSON_Print(items);
+        printed = cJSON_Print(typed);
+        TEST_ASSERT_EQUAL_STRING(expected, printed);
+        free(printed);
+        /* Also when the buffer has to grow along the way */
+        printed = cJSON_PrintBuffered(typed, 1, true);
+        TEST_ASSERT_EQUAL_STRING(expected, printed);
+        free(expected);
+        free(printed);
+
+        TEST_ASSERT_TRUE(cJSON_Compare(items, typed, true));
+        TEST_ASSERT_TRUE(cJSON_Compare(typed, items, false));
+        cJSON_Delete(items);
+        cJSON_Delete(typed);
+    }
+}
+
+void test_errors_at_same_position(void)
+{
+    const char* invalid[] = {"[1,2,", "[1,2,x]", "[1,,2]", "[1 2]", "[1,2,3", "[1,2,-]", "[1,2,3}", "{\"a\":[1,2,3}"};
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+    {
+        TEST_ASSERT_NULL(cJSON_ParseWithLength(invalid[i], strlen(invalid[i])));
+        size_t expected = (size_t) (cJSON_GetErrorPtr() - invalid[i]);
+        TEST_ASSERT_NULL_MESSAGE(parse_typed(invalid[i], 1), invalid[i]);
+        TEST_ASSERT_EQUAL_size_t_MESSAGE(expected, (size_t) (cJSON_GetErrorPtr() - invalid[i]), invalid[i]);
+    }
+}
+
+void test_int64_elements(void)
+{
+    /* Items round these through double; typed arrays keep every digit */
+    cJSON* item = parse_typed("[9007199254740993,-123456789012345678,0]", 1);
+    TEST_ASSERT_EQUAL_INT(cJSON_TypedInt64, cJSON_GetTypedArrayKind(item));
+    TEST_ASSERT_TRUE(cJSON_GetTypedArrayInt64s(item)[0] == 9007199254740993LL);
+    char* printed = cJSON_PrintUnformatted(item);
+    TEST_ASSERT_EQUAL_STRING("[9007199254740993,-123456789012345678,0]", printed);
+    free(printed);
+    cJSON_Delete(item);
+
+    /* 19 digits, fractions and exponents make the whole array double */
+    const char* promoted[] = {"[1,2,1234567890123456789]", "[1,2.0,3]", "[1,2,3e0]"};
+    for (size_t i = 0; i < sizeof(promoted) / sizeof(promoted[0]); i++)
+    {
+        item = parse_typed(promoted[i], 1);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(cJSON_TypedDouble, cJSON_GetTypedArrayKind(item), promoted[i]);
+        TEST_ASSERT_TRUE(cJSON_GetTypedArrayNumber(item, 0) == 1.0);
+        cJSON_Delete(item);
+    }
+}
+
+void test_create_duplicate_compare_expand(void)
+{
+    const double numbers[] = {0.5, -1, 3e10, 4};
+    cJSON* typed = cJSON_CreateTypedDoubleArray(numbers, 4);
+    cJSON* items = cJSON_CreateDoubleArray(numbers, 4);
+    TEST_ASSERT_TRUE(cJSON_Compare(typed, items, true));
+
+    cJSON* copy = cJSON_Duplicate(typed, false);
+    TEST_ASSERT_TRUE(cJSON_IsTypedArray(copy));
+    TEST_ASSERT_TRUE(cJSON_Compare(typed, copy, true));
+    cJSON_GetTypedArrayDoubles(copy)[3] = 5;
+    TEST_ASSERT_FALSE(cJSON_Compare(typed, copy, true));
+    TEST_ASSERT_FALSE(cJSON_Compare(copy, items, true));
+    cJSON_Delete(copy);
+
+    /* Same numbers, other element type */
+    const long long integers[] = {1, 2, 3};
+    cJSON* int64s = cJSON_CreateTypedInt64Array(integers, 3);
+    cJSON* doubles = cJSON_CreateTypedDoubleArray(NULL, 3);
+    for (int i = 0; i < 3; i++)
+        cJSON_GetTypedArrayDoubles(doubles)[i] = i + 1;
+    TEST_ASSERT_TRUE(cJSON_Compare(int64s, doubles, true));
+    TEST_ASSERT_FALSE(cJSON_Compare(int64s, typed, true));
+    TEST_ASSERT_TRUE(isnan(cJSON_GetTypedArrayNumber(int64s, 3)));
+    TEST_ASSERT_TRUE(isnan(cJSON_GetTypedArrayNumber(items, 0)));
+    cJSON_Delete(doubles);
+
+    /* Typed arrays nest like any item */
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddItemToObject(root, "t", typed);
+    cJSON_AddItemToObject(root, "i", int64s);
+    char* printed = cJSON_PrintUnformatted(root);
+    TEST_ASSERT_EQUAL_STRING("{\"t\":[0.5,-1,30000000000,4],\"i\":[1,2,3]}", printed);
+    free(printed);
+
+    TEST_ASSERT_TRUE(cJSON_ExpandTypedArray(typed));
+    TEST_ASSERT_TRUE(cJSON_IsArray(typed));
+    TEST_ASSERT_EQUAL_INT(4, cJSON_GetArraySize(typed));
+    TEST_ASSERT_TRUE(cJSON_GetArrayItem(typed, 3)->valuedouble == 4.0);
+    TEST_ASSERT_TRUE(cJSON_Compare(typed, items, true));
+    TEST_ASSERT_FALSE(cJSON_ExpandTypedArray(typed));
+    printed = cJSON_PrintUnformatted(root);
+    TEST_ASSERT_EQUAL_STRING("{\"t\":[0.5,-1,30000000000,4],\"i\":[1,2,3]}", printed);
+    free(printed);
+
+    cJSON_Delete(root);
+    cJSON_Delete(items);
+}
+
+/* Returns params.samples scaled by params.factor, as a typed array */
+static cJSON* scale_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) params;
+    (void) id;
+    const cJSON* samples = mjrpc_params_get(ctx, "samples");
+    const cJSON* factor = mjrpc_params_get(ctx, "factor");
+    if (!cJSON_IsTypedArray(samples) || !cJSON_IsNumber(factor))
+    {
+        ctx->error_code = JSON_RPC_CODE_INVALID_PARAMS;
+        return NULL;
+    }
+    size_t count = cJSON_GetTypedArraySize(samples);
+    cJSON* result = cJSON_CreateTypedDoubleArray(NULL, count);
+    for (size_t i = 0; i < count; i++)
+        cJSON_GetTypedArrayDoubles(result)[i] = cJSON_GetTypedArrayNumber(samples, i) * factor->valuedouble;
+    return result;
+}
+
+/* Sums positional params item by item */
+static cJSON* sum_func(mjrpc_func_ctx_t* ctx, cJSON* params, cJSON* id)
+{
+    (void) params;
+    (void) id;
+    double sum = 0;
+    for (int i = 0; i < mjrpc_params_size(ctx); i++)
+        sum += mjrpc_params_at(ctx, i)->valuedouble;
+    return cJSON_CreateNumber(sum);
+}
+
+static char* process(mjrpc_handle_t* h, const char* request, bool in_situ)
+{
+    size_t len = strlen(request);
+    if (!in_situ)
+        return mjrpc_process_buf(h, request, len, NULL);
+    char* buf = malloc(len);
+    memcpy(buf, request, len);
+    char* response = mjrpc_process_buf_insitu(h, buf, len, NULL);
+    free(buf);
+    return response;
+}
+
+void test_methods_with_typed_arrays(void)
+{
+    mjrpc_handle_t* h = mjrpc_create_handle(8);
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_ERROR_HANDLE_NOT_INITIALIZED, mjrpc_set_typed_arrays(NULL, 4));
+    TEST_ASSERT_EQUAL_INT(MJRPC_RET_OK, mjrpc_set_typed_arrays(h, 4));
+    mjrpc_add_method(h, scale_func, "scale", NULL);
+    mjrpc_add_method(h, sum_func, "sum", NULL);
+
+    for (int in_situ = 0; in_situ < 2; in_situ++)
+    {
+        char* response =
+            process(h, "{\"jsonrpc\":\"2.0\",\"method\":\"scale\",\"params\":{\"factor\":2,\"samples\":[1,2.5,-3,4]},\"id\":1}",
+                    in_situ);
+        TEST_ASSERT_EQUAL_STRING("{\"jsonrpc\":\"2.0\",\"result\":[2,5,-6,8],\"id\":1}", response);
+        free(response);
+
+        /* Shorter arrays stay items */
+        response = process(h, "{\"jsonrpc\":\"2.0\",\"method\":\"scale\",\"params\":{\"factor\":2,\"samples\":[1,2]},\"id\":2}",
+                           in_situ);
+        TEST_ASSERT_NOT_NULL(strstr(response, "-32602"));
+        free(response);
+
+        /* The params array itself is never typed */
+        response = process(h, "{\"jsonrpc\":\"2.0\",\"method\":\"sum\",\"params\":[1,2,3,4,5],\"id\":3}", in_situ);
+        TEST_ASSERT_EQUAL_STRING("{\"jsonrpc\":\"2.0\",\"result\":15,\"id\":3}", response);
+        free(response);
+
+        /* Nor is a batch of numbers, answered element by element */
+        response = process(h, "[1,2,3,4]", in_situ);
+        mjrpc_set_typed_arrays(h, 0);
+        char* expected = process(h, "[1,2,3,4]", in_situ);
+        mjrpc_set_typed_arrays(h, 4);
+        TEST_ASSERT_EQUAL_STRING(expected, response);
+        free(expected);
+        free(response);
+    }
+
+    /* Without the option, the method sees items */
+    mjrpc_set_typed_arrays(h, 0);
+    char* response =
+        process(h, "{\"jsonrpc\":\"2.0\",\"method\":\"scale\",\"params\":{\"factor\":2,\"samples\":[1,2,3,4]},\"id\":4}", false);
+    TEST_ASSERT_NOT_NULL(strstr(response, "-32602"));
+    free(response);
+    mjrpc_destroy_handle(h);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_which_arrays_become_typed);
+    RUN_TEST(test_output_matches_items);
+    RUN_TEST(test_errors_at_same_position);
+    RUN_TEST(test_int64_elements);
+    RUN_TEST(test_create_duplicate_compare_expand);
+    RUN_TEST(test_methods_with_typed_arrays);
+    return UNITY_END();
+}